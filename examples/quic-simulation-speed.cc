@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Network topology
+//
+//       n0 ----------- n1
+//            100 Mbps
+//             5 ms
+//
+// This program is a regression benchmark for the speed of the QUIC model.
+// A number of bulk transfers share a point-to-point link, with random losses
+// at the receiver so that the ACKs carry gaps and the loss detection and
+// retransmission paths are exercised. The wall-clock time of the run is
+// measured, and the program reports the number of packets transmitted on the
+// link per wall-clock second and per simulated second. The numbers are only
+// comparable between runs with the same parameters on the same machine, and
+// should be measured with an optimized build.
+
+#include <chrono>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/quic-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QuicSimulationSpeedExample");
+
+static uint64_t g_packets = 0;  //!< Packets transmitted on the link
+
+static void
+PhyTxEnd (Ptr<const Packet> p)
+{
+  g_packets++;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string dataRate = "100Mbps";
+  std::string delay = "5ms";
+  uint32_t QUICFlows = 4;
+  double errorRate = 0.001;
+  double duration = 10.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("DataRate", "Data rate of the bottleneck link", dataRate);
+  cmd.AddValue ("Delay", "One-way delay of the bottleneck link", delay);
+  cmd.AddValue ("QUICFlows", "Number of application flows between sender and receiver", QUICFlows);
+  cmd.AddValue ("ErrorRate", "Packet error rate at the receiver", errorRate);
+  cmd.AddValue ("Duration", "Duration of the transfers in seconds", duration);
+  cmd.Parse (argc, argv);
+
+  Time::SetResolution (Time::NS);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (delay));
+
+  NetDeviceContainer devices;
+  devices = pointToPoint.Install (nodes);
+
+  Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
+  em->SetAttribute ("ErrorRate", DoubleValue (errorRate));
+  em->SetAttribute ("ErrorUnit", StringValue ("ERROR_UNIT_PACKET"));
+  devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (em));
+
+  QuicHelper stack;
+  stack.InstallQuic (nodes);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer i = ipv4.Assign (devices);
+
+  ApplicationContainer sourceApps;
+  ApplicationContainer sinkApps;
+  for (uint32_t iterator = 0; iterator < QUICFlows; iterator++)
+    {
+      uint16_t port = 10000 + iterator;
+
+      BulkSendHelper source ("ns3::QuicSocketFactory",
+                             InetSocketAddress (i.GetAddress (1), port));
+      source.SetAttribute ("MaxBytes", UintegerValue (0));
+      sourceApps.Add (source.Install (nodes.Get (0)));
+
+      PacketSinkHelper sink ("ns3::QuicSocketFactory",
+                             InetSocketAddress (Ipv4Address::GetAny (), port));
+      sinkApps.Add (sink.Install (nodes.Get (1)));
+    }
+
+  sinkApps.Start (Seconds (0.0));
+  sinkApps.Stop (Seconds (duration + 1));
+  sourceApps.Start (Seconds (1.0));
+  sourceApps.Stop (Seconds (duration + 1));
+
+  Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::PointToPointNetDevice/PhyTxEnd",
+                                 MakeCallback (&PhyTxEnd));
+
+  Simulator::Stop (Seconds (duration + 2));
+
+  auto start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  auto stop = std::chrono::steady_clock::now ();
+  double wallClock = std::chrono::duration<double> (stop - start).count ();
+  double simulated = duration + 2;
+
+  uint64_t received = 0;
+  for (uint32_t iterator = 0; iterator < sinkApps.GetN (); iterator++)
+    {
+      received += DynamicCast<PacketSink> (sinkApps.Get (iterator))->GetTotalRx ();
+    }
+
+  std::cout << "Received bytes:                 " << received << "\n";
+  std::cout << "Packets on the link:            " << g_packets << "\n";
+  std::cout << "Wall-clock time:                " << wallClock << " s\n";
+  std::cout << "Packets per wall-clock second:  " << g_packets / wallClock << "\n";
+  std::cout << "Packets per simulated second:   " << g_packets / simulated << "\n";
+  std::cout << "Simulated seconds per second:   " << simulated / wallClock << "\n";
+
+  Simulator::Destroy ();
+  return 0;
+}
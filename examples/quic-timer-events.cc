@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Network topology
+//
+//       n0 ----------- n1
+//            100 Mbps
+//             5 ms
+//
+// This program measures the cost of the per-packet timers of QUIC in terms of
+// simulator events. A bulk transfer is run over a point-to-point link, and the
+// number of events scheduled and executed by the simulator during the
+// transfer is reported per packet transmitted on the link. Since the idle
+// timeout and the loss detection alarm are lazy timers, which are re-armed on
+// expiration instead of being rescheduled for each packet, the number of
+// events per packet should not depend on the number of packets in flight.
+
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/quic-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QuicTimerEventsExample");
+
+static uint64_t g_packets = 0;        //!< Packets transmitted on the link during the measurement
+static bool g_measuring = false;      //!< True during the measurement window
+static uint64_t g_startUid = 0;       //!< Event UID at the start of the measurement
+static uint64_t g_stopUid = 0;        //!< Event UID at the end of the measurement
+static uint64_t g_startCount = 0;     //!< Executed events at the start of the measurement
+static uint64_t g_stopCount = 0;      //!< Executed events at the end of the measurement
+
+static void
+DoNothing ()
+{
+}
+
+/*
+ * Event UIDs are assigned sequentially to every scheduled event, including
+ * the ones that are later canceled, so the UID of a new event is the number
+ * of events scheduled so far
+ */
+static uint64_t
+GetScheduledEvents ()
+{
+  return Simulator::ScheduleNow (&DoNothing).GetUid ();
+}
+
+static void
+StartMeasurement ()
+{
+  g_measuring = true;
+  g_startUid = GetScheduledEvents ();
+  g_startCount = Simulator::GetEventCount ();
+}
+
+static void
+StopMeasurement ()
+{
+  g_measuring = false;
+  g_stopUid = GetScheduledEvents ();
+  g_stopCount = Simulator::GetEventCount ();
+}
+
+static void
+PhyTxEnd (Ptr<const Packet> p)
+{
+  if (g_measuring)
+    {
+      g_packets++;
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string dataRate = "100Mbps";
+  std::string delay = "5ms";
+  double duration = 10.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("DataRate", "Data rate of the bottleneck link", dataRate);
+  cmd.AddValue ("Delay", "One-way delay of the bottleneck link", delay);
+  cmd.AddValue ("Duration", "Duration of the measurement in seconds", duration);
+  cmd.Parse (argc, argv);
+
+  Time::SetResolution (Time::NS);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (delay));
+
+  NetDeviceContainer devices;
+  devices = pointToPoint.Install (nodes);
+
+  QuicHelper stack;
+  stack.InstallQuic (nodes);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer i = ipv4.Assign (devices);
+
+  uint16_t port = 10000;
+  BulkSendHelper source ("ns3::QuicSocketFactory",
+                         InetSocketAddress (i.GetAddress (1), port));
+  source.SetAttribute ("MaxBytes", UintegerValue (0));
+  ApplicationContainer sourceApps = source.Install (nodes.Get (0));
+
+  PacketSinkHelper sink ("ns3::QuicSocketFactory",
+                         InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps = sink.Install (nodes.Get (1));
+
+  // measure the steady state, after the handshake and the first RTTs
+  double start = 2.0;
+  sinkApps.Start (Seconds (0.0));
+  sinkApps.Stop (Seconds (start + duration + 1));
+  sourceApps.Start (Seconds (1.0));
+  sourceApps.Stop (Seconds (start + duration + 1));
+
+  Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::PointToPointNetDevice/PhyTxEnd",
+                                 MakeCallback (&PhyTxEnd));
+  Simulator::Schedule (Seconds (start), &StartMeasurement);
+  Simulator::Schedule (Seconds (start + duration), &StopMeasurement);
+
+  Simulator::Stop (Seconds (start + duration + 2));
+  Simulator::Run ();
+
+  Ptr<PacketSink> packetSink = DynamicCast<PacketSink> (sinkApps.Get (0));
+  uint64_t scheduled = g_stopUid - g_startUid;
+  uint64_t executed = g_stopCount - g_startCount;
+
+  std::cout << "Received bytes:            " << packetSink->GetTotalRx () << "\n";
+  std::cout << "Packets on the link:       " << g_packets << "\n";
+  std::cout << "Scheduled events:          " << scheduled << "\n";
+  std::cout << "Executed events:           " << executed << "\n";
+  if (g_packets > 0)
+    {
+      std::cout << "Scheduled events / packet: " << (double) scheduled / g_packets << "\n";
+      std::cout << "Executed events / packet:  " << (double) executed / g_packets << "\n";
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "quic-ack-range-set.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QuicAckRangeSet");
+
+QuicAckRangeSet::QuicAckRangeSet ()
+  : m_maxRanges (21),
+    m_lastOutOfOrder (false)
+{
+}
+
+bool
+QuicAckRangeSet::Add (SequenceNumber32 packetNumber)
+{
+  NS_LOG_FUNCTION (this << packetNumber);
+
+  m_lastOutOfOrder = false;
+  if (m_ranges.empty () or packetNumber > m_ranges.back ().second)
+    {
+      // in-order reception: extend the highest range or open a new one
+      if (!m_ranges.empty () and packetNumber == m_ranges.back ().second + 1)
+        {
+          m_ranges.back ().second = packetNumber;
+        }
+      else
+        {
+          // a new gap, unless this is the first packet number
+          m_lastOutOfOrder = !m_ranges.empty ();
+          m_ranges.push_back (Range (packetNumber, packetNumber));
+        }
+    }
+  else
+    {
+      // find the first range whose upper edge is not below the packet number
+      std::deque<Range>::iterator it = std::lower_bound (
+        m_ranges.begin (), m_ranges.end (), packetNumber,
+        [] (const Range &r, SequenceNumber32 pn) { return r.second < pn; });
+      NS_ASSERT (it != m_ranges.end ());
+
+      if (it->first <= packetNumber)
+        {
+          NS_LOG_LOGIC ("Duplicate packet number " << packetNumber);
+          return false;
+        }
+
+      // the packet was received after a higher one
+      m_lastOutOfOrder = true;
+
+      bool joinUpper = (packetNumber + 1 == it->first);
+      bool joinLower = (it != m_ranges.begin () and (it - 1)->second + 1 == packetNumber);
+
+      if (joinUpper and joinLower)
+        {
+          // the packet fills a gap
+          (it - 1)->second = it->second;
+          m_ranges.erase (it);
+        }
+      else if (joinUpper)
+        {
+          it->first = packetNumber;
+        }
+      else if (joinLower)
+        {
+          (it - 1)->second = packetNumber;
+        }
+      else
+        {
+          m_ranges.insert (it, Range (packetNumber, packetNumber));
+        }
+    }
+
+  while (m_ranges.size () > m_maxRanges)
+    {
+      ForgetSecondLowest ();
+    }
+
+  return true;
+}
+
+bool
+QuicAckRangeSet::IsEmpty () const
+{
+  return m_ranges.empty ();
+}
+
+SequenceNumber32
+QuicAckRangeSet::GetLargest () const
+{
+  NS_ASSERT (!m_ranges.empty ());
+  return m_ranges.back ().second;
+}
+
+bool
+QuicAckRangeSet::HasReceivedMissing () const
+{
+  return m_lastOutOfOrder;
+}
+
+uint32_t
+QuicAckRangeSet::GetNumRanges () const
+{
+  return m_ranges.size ();
+}
+
+void
+QuicAckRangeSet::SetMaxRanges (uint32_t maxRanges)
+{
+  NS_LOG_FUNCTION (this << maxRanges);
+  m_maxRanges = std::max (maxRanges, (uint32_t) 2);
+  while (m_ranges.size () > m_maxRanges)
+    {
+      ForgetSecondLowest ();
+    }
+}
+
+uint32_t
+QuicAckRangeSet::GetMaxRanges () const
+{
+  return m_maxRanges;
+}
+
+void
+QuicAckRangeSet::PruneBelow (SequenceNumber32 packetNumber)
+{
+  NS_LOG_FUNCTION (this << packetNumber);
+
+  // the lowest range anchors the implicit last ACK block, and is kept
+  while (m_ranges.size () > 2 and m_ranges[1].second < packetNumber)
+    {
+      ForgetSecondLowest ();
+    }
+}
+
+void
+QuicAckRangeSet::GetAckBlocks (uint32_t maxGaps, std::vector<uint32_t> &gaps,
+                               std::vector<uint32_t> &additionalAckBlocks) const
+{
+  NS_LOG_FUNCTION (this << maxGaps);
+
+  if (m_ranges.size () < 2)
+    {
+      return;
+    }
+
+  // report the highest ranges, then the lowest one: the last ACK block
+  // implicitly covers all the lower packet numbers, so it must not be a
+  // range with unreported gaps below it
+  uint32_t gapBudget = std::max (maxGaps, (uint32_t) 1);
+  std::deque<Range>::const_reverse_iterator upper = m_ranges.rbegin ();
+  std::deque<Range>::const_reverse_iterator lowest = m_ranges.rend () - 1;
+  for (; gaps.size () + 1 < gapBudget and upper + 1 != lowest; ++upper)
+    {
+      gaps.push_back ((upper->first - 1).GetValue ());
+      additionalAckBlocks.push_back ((upper + 1)->second.GetValue ());
+    }
+  gaps.push_back ((upper->first - 1).GetValue ());
+  additionalAckBlocks.push_back (lowest->second.GetValue ());
+}
+
+void
+QuicAckRangeSet::ForgetSecondLowest ()
+{
+  NS_ASSERT (m_ranges.size () > 2);
+  std::deque<Range>::iterator it = m_ranges.begin () + 1;
+  NS_LOG_LOGIC ("Forgetting range [" << it->first << ", " << it->second << "]");
+  m_ranges.erase (it);
+}
+
+void
+QuicAckRangeSet::Print (std::ostream &os) const
+{
+  for (std::deque<Range>::const_iterator it = m_ranges.begin (); it != m_ranges.end (); ++it)
+    {
+      os << "[" << it->first << ", " << it->second << "]";
+    }
+}
+
+} // namespace ns3
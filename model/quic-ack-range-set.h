@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUICACKRANGESET_H
+#define QUICACKRANGESET_H
+
+#include <deque>
+#include <vector>
+#include <ostream>
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup quic
+ *
+ * \brief Set of received packet numbers, stored as merged ranges
+ *
+ * The received packet numbers are kept as an ordered sequence of disjoint,
+ * non-adjacent [lo, hi] ranges, so that the memory and the cost of building
+ * an ACK frame depend on the number of gaps rather than on the number of
+ * received packets.
+ *
+ * In the ACK frame encoding the last ACK block implicitly covers all the
+ * lower packet numbers, so the lowest range, which starts at the first
+ * received packet, is never forgotten and is always the last reported block.
+ * When the number of ranges is bounded or pruned, the ranges just above it
+ * are forgotten instead: their packets are then reported as missing, which
+ * the peer ignores since it has already seen them acknowledged, while no
+ * missing packet is ever reported as received.
+ */
+class QuicAckRangeSet
+{
+public:
+  typedef std::pair<SequenceNumber32, SequenceNumber32> Range;  //!< A [lo, hi] range of packet numbers
+
+  QuicAckRangeSet ();
+
+  /**
+   * \brief Add a received packet number
+   *
+   * \param packetNumber the packet number
+   * \return false if the packet number was already in the set, true otherwise
+   */
+  bool Add (SequenceNumber32 packetNumber);
+
+  /**
+   * \brief Check if no packet number has been received
+   *
+   * \return true if the set is empty
+   */
+  bool IsEmpty () const;
+
+  /**
+   * \brief Get the largest received packet number
+   *
+   * \return the largest packet number in the set
+   */
+  SequenceNumber32 GetLargest () const;
+
+  /**
+   * \brief Check if the last added packet number was received out of order
+   *
+   * This is the case if the packet left a gap below it, i.e., some packets
+   * before it are missing, or if it filled (part of) a gap, i.e., it was
+   * received after a higher packet number. In both cases the peer should
+   * be told immediately, to speed up its loss detection.
+   *
+   * \return true if the last added packet number was received out of order
+   */
+  bool HasReceivedMissing () const;
+
+  /**
+   * \brief Get the number of ranges in the set
+   *
+   * \return the number of ranges
+   */
+  uint32_t GetNumRanges () const;
+
+  /**
+   * \brief Set the maximum number of tracked ranges
+   *
+   * \param maxRanges the maximum number of ranges (at least 2, i.e., the
+   *        lowest and the highest range)
+   */
+  void SetMaxRanges (uint32_t maxRanges);
+
+  /**
+   * \brief Get the maximum number of tracked ranges
+   *
+   * \return the maximum number of ranges
+   */
+  uint32_t GetMaxRanges () const;
+
+  /**
+   * \brief Forget the ranges that lie entirely below a packet number
+   *
+   * This is called when an ACK frame, acknowledging up to packetNumber, has
+   * been acknowledged by the peer: the information below packetNumber has
+   * been delivered, and does not need to be repeated. The lowest and the
+   * highest range are always kept.
+   *
+   * \param packetNumber the largest acknowledged of the acknowledged ACK frame
+   */
+  void PruneBelow (SequenceNumber32 packetNumber);
+
+  /**
+   * \brief Build the ACK blocks for QuicSubheader::CreateAck
+   *
+   * For each gap, starting from the largest packet number, gaps contains the
+   * highest missing packet number and additionalAckBlocks the highest packet
+   * number of the next (lower) reported range. The last reported range is
+   * always the lowest one, so if there are more gaps than maxGaps, the
+   * ranges just above the lowest one are not reported.
+   *
+   * \param maxGaps the maximum number of gaps to report (at least one gap
+   *        is reported if the set has more than one range)
+   * \param gaps the vector filled with the gaps
+   * \param additionalAckBlocks the vector filled with the additional ACK blocks
+   */
+  void GetAckBlocks (uint32_t maxGaps, std::vector<uint32_t> &gaps,
+                     std::vector<uint32_t> &additionalAckBlocks) const;
+
+  /**
+   * \brief Print the ranges
+   * \param os ostream
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  /**
+   * \brief Forget the range just above the lowest one
+   *
+   * Its packets are merged into the gap above the lowest range.
+   */
+  void ForgetSecondLowest ();
+
+  std::deque<Range> m_ranges;  //!< Received ranges, in increasing order
+  uint32_t m_maxRanges;        //!< Maximum number of tracked ranges
+  bool m_lastOutOfOrder;       //!< True if the last added packet number was received out of order
+};
+
+} // namespace ns3
+
+#endif /* QUIC_ACK_RANGE_SET_H */
@@ -413,21 +413,21 @@ void
 QuicBbr::SetSendQuantum (Ptr<QuicSocketState> tcb)
 {
   NS_LOG_FUNCTION (this << tcb);
-  m_sendQuantum = 1 * tcb->m_segmentSize;
-/*TODO
-  Since TSO can't be implemented in ns-3
-  if (tcb->m_pacingRate < DataRate ("1.2Mbps"))
+  // as in Linux, more than one packet per pacing event at high rates
+  DataRate rate = tcb->m_pacingRate.Get ();
+  if (rate < DataRate ("1.2Mbps"))
     {
       m_sendQuantum = 1 * tcb->m_segmentSize;
     }
-  else if (tcb->m_pacingRate < DataRate ("24Mbps"))
+  else if (rate < DataRate ("24Mbps"))
     {
       m_sendQuantum  = 2 * tcb->m_segmentSize;
     }
   else
     {
-      m_sendQuantum = std::min (tcb->m_pacingRate.GetBitRate () * MilliSeconds (1).GetMilliSeconds () / 8, (uint64_t) 64000);
-    }*/
+      m_sendQuantum = std::min (rate.GetBitRate () / 8 / 1000, (uint64_t) 64000);
+    }
+  tcb->m_sendQuantum = m_sendQuantum;
 }
 
 void
@@ -718,8 +718,7 @@ QuicBbr::OnPacketSent (Ptr<TcpSocketState> tcb, SequenceNumber32 packetNumber, b
 }
 
 void
-QuicBbr::OnAckReceived (Ptr<TcpSocketState> tcb, QuicSubheader &ack,
-                        std::vector<Ptr<QuicSocketTxItem> > newAcks,
+QuicBbr::OnAckReceived (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent,
                         const struct RateSample *rs)
 {
   NS_LOG_FUNCTION (this);
@@ -727,17 +726,14 @@ QuicBbr::OnAckReceived (Ptr<TcpSocketState> tcb, QuicSubheader &ack,
   Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState *> (&(*tcb));
   NS_ASSERT_MSG (tcbd, "tcb is not a QuicSocketState");
 
-  tcbd->m_largestAckedPacket = SequenceNumber32 (ack.GetLargestAcknowledged ());
-
-  // newAcks are ordered from the highest packet number to the smalles
-  Ptr<QuicSocketTxItem> lastAcked = newAcks.at (0);
+  tcbd->m_largestAckedPacket = ackEvent.m_largestAcked;
 
   NS_LOG_LOGIC ("Updating RTT estimate");
   // If the largest acked is newly acked, update the RTT.
-  if (lastAcked->m_packetNumber == tcbd->m_largestAckedPacket)
+  if (!ackEvent.m_rttSample.IsZero ())
     {
-      tcbd->m_lastRtt = Now () - lastAcked->m_lastSent;
-      UpdateRtt (tcbd, tcbd->m_lastRtt, MicroSeconds (ack.GetAckDelay ()));
+      tcbd->m_lastRtt = ackEvent.m_rttSample;
+      UpdateRtt (tcbd, tcbd->m_lastRtt, ackEvent.m_ackDelay);
     }
 
   // Precess end of recovery
@@ -751,30 +747,28 @@ QuicBbr::OnAckReceived (Ptr<TcpSocketState> tcb, QuicSubheader &ack,
     }
 
   NS_LOG_LOGIC ("Processing acknowledged packets");
-  // Process each acked packet
-  for (auto it = newAcks.rbegin (); it != newAcks.rend (); ++it)
+  if (ackEvent.m_ackElicitingAcked > 0)
     {
-      if ((*it)->m_acked)
-        {
-          OnPacketAcked (tcb, (*it));
-        }
+      OnPacketsAcked (tcb, ackEvent);
     }
   CongControl (tcbd, rs);
 }
 
 void
-QuicBbr::OnPacketsLost (Ptr<TcpSocketState> tcb, std::vector<Ptr<QuicSocketTxItem> > lostPackets)
+QuicBbr::OnPacketsLost (Ptr<TcpSocketState> tcb, const std::vector<Ptr<QuicSocketTxItem> > &lostPackets)
 {
   NS_LOG_LOGIC (this);
   Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState *> (&(*tcb));
   NS_ASSERT_MSG (tcbd, "tcb is not a QuicSocketState");
 
-  auto largestLostPacket = *(lostPackets.end () - 1);
+  Ptr<QuicSocketTxItem> largestLostPacket = lostPackets.back ();
 
   NS_LOG_INFO ("Go in recovery mode");
 
   // TCP early retransmit logic [RFC 5827]: enter recovery (RFC 6675, Sec. 5)
-  if (!InRecovery (tcb, largestLostPacket->m_packetNumber))
+  bool newEpoch = !InRecovery (tcb, largestLostPacket->m_packetNumber);
+  SaveUndoState (tcb, lostPackets, newEpoch);
+  if (newEpoch)
     {
       tcbd->m_endOfRecovery = tcbd->m_highTxMark;
       tcbd->m_congState = TcpSocketState::CA_RECOVERY;
@@ -783,7 +777,7 @@ QuicBbr::OnPacketsLost (Ptr<TcpSocketState> tcb, std::vector<Ptr<QuicSocketTxIte
 }
 
 void
-QuicBbr::OnPacketAcked (Ptr<TcpSocketState> tcb, Ptr<QuicSocketTxItem> ackedPacket)
+QuicBbr::OnPacketsAcked (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent)
 {
   NS_LOG_FUNCTION (this);
   Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
@@ -792,7 +786,7 @@ QuicBbr::OnPacketAcked (Ptr<TcpSocketState> tcb, Ptr<QuicSocketTxItem> ackedPack
   NS_LOG_LOGIC ("Handle possible RTO");
   // If a packet sent prior to RTO was acked, then the RTO  was spurious. Otherwise, inform congestion control.
   if (tcbd->m_rtoCount > 0
-      and ackedPacket->m_packetNumber > tcbd->m_largestSentBeforeRto)
+      and ackEvent.m_largestNewlyAcked > tcbd->m_largestSentBeforeRto)
     {
       OnRetransmissionTimeoutVerified (tcb);
     }
@@ -812,6 +806,23 @@ QuicBbr::OnRetransmissionTimeoutVerified (Ptr<TcpSocketState> tcb)
   CongestionStateSet (tcbd, TcpSocketState::CA_LOSS);
 }
 
+void
+QuicBbr::UndoRecovery (Ptr<TcpSocketState> tcb)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
+  NS_ASSERT_MSG (tcbd, "tcb is not a QuicSocketState");
+
+  // Leave recovery as if it ended, which restores the saved window
+  tcbd->m_endOfRecovery = m_undoEndOfRecovery;
+  if (tcbd->m_congState == TcpSocketState::CA_RECOVERY)
+    {
+      tcbd->m_congState = TcpSocketState::CA_OPEN;
+      CongestionStateSet (tcb, TcpSocketState::CA_OPEN);
+      CwndEvent (tcb, TcpSocketState::CA_EVENT_COMPLETE_CWR);
+    }
+}
+
 Ptr<TcpCongestionOps>
 QuicBbr::Fork (void)
 {
@@ -95,9 +95,9 @@ public:
                                    const TcpSocketState::TcpCongState_t newState);
 
   virtual void OnPacketSent (Ptr<TcpSocketState> tcb, SequenceNumber32 packetNumber, bool isAckOnly);
-  virtual void OnAckReceived (Ptr<TcpSocketState> tcb, QuicSubheader &ack,
-                              std::vector<Ptr<QuicSocketTxItem> > newAcks, const struct RateSample *rs);
-  virtual void OnPacketsLost (Ptr<TcpSocketState> tcb, std::vector<Ptr<QuicSocketTxItem> > lostPackets);
+  virtual void OnAckReceived (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent,
+                              const struct RateSample *rs);
+  virtual void OnPacketsLost (Ptr<TcpSocketState> tcb, const std::vector<Ptr<QuicSocketTxItem> > &lostPackets);
 
   virtual void CwndEvent (Ptr<TcpSocketState> tcb,
                           const TcpSocketState::TcpCAEvent_t event);
@@ -115,9 +115,9 @@ public:
                             const TcpRateOps::TcpRateSample &rs);
 
 protected:
-  void OnPacketAcked (Ptr<TcpSocketState> tcb, Ptr<QuicSocketTxItem> ackedPacket);
+  void OnPacketsAcked (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent);
   virtual void OnRetransmissionTimeoutVerified (Ptr<TcpSocketState> tcb);
-
+  virtual void UndoRecovery (Ptr<TcpSocketState> tcb);
 
   /**
    * \brief Called when packets are delivered to update cwnd and pacing rate
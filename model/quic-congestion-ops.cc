@@ -41,6 +41,18 @@ NS_LOG_COMPONENT_DEFINE ("QuicCongestionControl");
 
 NS_OBJECT_ENSURE_REGISTERED (QuicCongestionOps);
 
+QuicAckEvent::QuicAckEvent ()
+  : m_largestAcked (0),
+    m_largestNewlyAcked (0),
+    m_smallestNewlyAcked (0),
+    m_ackedBytes (0),
+    m_ackElicitingAcked (0),
+    m_lostBytes (0),
+    m_rttSample (Seconds (0)),
+    m_ackDelay (Seconds (0)),
+    m_newAcks (0)
+{}
+
 TypeId
 QuicCongestionOps::GetTypeId (void)
 {
@@ -48,19 +60,35 @@ QuicCongestionOps::GetTypeId (void)
     .SetParent<TcpNewReno> ()
     .SetGroupName ("Internet")
     .AddConstructor<QuicCongestionOps> ()
+    .AddTraceSource ("Undo",
+                     "Number of window reductions undone after spurious losses",
+                     MakeTraceSourceAccessor (&QuicCongestionOps::m_undoCount),
+                     "ns3::TracedValueCallback::Uint32")
   ;
   return tid;
 }
 
 QuicCongestionOps::QuicCongestionOps (void)
-  : TcpNewReno ()
+  : TcpNewReno (),
+    m_undoCWnd (0),
+    m_undoSsThresh (0),
+    m_undoEndOfRecovery (0),
+    m_undoFloor (0),
+    m_undoLost (0),
+    m_undoCount (0)
 {
   NS_LOG_FUNCTION (this);
 }
 
 QuicCongestionOps::QuicCongestionOps (
   const QuicCongestionOps& sock)
-  : TcpNewReno (sock)
+  : TcpNewReno (sock),
+    m_undoCWnd (sock.m_undoCWnd),
+    m_undoSsThresh (sock.m_undoSsThresh),
+    m_undoEndOfRecovery (sock.m_undoEndOfRecovery),
+    m_undoFloor (sock.m_undoFloor),
+    m_undoLost (sock.m_undoLost),
+    m_undoCount (sock.m_undoCount)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -97,8 +125,7 @@ QuicCongestionOps::OnPacketSent (Ptr<TcpSocketState> tcb,
 
 void
 QuicCongestionOps::OnAckReceived (Ptr<TcpSocketState> tcb,
-                                  QuicSubheader &ack,
-                                  std::vector<Ptr<QuicSocketTxItem> > newAcks,
+                                  const QuicAckEvent &ackEvent,
                                   const struct RateSample *rs)
 {
   NS_LOG_FUNCTION (this << rs);
@@ -106,28 +133,20 @@ QuicCongestionOps::OnAckReceived (Ptr<TcpSocketState> tcb,
   Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
   NS_ASSERT_MSG (tcbd != 0, "tcb is not a QuicSocketState");
 
-  tcbd->m_largestAckedPacket = SequenceNumber32 (
-    ack.GetLargestAcknowledged ());
-
-  // newAcks are ordered from the highest packet number to the smalles
-  Ptr<QuicSocketTxItem> lastAcked = newAcks.at (0);
+  tcbd->m_largestAckedPacket = ackEvent.m_largestAcked;
 
   NS_LOG_LOGIC ("Updating RTT estimate");
   // If the largest acked is newly acked, update the RTT.
-  if (lastAcked->m_packetNumber == tcbd->m_largestAckedPacket)
+  if (!ackEvent.m_rttSample.IsZero ())
     {
-      tcbd->m_lastRtt = Now () - lastAcked->m_lastSent;
-      UpdateRtt (tcbd, tcbd->m_lastRtt, Time (ack.GetAckDelay ()));
+      tcbd->m_lastRtt = ackEvent.m_rttSample;
+      UpdateRtt (tcbd, tcbd->m_lastRtt, ackEvent.m_ackDelay);
     }
 
   NS_LOG_LOGIC ("Processing acknowledged packets");
-  // Process each acked packet
-  for (auto it = newAcks.rbegin (); it != newAcks.rend (); ++it)
+  if (ackEvent.m_ackElicitingAcked > 0)
     {
-      if ((*it)->m_acked)
-        {
-          OnPacketAcked (tcb, (*it));
-        }
+      OnPacketsAcked (tcb, ackEvent);
     }
 }
 
@@ -166,26 +185,26 @@ QuicCongestionOps::UpdateRtt (Ptr<TcpSocketState> tcb, Time latestRtt,
     {
       Time rttVarSample = Time (
         std::abs ((tcbd->m_smoothedRtt - latestRtt).GetDouble ()));
-      tcbd->m_rttVar = 3 / 4 * tcbd->m_rttVar + 1 / 4 * rttVarSample;
-      tcbd->m_smoothedRtt = 7 / 8 * tcbd->m_smoothedRtt + 1 / 8 * latestRtt;
+      tcbd->m_rttVar = (3 * tcbd->m_rttVar + rttVarSample) / 4;
+      tcbd->m_smoothedRtt = (7 * tcbd->m_smoothedRtt + latestRtt) / 8;
     }
 
 }
 
 void
-QuicCongestionOps::OnPacketAcked (Ptr<TcpSocketState> tcb,
-                                  Ptr<QuicSocketTxItem> ackedPacket)
+QuicCongestionOps::OnPacketsAcked (Ptr<TcpSocketState> tcb,
+                                   const QuicAckEvent &ackEvent)
 {
   NS_LOG_FUNCTION (this);
   Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
   NS_ASSERT_MSG (tcbd != 0, "tcb is not a QuicSocketState");
 
-  OnPacketAckedCC (tcbd, ackedPacket);
+  OnPacketsAckedCC (tcbd, ackEvent);
 
   NS_LOG_LOGIC ("Handle possible RTO");
   // If a packet sent prior to RTO was acked, then the RTO  was spurious. Otherwise, inform congestion control.
   if (tcbd->m_rtoCount > 0
-      and ackedPacket->m_packetNumber > tcbd->m_largestSentBeforeRto)
+      and ackEvent.m_largestNewlyAcked > tcbd->m_largestSentBeforeRto)
     {
       OnRetransmissionTimeoutVerified (tcb);
     }
@@ -206,32 +225,53 @@ QuicCongestionOps::InRecovery (Ptr<TcpSocketState> tcb,
 }
 
 void
-QuicCongestionOps::OnPacketAckedCC (Ptr<TcpSocketState> tcb,
-                                    Ptr<QuicSocketTxItem> ackedPacket)
+QuicCongestionOps::OnPacketsAckedCC (Ptr<TcpSocketState> tcb,
+                                     const QuicAckEvent &ackEvent)
 {
   NS_LOG_FUNCTION (this);
   Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
   NS_ASSERT_MSG (tcbd != 0, "tcb is not a QuicSocketState");
 
   NS_LOG_INFO ("Updating congestion window");
-  if (InRecovery (tcb, ackedPacket->m_packetNumber))
+  if (InRecovery (tcb, ackEvent.m_largestNewlyAcked))
     {
       NS_LOG_LOGIC ("In recovery");
       // Do not increase congestion window in recovery period.
       return;
     }
+
+  uint32_t ackedBytes = ackEvent.m_ackedBytes;
+  if (InRecovery (tcb, ackEvent.m_smallestNewlyAcked) && ackEvent.m_newAcks != 0)
+    {
+      // The ACK ends the recovery period: only count the packets sent after it
+      ackedBytes = 0;
+      for (const Ptr<QuicSocketTxItem> &item : *ackEvent.m_newAcks)
+        {
+          if (InRecovery (tcb, item->m_packetNumber))
+            {
+              break;
+            }
+          if (item->m_acked)
+            {
+              ackedBytes += item->m_packet->GetSize ();
+            }
+        }
+    }
+
   if (tcbd->m_cWnd < tcbd->m_ssThresh)
     {
       NS_LOG_LOGIC ("In slow start");
       // Slow start.
-      tcbd->m_cWnd += ackedPacket->m_packet->GetSize ();
+      uint32_t increase = std::min (ackedBytes, tcbd->m_ssThresh.Get () - tcbd->m_cWnd.Get ());
+      tcbd->m_cWnd += increase;
+      ackedBytes -= increase;
     }
-  else
+  if (ackedBytes > 0)
     {
       NS_LOG_LOGIC ("In congestion avoidance");
       // Congestion Avoidance.
       if (tcbd->m_cWnd > (uint32_t) 0) {
-          tcbd->m_cWnd += tcbd->m_segmentSize * ackedPacket->m_packet->GetSize ()
+          tcbd->m_cWnd += tcbd->m_segmentSize * ackedBytes
               / tcbd->m_cWnd;
       } else {
           tcbd->m_cWnd = tcbd->m_kMinimumWindow;
@@ -241,17 +281,19 @@ QuicCongestionOps::OnPacketAckedCC (Ptr<TcpSocketState> tcb,
 
 void
 QuicCongestionOps::OnPacketsLost (
-  Ptr<TcpSocketState> tcb, std::vector<Ptr<QuicSocketTxItem> > lostPackets)
+  Ptr<TcpSocketState> tcb, const std::vector<Ptr<QuicSocketTxItem> > &lostPackets)
 {
   NS_LOG_LOGIC (this);
   Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
   NS_ASSERT_MSG (tcbd != 0, "tcb is not a QuicSocketState");
 
-  auto largestLostPacket = *(lostPackets.end () - 1);
+  Ptr<QuicSocketTxItem> largestLostPacket = lostPackets.back ();
 
   NS_LOG_INFO ("Go in recovery mode");
   // Start a new recovery epoch if the lost packet is larger than the end of the previous recovery epoch.
-  if (!InRecovery (tcbd, largestLostPacket->m_packetNumber))
+  bool newEpoch = !InRecovery (tcbd, largestLostPacket->m_packetNumber);
+  SaveUndoState (tcbd, lostPackets, newEpoch);
+  if (newEpoch)
     {
       tcbd->m_endOfRecovery = tcbd->m_highTxMark;
       tcbd->m_cWnd *= tcbd->m_kLossReductionFactor;
@@ -263,6 +305,68 @@ QuicCongestionOps::OnPacketsLost (
     }
 }
 
+void
+QuicCongestionOps::OnPersistentCongestion (Ptr<TcpSocketState> tcb)
+{
+  NS_LOG_FUNCTION (this);
+  // the collapse of the window is never undone
+  m_undoLost = 0;
+  OnRetransmissionTimeoutVerified (tcb);
+}
+
+void
+QuicCongestionOps::OnSpuriousLoss (Ptr<TcpSocketState> tcb,
+                                   SequenceNumber32 packetNumber)
+{
+  NS_LOG_FUNCTION (this << packetNumber);
+
+  // Only the losses of the current recovery epoch count
+  if (m_undoLost == 0 or packetNumber < m_undoFloor
+      or !InRecovery (tcb, packetNumber))
+    {
+      return;
+    }
+  if (--m_undoLost == 0)
+    {
+      NS_LOG_INFO ("All the losses of the recovery epoch were spurious, undo");
+      UndoRecovery (tcb);
+      m_undoCount++;
+    }
+}
+
+void
+QuicCongestionOps::SaveUndoState (Ptr<TcpSocketState> tcb,
+                                  const std::vector<Ptr<QuicSocketTxItem> > &lostPackets,
+                                  bool newEpoch)
+{
+  NS_LOG_FUNCTION (this << newEpoch);
+  Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
+  NS_ASSERT_MSG (tcbd != 0, "tcb is not a QuicSocketState");
+
+  if (newEpoch)
+    {
+      m_undoCWnd = tcbd->m_cWnd;
+      m_undoSsThresh = tcbd->m_ssThresh;
+      m_undoEndOfRecovery = tcbd->m_endOfRecovery;
+      m_undoFloor = lostPackets.front ()->m_packetNumber;
+      m_undoLost = 0;
+    }
+  m_undoFloor = std::min (m_undoFloor, lostPackets.front ()->m_packetNumber);
+  m_undoLost += lostPackets.size ();
+}
+
+void
+QuicCongestionOps::UndoRecovery (Ptr<TcpSocketState> tcb)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
+  NS_ASSERT_MSG (tcbd != 0, "tcb is not a QuicSocketState");
+
+  tcbd->m_cWnd = std::max (tcbd->m_cWnd.Get (), m_undoCWnd);
+  tcbd->m_ssThresh = std::max (tcbd->m_ssThresh.Get (), m_undoSsThresh);
+  tcbd->m_endOfRecovery = m_undoEndOfRecovery;
+}
+
 void
 QuicCongestionOps::OnRetransmissionTimeoutVerified (
   Ptr<TcpSocketState> tcb)
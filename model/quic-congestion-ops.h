@@ -43,6 +43,32 @@ namespace ns3 {
  * The various congestion control algorithms.
  */
 
+/**
+ * \ingroup congestionOps
+ *
+ * \brief Summary of the processing of a received ACK frame
+ *
+ * The socket fills the summary once per ACK frame, so that the congestion
+ * control can update its state once per frame instead of once per
+ * acknowledged packet. The aggregate quantities only account for the newly
+ * acknowledged packets which left the sent list (i.e., with m_acked set),
+ * which are the ones that grow the congestion window.
+ */
+struct QuicAckEvent
+{
+  QuicAckEvent ();
+
+  SequenceNumber32 m_largestAcked;          //!< Largest packet number acknowledged by the frame
+  SequenceNumber32 m_largestNewlyAcked;     //!< Largest newly acknowledged packet number
+  SequenceNumber32 m_smallestNewlyAcked;    //!< Smallest newly acknowledged packet number
+  uint32_t m_ackedBytes;                    //!< Bytes of the newly acknowledged packets
+  uint32_t m_ackElicitingAcked;             //!< Number of newly acknowledged (ack-eliciting) packets
+  uint32_t m_lostBytes;                     //!< Bytes declared lost while processing the frame
+  Time m_rttSample;                         //!< RTT sample, zero if the largest acknowledged is not newly acked
+  Time m_ackDelay;                          //!< ACK delay reported by the peer
+  const std::vector<Ptr<QuicSocketTxItem> > *m_newAcks; //!< Newly acknowledged packets, from the highest packet number (not owned)
+};
+
 /**
  * \ingroup congestionOps
  *
@@ -101,11 +127,10 @@ public:
    *   the quantities in the tcb.
    *
    * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
-   * \param ack the received ACK
-   * \param newAcks the newly acked packets
+   * \param ackEvent the summary of the received ACK frame
    * \param rs the connection RateSample
    */
-  virtual void OnAckReceived (Ptr<TcpSocketState> tcb, QuicSubheader &ack, std::vector<Ptr<QuicSocketTxItem> > newAcks,
+  virtual void OnAckReceived (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent,
                               const struct RateSample *rs);
 
   /**
@@ -115,7 +140,24 @@ public:
    * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
    * \param lostPackets the lost packets
    */
-  virtual void OnPacketsLost (Ptr<TcpSocketState> tcb, std::vector<Ptr<QuicSocketTxItem> > lostPackets);
+  virtual void OnPacketsLost (Ptr<TcpSocketState> tcb, const std::vector<Ptr<QuicSocketTxItem> > &lostPackets);
+
+  /**
+   * \brief Method called when the lost packets declare persistent congestion (RFC 9002, Sec. 7.6).
+   *   It reduces the congestion window as after a verified retransmission timeout.
+   *
+   * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
+   */
+  virtual void OnPersistentCongestion (Ptr<TcpSocketState> tcb);
+
+  /**
+   * \brief Method called when a packet declared lost is acknowledged. When all the losses
+   *   of the recovery epoch are spurious, the window reduction is undone.
+   *
+   * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
+   * \param packetNumber the packet number of the spuriously lost packet
+   */
+  void OnSpuriousLoss (Ptr<TcpSocketState> tcb, SequenceNumber32 packetNumber);
 
 protected:
   // QuicCongestionControl Draft10
@@ -130,13 +172,13 @@ protected:
   void UpdateRtt (Ptr<TcpSocketState> tcb, Time latestRtt, Time ackDelay);
 
   /**
-   * \brief Method called when a packet is acked. It process the acked packet and updates
+   * \brief Method called when packets are acked. It process the acked packets and updates
    *   the quantities in the tcb.
    *
    * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
-   * \param ackedPacked the acked packet
+   * \param ackEvent the summary of the received ACK frame
    */
-  virtual void OnPacketAcked (Ptr<TcpSocketState> tcb, Ptr<QuicSocketTxItem> ackedPacket);
+  virtual void OnPacketsAcked (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent);
 
   /**
    * \brief Check if in recovery period
@@ -148,12 +190,12 @@ protected:
   bool InRecovery (Ptr<TcpSocketState> tcb, SequenceNumber32 packetNumber);
 
   /**
-   * \brief Method called when a packet is acked. It updates the quantities in the tcb.
+   * \brief Method called when packets are acked. It updates the quantities in the tcb.
    *
    * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
-   * \param ackedPacked the acked packet
+   * \param ackEvent the summary of the received ACK frame
    */
-  void OnPacketAckedCC (Ptr<TcpSocketState> tcb, Ptr<QuicSocketTxItem> ackedPacket);
+  void OnPacketsAckedCC (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent);
 
   /**
    * \brief Method called when retransmission timeout fires. It updates the quantities in the tcb.
@@ -162,6 +204,31 @@ protected:
    */
   virtual void OnRetransmissionTimeoutVerified (Ptr<TcpSocketState> tcb);
 
+  /**
+   * \brief Count the lost packets of the recovery epoch, and save the window
+   *   when a new epoch starts, so that the reduction can be undone
+   *
+   * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
+   * \param lostPackets the lost packets
+   * \param newEpoch true if the losses start a new recovery epoch
+   */
+  void SaveUndoState (Ptr<TcpSocketState> tcb, const std::vector<Ptr<QuicSocketTxItem> > &lostPackets,
+                      bool newEpoch);
+
+  /**
+   * \brief Method called when all the losses of the recovery epoch are spurious.
+   *   It restores the window saved at the start of the epoch.
+   *
+   * \param tcb a smart pointer to the SocketState (it accepts a QuicSocketState)
+   */
+  virtual void UndoRecovery (Ptr<TcpSocketState> tcb);
+
+  uint32_t m_undoCWnd;                   //!< Congestion window before the recovery epoch
+  uint32_t m_undoSsThresh;               //!< Slow start threshold before the recovery epoch
+  SequenceNumber32 m_undoEndOfRecovery;  //!< End of the previous recovery epoch
+  SequenceNumber32 m_undoFloor;          //!< Smallest packet number lost in the recovery epoch
+  uint32_t m_undoLost;                   //!< Losses of the recovery epoch not found spurious yet
+  TracedValue<uint32_t> m_undoCount;     //!< Number of recovery epochs undone
 };
 
 }
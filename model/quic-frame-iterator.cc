@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "quic-frame-iterator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QuicFrameIterator");
+
+QuicFrameIterator::QuicFrameIterator (Ptr<Packet> packet)
+  : m_packet (packet)
+{
+}
+
+bool
+QuicFrameIterator::HasNext () const
+{
+  return m_packet != nullptr and m_packet->GetSize () > 0;
+}
+
+Ptr<Packet>
+QuicFrameIterator::Next (QuicSubheader &sub)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (HasNext ());
+
+  m_packet->RemoveHeader (sub);
+  uint32_t length = sub.GetLength ();
+  NS_LOG_INFO ("subheader " << sub << " remaining " << m_packet->GetSize () << " frame size " << length);
+  NS_ASSERT_MSG (length <= m_packet->GetSize (), "Frame exceeds the packet boundary");
+
+  Ptr<Packet> payload;
+  if (length == 0)
+    {
+      payload = Create<Packet> ();
+    }
+  else if (length == m_packet->GetSize ())
+    {
+      // last frame, hand over the packet
+      payload = m_packet;
+      m_packet = nullptr;
+    }
+  else
+    {
+      payload = m_packet->CreateFragment (0, length);
+      m_packet->RemoveAtStart (length);
+    }
+
+  return payload;
+}
+
+} // namespace ns3
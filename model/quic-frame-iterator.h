@@ -0,0 +1,73 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUICFRAMEITERATOR_H
+#define QUICFRAMEITERATOR_H
+
+#include "ns3/packet.h"
+#include "quic-subheader.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup quic
+ *
+ * \brief Iterator over the frames aggregated in a received QUIC packet
+ *
+ * The iterator takes ownership of the packet and consumes it: the subheader
+ * of each frame is removed from the front of the packet, and the frame
+ * payload is returned as a fragment that shares the packet buffer. The
+ * payload of the last frame is the remainder of the packet itself, so that
+ * the common case of a packet with a single frame involves no packet copy.
+ * Frames without payload get an empty packet, which does not touch the
+ * received packet at all.
+ */
+class QuicFrameIterator
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param packet the received packet, without the QUIC header; it must not
+   *        be used by the caller afterwards
+   */
+  QuicFrameIterator (Ptr<Packet> packet);
+
+  /**
+   * \brief Check if there are frames left in the packet
+   *
+   * \return true if Next can be called
+   */
+  bool HasNext () const;
+
+  /**
+   * \brief Extract the next frame
+   *
+   * The returned payload is owned by the caller, and it can be stored
+   * (e.g., in a reception buffer) without being copied.
+   *
+   * \param sub the subheader of the frame
+   * \return the payload of the frame
+   */
+  Ptr<Packet> Next (QuicSubheader &sub);
+
+private:
+  Ptr<Packet> m_packet;  //!< The unparsed part of the packet
+};
+
+} // namespace ns3
+
+#endif /* QUIC_FRAME_ITERATOR_H */
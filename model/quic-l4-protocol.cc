@@ -26,6 +26,7 @@
 #include "ns3/log.h"
 #include "ns3/nstime.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 #include "ns3/object-vector.h"
 #include "ns3/pointer.h"
 
@@ -138,6 +139,11 @@ QuicL4Protocol::GetTypeId (void)
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QuicL4Protocol::m_quicUdpBindingList),
                    MakeObjectVectorChecker<QuicUdpBinding> ())
+    .AddAttribute ("RcvBufBudget",
+                   "Memory (bytes) shared by the streams of the node to grow their receive windows",
+                   UintegerValue (67108864), // 64M
+                   MakeUintegerAccessor (&QuicL4Protocol::m_rcvBufBudget),
+                   MakeUintegerChecker<uint64_t> ())
     /*.AddAttribute ("AuthAddresses", "The list of Authenticated addresses associated to this protocol.",
                                            ObjectVectorValue (),
                                            MakeObjectVectorAccessor (&QuicL4Protocol::m_authAddresses),
@@ -150,6 +156,7 @@ QuicL4Protocol::QuicL4Protocol ()
   : m_node (0),
   m_0RTTHandshakeStart (false),
   m_isServer (false),
+  m_rcvBufReserved (0),
   m_endPoints (new Ipv4EndPointDemux ()),
   m_endPoints6 (new Ipv6EndPointDemux ())
 {
@@ -163,6 +170,8 @@ QuicL4Protocol::~QuicL4Protocol ()
 {
   NS_LOG_FUNCTION (this);
   m_quicUdpBindingList.clear ();
+  m_connIdIndex.clear ();
+  m_socketIndex.clear ();
 }
 
 void
@@ -180,17 +189,12 @@ QuicL4Protocol::UdpBind (Ptr<QuicSocketBase> socket)
   NS_LOG_FUNCTION (this << socket);
 
   int res = -1;
-  QuicUdpBindingList::iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (socket));
+  if (item != nullptr and item->m_budpSocket == nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == socket and item->m_budpSocket == nullptr)
-        {
-          Ptr<Socket> udpSocket = CreateUdpSocket ();
-          res = udpSocket->Bind ();
-          item->m_budpSocket = udpSocket;
-          break;
-        }
+      Ptr<Socket> udpSocket = CreateUdpSocket ();
+      res = udpSocket->Bind ();
+      item->m_budpSocket = udpSocket;
     }
 
   return res;
@@ -202,17 +206,12 @@ QuicL4Protocol::UdpBind6 (Ptr<QuicSocketBase> socket)
   NS_LOG_FUNCTION (this << socket);
 
   int res = -1;
-  QuicUdpBindingList::iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (socket));
+  if (item != nullptr and item->m_budpSocket6 == nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == socket and item->m_budpSocket6 == nullptr)
-        {
-          Ptr<Socket> udpSocket6 = CreateUdpSocket6 ();
-          res = udpSocket6->Bind ();
-          item->m_budpSocket6 = udpSocket6;
-          break;
-        }
+      Ptr<Socket> udpSocket6 = CreateUdpSocket6 ();
+      res = udpSocket6->Bind ();
+      item->m_budpSocket6 = udpSocket6;
     }
 
   return res;
@@ -224,36 +223,25 @@ QuicL4Protocol::UdpBind (const Address &address, Ptr<QuicSocketBase> socket)
   NS_LOG_FUNCTION (this << address << socket);
 
   int res = -1;
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (socket));
   if (InetSocketAddress::IsMatchingType (address))
     {
-      QuicUdpBindingList::iterator it;
-      for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+      if (item != nullptr and item->m_budpSocket == nullptr)
         {
-          Ptr<QuicUdpBinding> item = *it;
-          if (item->m_quicSocket == socket and item->m_budpSocket == nullptr)
-            {
-              Ptr<Socket> udpSocket = CreateUdpSocket ();
-              res = udpSocket->Bind (address);
-              item->m_budpSocket = udpSocket;
-              break;
-            }
+          Ptr<Socket> udpSocket = CreateUdpSocket ();
+          res = udpSocket->Bind (address);
+          item->m_budpSocket = udpSocket;
         }
 
       return res;
     }
   else if (Inet6SocketAddress::IsMatchingType (address))
     {
-      QuicUdpBindingList::iterator it;
-      for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+      if (item != nullptr and item->m_budpSocket6 == nullptr)
         {
-          Ptr<QuicUdpBinding> item = *it;
-          if (item->m_quicSocket == socket and item->m_budpSocket6 == nullptr)
-            {
-              Ptr<Socket> udpSocket6 = CreateUdpSocket ();
-              res = udpSocket6->Bind (address);
-              item->m_budpSocket6 = udpSocket6;
-              break;
-            }
+          Ptr<Socket> udpSocket6 = CreateUdpSocket ();
+          res = udpSocket6->Bind (address);
+          item->m_budpSocket6 = udpSocket6;
         }
 
       return res;
@@ -269,14 +257,10 @@ QuicL4Protocol::UdpConnect (const Address & address, Ptr<QuicSocketBase> socket)
     {
       UdpBind (address, socket);
 
-      QuicUdpBindingList::iterator it;
-      for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+      Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (socket));
+      if (item != nullptr)
         {
-          Ptr<QuicUdpBinding> item = *it;
-          if (item->m_quicSocket == socket)
-            {
-              return item->m_budpSocket->Connect (address);
-            }
+          return item->m_budpSocket->Connect (address);
         }
 
       NS_LOG_INFO ("UDP Socket: Connecting");
@@ -286,14 +270,10 @@ QuicL4Protocol::UdpConnect (const Address & address, Ptr<QuicSocketBase> socket)
     {
       UdpBind (address, socket);
 
-      QuicUdpBindingList::iterator it;
-      for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+      Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (socket));
+      if (item != nullptr)
         {
-          Ptr<QuicUdpBinding> item = *it;
-          if (item->m_quicSocket == socket)
-            {
-              return item->m_budpSocket6->Connect (address);
-            }
+          return item->m_budpSocket6->Connect (address);
         }
       NS_LOG_INFO ("UDP Socket: Connecting");
 
@@ -323,14 +303,10 @@ QuicL4Protocol::GetTxAvailable (Ptr<QuicSocketBase> quicSocket) const
 {
   NS_LOG_FUNCTION (this);
 
-  QuicUdpBindingList::const_iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (quicSocket));
+  if (item != nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == quicSocket)
-        {
-          return item->m_budpSocket->GetTxAvailable ();
-        }
+      return item->m_budpSocket->GetTxAvailable ();
     }
   return 0;
 }
@@ -340,14 +316,10 @@ QuicL4Protocol::GetRxAvailable (Ptr<QuicSocketBase> quicSocket) const
 {
   NS_LOG_FUNCTION (this);
 
-  QuicUdpBindingList::const_iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (quicSocket));
+  if (item != nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == quicSocket)
-        {
-          return item->m_budpSocket->GetRxAvailable ();
-        }
+      return item->m_budpSocket->GetRxAvailable ();
     }
   return 0;
 }
@@ -357,14 +329,10 @@ QuicL4Protocol::GetSockName (const ns3::QuicSocketBase* quicSocket, Address &add
 {
   NS_LOG_FUNCTION (this);
 
-  QuicUdpBindingList::const_iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (quicSocket);
+  if (item != nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == quicSocket)
-        {
-          return item->m_budpSocket->GetSockName (address);
-        }
+      return item->m_budpSocket->GetSockName (address);
     }
 
   return -1;
@@ -375,14 +343,10 @@ QuicL4Protocol::GetPeerName (const ns3::QuicSocketBase* quicSocket, Address &add
 {
   NS_LOG_FUNCTION (this);
 
-  QuicUdpBindingList::const_iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (quicSocket);
+  if (item != nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == quicSocket)
-        {
-          return item->m_budpSocket->GetPeerName (address);
-        }
+      return item->m_budpSocket->GetPeerName (address);
     }
 
   return -1;
@@ -393,14 +357,10 @@ QuicL4Protocol::BindToNetDevice (Ptr<QuicSocketBase> quicSocket, Ptr<NetDevice>
 {
   NS_LOG_FUNCTION (this);
 
-  QuicUdpBindingList::iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (quicSocket));
+  if (item != nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == quicSocket)
-        {
-          item->m_budpSocket->BindToNetDevice (netdevice);
-        }
+      item->m_budpSocket->BindToNetDevice (netdevice);
     }
 }
 
@@ -411,9 +371,17 @@ QuicL4Protocol::SetListener (Ptr<QuicSocketBase> sock)
 
   if (sock != nullptr and m_quicUdpBindingList.size () == 1)
     {
+      Ptr<QuicUdpBinding> listener = m_quicUdpBindingList.front ();
       m_isServer = true;
-      m_quicUdpBindingList.front ()->m_quicSocket = sock;
-      m_quicUdpBindingList.front ()->m_listenerBinding = true;
+      if (listener->m_quicSocket != sock)
+        {
+          m_socketIndex.erase (PeekPointer (listener->m_quicSocket));
+          m_connIdIndex.erase (listener->m_quicSocket->GetConnectionId ());
+          listener->m_quicSocket = sock;
+          m_socketIndex[PeekPointer (sock)] = listener;
+          m_connIdIndex.emplace (sock->GetConnectionId (), listener);
+        }
+      listener->m_listenerBinding = true;
       return true;
     }
 
@@ -477,17 +445,7 @@ QuicL4Protocol::ForwardUp (Ptr<Socket> sock)
                           " if source and destination IP address and port are sufficient to identify a connection");
         }
 
-      QuicUdpBindingList::iterator it;
-      Ptr<QuicSocketBase> socket;
-      for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
-        {
-          Ptr<QuicUdpBinding> item = *it;
-          if (item->m_quicSocket->GetConnectionId () == connectionId)
-            {
-              socket = item->m_quicSocket;
-              break;
-            }
-        }
+      Ptr<QuicSocketBase> socket = LookupSocket (connectionId);
 
       NS_LOG_LOGIC ((socket == nullptr));
       /*NS_LOG_INFO ("Initial " << header.IsInitial ());
@@ -500,8 +458,7 @@ QuicL4Protocol::ForwardUp (Ptr<Socket> sock)
       if (header.IsInitial () and m_isServer and socket == nullptr)
         {
           NS_LOG_LOGIC (this << " Cloning listening socket " << m_quicUdpBindingList.front ()->m_quicSocket);
-          socket = CloneSocket (m_quicUdpBindingList.front ()->m_quicSocket);
-          socket->SetConnectionId (connectionId);
+          socket = CloneSocket (m_quicUdpBindingList.front ()->m_quicSocket, connectionId);
           socket->Connect (from);
           socket->SetupCallback ();
 
@@ -536,8 +493,7 @@ QuicL4Protocol::ForwardUp (Ptr<Socket> sock)
           NS_LOG_LOGIC ("CONNECTION AUTHENTICATED - Server authenticated Client " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
                         InetSocketAddress::ConvertFrom (from).GetPort () << "");
           NS_LOG_LOGIC ( this << " Cloning listening socket " << m_quicUdpBindingList.front ()->m_quicSocket);
-          socket = CloneSocket (m_quicUdpBindingList.front ()->m_quicSocket);
-          socket->SetConnectionId (connectionId);
+          socket = CloneSocket (m_quicUdpBindingList.front ()->m_quicSocket, connectionId);
           socket->Connect (from);
           socket->SetupCallback ();
 
@@ -559,10 +515,11 @@ QuicL4Protocol::ForwardUp (Ptr<Socket> sock)
         }
 
       // Handle callback for the correct socket
-      if (!m_socketHandlers[socket].IsNull ())
+      Ptr<QuicUdpBinding> binding = FindBinding (PeekPointer (socket));
+      if (binding != nullptr and !binding->m_recvCallback.IsNull ())
         {
           NS_LOG_LOGIC (this << " waking up handler of socket " << socket);
-          m_socketHandlers[socket] (packet, header, from);
+          binding->m_recvCallback (packet, header, from);
         }
       else
         {
@@ -576,25 +533,29 @@ QuicL4Protocol::SetRecvCallback (Callback<void, Ptr<Packet>, const QuicHeader&,
 {
   NS_LOG_FUNCTION (this);
 
-  m_socketHandlers.insert ( std::pair< Ptr<Socket>, Callback<void, Ptr<Packet>, const QuicHeader&, Address& > > (sock,handler));
-  QuicUdpBindingList::iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (DynamicCast<QuicSocketBase> (sock)));
+  if (item == nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == sock && item->m_budpSocket)
-        {
-          item->m_budpSocket->SetRecvCallback (MakeCallback (&QuicL4Protocol::ForwardUp, this));
-          break;
-        }
-      else if (item->m_quicSocket == sock && item->m_budpSocket6)
-        {
-          item->m_budpSocket6->SetRecvCallback (MakeCallback (&QuicL4Protocol::ForwardUp, this));
-          break;
-        }
-      else if (item->m_quicSocket == sock)
-        {
-          NS_FATAL_ERROR ("The UDP socket for this QuicUdpBinding item is not set");
-        }
+      NS_LOG_WARN (this << " no QuicUdpBinding for socket " << sock);
+      return;
+    }
+
+  if (item->m_recvCallback.IsNull ())
+    {
+      item->m_recvCallback = handler;
+    }
+
+  if (item->m_budpSocket)
+    {
+      item->m_budpSocket->SetRecvCallback (MakeCallback (&QuicL4Protocol::ForwardUp, this));
+    }
+  else if (item->m_budpSocket6)
+    {
+      item->m_budpSocket6->SetRecvCallback (MakeCallback (&QuicL4Protocol::ForwardUp, this));
+    }
+  else
+    {
+      NS_FATAL_ERROR ("The UDP socket for this QuicUdpBinding item is not set");
     }
 }
 
@@ -629,6 +590,8 @@ QuicL4Protocol::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_quicUdpBindingList.clear ();
+  m_connIdIndex.clear ();
+  m_socketIndex.clear ();
 
   m_node = 0;
 //  m_downTarget.Nullify ();
@@ -637,21 +600,83 @@ QuicL4Protocol::DoDispose (void)
 }
 
 Ptr<QuicSocketBase>
-QuicL4Protocol::CloneSocket (Ptr<QuicSocketBase> oldsock)
+QuicL4Protocol::CloneSocket (Ptr<QuicSocketBase> oldsock, uint64_t connectionId)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << connectionId);
   Ptr<QuicSocketBase> newsock = CopyObject<QuicSocketBase> (oldsock);
   NS_LOG_LOGIC (this << " cloned socket " << oldsock << " to socket " << newsock);
+  newsock->SetConnectionId (connectionId);
   Ptr<QuicUdpBinding> udpBinding = CreateObject<QuicUdpBinding> ();
   udpBinding->m_budpSocket = nullptr;
   udpBinding->m_budpSocket6 = nullptr;
   udpBinding->m_quicSocket = newsock;
-  m_quicUdpBindingList.insert (m_quicUdpBindingList.end (), udpBinding);
+  AddBinding (udpBinding);
 
   return newsock;
 }
 
+void
+QuicL4Protocol::AddBinding (Ptr<QuicUdpBinding> binding)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (binding->m_quicSocket != nullptr);
+
+  m_quicUdpBindingList.insert (m_quicUdpBindingList.end (), binding);
+  m_socketIndex[PeekPointer (binding->m_quicSocket)] = binding;
+  // on a (very unlikely) connection ID collision, the oldest binding keeps the
+  // ID, as with the linear scan of the binding list
+  m_connIdIndex.emplace (binding->m_quicSocket->GetConnectionId (), binding);
+}
+
+Ptr<QuicUdpBinding>
+QuicL4Protocol::FindBinding (const QuicSocketBase* socket) const
+{
+  QuicUdpBindingSocketMap::const_iterator it = m_socketIndex.find (socket);
+  if (it == m_socketIndex.end ())
+    {
+      return nullptr;
+    }
+  return it->second;
+}
+
+Ptr<QuicSocketBase>
+QuicL4Protocol::LookupSocket (uint64_t connectionId) const
+{
+  QuicUdpBindingConnIdMap::const_iterator it = m_connIdIndex.find (connectionId);
+  if (it == m_connIdIndex.end ())
+    {
+      return nullptr;
+    }
+  return it->second->m_quicSocket;
+}
+
+
 
+uint32_t
+QuicL4Protocol::ReserveRcvBuf (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+
+  uint64_t left = (m_rcvBufReserved < m_rcvBufBudget) ? m_rcvBufBudget - m_rcvBufReserved : 0;
+  uint32_t granted = std::min<uint64_t> (size, left);
+  m_rcvBufReserved += granted;
+  NS_LOG_INFO ("Granted " << granted << " bytes, " << m_rcvBufReserved << " of " << m_rcvBufBudget << " reserved");
+  return granted;
+}
+
+void
+QuicL4Protocol::ReleaseRcvBuf (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (size <= m_rcvBufReserved);
+  m_rcvBufReserved -= size;
+}
+
+uint64_t
+QuicL4Protocol::GetRcvBufReserved () const
+{
+  return m_rcvBufReserved;
+}
 
 Ptr<Socket>
 QuicL4Protocol::CreateSocket ()
@@ -686,28 +711,19 @@ QuicL4Protocol::CreateSocket (TypeId congestionTypeId)
   // sockets associated to this L4 protocol
   Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
 
-  bool found = false;
   uint64_t connectionId;
-  while (not found)
+  do
     {
       connectionId = uint64_t (rand->GetValue (0, pow (2, 64) - 1));
-      found = true;
-      for (auto it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
-        {
-          found = false;
-          if (connectionId == (*it)->m_quicSocket->GetConnectionId ())
-            {
-              break;
-            }
-          found = true;
-        }
     }
+  while (m_connIdIndex.find (connectionId) != m_connIdIndex.end ());
+
   socket->SetConnectionId (connectionId);
   Ptr<QuicUdpBinding> udpBinding = Create<QuicUdpBinding> ();
   udpBinding->m_budpSocket = nullptr;
   udpBinding->m_budpSocket6 = nullptr;
   udpBinding->m_quicSocket = socket;
-  m_quicUdpBindingList.insert (m_quicUdpBindingList.end (), udpBinding);
+  AddBinding (udpBinding);
 
   return socket;
 }
@@ -798,15 +814,10 @@ QuicL4Protocol::SendPacket (Ptr<QuicSocketBase> socket, Ptr<Packet> pkt, const Q
   //packetSent->Print (std::clog);
   // NS_LOG_INFO ("");
 
-  QuicUdpBindingList::const_iterator it;
-  for (it = m_quicUdpBindingList.begin (); it != m_quicUdpBindingList.end (); ++it)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (socket));
+  if (item != nullptr)
     {
-      Ptr<QuicUdpBinding> item = *it;
-      if (item->m_quicSocket == socket)
-        {
-          UdpSend (item->m_budpSocket, packetSent, 0);
-          break;
-        }
+      UdpSend (item->m_budpSocket, packetSent, 0);
     }
 }
 
@@ -820,20 +831,24 @@ QuicL4Protocol::RemoveSocket (Ptr<QuicSocketBase> socket)
   bool found = false;
   bool closedListener = false;
 
-  for (iter = m_quicUdpBindingList.begin (); iter != m_quicUdpBindingList.end (); ++iter)
+  Ptr<QuicUdpBinding> item = FindBinding (PeekPointer (socket));
+  if (item != nullptr)
     {
-      Ptr<QuicUdpBinding> item = *iter;
-      if (item->m_quicSocket == socket)
-        {
-          found = true;
-          if (item->m_listenerBinding)
-            {
-              closedListener = true;
-            }
-          m_quicUdpBindingList.erase (iter);
+      found = true;
+      closedListener = item->m_listenerBinding;
 
-          break;
+      m_socketIndex.erase (PeekPointer (socket));
+      QuicUdpBindingConnIdMap::iterator idIt = m_connIdIndex.find (socket->GetConnectionId ());
+      if (idIt != m_connIdIndex.end () and idIt->second == item)
+        {
+          m_connIdIndex.erase (idIt);
         }
+
+      // the binding list keeps the creation order (it is exposed through the
+      // SocketList attribute), so the erase is linear, but only on teardown
+      iter = std::find (m_quicUdpBindingList.begin (), m_quicUdpBindingList.end (), item);
+      NS_ASSERT (iter != m_quicUdpBindingList.end ());
+      m_quicUdpBindingList.erase (iter);
     }
 
   //if closing the listener, close all the clone ones
@@ -27,6 +27,7 @@
 
 #include <stdint.h>
 #include <map>
+#include <unordered_map>
 #include "ns3/node.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
@@ -61,6 +62,7 @@ public:
   Ptr<Socket> m_budpSocket6;         //!< The IPv6 UDP this binding is associated with
   Ptr<QuicSocketBase> m_quicSocket;  //!< The quic socket associated with this binding
   bool m_listenerBinding;            //!< A flag that indicates if in this binding resides the listening socket
+  Callback<void, Ptr<Packet>, const QuicHeader&, Address& > m_recvCallback;  //!< Callback handler for the quic socket
 };
 
 /**
@@ -267,6 +269,17 @@ public:
    */
   void SendPacket (Ptr<QuicSocketBase> socket, Ptr<Packet> pkt, const QuicHeader &outgoing) const;
 
+  /**
+   * \brief Get the socket associated with a connection ID
+   *
+   * The lookup is performed on the connection ID index, hence it does not
+   * depend on the number of sockets associated with this protocol
+   *
+   * \param connectionId the connection ID
+   * \return a smart pointer to the socket, or 0 if no socket uses connectionId
+   */
+  Ptr<QuicSocketBase> LookupSocket (uint64_t connectionId) const;
+
   /**
    * \brief Remove a socket (and its clones if it is a listener)
    *  If no sockets are left, close the UDP connection
@@ -276,6 +289,30 @@ public:
    */
   bool RemoveSocket (Ptr<QuicSocketBase> socket);
 
+  /**
+   * \brief Reserve receive buffer memory for the flow-control autotuning of a stream
+   *
+   * The memory is taken from the budget shared by all the sockets of the node
+   *
+   * \param size the number of bytes requested
+   * \return the number of bytes granted, smaller than size if the budget is exhausted
+   */
+  uint32_t ReserveRcvBuf (uint32_t size);
+
+  /**
+   * \brief Give back receive buffer memory to the budget of the node
+   *
+   * \param size the number of bytes previously granted by ReserveRcvBuf
+   */
+  void ReleaseRcvBuf (uint32_t size);
+
+  /**
+   * \brief Get the receive buffer memory currently reserved by the autotuning
+   *
+   * \return the number of reserved bytes
+   */
+  uint64_t GetRcvBufReserved () const;
+
   /**
    * \brief Set the listener QuicSocketBase
    *
@@ -421,24 +458,45 @@ protected:
 
 private:
   typedef std::vector< Ptr<QuicUdpBinding> > QuicUdpBindingList;  //!< container for the QuicUdp bindings
+  typedef std::unordered_map<uint64_t, Ptr<QuicUdpBinding> > QuicUdpBindingConnIdMap;  //!< index of the QuicUdp bindings by connection ID
+  typedef std::unordered_map<const QuicSocketBase*, Ptr<QuicUdpBinding> > QuicUdpBindingSocketMap;  //!< index of the QuicUdp bindings by QUIC socket
 
   /**
    * \brief Clone a QuicSocket and add it to the list of sockets associated to this protocol
    *
    * \param sock a smart pointer to the socket to be cloned
+   * \param connectionId the connection ID of the new socket
    * \return a smart pointer to the new cloned socket
    */
-  Ptr<QuicSocketBase> CloneSocket (Ptr<QuicSocketBase> oldsock);
+  Ptr<QuicSocketBase> CloneSocket (Ptr<QuicSocketBase> oldsock, uint64_t connectionId);
+
+  /**
+   * \brief Append a binding to the list and add it to the indexes
+   *
+   * \param binding a smart pointer to the binding, with the QUIC socket already set
+   */
+  void AddBinding (Ptr<QuicUdpBinding> binding);
+
+  /**
+   * \brief Find the binding of a QUIC socket
+   *
+   * \param socket the QUIC socket
+   * \return a smart pointer to the binding, or 0 if the socket is not bound
+   */
+  Ptr<QuicUdpBinding> FindBinding (const QuicSocketBase* socket) const;
 
   Ptr<Node> m_node;           //!< The node this stack is associated with
   TypeId m_rttTypeId;         //!< The type of RttEstimator objects
   TypeId m_congestionTypeId;  //!< The socket type of QUIC objects
   bool m_0RTTHandshakeStart;  //!< A flag indicating if the L4 Protocol allows the 0-RTT Hansdhake start
-  std::map <Ptr<Socket>, Callback<void, Ptr<Packet>, const QuicHeader&, Address& > > m_socketHandlers;  //!< Callback handlers for sockets
 
   std::vector<Address > m_authAddresses;    //!< Authenticated addresses for this L4 Protocol
   QuicUdpBindingList m_quicUdpBindingList;  //!< List of QuicUdp bindings
+  QuicUdpBindingConnIdMap m_connIdIndex;    //!< QuicUdp bindings indexed by connection ID (demultiplexing)
+  QuicUdpBindingSocketMap m_socketIndex;    //!< QuicUdp bindings indexed by QUIC socket (multiplexing)
   bool m_isServer;                          //!< A flag indicating if the L4 Protocol is server
+  uint64_t m_rcvBufBudget;                  //!< Receive buffer memory available to the autotuning of the node
+  uint64_t m_rcvBufReserved;                //!< Receive buffer memory reserved by the autotuning
 
   Ipv4EndPointDemux *m_endPoints;   //!< A list of IPv4 end points.
   Ipv6EndPointDemux *m_endPoints6;  //!< A list of IPv6 end points.
@@ -45,6 +45,7 @@
 #include "quic-socket-factory.h"
 #include "quic-socket-base.h"
 #include "quic-stream-base.h"
+#include "quic-frame-iterator.h"
 
 namespace ns3 {
 
@@ -89,6 +90,30 @@ QuicL5Protocol::~QuicL5Protocol ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+QuicL5Protocol::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (auto stream : m_streams)
+    {
+      stream->Dispose ();
+    }
+  m_streams.clear ();
+  m_socket = 0;
+  m_node = 0;
+  Object::DoDispose ();
+}
+
+void
+QuicL5Protocol::ReleaseRcvBuf ()
+{
+  NS_LOG_FUNCTION (this);
+  for (auto stream : m_streams)
+    {
+      stream->ReleaseRcvBuf ();
+    }
+}
+
 void
 QuicL5Protocol::CreateStream (
   const QuicStreamBase::QuicStreamDirectionTypes_t streamDirectionType)
@@ -173,7 +198,7 @@ QuicL5Protocol::DispatchSend (Ptr<Packet> data)
   int sentData = 0;
 
   // if the streams are not created yet, open the streams
-  if (m_streams.size () != m_socket->GetMaxStreamId ())
+  if (m_streams.size () <= m_socket->GetMaxStreamId ())
     {
       NS_LOG_INFO ("Create the missing streams");
       CreateStream (QuicStream::SENDER, m_socket->GetMaxStreamId ());   // TODO open up to max_stream_uni and max_stream_bidi
@@ -222,13 +247,14 @@ QuicL5Protocol::DispatchSend (Ptr<Packet> data, uint64_t streamId)
   if (stream == nullptr)
     {
       CreateStream (QuicStream::SENDER, streamId);
+      stream = SearchStream (streamId);
     }
 
-  stream = SearchStream (streamId);
   int sentData = 0;
 
-  if (stream->GetStreamDirectionType () == QuicStream::SENDER
-      or stream->GetStreamDirectionType () == QuicStream::BIDIRECTIONAL)
+  if (stream != nullptr
+      and (stream->GetStreamDirectionType () == QuicStream::SENDER
+           or stream->GetStreamDirectionType () == QuicStream::BIDIRECTIONAL))
     {
       sentData = stream->Send (data);
     }
@@ -253,7 +279,7 @@ QuicL5Protocol::DispatchRecv (Ptr<Packet> data, Address &address)
     }
 
   bool onlyAckFrames = true;
-  uint64_t currStreamNum = m_streams.size () - 1;
+  uint64_t currStreamNum = 0;
   for (auto &elem : disgregated)
     {
       QuicSubheader sub = elem.second;
@@ -270,7 +296,11 @@ QuicL5Protocol::DispatchRecv (Ptr<Packet> data, Address &address)
         }
     }
 
-  CreateStream (QuicStream::RECEIVER, currStreamNum);
+  // open the streams implicitly opened by the peer, if any
+  if (currStreamNum >= m_streams.size ())
+    {
+      CreateStream (QuicStream::RECEIVER, currStreamNum);
+    }
 
   for (auto it = disgregated.begin (); it != disgregated.end (); ++it)
     {
@@ -278,7 +308,7 @@ QuicL5Protocol::DispatchRecv (Ptr<Packet> data, Address &address)
 
       if (sub.IsRstStream () or sub.IsMaxStreamData ()
           or sub.IsStreamBlocked () or sub.IsStopSending ()
-          or sub.IsStream ())
+          or sub.IsStream () or sub.IsExpiredStreamData ())
         {
           Ptr<QuicStreamBase> stream = SearchStream (sub.GetStreamId ());
 
@@ -365,49 +395,34 @@ QuicL5Protocol::DisgregateRecv (Ptr<Packet> data)
 {
   NS_LOG_FUNCTION (this);
 
-  uint32_t dataSizeByte = data->GetSize ();
   std::vector< std::pair<Ptr<Packet>, QuicSubheader> > disgregated;
-  NS_LOG_INFO ("DisgregateRecv for a packet with size " << dataSizeByte);
-  //data->Print(std::cout);
+  NS_LOG_INFO ("DisgregateRecv for a packet with size " << data->GetSize ());
 
   // the packet could contain multiple frames
   // each of them starts with a subheader
-  // cycle through the data packet and extract the frames
-  for (uint32_t start = 0; start < dataSizeByte; )
+  // the frames are extracted without copying the packet data
+  QuicFrameIterator frames (data);
+  while (frames.HasNext ())
     {
       QuicSubheader sub;
-      data->RemoveHeader (sub);
-      NS_LOG_INFO ("subheader " << sub << " dataSizeByte " << dataSizeByte
-                                << " remaining " << data->GetSize () << " frame size " << sub.GetLength ());
-      Ptr<Packet> remainingfragment = data->CreateFragment (0, sub.GetLength ());
-      NS_LOG_INFO ("fragment size " << remainingfragment->GetSize ());
-
-      // remove the first portion of the packet
-      data->RemoveAtStart (sub.GetLength ());
-      start += sub.GetSerializedSize () + sub.GetLength ();
-      disgregated.push_back (std::make_pair (remainingfragment, sub));
+      Ptr<Packet> payload = frames.Next (sub);
+      disgregated.push_back (std::make_pair (payload, sub));
     }
 
-
   return disgregated;
 }
 
 Ptr<QuicStreamBase>
 QuicL5Protocol::SearchStream (uint64_t streamId)
 {
-  NS_LOG_FUNCTION (this);
-  std::vector<Ptr<QuicStreamBase> >::iterator it = m_streams.begin ();
-  Ptr<QuicStreamBase> stream;
-  while (it != m_streams.end ())
+  NS_LOG_FUNCTION (this << streamId);
+  // streams are created in order, so the stream ID is the index in m_streams
+  if (streamId < m_streams.size ())
     {
-      if ((*it)->GetStreamId () == streamId)
-        {
-          stream = *it;
-          break;
-        }
-      ++it;
+      NS_ASSERT (m_streams[streamId]->GetStreamId () == streamId);
+      return m_streams[streamId];
     }
-  return stream;
+  return nullptr;
 }
 
 void
@@ -451,6 +466,19 @@ QuicL5Protocol::SignalAbortConnection (uint16_t transportErrorCode,
   m_socket->AbortConnection (transportErrorCode, reasonPhrase);
 }
 
+void
+QuicL5Protocol::SignalStreamBlocked (uint64_t streamId, uint64_t limit)
+{
+  NS_LOG_FUNCTION (this << streamId << limit);
+  m_socket->OnStreamBlocked (streamId, limit);
+}
+
+Time
+QuicL5Protocol::GetSmoothedRtt () const
+{
+  return m_socket->GetSmoothedRtt ();
+}
+
 void
 QuicL5Protocol::UpdateInitialMaxStreamData (uint32_t newMaxStreamData)
 {
@@ -479,5 +507,65 @@ QuicL5Protocol::GetMaxData ()
   return maxData;
 }
 
+void
+QuicL5Protocol::OnAckedStreamData (uint64_t streamId, uint64_t offset, uint32_t length)
+{
+  NS_LOG_FUNCTION (this << streamId << offset << length);
+
+  Ptr<QuicStreamBase> stream = SearchStream (streamId);
+  if (stream != nullptr)
+    {
+      stream->OnAckedData (offset, length);
+    }
+}
+
+bool
+QuicL5Protocol::OnLostStreamData (uint64_t streamId, uint64_t offset, uint32_t length,
+                                  std::vector<QuicStreamTxRange> &ranges)
+{
+  NS_LOG_FUNCTION (this << streamId << offset << length);
+
+  Ptr<QuicStreamBase> stream = SearchStream (streamId);
+  if (stream == nullptr)
+    {
+      return false;
+    }
+  ranges = stream->OnLostData (offset, length);
+  return true;
+}
+
+Ptr<Packet>
+QuicL5Protocol::OnLostControlFrames (Ptr<Packet> frames)
+{
+  NS_LOG_FUNCTION (this << frames);
+
+  Ptr<Packet> refreshed = Create<Packet> ();
+  QuicFrameIterator it (frames->Copy ());
+  while (it.HasNext ())
+    {
+      QuicSubheader sub;
+      Ptr<Packet> frame = it.Next (sub);
+      if (sub.IsMaxData ())
+        {
+          sub = QuicSubheader::CreateMaxData (std::max (sub.GetMaxData (), GetMaxData ()));
+        }
+      else if (sub.IsMaxStreamData ())
+        {
+          Ptr<QuicStreamBase> stream = SearchStream (sub.GetStreamId ());
+          if (stream != nullptr)
+            {
+              uint64_t maxStreamData = std::max<uint64_t> (sub.GetMaxStreamData (),
+                                                           stream->SendMaxStreamData ());
+              sub = QuicSubheader::CreateMaxStreamData (sub.GetStreamId (), maxStreamData);
+            }
+        }
+      frame->AddHeader (sub);
+      refreshed->AddAtEnd (frame);
+    }
+  NS_LOG_INFO ("Lost control frames of size " << frames->GetSize () << " sent again with size "
+                                              << refreshed->GetSize ());
+  return refreshed;
+}
+
 } // namespace ns3
 
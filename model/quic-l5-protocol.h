@@ -25,9 +25,11 @@
 #ifndef QUICL5PROTOCOL_H
 #define QUICL5PROTOCOL_H
 
+#include "ns3/nstime.h"
 #include "quic-transport-parameters.h"
 #include "quic-stream.h"
 #include "quic-subheader.h"
+#include "quic-stream-tx-buffer.h"
 
 
 namespace ns3 {
@@ -70,6 +72,11 @@ public:
   QuicL5Protocol ();
   virtual ~QuicL5Protocol ();
 
+  /**
+   * \brief Return the receive buffer memory reserved by the streams to the node budget
+   */
+  void ReleaseRcvBuf ();
+
   /**
    * \brief Set the Quic Socket associated with this stack
    *
@@ -164,8 +171,11 @@ public:
   /**
    * \brief get the stream associated to the ID
    *
+   * Streams are created in increasing ID order, so the lookup is a direct
+   * access to the stream table.
+   *
    * \param streamId the ID of the stream
-   * \return a smart pointer to the stream object
+   * \return a smart pointer to the stream object, or 0 if the stream has not been created
    */
   Ptr<QuicStreamBase> SearchStream (uint64_t streamId);
 
@@ -214,6 +224,21 @@ public:
    */
   void SignalAbortConnection (uint16_t transportErrorCode, const char* reasonPhrase);
 
+  /**
+   * \brief Notify the QUIC socket that a stream has data to send but no flow-control credit
+   *
+   * \param streamId the ID of the blocked stream
+   * \param limit the MAX_STREAM_DATA limit that blocks the stream
+   */
+  void SignalStreamBlocked (uint64_t streamId, uint64_t limit);
+
+  /**
+   * \brief Get the smoothed RTT of the connection
+   *
+   * \return the smoothed RTT, zero before the first sample
+   */
+  Time GetSmoothedRtt () const;
+
   /**
    * \brief Propagate the updated max stream data values to all the streams
    *
@@ -228,11 +253,47 @@ public:
    */
   uint64_t GetMaxData ();
 
+  /**
+   * \brief Notify a stream that some of its data has been acknowledged
+   *
+   * \param streamId the ID of the stream
+   * \param offset the offset of the acknowledged data
+   * \param length the length of the acknowledged data
+   */
+  void OnAckedStreamData (uint64_t streamId, uint64_t offset, uint32_t length);
+
+  /**
+   * \brief Notify a stream that some of its data has been lost
+   *
+   * \param streamId the ID of the stream
+   * \param offset the offset of the lost data
+   * \param length the length of the lost data
+   * \param ranges filled with the lost data that is still missing
+   * \return false if the stream does not exist
+   */
+  bool OnLostStreamData (uint64_t streamId, uint64_t offset, uint32_t length,
+                         std::vector<QuicStreamTxRange> &ranges);
+
+  /**
+   * \brief Refresh the frames of a lost control packet
+   *
+   * MAX_DATA and MAX_STREAM_DATA frames carry the latest limits, as the
+   * values they advertised when first sent may be stale. The other frames
+   * are sent again unchanged, in the same order.
+   *
+   * \param frames the lost control frames
+   * \return the frames to send again
+   */
+  Ptr<Packet> OnLostControlFrames (Ptr<Packet> frames);
+
+protected:
+  virtual void DoDispose (void);
+
 private:
   Ptr<QuicSocketBase> m_socket;                 //!< The Quic socket this stack is associated with
   Ptr<Node> m_node;                             //!< The node this stack is associated with
   uint64_t m_connectionId;                      //!< The connection id this stack is associated with
-  std::vector<Ptr<QuicStreamBase> > m_streams;  //!< The streams this stack is associated with
+  std::vector<Ptr<QuicStreamBase> > m_streams;  //!< The streams this stack is associated with, indexed by stream ID
 };
 
 } // namespace ns3
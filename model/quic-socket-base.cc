@@ -122,7 +122,8 @@ QuicSocketBase::GetTypeId (void)
                    MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("MaxTrackedGaps", "Maximum number of gaps in an ACK",
                    UintegerValue (20),
-                   MakeUintegerAccessor (&QuicSocketBase::m_maxTrackedGaps),
+                   MakeUintegerAccessor (&QuicSocketBase::GetMaxTrackedGaps,
+                                         &QuicSocketBase::SetMaxTrackedGaps),
                    MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("OmitConnectionId", "Omit ConnectionId field in Short QuicHeader format",
                    BooleanValue (false),
@@ -165,7 +166,7 @@ QuicSocketBase::GetTypeId (void)
                    MakeUintegerAccessor (&QuicSocketState::m_kReorderingThreshold),
                    MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("kTimeReorderingFraction", "Maximum reordering in time space before time based loss detection considers a packet lost",
-                   DoubleValue (9 / 8),
+                   DoubleValue (9.0 / 8),
                    MakeDoubleAccessor (&QuicSocketState::m_kTimeReorderingFraction),
                    MakeDoubleChecker<double> (0))
     .AddAttribute ("kUsingTimeLossDetection", "Whether time based loss detection is in use", 
@@ -211,6 +212,16 @@ QuicSocketBase::GetTypeId (void)
                    TimeValue (MilliSeconds (100)),
                    MakeTimeAccessor (&QuicSocketBase::m_defaultLatency),
                    MakeTimeChecker ())
+    .AddAttribute ("MinAckDelay",
+                   "Minimum ACK delay advertised to the peer for the ACK frequency extension (0 to disable it)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&QuicSocketBase::m_minAckDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("AckFrequencyRatio",
+                   "Number of ACKs requested to a peer that supports ACK_FREQUENCY for each congestion window",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&QuicSocketBase::m_ackFrequencyRatio),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("LegacyCongestionControl", "When true, use TCP implementations for the congestion control",
                    BooleanValue (false),
                    MakeBooleanAccessor (&QuicSocketBase::m_quicCongestionControlLegacy),
@@ -289,6 +300,26 @@ QuicSocketBase::GetTypeId (void)
                      "Receive QUIC packet from UDP protocol",
                      MakeTraceSourceAccessor (&QuicSocketBase::m_rxTrace),
                      "ns3::QuicSocketBase::QuicTxRxTracedCallback")
+    .AddTraceSource ("DeadlineMiss",
+                     "Stream frame dropped by the scheduler after its deadline",
+                     MakeTraceSourceAccessor (&QuicSocketBase::m_deadlineMissTrace),
+                     "ns3::QuicSocketBase::DeadlineMissTracedCallback")
+    .AddTraceSource ("Blocked",
+                     "Data waiting for connection-level flow-control credit",
+                     MakeTraceSourceAccessor (&QuicSocketBase::m_blockedTrace),
+                     "ns3::QuicSocketBase::BlockedTracedCallback")
+    .AddTraceSource ("StreamBlocked",
+                     "Data waiting for stream-level flow-control credit",
+                     MakeTraceSourceAccessor (&QuicSocketBase::m_streamBlockedTrace),
+                     "ns3::QuicSocketBase::StreamBlockedTracedCallback")
+    .AddTraceSource ("SpuriousLoss",
+                     "Packet declared lost and acknowledged afterwards",
+                     MakeTraceSourceAccessor (&QuicSocketBase::m_spuriousLossTrace),
+                     "ns3::QuicSocketBase::SpuriousLossTracedCallback")
+    .AddTraceSource ("ReorderingThreshold",
+                     "Packet and time reordering thresholds raised after a spurious loss",
+                     MakeTraceSourceAccessor (&QuicSocketBase::m_reorderingThresholdTrace),
+                     "ns3::QuicSocketBase::ReorderingThresholdTracedCallback")
   ;
   return tid;
 }
@@ -312,13 +343,28 @@ QuicSocketState::GetTypeId (void)
                    MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("kTimeReorderingFraction",
                    "Maximum reordering in time space before time based loss detection considers a packet lost",
-                   DoubleValue (9 / 8),
+                   DoubleValue (9.0 / 8),
                    MakeDoubleAccessor (&QuicSocketState::m_kTimeReorderingFraction),
                    MakeDoubleChecker<double> (0))
     .AddAttribute ("kUsingTimeLossDetection",
                    "Whether time based loss detection is in use", BooleanValue (false),
                    MakeBooleanAccessor (&QuicSocketState::m_kUsingTimeLossDetection),
                    MakeBooleanChecker ())
+    .AddAttribute ("kUsingAdaptiveReordering",
+                   "Whether spurious losses raise the reordering thresholds and undo the congestion window reduction",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QuicSocketState::m_kUsingAdaptiveReordering),
+                   MakeBooleanChecker ())
+    .AddAttribute ("kMaxReorderingThreshold",
+                   "Upper bound of the adaptive packet reordering threshold",
+                   UintegerValue (20),
+                   MakeUintegerAccessor (&QuicSocketState::m_kMaxReorderingThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("kMaxTimeReorderingFraction",
+                   "Upper bound of the adaptive time reordering fraction",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&QuicSocketState::m_kMaxTimeReorderingFraction),
+                   MakeDoubleChecker<double> (0))
     .AddAttribute ("kMinTLPTimeout",
                    "Minimum time in the future a tail loss probe alarm may be set for",
                    TimeValue (MilliSeconds (10)),
@@ -338,11 +384,31 @@ QuicSocketState::GetTypeId (void)
                    TimeValue (MilliSeconds (100)),
                    MakeTimeAccessor (&QuicSocketState::m_kDefaultInitialRtt),
                    MakeTimeChecker ())
+    .AddAttribute ("kUsingProbeTimeout",
+                   "Whether the RFC 9002 probe timeout replaces the TLP and RTO alarms",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QuicSocketState::m_kUsingProbeTimeout),
+                   MakeBooleanChecker ())
+    .AddAttribute ("kGranularity",
+                   "Timer granularity, lower bound of the RTT variance term of the probe timeout",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&QuicSocketState::m_kGranularity),
+                   MakeTimeChecker ())
+    .AddAttribute ("kPersistentCongestionThreshold",
+                   "Number of probe timeouts without acknowledgments that declare persistent congestion",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&QuicSocketState::m_kPersistentCongestionThreshold),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("kMaxPacketsReceivedBeforeAckSend",
                    "The maximum number of packets without sending an ACK",
                    UintegerValue (20),
                    MakeUintegerAccessor (&QuicSocketState::m_kMaxPacketsReceivedBeforeAckSend),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SendQuantum",
+                   "Maximum number of bytes released at once by the pacer (0 for one packet)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&QuicSocketState::m_sendQuantum),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -371,18 +437,25 @@ QuicSocketState::QuicSocketState ()
     m_kMaxTLPs (
       2),
     m_kReorderingThreshold (3),
-    m_kTimeReorderingFraction (9 / 8),
+    m_kTimeReorderingFraction (9.0 / 8),
     m_kUsingTimeLossDetection (
       false),
+    m_kUsingAdaptiveReordering (false),
+    m_kMaxReorderingThreshold (20),
+    m_kMaxTimeReorderingFraction (2.0),
     m_kMinTLPTimeout (MilliSeconds (10)),
     m_kMinRTOTimeout (
       MilliSeconds (200)),
+    m_kUsingProbeTimeout (false),
+    m_kGranularity (MilliSeconds (1)),
+    m_kPersistentCongestionThreshold (3),
     m_kDelayedAckTimeout (MilliSeconds (25)),
     m_alarmType (0),
     m_nextAlarmTrigger (Seconds (100)),
     m_kDefaultInitialRtt (
       MilliSeconds (100)),
-    m_kMaxPacketsReceivedBeforeAckSend (20)
+    m_kMaxPacketsReceivedBeforeAckSend (20),
+    m_sendQuantum (0)
 {
   m_lossDetectionAlarm.Cancel ();
 }
@@ -395,6 +468,7 @@ QuicSocketState::QuicSocketState (const QuicSocketState &other)
     m_tlpCount (other.m_tlpCount),
     m_rtoCount (
       other.m_rtoCount),
+    m_ptoCount (other.m_ptoCount),
     m_largestSentBeforeRto (
       other.m_largestSentBeforeRto),
     m_timeOfLastSentPacket (
@@ -421,14 +495,21 @@ QuicSocketState::QuicSocketState (const QuicSocketState &other)
       other.m_kTimeReorderingFraction),
     m_kUsingTimeLossDetection (
       other.m_kUsingTimeLossDetection),
+    m_kUsingAdaptiveReordering (other.m_kUsingAdaptiveReordering),
+    m_kMaxReorderingThreshold (other.m_kMaxReorderingThreshold),
+    m_kMaxTimeReorderingFraction (other.m_kMaxTimeReorderingFraction),
     m_kMinTLPTimeout (
       other.m_kMinTLPTimeout),
     m_kMinRTOTimeout (other.m_kMinRTOTimeout),
+    m_kUsingProbeTimeout (other.m_kUsingProbeTimeout),
+    m_kGranularity (other.m_kGranularity),
+    m_kPersistentCongestionThreshold (other.m_kPersistentCongestionThreshold),
     m_kDelayedAckTimeout (
       other.m_kDelayedAckTimeout),
     m_kDefaultInitialRtt (
       other.m_kDefaultInitialRtt),
-    m_kMaxPacketsReceivedBeforeAckSend (other.m_kMaxPacketsReceivedBeforeAckSend)
+    m_kMaxPacketsReceivedBeforeAckSend (other.m_kMaxPacketsReceivedBeforeAckSend),
+    m_sendQuantum (other.m_sendQuantum)
 {
   m_lossDetectionAlarm.Cancel ();
 }
@@ -476,6 +557,8 @@ QuicSocketBase::QuicSocketBase (void)
     m_lastRtt (Seconds (0.0)),
     m_queue_ack (false),
     m_numPacketsReceivedSinceLastAckSent (0),
+    m_minAckDelay (Seconds (0)),
+    m_ackFrequencyRatio (8),
     m_pacingTimer (Timer::REMOVE_ON_DESTROY)
 {
   NS_LOG_FUNCTION (this);
@@ -483,13 +566,17 @@ QuicSocketBase::QuicSocketBase (void)
 
   m_rxBuffer = CreateObject<QuicSocketRxBuffer> ();
   m_txBuffer = CreateObject<QuicSocketTxBuffer> ();
-  m_receivedPacketNumbers = std::vector<SequenceNumber32> ();
+  m_receivedPacketNumbers = QuicAckRangeSet ();
+  m_receivedPacketNumbers.SetMaxRanges (m_maxTrackedGaps + 1);
 
   m_tcb = CreateObject<QuicSocketState> ();
   m_tcb->m_cWnd = m_tcb->m_initialCWnd;
   m_tcb->m_ssThresh = m_tcb->m_initialSsThresh;
   m_quicCongestionControlLegacy = false;
   m_txBuffer->SetQuicSocketState (m_tcb);
+  m_txBuffer->SetLostStreamDataCallback (MakeCallback (&QuicSocketBase::OnLostStreamData, this));
+  m_txBuffer->SetLostControlFramesCallback (MakeCallback (&QuicSocketBase::OnLostControlFrames, this));
+  m_txBuffer->SetExpiredStreamDataCallback (MakeCallback (&QuicSocketBase::OnExpiredStreamData, this));
 
   m_tcb->m_pacingRate = m_tcb->m_maxPacingRate;
   m_pacingTimer.SetFunction (&QuicSocketBase::NotifyPacingPerformed, this);
@@ -569,9 +656,16 @@ QuicSocketBase::QuicSocketBase (const QuicSocketBase& sock)   // Copy constructo
     m_numPacketsReceivedSinceLastAckSent (sock.m_numPacketsReceivedSinceLastAckSent),
     m_lastMaxData(0),
     m_maxDataInterval(10),
+    m_minAckDelay (sock.m_minAckDelay),
+    m_ackFrequencyRatio (sock.m_ackFrequencyRatio),
     m_pacingTimer (Timer::REMOVE_ON_DESTROY),
     m_txTrace (sock.m_txTrace),
-    m_rxTrace (sock.m_rxTrace)
+    m_rxTrace (sock.m_rxTrace),
+    m_deadlineMissTrace (sock.m_deadlineMissTrace),
+    m_blockedTrace (sock.m_blockedTrace),
+    m_streamBlockedTrace (sock.m_streamBlockedTrace),
+    m_spuriousLossTrace (sock.m_spuriousLossTrace),
+    m_reorderingThresholdTrace (sock.m_reorderingThresholdTrace)
 {
   NS_LOG_FUNCTION (this);
 
@@ -584,7 +678,8 @@ QuicSocketBase::QuicSocketBase (const QuicSocketBase& sock)   // Copy constructo
 //  SetRecvCallback (vPS);
   m_txBuffer = CopyObject (sock.m_txBuffer);
   m_rxBuffer = CopyObject (sock.m_rxBuffer);
-  m_receivedPacketNumbers = std::vector<SequenceNumber32> ();
+  m_receivedPacketNumbers = QuicAckRangeSet ();
+  m_receivedPacketNumbers.SetMaxRanges (m_maxTrackedGaps + 1);
 
   m_tcb = CopyObject (sock.m_tcb);
   if (sock.m_congestionControl)
@@ -593,6 +688,9 @@ QuicSocketBase::QuicSocketBase (const QuicSocketBase& sock)   // Copy constructo
     }
   m_quicCongestionControlLegacy = sock.m_quicCongestionControlLegacy;
   m_txBuffer->SetQuicSocketState (m_tcb);
+  m_txBuffer->SetLostStreamDataCallback (MakeCallback (&QuicSocketBase::OnLostStreamData, this));
+  m_txBuffer->SetLostControlFramesCallback (MakeCallback (&QuicSocketBase::OnLostControlFrames, this));
+  m_txBuffer->SetExpiredStreamDataCallback (MakeCallback (&QuicSocketBase::OnExpiredStreamData, this));
 
   m_tcb->m_pacingRate = m_tcb->m_maxPacingRate;
   m_pacingTimer.SetFunction (&QuicSocketBase::NotifyPacingPerformed, this);
@@ -635,6 +733,7 @@ QuicSocketBase::~QuicSocketBase (void)
   m_quicl4 = 0;
   //CancelAllTimers ();
   m_pacingTimer.Cancel ();
+  m_probeEvent.Cancel ();
 }
 
 /* Inherit from Socket class: Bind socket to an end-point in QuicL4Protocol */
@@ -977,16 +1076,11 @@ QuicSocketBase::SendPendingData (bool withAck)
   // prioritize stream 0
   while (m_txBuffer->GetNumFrameStream0InBuffer () > 0)
     {
-      // check pacing timer
-      if (m_tcb->m_pacing)
+      // check the pacer
+      if (!PacerAllowsSend ())
         {
-          NS_LOG_DEBUG ("Pacing is enabled");
-          if (m_pacingTimer.IsRunning ())
-            {
-              NS_LOG_INFO ("Skipping Packet due to pacing - for " << m_pacingTimer.GetDelayLeft ());
-              break;
-            }
-          NS_LOG_DEBUG ("Pacing Timer is not running");
+          NS_LOG_INFO ("Skipping Packet due to pacing - for " << m_pacingTimer.GetDelayLeft ());
+          break;
         }
 
       NS_LOG_DEBUG ("Send a frame for stream 0");
@@ -1018,6 +1112,32 @@ QuicSocketBase::SendPendingData (bool withAck)
 
       ++nPacketsSent;
     }
+
+  // control frames (e.g., MAX_DATA and MAX_STREAM_DATA) are not limited by
+  // the congestion window or the pacer, otherwise a peer blocked by flow
+  // control waits for data that cannot be sent
+  while (m_txBuffer->GetNumControlFramesInBuffer () > 0)
+    {
+      // check draining period
+      if (m_drainingPeriodEvent.IsRunning ())
+        {
+          NS_LOG_INFO ("Draining period: no packets can be sent");
+          return false;
+        }
+
+      // check the state of the socket!
+      if (m_socketState == CONNECTING_CLT || m_socketState == CONNECTING_SVR)
+        {
+          NS_LOG_INFO ("CONNECTING_CLT and CONNECTING_SVR state; no control frames to transmit");
+          break;
+        }
+
+      NS_LOG_DEBUG ("Send " << m_txBuffer->GetNumControlFramesInBuffer () << " control frames");
+      SequenceNumber32 next = ++m_tcb->m_nextTxSequence;
+      SendDataPacket (next, 0, withAck);
+
+      ++nPacketsSent;
+    }
   uint32_t availableWindow = AvailableWindow ();
 
   while (availableWindow > 0 and m_txBuffer->AppSize () > 0)
@@ -1029,16 +1149,11 @@ QuicSocketBase::SendPendingData (bool withAck)
           return false;
         }
 
-      // check pacing timer
-      if (m_tcb->m_pacing)
+      // check the pacer
+      if (!PacerAllowsSend ())
         {
-          NS_LOG_DEBUG ("Pacing is enabled");
-          if (m_pacingTimer.IsRunning ())
-            {
-              NS_LOG_INFO ("Skipping Packet due to pacing - for " << m_pacingTimer.GetDelayLeft ());
-              break;
-            }
-          NS_LOG_DEBUG ("Pacing Timer is not running");
+          NS_LOG_INFO ("Skipping Packet due to pacing - for " << m_pacingTimer.GetDelayLeft ());
+          break;
         }
 
       // check the state of the socket!
@@ -1094,6 +1209,16 @@ QuicSocketBase::SendPendingData (bool withAck)
       availableWindow = AvailableWindow ();
     }
 
+  // report each MAX_DATA limit that leaves data waiting once
+  uint32_t connWin = ConnectionWindow ();
+  if (m_txBuffer->AppSize () > 0 and connWin < std::min (GetSegSize (), m_txBuffer->AppSize ())
+      and m_max_data != m_blockedMaxData)
+    {
+      NS_LOG_INFO ("Connection blocked by flow control at " << m_max_data);
+      m_blockedMaxData = m_max_data;
+      m_blockedTrace (m_max_data);
+    }
+
   if (nPacketsSent > 0)
     {
       NS_LOG_INFO ("SendPendingData sent " << nPacketsSent << " packets");
@@ -1133,7 +1258,7 @@ QuicSocketBase::MaybeQueueAck ()
   NS_LOG_INFO ("m_numPacketsReceivedSinceLastAckSent " << m_numPacketsReceivedSinceLastAckSent << " m_queue_ack " << m_queue_ack);
 
   // handle the list of m_receivedPacketNumbers
-  if (m_receivedPacketNumbers.empty ())
+  if (m_receivedPacketNumbers.IsEmpty ())
     {
       NS_LOG_INFO ("Nothing to ACK");
       m_queue_ack = false;
@@ -1146,7 +1271,7 @@ QuicSocketBase::MaybeQueueAck ()
   //   return;
   // }
 
-  if (m_numPacketsReceivedSinceLastAckSent > m_tcb->m_kMaxPacketsReceivedBeforeAckSend)
+  if (m_numPacketsReceivedSinceLastAckSent > std::max<uint64_t> (m_tcb->m_kMaxPacketsReceivedBeforeAckSend, m_ackElicitingThreshold))
     {
       NS_LOG_INFO ("immediately send ACK - max number of unacked packets reached");
       m_queue_ack = true;
@@ -1159,6 +1284,18 @@ QuicSocketBase::MaybeQueueAck ()
   if (HasReceivedMissing ())  // immediately queue the ACK
     {
       NS_LOG_INFO ("immediately send ACK - some packets have been received out of order");
+      m_reorderingAcks++;
+      m_queue_ack = true;
+      if (!m_sendAckEvent.IsRunning ())
+        {
+          m_sendAckEvent = Simulator::Schedule (TimeStep (1), &QuicSocketBase::SendAck, this);
+        }
+    }
+
+  if (m_immediateAckRequested)
+    {
+      NS_LOG_INFO ("immediately send ACK - requested by the peer");
+      m_immediateAckRequested = false;
       m_queue_ack = true;
       if (!m_sendAckEvent.IsRunning ())
         {
@@ -1168,9 +1305,9 @@ QuicSocketBase::MaybeQueueAck ()
 
   if (!m_queue_ack)
     {
-      if (m_numPacketsReceivedSinceLastAckSent > 2) // QUIC decimation option
+      if (m_numPacketsReceivedSinceLastAckSent > m_ackElicitingThreshold) // QUIC decimation option, or the peer's ACK_FREQUENCY
         {
-          NS_LOG_INFO ("immediately send ACK - more than 2 packets received");
+          NS_LOG_INFO ("immediately send ACK - more than " << m_ackElicitingThreshold << " packets received");
           m_queue_ack = true;
           if (!m_sendAckEvent.IsRunning ())
             {
@@ -1183,8 +1320,8 @@ QuicSocketBase::MaybeQueueAck ()
             {
               NS_LOG_INFO ("Schedule a delayed ACK");
               // schedule a delayed ACK
-              m_delAckEvent = Simulator::Schedule (
-                m_tcb->m_kDelayedAckTimeout, &QuicSocketBase::SendAck, this);
+              Time delay = m_maxAckDelay.IsZero () ? m_tcb->m_kDelayedAckTimeout : m_maxAckDelay;
+              m_delAckEvent = Simulator::Schedule (delay, &QuicSocketBase::SendAck, this);
             }
           else
             {
@@ -1197,8 +1334,72 @@ QuicSocketBase::MaybeQueueAck ()
 bool
 QuicSocketBase::HasReceivedMissing ()
 {
-  // TODO implement this
-  return false;
+  return m_receivedPacketNumbers.HasReceivedMissing ();
+}
+
+void
+QuicSocketBase::OnReceivedAckFrequencyFrame (QuicSubheader &sub)
+{
+  NS_LOG_FUNCTION (this << sub.GetSequence () << sub.GetAckElicitingThreshold () << sub.GetRequestMaxAckDelay ());
+
+  if (m_minAckDelay.IsZero ())
+    {
+      AbortConnection (
+        QuicSubheader::TransportErrorCodes_t::PROTOCOL_VIOLATION,
+        "Received ACK_FREQUENCY without advertising a min_ack_delay");
+      return;
+    }
+
+  Time maxAckDelay = MicroSeconds (sub.GetRequestMaxAckDelay ());
+  if (maxAckDelay < m_minAckDelay)
+    {
+      AbortConnection (
+        QuicSubheader::TransportErrorCodes_t::PROTOCOL_VIOLATION,
+        "Requested max ACK delay below the advertised min_ack_delay");
+      return;
+    }
+
+  // the frames can be reordered, only the most recent one is applied
+  if (sub.GetSequence () < m_nextAckFrequencySequence)
+    {
+      NS_LOG_INFO ("Ignoring old ACK_FREQUENCY frame " << sub.GetSequence ());
+      return;
+    }
+  m_nextAckFrequencySequence = sub.GetSequence () + 1;
+  m_ackElicitingThreshold = sub.GetAckElicitingThreshold ();
+  m_maxAckDelay = maxAckDelay;
+  NS_LOG_INFO ("ACK after more than " << m_ackElicitingThreshold << " packets or " << m_maxAckDelay);
+}
+
+void
+QuicSocketBase::MaybeSendAckFrequency ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_peerMinAckDelay.IsZero () or !m_connected)
+    {
+      return;
+    }
+
+  // about m_ackFrequencyRatio ACKs per window, but not fewer packets per ACK than by default
+  uint64_t packetsPerAck = m_tcb->m_cWnd.Get () / (m_ackFrequencyRatio * GetSegSize ());
+  uint64_t threshold = std::max<uint64_t> (packetsPerAck, 3) - 1;
+
+  // avoid a frame for each small window increase, but follow reductions right away
+  if (threshold == m_sentAckElicitingThreshold
+      or (threshold > m_sentAckElicitingThreshold
+          and threshold < m_sentAckElicitingThreshold + m_sentAckElicitingThreshold / 4))
+    {
+      return;
+    }
+
+  Time maxAckDelay = std::max (m_tcb->m_kDelayedAckTimeout, m_peerMinAckDelay);
+  NS_LOG_INFO ("Request an ACK after more than " << threshold << " packets or " << maxAckDelay);
+  Ptr<Packet> frame = Create<Packet> ();
+  frame->AddHeader (QuicSubheader::CreateAckFrequency (m_ackFrequencySequence++, threshold,
+                                                       maxAckDelay.GetMicroSeconds ()));
+  AppendingTx (frame);
+  m_sentAckElicitingThreshold = threshold;
 }
 
 void
@@ -1214,6 +1415,7 @@ QuicSocketBase::SendAck ()
   Ptr<Packet> p = Create<Packet> ();
   p->AddAtEnd (OnSendingAckFrame ());
   SequenceNumber32 packetNumber = ++m_tcb->m_nextTxSequence;
+  OnAckFrameSent (packetNumber);
 
   QuicHeader head;
 
@@ -1274,11 +1476,9 @@ QuicSocketBase::SendDataPacket (SequenceNumber32 packetNumber,
 
   if (!m_drainingPeriodEvent.IsRunning ())
     {
-      m_idleTimeoutEvent.Cancel ();
       NS_LOG_LOGIC (
-        this << " SendDataPacket Schedule Close at time " << Simulator::Now ().GetSeconds () << " to expire at time " << (Simulator::Now () + m_idleTimeout.Get ()).GetSeconds ());
-      m_idleTimeoutEvent = Simulator::Schedule (m_idleTimeout,
-                                                &QuicSocketBase::Close, this);
+        this << " SendDataPacket reset idle timeout at time " << Simulator::Now ().GetSeconds () << " to expire at time " << (Simulator::Now () + m_idleTimeout.Get ()).GetSeconds ());
+      ResetIdleTimeout ();
     }
   else
     {
@@ -1293,12 +1493,17 @@ QuicSocketBase::SendDataPacket (SequenceNumber32 packetNumber,
       p = m_txBuffer->NextStream0Sequence (packetNumber);
       NS_ABORT_MSG_IF (p == 0, "No packet for stream 0 in the buffer!");
     }
+  else if (maxSize == 0 and m_txBuffer->GetNumControlFramesInBuffer () > 0)
+    {
+      // no room for data, send the control frames on their own
+      NS_LOG_LOGIC (
+        this << " SendDataPacket - sending control packet " << packetNumber.GetValue () << " at time " << Simulator::Now ().GetSeconds ());
+      p = m_txBuffer->NextControlSequence (GetSegSize (), packetNumber);
+    }
   else
     {
       NS_LOG_LOGIC (
         this << " SendDataPacket - sending packet " << packetNumber.GetValue () << " of size " << maxSize << " at time " << Simulator::Now ().GetSeconds ());
-      m_idleTimeoutEvent = Simulator::Schedule (m_idleTimeout,
-                                                &QuicSocketBase::Close, this);
       p = m_txBuffer->NextSequence (maxSize, packetNumber);
     }
 
@@ -1311,28 +1516,20 @@ QuicSocketBase::SendDataPacket (SequenceNumber32 packetNumber,
       m_tcb->m_appLimitedUntil = m_tcb->m_delivered + m_tcb->m_bytesInFlight.Get () ? : 1U;
     }
 
-  // perform pacing
+  // charge the packet to the pacer
   if (m_tcb->m_pacing)
     {
-      NS_LOG_DEBUG ("Pacing is enabled");
-      if (m_pacingTimer.IsExpired ())
-        {
-          NS_LOG_DEBUG ("Current Pacing Rate " << m_tcb->m_pacingRate);
-          NS_LOG_DEBUG ("Pacing Timer is in expired state, activate it. Expires in " <<
-                        m_tcb->m_pacingRate.Get ().CalculateBytesTxTime (sz));
-          m_pacingTimer.Schedule (m_tcb->m_pacingRate.Get ().CalculateBytesTxTime (sz));
-        }
-      else
-        {
-          NS_LOG_INFO ("Pacing Timer is already in running state");
-        }
+      m_pacingTokens -= sz;
     }
 
   bool isAckOnly = ((sz == 0) & (withAck));
 
-  if (withAck && !m_receivedPacketNumbers.empty ())
+  if (withAck && !m_receivedPacketNumbers.IsEmpty ())
     {
+      // the sent item keeps only the frames that it accounts for
+      p = p->Copy ();
       p->AddAtEnd (OnSendingAckFrame ());
+      OnAckFrameSent (packetNumber);
     }
 
 
@@ -1392,6 +1589,7 @@ QuicSocketBase::SendDataPacket (SequenceNumber32 packetNumber,
     }
   if (!isAckOnly)
     {
+      m_lastAckElicitingSent = Simulator::Now ();
       SetReTxTimeout ();
     }
 
@@ -1412,14 +1610,28 @@ QuicSocketBase::SetReTxTimeout ()
       return;
     }
 
-  if (m_tcb->m_kUsingTimeLossDetection)
-    {
-      m_tcb->m_lossTime = Simulator::Now () + m_tcb->m_kTimeReorderingFraction * m_tcb->m_smoothedRtt;
-    }
+  // the earliest time at which an outstanding packet crosses the time
+  // threshold, zero without time-based loss detection - RFC 9002, Sec. 6.1.2
+  m_tcb->m_lossTime = m_txBuffer->GetLossTime ();
 
   Time alarmDuration;
+  bool handshake = (m_socketState == CONNECTING_CLT || m_socketState == CONNECTING_SVR);
+  if (m_tcb->m_kUsingProbeTimeout and m_tcb->m_lossTime == Seconds (0))
+    {
+      // the handshake keeps the alarm armed, so that lost handshake packets are probed
+      if (BytesInFlight () == 0 and !handshake)
+        {
+          NS_LOG_INFO ("No ack-eliciting packets in flight, cancel the alarm");
+          m_tcb->m_lossDetectionAlarm.Cancel ();
+          return;
+        }
+      // Probe timeout, from the last ack-eliciting packet - RFC 9002, Sec. 6.2.1
+      Time expiration = m_lastAckElicitingSent + GetProbeTimeout (handshake);
+      alarmDuration = std::max (expiration - Simulator::Now (), Seconds (0));
+      m_tcb->m_alarmType = 4;
+    }
   // Handshake packets are outstanding
-  if (m_socketState == CONNECTING_CLT || m_socketState == CONNECTING_SVR)
+  else if (handshake)
     {
       NS_LOG_INFO ("Connecting, set alarm");
       // Handshake retransmission alarm.
@@ -1433,14 +1645,14 @@ QuicSocketBase::SetReTxTimeout ()
         }
       alarmDuration = std::max (alarmDuration + m_tcb->m_maxAckDelay,
                                 m_tcb->m_kMinTLPTimeout);
-      alarmDuration = alarmDuration * (2 ^ m_tcb->m_handshakeCount);
+      alarmDuration = alarmDuration * (1 << std::min (m_tcb->m_handshakeCount, 16U));
       m_tcb->m_alarmType = 0;
     }
   else if (m_tcb->m_lossTime != Seconds (0))
     {
       NS_LOG_INFO ("Early retransmit timer");
       // Early retransmit timer or time loss detection.
-      alarmDuration = m_tcb->m_lossTime - m_tcb->m_timeOfLastSentPacket;
+      alarmDuration = std::max (m_tcb->m_lossTime - Simulator::Now (), Seconds (0));
       m_tcb->m_alarmType = 1;
     }
   else if (m_tcb->m_tlpCount < m_tcb->m_kMaxTLPs)
@@ -1448,7 +1660,7 @@ QuicSocketBase::SetReTxTimeout ()
       NS_LOG_LOGIC ("m_tcb->m_tlpCount < m_tcb->m_kMaxTLPs");
       // Tail Loss Probe
       alarmDuration = std::max (
-        (3 / 2) * m_tcb->m_smoothedRtt + m_tcb->m_maxAckDelay,
+        3 * m_tcb->m_smoothedRtt / 2 + m_tcb->m_maxAckDelay,
         m_tcb->m_kMinTLPTimeout);
       m_tcb->m_alarmType = 2;
     }
@@ -1458,14 +1670,60 @@ QuicSocketBase::SetReTxTimeout ()
       alarmDuration = m_tcb->m_smoothedRtt + 4 * m_tcb->m_rttVar
         + m_tcb->m_maxAckDelay;
       alarmDuration = std::max (alarmDuration, m_tcb->m_kMinRTOTimeout);
-      alarmDuration = alarmDuration * (2 ^ m_tcb->m_rtoCount);
+      alarmDuration = alarmDuration * (1 << std::min (m_tcb->m_rtoCount, 16U));
       m_tcb->m_alarmType = 3;
     }
   NS_LOG_INFO ("Schedule ReTxTimeout at time " << Simulator::Now ().GetSeconds () << " to expire at time " << (Simulator::Now () + alarmDuration).GetSeconds ());
   NS_LOG_INFO ("Alarm after " << alarmDuration.GetSeconds () << " seconds");
+  m_tcb->m_nextAlarmTrigger = Simulator::Now () + alarmDuration;
+
+  // a pending alarm that expires earlier re-arms itself in ReTxTimeout,
+  // so a new event is only needed if the alarm has to fire sooner
+  if (m_tcb->m_lossDetectionAlarm.IsRunning ()
+      and Simulator::GetDelayLeft (m_tcb->m_lossDetectionAlarm) <= alarmDuration)
+    {
+      return;
+    }
+  m_tcb->m_lossDetectionAlarm.Cancel ();
   m_tcb->m_lossDetectionAlarm = Simulator::Schedule (alarmDuration,
                                                      &QuicSocketBase::ReTxTimeout, this);
-  m_tcb->m_nextAlarmTrigger = Simulator::Now () + alarmDuration;
+}
+
+void
+QuicSocketBase::ResetIdleTimeout ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_lastActivityTime = Simulator::Now ();
+
+  // the pending event is only replaced if it would expire too late, i.e.,
+  // if the idle timeout was reduced (e.g., by the peer transport parameters)
+  if (m_idleTimeoutEvent.IsRunning ()
+      and Simulator::GetDelayLeft (m_idleTimeoutEvent) <= m_idleTimeout.Get ())
+    {
+      return;
+    }
+  m_idleTimeoutEvent.Cancel ();
+  m_idleTimeoutEvent = Simulator::Schedule (m_idleTimeout,
+                                            &QuicSocketBase::IdleTimeout, this);
+}
+
+void
+QuicSocketBase::IdleTimeout ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Time expiration = m_lastActivityTime + m_idleTimeout.Get ();
+  if (Simulator::Now () < expiration)
+    {
+      NS_LOG_LOGIC (this << " Activity since the idle timer was armed, re-arm it to expire at time " << expiration.GetSeconds ());
+      m_idleTimeoutEvent = Simulator::Schedule (expiration - Simulator::Now (),
+                                                &QuicSocketBase::IdleTimeout, this);
+      return;
+    }
+
+  NS_LOG_INFO (this << " Idle timeout expired at time " << Simulator::Now ().GetSeconds ());
+  Close ();
 }
 
 void
@@ -1473,9 +1731,15 @@ QuicSocketBase::DoRetransmit (std::vector<Ptr<QuicSocketTxItem> > lostPackets)
 {
   NS_LOG_FUNCTION (this);
   // Get packets to retransmit
-  SequenceNumber32 next = ++m_tcb->m_nextTxSequence;
+  SequenceNumber32 next = m_tcb->m_nextTxSequence.Get () + 1;
   uint32_t toRetx = m_txBuffer->Retransmission (next);
   NS_LOG_INFO (toRetx << " bytes to retransmit");
+  if (toRetx == 0)
+    {
+      NS_LOG_INFO ("The lost data has already been acknowledged");
+      return;
+    }
+  m_tcb->m_nextTxSequence = next;
   NS_LOG_DEBUG ("Send the retransmitted frame");
   uint32_t win = AvailableWindow ();
   uint32_t connWin = ConnectionWindow ();
@@ -1492,12 +1756,57 @@ QuicSocketBase::DoRetransmit (std::vector<Ptr<QuicSocketTxItem> > lostPackets)
   SendDataPacket (next, toRetx, m_connected);
 }
 
+bool
+QuicSocketBase::OnLostStreamData (uint64_t streamId, uint64_t offset, uint32_t length,
+                                  std::vector<QuicStreamTxRange> &ranges)
+{
+  NS_LOG_FUNCTION (this << streamId << offset << length);
+  if (m_quicl5 == 0)
+    {
+      return false;
+    }
+  return m_quicl5->OnLostStreamData (streamId, offset, length, ranges);
+}
+
+Ptr<Packet>
+QuicSocketBase::OnLostControlFrames (Ptr<Packet> frames)
+{
+  NS_LOG_FUNCTION (this << frames);
+  if (m_quicl5 == 0)
+    {
+      return frames;
+    }
+  return m_quicl5->OnLostControlFrames (frames);
+}
+
+void
+QuicSocketBase::OnExpiredStreamData (uint64_t streamId, uint64_t offset, uint32_t length, bool fin)
+{
+  NS_LOG_FUNCTION (this << streamId << offset << length << fin);
+  if (m_quicl5 == 0)
+    {
+      return;
+    }
+  // the abandoned data is handled as acknowledged, so that it is never retransmitted
+  m_quicl5->OnAckedStreamData (streamId, offset, length);
+
+  uint32_t misses = ++m_deadlineMisses[streamId];
+  NS_LOG_INFO ("Deadline miss " << misses << " on stream " << streamId << ", skipping offsets " << offset << " to " << offset + length);
+  m_deadlineMissTrace (streamId, misses);
+
+  Ptr<Packet> frame = Create<Packet> ();
+  frame->AddHeader (QuicSubheader::CreateExpiredStreamData (streamId, offset, length, fin));
+  AppendingTx (frame);
+}
+
 void
 QuicSocketBase::ReTxTimeout ()
 {
   if (Simulator::Now () < m_tcb->m_nextAlarmTrigger)
     {
-      NS_LOG_INFO ("Canceled alarm");
+      NS_LOG_INFO ("Alarm postponed to time " << m_tcb->m_nextAlarmTrigger.GetSeconds ());
+      m_tcb->m_lossDetectionAlarm = Simulator::Schedule (m_tcb->m_nextAlarmTrigger - Simulator::Now (),
+                                                         &QuicSocketBase::ReTxTimeout, this);
       return;
     }
   NS_LOG_FUNCTION (this);
@@ -1512,10 +1821,15 @@ QuicSocketBase::ReTxTimeout ()
     }
   else if (m_tcb->m_alarmType == 1 && m_tcb->m_lossTime != Seconds (0))
     {
-      std::vector<Ptr<QuicSocketTxItem> > lostPackets = m_txBuffer->DetectLostPackets ();
       NS_LOG_INFO ("RTO triggered: early retransmit");
       // Early retransmit or Time Loss Detection.
-      if (m_quicCongestionControlLegacy)
+      m_txBuffer->OnLossTimeout (m_tcb);
+      std::vector<Ptr<QuicSocketTxItem> > lostPackets = m_txBuffer->DetectLostPackets ();
+      if (lostPackets.empty ())
+        {
+          NS_LOG_INFO ("No packet crossed the time threshold");
+        }
+      else if (m_quicCongestionControlLegacy)
         {
           // TCP early retransmit logic [RFC 5827]: enter recovery (RFC 6675, Sec. 5)
           if (m_tcb->m_congState != TcpSocketState::CA_RECOVERY)
@@ -1534,8 +1848,11 @@ QuicSocketBase::ReTxTimeout ()
           Ptr<QuicCongestionOps> cc = dynamic_cast<QuicCongestionOps*> (&(*m_congestionControl));
           cc->OnPacketsLost (m_tcb, lostPackets);
         }
+      MaybePersistentCongestion (lostPackets);
       // Retransmit all lost packets immediately
       DoRetransmit (lostPackets);
+      // arm the alarm for the next loss time, or for a probe
+      SetReTxTimeout ();
     }
   else if (m_tcb->m_alarmType == 2 && m_tcb->m_tlpCount < m_tcb->m_kMaxTLPs)
     {
@@ -1547,6 +1864,14 @@ QuicSocketBase::ReTxTimeout ()
       // cancel pacing to send packet immediately
       m_pacingTimer.Cancel ();
 
+      // a peer that acknowledges less often must not delay the ACK of the probe
+      if (!m_peerMinAckDelay.IsZero ())
+        {
+          Ptr<Packet> frame = Create<Packet> ();
+          frame->AddHeader (QuicSubheader::CreateImmediateAck ());
+          m_txBuffer->Add (frame);
+        }
+
       SendDataPacket (next, s, m_connected);
       m_tcb->m_tlpCount++;
     }
@@ -1577,6 +1902,163 @@ QuicSocketBase::ReTxTimeout ()
 
       m_tcb->m_rtoCount++;
     }
+  else if (m_tcb->m_alarmType == 4)
+    {
+      // Probe timeout - RFC 9002, Sec. 6.2.4
+      NS_LOG_INFO ("PTO triggered, count " << m_tcb->m_ptoCount);
+      m_tcb->m_ptoCount++;
+      if (m_socketState == CONNECTING_CLT || m_socketState == CONNECTING_SVR)
+        {
+          // the handshake data is sent again, as for the Initial and Handshake spaces
+          m_txBuffer->ResetSentList (0);
+          DoRetransmit (m_txBuffer->DetectLostPackets ());
+        }
+      else
+        {
+          // send two probes, the second one spaced by the pacer instead of back to back
+          SendProbePacket ();
+          Time gap = Seconds (0);
+          if (m_tcb->m_pacing and m_tcb->m_pacingRate.Get ().GetBitRate () > 0)
+            {
+              gap = m_tcb->m_pacingRate.Get ().CalculateBytesTxTime (GetSegSize ());
+            }
+          m_probeEvent.Cancel ();
+          m_probeEvent = Simulator::Schedule (gap, &QuicSocketBase::SendProbePacket, this);
+        }
+      SetReTxTimeout ();
+    }
+}
+
+Time
+QuicSocketBase::GetProbeTimeout (bool handshake) const
+{
+  Time smoothedRtt = m_tcb->m_smoothedRtt;
+  Time rttVar = m_tcb->m_rttVar;
+  if (smoothedRtt == Seconds (0))
+    {
+      smoothedRtt = m_tcb->m_kDefaultInitialRtt;
+      rttVar = smoothedRtt / 2;
+    }
+  Time pto = smoothedRtt + std::max (4 * rttVar, m_tcb->m_kGranularity);
+  if (!handshake)
+    {
+      // the peer may delay the ACK by its max_ack_delay, or by the one we requested
+      pto += std::max (m_tcb->m_kDelayedAckTimeout, m_peerMinAckDelay);
+    }
+  return pto * (1 << std::min (m_tcb->m_ptoCount, 16U));
+}
+
+void
+QuicSocketBase::SendProbePacket ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_drainingPeriodEvent.IsRunning () or m_socketState != OPEN)
+    {
+      return;
+    }
+
+  // the probe ignores the congestion window, but not the flow control limit of the peer
+  uint32_t window = std::min (ConnectionWindow (), GetSegSize ());
+
+  // the probe must be ack-eliciting even without data that can be sent
+  if (m_txBuffer->AppSize () == 0 or window == 0)
+    {
+      Ptr<Packet> ping = Create<Packet> ();
+      ping->AddHeader (QuicSubheader::CreatePing ());
+      m_txBuffer->Add (ping);
+    }
+  // a peer that acknowledges less often must not delay the ACK of the probe
+  if (!m_peerMinAckDelay.IsZero ())
+    {
+      Ptr<Packet> frame = Create<Packet> ();
+      frame->AddHeader (QuicSubheader::CreateImmediateAck ());
+      m_txBuffer->Add (frame);
+    }
+
+  // without window, the control frames are sent alone, and the pacer debt delays the next packets
+  SequenceNumber32 next = ++m_tcb->m_nextTxSequence;
+  SendDataPacket (next, window, m_connected);
+}
+
+void
+QuicSocketBase::MaybePersistentCongestion (const std::vector<Ptr<QuicSocketTxItem> > &lostPackets)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_tcb->m_kUsingProbeTimeout or m_tcb->m_smoothedRtt == Seconds (0))
+    {
+      return;
+    }
+
+  // RFC 9002, Sec. 7.6.1
+  Time duration = (m_tcb->m_smoothedRtt + std::max (4 * m_tcb->m_rttVar, m_tcb->m_kGranularity)
+                   + std::max (m_tcb->m_kDelayedAckTimeout, m_peerMinAckDelay))
+    * m_tcb->m_kPersistentCongestionThreshold;
+  if (!m_txBuffer->IsPersistentCongestion (lostPackets, duration))
+    {
+      return;
+    }
+
+  NS_LOG_INFO ("Persistent congestion, losses over more than " << duration);
+  if (m_quicCongestionControlLegacy)
+    {
+      m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
+      m_tcb->m_cWnd = m_tcb->m_kMinimumWindow;
+      m_tcb->m_endOfRecovery = m_tcb->m_highTxMark;
+      m_tcb->m_congState = TcpSocketState::CA_LOSS;
+      m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_LOSS);
+    }
+  else
+    {
+      DynamicCast<QuicCongestionOps> (m_congestionControl)->OnPersistentCongestion (m_tcb);
+    }
+}
+
+void
+QuicSocketBase::OnSpuriousLoss (const QuicSpuriousLoss &loss)
+{
+  NS_LOG_FUNCTION (this << loss.m_packetNumber << loss.m_reordering);
+
+  m_spuriousLosses++;
+  NS_LOG_INFO ("Packet " << loss.m_packetNumber << " spuriously lost, reordering " << loss.m_reordering);
+  m_spuriousLossTrace (loss.m_packetNumber.GetValue (), m_spuriousLosses);
+
+  if (!m_tcb->m_kUsingAdaptiveReordering)
+    {
+      return;
+    }
+
+  // The thresholds grow to tolerate the observed reordering - RFC 9002, Sec. 6.1
+  bool raised = false;
+  uint32_t threshold = std::min (loss.m_reordering + 1, m_tcb->m_kMaxReorderingThreshold);
+  if (threshold > m_tcb->m_kReorderingThreshold)
+    {
+      m_tcb->m_kReorderingThreshold = threshold;
+      raised = true;
+    }
+  Time rtt = std::max (m_tcb->m_lastRtt.Get (), m_tcb->m_smoothedRtt);
+  if (m_tcb->m_kUsingTimeLossDetection and !rtt.IsZero ())
+    {
+      double fraction = (Simulator::Now () - loss.m_lastSent).GetSeconds () / rtt.GetSeconds ();
+      fraction = std::min (fraction, m_tcb->m_kMaxTimeReorderingFraction);
+      if (fraction > m_tcb->m_kTimeReorderingFraction)
+        {
+          m_tcb->m_kTimeReorderingFraction = fraction;
+          raised = true;
+        }
+    }
+  if (raised)
+    {
+      NS_LOG_INFO ("Reordering threshold " << m_tcb->m_kReorderingThreshold
+                                           << ", time fraction " << m_tcb->m_kTimeReorderingFraction);
+      m_reorderingThresholdTrace (m_tcb->m_kReorderingThreshold, m_tcb->m_kTimeReorderingFraction);
+    }
+
+  if (!m_quicCongestionControlLegacy)
+    {
+      DynamicCast<QuicCongestionOps> (m_congestionControl)->OnSpuriousLoss (m_tcb, loss.m_packetNumber);
+    }
 }
 
 uint32_t
@@ -1876,6 +2358,8 @@ QuicSocketBase::AppendingRx (Ptr<Packet> frame, Address &address)
 
   NS_LOG_FUNCTION (this);
 
+  // the buffer takes ownership of the frame
+  uint32_t size = frame->GetSize ();
   if (!m_rxBuffer->Add (frame))
     {
       // Insert failed: No data or RX buffer full
@@ -1888,7 +2372,7 @@ QuicSocketBase::AppendingRx (Ptr<Packet> frame, Address &address)
       NotifyDataRecv ();   // trigger the application method
     }
 
-  return frame->GetSize ();
+  return size;
 }
 
 void
@@ -2153,6 +2637,16 @@ QuicSocketBase::OnReceivedFrame (QuicSubheader &sub)
         NS_LOG_INFO ("Received PATH_RESPONSE frame");
         break;
 
+      case QuicSubheader::ACK_FREQUENCY:
+        NS_LOG_INFO ("Received ACK_FREQUENCY frame");
+        OnReceivedAckFrequencyFrame (sub);
+        break;
+
+      case QuicSubheader::IMMEDIATE_ACK:
+        NS_LOG_INFO ("Received IMMEDIATE_ACK frame");
+        m_immediateAckRequested = true;
+        break;
+
       default:
         AbortConnection (
           QuicSubheader::TransportErrorCodes_t::PROTOCOL_VIOLATION,
@@ -2167,7 +2661,7 @@ QuicSocketBase::OnSendingAckFrame ()
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ABORT_MSG_IF (m_receivedPacketNumbers.empty (),
+  NS_ABORT_MSG_IF (m_receivedPacketNumbers.IsEmpty (),
                    " Sending Ack Frame without packets to acknowledge");
 
 //m_delAckEvent.Cancel();
@@ -2175,38 +2669,13 @@ QuicSocketBase::OnSendingAckFrame ()
 
   NS_LOG_INFO ("Attach an ACK frame to the packet");
 
-  std::sort (m_receivedPacketNumbers.begin (), m_receivedPacketNumbers.end (),
-             std::greater<SequenceNumber32> ());
+  SequenceNumber32 largestAcknowledged = m_receivedPacketNumbers.GetLargest ();
 
-  SequenceNumber32 largestAcknowledged = *(m_receivedPacketNumbers.begin ());
-
-  uint32_t ackBlockCount = 0;
   std::vector<uint32_t> additionalAckBlocks;
   std::vector<uint32_t> gaps;
 
-  std::vector<SequenceNumber32>::const_iterator curr_rec_it =
-    m_receivedPacketNumbers.begin ();
-  std::vector<SequenceNumber32>::const_iterator next_rec_it =
-    m_receivedPacketNumbers.begin () + 1;
-
-  for (; next_rec_it != m_receivedPacketNumbers.end ();
-       ++curr_rec_it, ++next_rec_it)
-    {
-
-      if (((*curr_rec_it) - (*next_rec_it) - 1 > 0)
-          and ((*curr_rec_it) != (*next_rec_it)))
-        {
-          //std::clog << "curr " << (*curr_rec_it) << " next " << (*next_rec_it) << " ";
-          additionalAckBlocks.push_back ((*next_rec_it).GetValue ());
-          gaps.push_back ((*curr_rec_it).GetValue () - 1);
-          ackBlockCount++;
-        }
-      // Limit the number of gaps that are sent in an ACK (older packets have already been retransmitted)
-      if (ackBlockCount >= m_maxTrackedGaps)
-        {
-          break;
-        }
-    }
+  // Limit the number of gaps that are sent in an ACK (the ranges just above the lowest one are left out)
+  m_receivedPacketNumbers.GetAckBlocks (m_maxTrackedGaps, gaps, additionalAckBlocks);
 
 
   Time delay = Simulator::Now () - m_lastReceived;
@@ -2232,12 +2701,69 @@ QuicSocketBase::OnSendingAckFrame ()
   return ackFrame;
 }
 
+void
+QuicSocketBase::OnAckFrameSent (SequenceNumber32 packetNumber)
+{
+  NS_LOG_FUNCTION (this << packetNumber);
+
+  m_sentAckFrames[packetNumber] = m_receivedPacketNumbers.GetLargest ();
+}
+
+void
+QuicSocketBase::PruneReceivedPacketNumbers (const QuicSubheader &sub)
+{
+  NS_LOG_FUNCTION (this);
+
+  const std::vector<uint32_t> &gaps = sub.GetGaps ();
+  const std::vector<uint32_t> &additionalAckBlocks = sub.GetAdditionalAckBlocks ();
+  SequenceNumber32 largestAcknowledged = SequenceNumber32 (sub.GetLargestAcknowledged ());
+
+  bool ackOfAck = false;
+  SequenceNumber32 pruneBelow (0);
+
+  // the packets with an ACK frame that are not covered by this ACK are either
+  // lost or superseded by a later packet, so they are forgotten as well
+  std::map<SequenceNumber32, SequenceNumber32>::iterator end = m_sentAckFrames.upper_bound (largestAcknowledged);
+  for (std::map<SequenceNumber32, SequenceNumber32>::iterator it = m_sentAckFrames.begin (); it != end; ++it)
+    {
+      uint32_t pn = it->first.GetValue ();
+      bool acked = true;
+      for (uint32_t i = 0; i < gaps.size (); i++)
+        {
+          if (pn > gaps[i])
+            {
+              break;
+            }
+          if (pn > additionalAckBlocks[i])
+            {
+              acked = false;
+              break;
+            }
+        }
+
+      if (acked and (!ackOfAck or it->second > pruneBelow))
+        {
+          ackOfAck = true;
+          pruneBelow = it->second;
+        }
+    }
+  m_sentAckFrames.erase (m_sentAckFrames.begin (), end);
+
+  if (ackOfAck)
+    {
+      NS_LOG_LOGIC ("Stop tracking the received packets below " << pruneBelow);
+      m_receivedPacketNumbers.PruneBelow (pruneBelow);
+    }
+}
+
 void
 QuicSocketBase::OnReceivedAckFrame (QuicSubheader &sub)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_INFO ("Process ACK");
 
+  PruneReceivedPacketNumbers (sub);
+
   // Generate RateSample
   struct RateSample * rs = m_txBuffer->GetRateSample ();
   rs->m_priorInFlight = m_tcb->m_bytesInFlight.Get ();
@@ -2261,9 +2787,27 @@ QuicSocketBase::OnReceivedAckFrame (QuicSubheader &sub)
   std::vector<Ptr<QuicSocketTxItem> > ackedPackets = m_txBuffer->OnAckUpdate (
     m_tcb, largestAcknowledged, additionalAckBlocks, gaps);
 
+  // Packets declared lost and then acknowledged reveal reordering
+  for (const QuicSpuriousLoss &loss : m_txBuffer->DetectSpuriousLosses ())
+    {
+      OnSpuriousLoss (loss);
+    }
+
   // Count newly acked bytes
   uint32_t ackedBytes = previousWindow - m_txBuffer->BytesInFlight ();
 
+  // Let the streams release the acknowledged data
+  for (const Ptr<QuicSocketTxItem> &item : ackedPackets)
+    {
+      for (const QuicSocketTxFrame &frame : item->m_frames)
+        {
+          if (frame.m_length > 0)
+            {
+              m_quicl5->OnAckedStreamData (frame.m_streamId, frame.m_offset, frame.m_length);
+            }
+        }
+    }
+
   m_txBuffer->GenerateRateSample ();
   rs->m_packetLoss = std::abs ((int) lostOut - (int) m_txBuffer->GetLost ());
   m_tcb->m_lastAckedSackedBytes = m_tcb->m_delivered - delivered;
@@ -2305,6 +2849,12 @@ QuicSocketBase::OnReceivedAckFrame (QuicSubheader &sub)
       m_tcb->m_tlpCount = 0;
     }
 
+  // the PTO backoff is reset by any acknowledgment - RFC 9002, Sec. 6.2.1
+  if (!ackedPackets.empty ())
+    {
+      m_tcb->m_ptoCount = 0;
+    }
+
   // Find lost packets
   std::vector<Ptr<QuicSocketTxItem> > lostPackets =
     m_txBuffer->DetectLostPackets ();
@@ -2331,6 +2881,7 @@ QuicSocketBase::OnReceivedAckFrame (QuicSubheader &sub)
           DynamicCast<QuicCongestionOps> (m_congestionControl)->OnPacketsLost (
             m_tcb, lostPackets);
         }
+      MaybePersistentCongestion (lostPackets);
       DoRetransmit (lostPackets);
     }
   /* else */ if (ackedBytes > 0)
@@ -2338,9 +2889,36 @@ QuicSocketBase::OnReceivedAckFrame (QuicSubheader &sub)
       if (!m_quicCongestionControlLegacy)
         {
           NS_LOG_INFO ("Update the variables in the congestion control (QUIC)");
+          // Summarize the ACK, so that the congestion control processes it at once
+          QuicAckEvent ackEvent;
+          ackEvent.m_largestAcked = SequenceNumber32 (largestAcknowledged);
+          ackEvent.m_ackDelay = MicroSeconds (sub.GetAckDelay ());
+          ackEvent.m_newAcks = &ackedPackets;
+          // new acks are ordered from the highest packet number to the smallest
+          if (ackedPackets.at (0)->m_packetNumber == ackEvent.m_largestAcked)
+            {
+              ackEvent.m_rttSample = Now () - ackedPackets.at (0)->m_lastSent;
+            }
+          for (const Ptr<QuicSocketTxItem> &item : ackedPackets)
+            {
+              if (item->m_acked)
+                {
+                  if (ackEvent.m_ackElicitingAcked == 0)
+                    {
+                      ackEvent.m_largestNewlyAcked = item->m_packetNumber;
+                    }
+                  ackEvent.m_smallestNewlyAcked = item->m_packetNumber;
+                  ackEvent.m_ackedBytes += item->m_packet->GetSize ();
+                  ackEvent.m_ackElicitingAcked++;
+                }
+            }
+          for (const Ptr<QuicSocketTxItem> &item : lostPackets)
+            {
+              ackEvent.m_lostBytes += item->m_packet->GetSize ();
+            }
           // Process the ACK
           DynamicCast<QuicCongestionOps> (m_congestionControl)->OnAckReceived (
-            m_tcb, sub, ackedPackets, rs);
+            m_tcb, ackEvent, rs);
           m_lastRtt = m_tcb->m_lastRtt;
         }
       else
@@ -2396,6 +2974,9 @@ QuicSocketBase::OnReceivedAckFrame (QuicSubheader &sub)
       NotifySend (GetTxAvailable ());
     }
 
+  // the congestion window may call for a different ACK rate
+  MaybeSendAckFrequency ();
+
   // try to send more data
   SendPendingData (m_connected);
 
@@ -2413,7 +2994,8 @@ QuicSocketBase::OnSendingTransportParameters ()
     m_initial_max_stream_data, m_max_data, m_initial_max_stream_id_bidi,
     (uint16_t) m_idleTimeout.Get ().GetSeconds (),
     (uint8_t) m_omit_connection_id, m_tcb->m_segmentSize,
-    m_ack_delay_exponent, m_initial_max_stream_id_uni);
+    m_ack_delay_exponent, m_initial_max_stream_id_uni,
+    (uint32_t) m_minAckDelay.GetMicroSeconds ());
 
   return transportParameters;
 }
@@ -2514,6 +3096,9 @@ QuicSocketBase::OnReceivedTransportParameters (
     transportParameters.GetInitialMaxStreamIdUni (),
     m_initial_max_stream_id_uni);
 
+  // the peer accepts ACK_FREQUENCY frames only if it advertised a min_ack_delay
+  m_peerMinAckDelay = MicroSeconds (transportParameters.GetMinAckDelay ());
+
   NS_LOG_DEBUG (
     "After applying received transport parameters " << " m_initial_max_stream_data " << m_initial_max_stream_data << " m_max_data " << m_max_data << " m_initial_max_stream_id_bidi " << m_initial_max_stream_id_bidi << " m_idleTimeout " << m_idleTimeout << " m_omit_connection_id " << m_omit_connection_id << " m_tcb->m_segmentSize " << m_tcb->m_segmentSize << " m_ack_delay_exponent " << m_ack_delay_exponent << " m_initial_max_stream_id_uni " << m_initial_max_stream_id_uni);
 }
@@ -2593,6 +3178,11 @@ QuicSocketBase::DoClose (void)
     }
 
   SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+  // the connection will not receive data anymore
+  if (m_quicl5 != 0)
+    {
+      m_quicl5->ReleaseRcvBuf ();
+    }
   return m_quicl4->RemoveSocket (this);
 }
 
@@ -2609,11 +3199,9 @@ QuicSocketBase::ReceivedData (Ptr<Packet> p, const QuicHeader& quicHeader,
   // check if this packet is not received during the draining period
   if (!m_drainingPeriodEvent.IsRunning ())
     {
-      m_idleTimeoutEvent.Cancel ();   // reset the IDLE timeout
       NS_LOG_LOGIC (
-        this << " ReceivedData Schedule Close at time " << Simulator::Now ().GetSeconds () << " to expire at time " << (Simulator::Now () + m_idleTimeout.Get ()).GetSeconds ());
-      m_idleTimeoutEvent = Simulator::Schedule (m_idleTimeout,
-                                                &QuicSocketBase::Close, this);
+        this << " ReceivedData reset idle timeout at time " << Simulator::Now ().GetSeconds () << " to expire at time " << (Simulator::Now () + m_idleTimeout.Get ()).GetSeconds ());
+      ResetIdleTimeout ();   // reset the IDLE timeout
     }
   else   // If the socket is in Draining Period, discard the packets
     {
@@ -2636,7 +3224,7 @@ QuicSocketBase::ReceivedData (Ptr<Packet> p, const QuicHeader& quicHeader,
       m_couldContainTransportParameters = true;
 
       onlyAckFrames = m_quicl5->DispatchRecv (p, address);
-      m_receivedPacketNumbers.push_back (quicHeader.GetPacketNumber ());
+      m_receivedPacketNumbers.Add (quicHeader.GetPacketNumber ());
 
       m_connected = true;
       m_keyPhase == QuicHeader::PHASE_ONE ? m_keyPhase =
@@ -2672,7 +3260,7 @@ QuicSocketBase::ReceivedData (Ptr<Packet> p, const QuicHeader& quicHeader,
         }
 
       onlyAckFrames = m_quicl5->DispatchRecv (p, address);
-      m_receivedPacketNumbers.push_back (quicHeader.GetPacketNumber ());
+      m_receivedPacketNumbers.Add (quicHeader.GetPacketNumber ());
 
       if (IsVersionSupported (quicHeader.GetVersion ()))
         {
@@ -2693,7 +3281,7 @@ QuicSocketBase::ReceivedData (Ptr<Packet> p, const QuicHeader& quicHeader,
       NS_LOG_INFO ("Client receives HANDSHAKE");
 
       onlyAckFrames = m_quicl5->DispatchRecv (p, address);
-      m_receivedPacketNumbers.push_back (quicHeader.GetPacketNumber ());
+      m_receivedPacketNumbers.Add (quicHeader.GetPacketNumber ());
 
       SetState (OPEN);
       Simulator::ScheduleNow (&QuicSocketBase::ConnectionSucceeded, this);
@@ -2709,7 +3297,7 @@ QuicSocketBase::ReceivedData (Ptr<Packet> p, const QuicHeader& quicHeader,
       NS_LOG_INFO ("Server receives HANDSHAKE");
 
       onlyAckFrames = m_quicl5->DispatchRecv (p, address);
-      m_receivedPacketNumbers.push_back (quicHeader.GetPacketNumber ());
+      m_receivedPacketNumbers.Add (quicHeader.GetPacketNumber ());
 
       SetState (OPEN);
       Simulator::ScheduleNow (&QuicSocketBase::ConnectionSucceeded, this);
@@ -2774,7 +3362,7 @@ QuicSocketBase::ReceivedData (Ptr<Packet> p, const QuicHeader& quicHeader,
       // we need to check if the packet contains only an ACK frame
       // in this case we cannot explicitely ACK it!
       // check if delayed ACK is used
-      m_receivedPacketNumbers.push_back (quicHeader.GetPacketNumber ());
+      m_receivedPacketNumbers.Add (quicHeader.GetPacketNumber ());
       onlyAckFrames = m_quicl5->DispatchRecv (p, address);
 
     }
@@ -2935,7 +3523,7 @@ QuicSocketBase::GetReceivedTransportParametersFlag () const
 
 bool
 QuicSocketBase::CheckIfPacketOverflowMaxDataLimit (
-  std::vector<std::pair<Ptr<Packet>, QuicSubheader> > disgregated)
+  const std::vector<std::pair<Ptr<Packet>, QuicSubheader> > &disgregated)
 {
   NS_LOG_FUNCTION (this);
   uint32_t validPacketSize = 0;
@@ -3091,6 +3679,21 @@ QuicSocketBase::GetInitialPacketSize () const
   return m_initialPacketSize;
 }
 
+void
+QuicSocketBase::SetMaxTrackedGaps (uint32_t maxTrackedGaps)
+{
+  NS_LOG_FUNCTION (this << maxTrackedGaps);
+  m_maxTrackedGaps = maxTrackedGaps;
+  // one range more than the number of gaps that can be reported in an ACK
+  m_receivedPacketNumbers.SetMaxRanges (maxTrackedGaps + 1);
+}
+
+uint32_t
+QuicSocketBase::GetMaxTrackedGaps () const
+{
+  return m_maxTrackedGaps;
+}
+
 void QuicSocketBase::SetLatency (uint32_t streamId, Time latency)
 {
   m_txBuffer->SetLatency (streamId, latency);
@@ -3111,6 +3714,59 @@ Time QuicSocketBase::GetDefaultLatency ()
   return m_txBuffer->GetDefaultLatency ();
 }
 
+void QuicSocketBase::SetStreamPriority (uint32_t streamId, uint8_t urgency, bool incremental)
+{
+  m_txBuffer->SetStreamPriority (streamId, urgency, incremental);
+}
+
+uint8_t QuicSocketBase::GetStreamUrgency (uint32_t streamId)
+{
+  return m_txBuffer->GetStreamUrgency (streamId);
+}
+
+bool QuicSocketBase::GetStreamIncremental (uint32_t streamId)
+{
+  return m_txBuffer->GetStreamIncremental (streamId);
+}
+
+void QuicSocketBase::SetDropExpired (uint32_t streamId, bool drop)
+{
+  m_txBuffer->SetDropExpired (streamId, drop);
+}
+
+bool QuicSocketBase::GetDropExpired (uint32_t streamId)
+{
+  return m_txBuffer->GetDropExpired (streamId);
+}
+
+uint32_t QuicSocketBase::GetDeadlineMisses (uint64_t streamId) const
+{
+  auto it = m_deadlineMisses.find (streamId);
+  return it != m_deadlineMisses.end () ? it->second : 0;
+}
+
+uint64_t QuicSocketBase::GetReorderingAcks () const
+{
+  return m_reorderingAcks;
+}
+
+uint64_t QuicSocketBase::GetSpuriousLosses () const
+{
+  return m_spuriousLosses;
+}
+
+Time QuicSocketBase::GetSmoothedRtt () const
+{
+  return m_tcb->m_smoothedRtt;
+}
+
+void QuicSocketBase::OnStreamBlocked (uint64_t streamId, uint64_t limit)
+{
+  NS_LOG_FUNCTION (this << streamId << limit);
+  NS_LOG_INFO ("Stream " << streamId << " blocked by flow control at offset " << limit);
+  m_streamBlockedTrace (streamId, limit);
+}
+
 void
 QuicSocketBase::NotifyPacingPerformed (void)
 {
@@ -3119,4 +3775,40 @@ QuicSocketBase::NotifyPacingPerformed (void)
   SendPendingData (m_connected);
 }
 
+bool
+QuicSocketBase::PacerAllowsSend (void)
+{
+  DataRate rate = m_tcb->m_pacingRate.Get ();
+  if (!m_tcb->m_pacing or rate.GetBitRate () == 0)
+    {
+      return true;
+    }
+
+  // fill the bucket at the pacing rate since the last update
+  double quantum = GetPacingQuantum ();
+  Time now = Simulator::Now ();
+  double earned = (now - m_pacingLastUpdate).GetSeconds () * rate.GetBitRate () / 8;
+  m_pacingTokens = std::min (quantum, m_pacingTokens + earned);
+  m_pacingLastUpdate = now;
+
+  if (m_pacingTokens > 0)
+    {
+      return true;
+    }
+
+  if (!m_pacingTimer.IsRunning ())
+    {
+      Time wait = rate.CalculateBytesTxTime (static_cast<uint32_t> (std::ceil (quantum - m_pacingTokens)));
+      NS_LOG_DEBUG ("Pacing rate " << rate << ", release " << quantum << " bytes in " << wait);
+      m_pacingTimer.Schedule (wait);
+    }
+  return false;
+}
+
+uint32_t
+QuicSocketBase::GetPacingQuantum (void) const
+{
+  return std::max (m_tcb->m_sendQuantum, GetSegSize ());
+}
+
 } // namespace ns3
@@ -39,6 +39,7 @@
 #include "quic-header.h"
 #include "quic-subheader.h"
 #include "quic-transport-parameters.h"
+#include "quic-ack-range-set.h"
 // #include "ns3/ipv4-end-point.h"
 #include "ns3/tcp-socket-base.h"
 #include "ns3/tcp-congestion-ops.h"
@@ -54,6 +55,10 @@ class QuicL4Protocol;
  *
  * In this data structure, basic informations that should be passed between
  * socket and the congestion control algorithm are saved.
+ *
+ * The loss recovery engine is configured through the attributes of this
+ * class, e.g., with Config::SetDefault ("ns3::QuicSocketState::kUsingProbeTimeout", ...)
+ * before the socket is created, or through the "TCB" attribute of the socket.
  */
 class QuicSocketState : public TcpSocketState
 {
@@ -77,6 +82,7 @@ public:
   uint32_t m_tlpCount;                     /**< The number of times a tail loss probe has been sent without
                                             *   receiving an ack. */
   uint32_t m_rtoCount;                      //!< The number of times an rto has been sent without receiving an ack.
+  uint32_t m_ptoCount {0};                  //!< The number of times a PTO has expired without receiving an ack.
   SequenceNumber32 m_largestSentBeforeRto;  //!< The last packet number sent prior to the first retransmission timeout.
   Time m_timeOfLastSentPacket;              //!< The time the most recent packet was sent.
   SequenceNumber32 m_largestAckedPacket;    //!< The largest packet number acknowledged in an ACK frame.
@@ -107,13 +113,21 @@ public:
                                                  *   considers a packet lost. In fraction of an RTT. */
   bool m_kUsingTimeLossDetection;               /**< Whether time based loss detection is in use. If false, uses FACK
                                                  *   style loss detection. */
+  bool m_kUsingAdaptiveReordering;              /**< Whether spurious losses raise the reordering thresholds and undo
+                                                 *   the congestion window reduction. */
+  uint32_t m_kMaxReorderingThreshold;           //!< Upper bound of the adaptive packet reordering threshold.
+  double m_kMaxTimeReorderingFraction;          //!< Upper bound of the adaptive time reordering fraction.
   Time m_kMinTLPTimeout;                        //!< Minimum time in the future a tail loss probe alarm may be set for.
   Time m_kMinRTOTimeout;                        //!< Minimum time in the future an RTO alarm may be set for.
+  bool m_kUsingProbeTimeout;                    //!< Whether the RFC 9002 probe timeout replaces the TLP and RTO alarms.
+  Time m_kGranularity;                          //!< Timer granularity, lower bound of the RTT variance term of the PTO.
+  uint32_t m_kPersistentCongestionThreshold;    //!< Number of PTOs without acknowledgments that declare persistent congestion.
   Time m_kDelayedAckTimeout;                    //!< The lenght of the peer's delayed ack timer.
   uint8_t m_alarmType;                          //!< The type of the next alarm
   Time m_nextAlarmTrigger;                      //<! Time of the next alarm
   Time m_kDefaultInitialRtt;                    //!< The default RTT used before an RTT sample is taken.
   uint32_t m_kMaxPacketsReceivedBeforeAckSend;  //!< The number of packets to be received before an ACK is triggered
+  uint32_t m_sendQuantum;                       //!< Maximum number of bytes released at once by the pacer (0 for one packet)
 
   // RateSample variables of interest
   uint64_t              m_delivered       {0};              //!< The total amount of data in bytes delivered so far
@@ -384,7 +398,7 @@ public:
    * \param a vector of pairs with received frames and subheaders
    * \return a boolean, true if the limit was exceeded
    */
-  bool CheckIfPacketOverflowMaxDataLimit (std::vector<std::pair<Ptr<Packet>, QuicSubheader> > disgregated);
+  bool CheckIfPacketOverflowMaxDataLimit (const std::vector<std::pair<Ptr<Packet>, QuicSubheader> > &disgregated);
 
   /**
    * \brief Get the maximum of stream ID (i.e., number of streams - 1)
@@ -524,6 +538,20 @@ public:
    */
   uint32_t GetInitialPacketSize (void) const;
 
+  /**
+   * \brief Set the maximum number of gaps in an ACK frame
+   *
+   * \param maxTrackedGaps the maximum number of gaps
+   */
+  void SetMaxTrackedGaps (uint32_t maxTrackedGaps);
+
+  /**
+   * \brief Get the maximum number of gaps in an ACK frame
+   *
+   * \returns the maximum number of gaps
+   */
+  uint32_t GetMaxTrackedGaps (void) const;
+
   // Implementation of ns3::Socket virtuals
 
   /**
@@ -594,6 +622,126 @@ public:
    */
   Time GetDefaultLatency ();
 
+  /**
+   * Set the priority of a specified stream (only used by the priority scheduler)
+   *
+   * \param streamId The stream ID
+   * \param urgency The stream's urgency, from 0 (highest) to 7 (lowest)
+   * \param incremental True if the stream's data can be interleaved with other streams
+   */
+  void SetStreamPriority (uint32_t streamId, uint8_t urgency, bool incremental);
+
+  /**
+   * Get the urgency of a specified stream
+   *
+   * \param streamId The stream ID
+   * \return The stream's urgency
+   */
+  uint8_t GetStreamUrgency (uint32_t streamId);
+
+  /**
+   * Get the incremental flag of a specified stream
+   *
+   * \param streamId The stream ID
+   * \return The stream's incremental flag
+   */
+  bool GetStreamIncremental (uint32_t streamId);
+
+  /**
+   * Enable or disable the drop of the expired frames of a specified stream (only used by the EDF scheduler)
+   *
+   * The frames that are still waiting to be sent, or retransmitted, after
+   * their deadline are dropped, and the receiver is told to skip their data.
+   *
+   * \param streamId The stream ID
+   * \param drop True if the expired frames of the stream are dropped
+   */
+  void SetDropExpired (uint32_t streamId, bool drop);
+
+  /**
+   * Check whether the expired frames of a specified stream are dropped
+   *
+   * \param streamId The stream ID
+   * \return True if the expired frames of the stream are dropped
+   */
+  bool GetDropExpired (uint32_t streamId);
+
+  /**
+   * Get the number of frames of a specified stream dropped because expired
+   *
+   * \param streamId The stream ID
+   * \return The number of deadline misses of the stream
+   */
+  uint32_t GetDeadlineMisses (uint64_t streamId) const;
+
+  /**
+   * Get the number of ACKs sent immediately because a packet was received out of order
+   *
+   * \return The number of reordering-triggered ACKs
+   */
+  uint64_t GetReorderingAcks () const;
+
+  /**
+   * Get the number of packets declared lost and acknowledged afterwards
+   *
+   * \return The number of spurious losses
+   */
+  uint64_t GetSpuriousLosses () const;
+
+  /**
+   * Get the smoothed RTT of the connection
+   *
+   * \return The smoothed RTT, zero before the first sample
+   */
+  Time GetSmoothedRtt () const;
+
+  /**
+   * \brief Notify that a stream has data to send but no flow-control credit
+   *
+   * \param streamId The ID of the blocked stream
+   * \param limit The MAX_STREAM_DATA limit that blocks the stream
+   */
+  void OnStreamBlocked (uint64_t streamId, uint64_t limit);
+
+  /**
+   * \brief TracedCallback signature for deadline misses.
+   *
+   * \param [in] streamId The ID of the stream
+   * \param [in] misses The number of deadline misses of the stream so far
+   */
+  typedef void (*DeadlineMissTracedCallback)(uint64_t streamId, uint32_t misses);
+
+  /**
+   * \brief TracedCallback signature for connection-level flow-control blocking.
+   *
+   * \param [in] limit The MAX_DATA limit that blocks the connection
+   */
+  typedef void (*BlockedTracedCallback)(uint64_t limit);
+
+  /**
+   * \brief TracedCallback signature for stream-level flow-control blocking.
+   *
+   * \param [in] streamId The ID of the blocked stream
+   * \param [in] limit The MAX_STREAM_DATA limit that blocks the stream
+   */
+  typedef void (*StreamBlockedTracedCallback)(uint64_t streamId, uint64_t limit);
+
+  /**
+   * \brief TracedCallback signature for spurious losses.
+   *
+   * \param [in] packetNumber The packet number of the packet declared lost and then acknowledged
+   * \param [in] count The number of spurious losses so far
+   */
+  typedef void (*SpuriousLossTracedCallback)(uint32_t packetNumber, uint64_t count);
+
+  /**
+   * \brief TracedCallback signature for the adaptation of the reordering thresholds.
+   *
+   * \param [in] threshold The packet reordering threshold
+   * \param [in] fraction The time reordering fraction of the RTT
+   */
+  typedef void (*ReorderingThresholdTracedCallback)(uint32_t threshold, double fraction);
+
   /**
    * \brief TracedCallback signature for QUIC packet transmission or reception events.
    *
@@ -626,11 +774,91 @@ protected:
    */
   void ReTxTimeout ();
 
+  /**
+   * \brief Compute the probe timeout of RFC 9002, with the exponential backoff
+   *
+   * \param handshake true during the handshake, whose PTO does not include the peer max_ack_delay
+   * \return the probe timeout
+   */
+  Time GetProbeTimeout (bool handshake) const;
+
+  /**
+   * \brief Send a probe packet, with new data if available or else a PING frame
+   *
+   * The probe is not limited by the congestion window, but it is charged to the pacer.
+   * The data it carries is limited by the MAX_DATA of the peer, and without
+   * room for data the probe is a PING sent alone.
+   */
+  void SendProbePacket ();
+
+  /**
+   * \brief Collapse the congestion window if the lost packets declare persistent congestion
+   *
+   * \param lostPackets the lost packets, by increasing packet number
+   */
+  void MaybePersistentCongestion (const std::vector<Ptr<QuicSocketTxItem> > &lostPackets);
+
+  /**
+   * \brief Count a spurious loss, raise the reordering thresholds to tolerate the
+   *   observed reordering, and let the congestion control undo the window reduction
+   *
+   * \param loss the packet declared lost and then acknowledged
+   */
+  void OnSpuriousLoss (const QuicSpuriousLoss &loss);
+
+  /**
+   * \brief Record activity on the connection and make sure the idle timer is armed
+   *
+   * The idle timer is lazy: instead of being canceled and rescheduled for
+   * every packet, a single event is kept pending, and it re-arms itself on
+   * expiration if some activity happened in the meantime
+   */
+  void ResetIdleTimeout ();
+
+  /**
+   * \brief Handle the expiration of the idle timer
+   */
+  void IdleTimeout ();
+
   /**
    * \brief Handle retransmission after loss
    */
   void DoRetransmit (std::vector<Ptr<QuicSocketTxItem> > lostPackets);
 
+  /**
+   * \brief Find the data of a lost stream frame that is still missing
+   *
+   * \param streamId the ID of the stream
+   * \param offset the offset of the lost data
+   * \param length the length of the lost data
+   * \param ranges filled with the data that has not been acknowledged
+   * \return false if the stream is unknown
+   */
+  bool OnLostStreamData (uint64_t streamId, uint64_t offset, uint32_t length,
+                         std::vector<QuicStreamTxRange> &ranges);
+
+  /**
+   * \brief Refresh the frames of a lost control packet before they are sent again
+   *
+   * \param frames the lost control frames
+   * \return the frames to send again
+   */
+  Ptr<Packet> OnLostControlFrames (Ptr<Packet> frames);
+
+  /**
+   * \brief Abandon the stream data dropped by the scheduler because expired
+   *
+   * The data is never retransmitted, and the receiver is told to skip it
+   * with an EXPIRED_STREAM_DATA frame, which also carries the FIN if the
+   * dropped data ended the stream.
+   *
+   * \param streamId the ID of the stream
+   * \param offset the offset of the dropped data
+   * \param length the length of the dropped data
+   * \param fin true if the dropped data carried the FIN of the stream
+   */
+  void OnExpiredStreamData (uint64_t streamId, uint64_t offset, uint32_t length, bool fin);
+
   /**
    * \brief Extract at most maxSize bytes from the TxBuffer at sequence packetNumber, add the
    *        QUIC header, and send to QuicL4Protocol
@@ -640,7 +868,7 @@ protected:
    * be compatible with the TcpSocketBase class
    *
    * \param seq the sequence number
-   * \param maxSize the maximum data block to be transmitted (in bytes)
+   * \param maxSize the maximum data block to be transmitted (in bytes), if 0 the pending control frames are sent alone
    * \param withAck forces an ACK to be sent
    * \returns the number of bytes sent
    */
@@ -710,17 +938,52 @@ protected:
   bool IsVersionSupported (uint32_t version);
 
   /**
-   * \brief Check if there are missing packets in the m_receivedPacketNumbers list
+   * \brief Check if the last received packet opened or filled a gap in the m_receivedPacketNumbers list
    *
    * \return true if there are missing packets
    */
   bool HasReceivedMissing ();
 
+  /**
+   * \brief Record that an ACK frame was sent in a packet
+   *
+   * \param packetNumber the number of the packet carrying the ACK frame
+   */
+  void OnAckFrameSent (SequenceNumber32 packetNumber);
+
+  /**
+   * \brief Stop tracking the received packets that the peer knows to be acknowledged
+   *
+   * When one of the packets carrying an ACK frame is acknowledged, the received
+   * packet numbers below the largest acknowledged of that ACK frame do not need
+   * to be reported anymore.
+   *
+   * \param sub the received ACK frame
+   */
+  void PruneReceivedPacketNumbers (const QuicSubheader &sub);
+
   /**
    * \brief Send an ACK packet
    */
   void SendAck ();
 
+  /**
+   * \brief Apply the ACK rate requested by the peer with an ACK_FREQUENCY frame
+   *
+   * \param sub the received ACK_FREQUENCY frame
+   */
+  void OnReceivedAckFrequencyFrame (QuicSubheader &sub);
+
+  /**
+   * \brief Ask the peer to scale its ACK rate with the congestion window
+   *
+   * If the peer supports the ACK frequency extension, an ACK_FREQUENCY frame
+   * is sent when the congestion window calls for a different ack-eliciting
+   * threshold, so that the peer sends about AckFrequencyRatio ACKs per
+   * window instead of one ACK every few packets.
+   */
+  void MaybeSendAckFrequency ();
+
   /**
    * \brief Call Socket::NotifyConnectionSucceeded()
    */
@@ -730,6 +993,24 @@ protected:
    * \brief Notify Pacing
    */
   void NotifyPacingPerformed (void);
+
+  /**
+   * \brief Check whether the pacer lets a packet be sent now
+   *
+   * The pacer is a token bucket, filled at the pacing rate up to the send
+   * quantum. When it is empty, the pacing timer is armed to fire when a
+   * whole quantum can be released, so that bursts of packets are sent with
+   * a single timer event while the long-run rate is the pacing rate.
+   *
+   * \return true if pacing is disabled or the bucket is not empty
+   */
+  bool PacerAllowsSend (void);
+
+  /**
+   * \brief Get the maximum number of bytes the pacer releases at once
+   * \return the send quantum, at least one packet
+   */
+  uint32_t GetPacingQuantum (void) const;
   /**
    * Send the connection close packet and schedule
    * the DoClose method
@@ -748,9 +1029,14 @@ protected:
   Ptr<QuicSocketTxBuffer> m_txBuffer;                     //!< TX buffer
   uint32_t m_socketTxBufferSize;                          //!< Size of the socket TX buffer
   uint32_t m_socketRxBufferSize;                          //!< Size of the socket RX buffer
-  std::vector<SequenceNumber32> m_receivedPacketNumbers;  //!< Received packet number vector
+  QuicAckRangeSet m_receivedPacketNumbers;                //!< Received packet number ranges
+  std::map<SequenceNumber32, SequenceNumber32> m_sentAckFrames;  //!< Largest acknowledged of the ACK frames sent, by packet number
   TypeId m_schedulingTypeId;                                                      //!< The socket type of the packet scheduler
   Time m_defaultLatency;                                                                  //!< The default latency bound (only used by the EDF scheduler)
+  std::map<uint64_t, uint32_t> m_deadlineMisses;          //!< Number of expired frames dropped, by stream
+  uint64_t m_reorderingAcks {0};                          //!< Number of ACKs sent immediately because of reordering
+  uint64_t m_blockedMaxData {0};                          //!< MAX_DATA limit of the last connection-level blocking
+  uint64_t m_spuriousLosses {0};                          //!< Number of packets declared lost and acknowledged afterwards
 
   // State-related attributes
   TracedValue<QuicStates_t> m_socketState;  //!< State in the Congestion state machine
@@ -782,6 +1068,7 @@ protected:
   EventId m_sendPendingDataEvent;             //!< Micro-delay event to send pending data
   EventId m_retxEvent;                        //!< Retransmission event
   EventId m_idleTimeoutEvent;                 //!< Event triggered upon receiving or sending a packet, when it expires the connection closes
+  Time m_lastActivityTime;                    //!< Time of the last packet sent or received, used by the idle timer
   EventId m_drainingPeriodEvent;              //!< Event triggered upon idle timeout or immediate connection close, when it expires all closes
   TracedValue<Time> m_rto;                    //!< Retransmit timeout
   TracedValue<Time> m_drainingPeriodTimeout;  //!< Draining Period timeout
@@ -800,10 +1087,27 @@ protected:
   uint32_t m_lastMaxData;                                                 //!< Last MaxData ACK
   uint32_t m_maxDataInterval;                                     //!< Interval between successive MaxData frames in ACKs
 
+  // ACK frequency extension
+  Time m_minAckDelay;                                     //!< Minimum ACK delay advertised to the peer, zero if ACK_FREQUENCY is not supported
+  uint32_t m_ackFrequencyRatio;                           //!< Number of ACKs requested to the peer per congestion window
+  Time m_peerMinAckDelay              {Seconds (0)};      //!< Minimum ACK delay advertised by the peer, zero if ACK_FREQUENCY is not supported
+  uint64_t m_ackFrequencySequence     {0};                //!< Sequence number of the next ACK_FREQUENCY frame to send
+  uint64_t m_sentAckElicitingThreshold {2};               //!< Ack-eliciting threshold last requested to the peer
+  uint64_t m_nextAckFrequencySequence {0};                //!< Lowest sequence number of an ACK_FREQUENCY frame not yet applied
+  uint64_t m_ackElicitingThreshold    {2};                //!< Packets received without sending an ACK, before one is sent immediately
+  Time m_maxAckDelay                  {Seconds (0)};      //!< ACK delay requested by the peer, zero to use kDelayedAckTimeout
+  bool m_immediateAckRequested        {false};            //!< True if the peer asked for an ACK with an IMMEDIATE_ACK frame
+
   uint32_t m_initialPacketSize; //!< size of the first packet to be sent durin the handshake (at least 1200 bytes, per RFC)
 
   // Pacing timer
   Timer m_pacingTimer       {Timer::REMOVE_ON_DESTROY}; //!< Pacing Event
+  double m_pacingTokens     {0};                        //!< Bytes the pacer can release, negative when in debt
+  Time m_pacingLastUpdate   {Seconds (0)};              //!< Last time the pacer was filled
+
+  // Probe timeout (RFC 9002)
+  Time m_lastAckElicitingSent {Seconds (0)};            //!< Time of the last ack-eliciting packet sent
+  EventId m_probeEvent;                                 //!< Second probe of a PTO, spaced by the pacer
 
   /**
   * \brief Callback pointer for cWnd trace chaining
@@ -837,6 +1141,12 @@ protected:
   TracedCallback<Ptr<const Packet>, const QuicHeader&,
                  Ptr<const QuicSocketBase> > m_rxTrace; //!< Trace of received packets
 
+  TracedCallback<uint64_t, uint32_t> m_deadlineMissTrace; //!< Trace of the expired frames dropped by the scheduler
+  TracedCallback<uint64_t> m_blockedTrace;                 //!< Trace of the connection-level flow-control blocking
+  TracedCallback<uint64_t, uint64_t> m_streamBlockedTrace; //!< Trace of the stream-level flow-control blocking
+  TracedCallback<uint32_t, uint64_t> m_spuriousLossTrace;  //!< Trace of the packets declared lost and then acknowledged
+  TracedCallback<uint32_t, double> m_reorderingThresholdTrace; //!< Trace of the adaptive reordering thresholds
+
 };
 
 } //namespace ns3
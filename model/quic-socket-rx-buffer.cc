@@ -102,7 +102,7 @@ QuicSocketRxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_socketRecvList.insert (m_socketRecvList.end (), p->Copy ());
+          m_socketRecvList.insert (m_socketRecvList.end (), p);
           m_recvSize += p->GetSize ();
           m_recvSizeTot += p->GetSize ();
 
@@ -133,35 +133,50 @@ QuicSocketRxBuffer::Extract (uint32_t maxSize)
       return 0;
     }
 
-  Ptr<Packet> outPkt = Create<Packet> ();
+  Ptr<Packet> outPkt = 0;
+  bool shared = false;
 
-  QuicSocketRxPacketList::iterator it = m_socketRecvList.begin ();
-
-  while (extractSize > 0 && !m_socketRecvList.empty () && it != m_socketRecvList.end ())
+  while (extractSize > 0 && !m_socketRecvList.empty ())
     {
-      it = m_socketRecvList.begin ();
-      Ptr<Packet> currentPacket = *it;
+      Ptr<Packet> currentPacket = m_socketRecvList.front ();
+      uint32_t currentSize = currentPacket->GetSize ();
+      Ptr<Packet> extracted;
+      bool whole = (currentSize <= extractSize);
 
-      if (currentPacket->GetSize () + outPkt->GetSize () <= extractSize)   // Merge
+      if (whole)
         {
+          extracted = currentPacket;
+          m_socketRecvList.pop_front ();
+        }
+      else
+        {
+          // Split the packet, without modifying the buffered one
+          extracted = currentPacket->CreateFragment (0, extractSize);
+          m_socketRecvList.front () = currentPacket->CreateFragment (extractSize, currentSize - extractSize);
+        }
 
-          outPkt->AddAtEnd ((*it));
-          m_socketRecvList.erase (it);
-
-          m_recvSize -= (*it)->GetSize ();
-          extractSize -= (*it)->GetSize ();
-          NS_LOG_LOGIC ("Added packet of size " << (*it)->GetSize ());
-          continue;
+      if (outPkt == nullptr)
+        {
+          // Return the first packet as it is, if nothing follows
+          outPkt = extracted;
+          shared = whole;
         }
       else
         {
-          break;
+          if (shared)
+            {
+              outPkt = outPkt->Copy ();
+              shared = false;
+            }
+          outPkt->AddAtEnd (extracted);
         }
 
-      it++;
+      m_recvSize -= extracted->GetSize ();
+      extractSize -= extracted->GetSize ();
+      NS_LOG_LOGIC ("Added packet of size " << extracted->GetSize ());
     }
 
-  if (outPkt->GetSize () == 0)
+  if (outPkt == nullptr)
     {
       NS_LOG_LOGIC ("Nothing extracted.");
       return 0;
@@ -25,6 +25,7 @@
 #ifndef QUICSOCKETRXBUFFER_H
 #define QUICSOCKETRXBUFFER_H
 
+#include <deque>
 #include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
@@ -135,6 +136,9 @@ public:
   /**
    * Add a packet in the buffer
    *
+   * The buffer takes ownership of the packet, which is stored without being
+   * copied, and must not be modified by the caller afterwards
+   *
    * \param p a pointer to the packet
    * \return true if the insertion was successful
    */
@@ -143,15 +147,19 @@ public:
   /**
    * Try to extract maxSize bytes from the buffer
    *
+   * The packets are extracted in order; if the next packet is larger than
+   * the remaining space, only its first part is extracted, and the rest is
+   * left at the head of the buffer. A packet extracted whole is returned
+   * without being copied.
+   *
    * \param maxSize the number of bytes to extract
    * \return a smart pointer to the packet; a pointer to 0 if there is no data to extract
-   * (or the first packet in the buffer is larger than maxSize)
    */
   Ptr<Packet> Extract (uint32_t maxSize);
 
 private:
   typedef std::vector<QuicSocketRxItem*> QuicStreamRxPacketList;  //!< Container for data stored in the buffer
-  typedef std::vector<Ptr<Packet> > QuicSocketRxPacketList;       //!< Container for data stored in the buffer
+  typedef std::deque<Ptr<Packet> > QuicSocketRxPacketList;        //!< Container for data stored in the buffer
 
   QuicSocketRxPacketList m_socketRecvList;  //!< List of received packets with additional info
   uint32_t m_recvSize;                      //!< Current buffer occupancy
@@ -26,6 +26,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include "ns3/simulator.h"
 
@@ -36,25 +37,12 @@
 #include "quic-socket-base.h"
 #include "quic-socket-tx-scheduler.h"
 #include "quic-socket-tx-edf-scheduler.h"
+#include "quic-socket-tx-priority-scheduler.h"
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("QuicSocketTxBuffer");
 
-TypeId QuicSocketTxItem::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::QuicSocketTxItem")
-    .SetParent<Object>()
-    .SetGroupName ("Internet")
-    .AddConstructor<QuicSocketTxItem>()
-//    .AddTraceSource ("UnackSequence",
-//                     "First unacknowledged sequence number (SND.UNA)",
-//                     MakeTraceSourceAccessor (&QuicSocketTxBuffer::m_sentSize),
-//                     "ns3::SequenceNumber32TracedValueCallback")
-  ;
-  return tid;
-}
-
 QuicSocketTxItem::QuicSocketTxItem () 
   : m_packet (0), 
     m_packetNumber (0), 
@@ -71,6 +59,7 @@ QuicSocketTxItem::QuicSocketTxItem ()
 
 QuicSocketTxItem::QuicSocketTxItem (const QuicSocketTxItem &other)
   : m_packet (other.m_packet),
+    m_frames (other.m_frames),
     m_packetNumber (other.m_packetNumber), 
     m_lost (other.m_lost), 
     m_retrans (other.m_retrans), 
@@ -146,6 +135,7 @@ void QuicSocketTxItem::MergeItems (QuicSocketTxItem &t1, QuicSocketTxItem &t2)
     }
 
   t1.m_packet->AddAtEnd (t2.m_packet);
+  t1.m_frames.insert (t1.m_frames.end (), t2.m_frames.begin (), t2.m_frames.end ());
 }
 
 void QuicSocketTxItem::SplitItems (QuicSocketTxItem &t1, QuicSocketTxItem &t2,
@@ -166,25 +156,34 @@ void QuicSocketTxItem::SplitItems (QuicSocketTxItem &t1, QuicSocketTxItem &t2,
       t1.m_lost = true;
     }
   t2.m_generated = t1.m_generated;
-  // Copy the packet into t2
-  t2.m_packet = t1.m_packet->Copy ();
-  // Remove the first size bytes from t2
-  t2.m_packet->RemoveAtStart (size);
-
-  // Change subheader
-  QuicSubheader qsb;
-  t1.m_packet->RemoveHeader (qsb);
-  qsb.SetLength (t1.m_packet->GetSize () - size);
-  t1.m_packet->AddHeader (qsb);
 
-  NS_ASSERT_MSG (t2.m_packet->GetSize () == initialSize - size,
-                 "Wrong size " << t2.m_packet->GetSize ());
-  qsb.SetLength (t2.m_packet->GetSize ());
-  t2.m_packet->AddHeader (qsb);
-  // Remove the bytes from size to end from t1
-  t1.m_packet->RemoveAtEnd (t1.m_packet->GetSize () - size);
-  NS_ASSERT_MSG (t1.m_packet->GetSize () == size,
-                 "Wrong size " << t1.m_packet->GetSize ());
+  NS_ASSERT_MSG (t1.m_frames.size () == 1, "Only single frame items can be split");
+  QuicSocketTxFrame frame = t1.m_frames.front ();
+  NS_ASSERT_MSG (size < frame.m_length, "Wrong split size " << size);
+  uint32_t headerSize = frame.m_size - frame.m_length;
+
+  QuicSocketTxFrame first = frame;
+  first.m_length = size;
+  first.m_fin = false;
+  QuicSocketTxFrame second = frame;
+  second.m_offset += size;
+  second.m_length = frame.m_length - size;
+
+  // Build the subheaders of the two parts, and take the data from the packet
+  QuicSubheader firstSub = QuicSubheader::CreateStreamSubHeader (
+    first.m_streamId, first.m_offset, first.m_length, first.m_offset != 0, true, first.m_fin);
+  QuicSubheader secondSub = QuicSubheader::CreateStreamSubHeader (
+    second.m_streamId, second.m_offset, second.m_length, true, true, second.m_fin);
+
+  t2.m_packet = t1.m_packet->CreateFragment (headerSize + size, second.m_length);
+  t2.m_packet->AddHeader (secondSub);
+  t1.m_packet = t1.m_packet->CreateFragment (headerSize, size);
+  t1.m_packet->AddHeader (firstSub);
+
+  first.m_size = t1.m_packet->GetSize ();
+  second.m_size = t2.m_packet->GetSize ();
+  t1.m_frames.front () = first;
+  t2.m_frames.assign (1, second);
 }
 
 NS_OBJECT_ENSURE_REGISTERED (QuicSocketTxBuffer);
@@ -203,21 +202,28 @@ TypeId QuicSocketTxBuffer::GetTypeId (void)
 }
 
 QuicSocketTxBuffer::QuicSocketTxBuffer () :
-  m_maxBuffer (32768), m_streamZeroSize (0), m_sentSize (0), m_numFrameStream0InBuffer (
-    0)
+  m_sentListBase (0), m_lossDetectionFloor (0), m_largestAcked (0),
+  m_lossTime (Seconds (0)), m_maxBuffer (32768),
+  m_streamZeroSize (0), m_sentSize (0), m_inFlightSize (0), m_lostSize (0),
+  m_numFrameStream0InBuffer (0), m_controlSize (0)
 {
   m_streamZeroList = QuicTxPacketList ();
-  m_sentList = QuicTxPacketList ();
+  m_sentList = QuicTxSentPacketList ();
+  m_itemPool = Create<QuicSocketTxItemPool> ();
 }
 
 QuicSocketTxBuffer::~QuicSocketTxBuffer (void)
 {
-  QuicTxPacketList::iterator it;
-
-  m_sentList = QuicTxPacketList ();
+  m_sentList = QuicTxSentPacketList ();
+  m_sackedRanges.clear ();
+  m_lostPackets.clear ();
   m_streamZeroList = QuicTxPacketList ();
   m_sentSize = 0;
+  m_inFlightSize = 0;
+  m_lostSize = 0;
   m_streamZeroSize = 0;
+  m_controlList.clear ();
+  m_controlSize = 0;
 }
 
 void QuicSocketTxBuffer::Print (std::ostream &os) const
@@ -226,10 +232,15 @@ void QuicSocketTxBuffer::Print (std::ostream &os) const
   QuicSocketTxBuffer::QuicTxPacketList::const_iterator it;
   std::stringstream ss;
   std::stringstream as;
+  uint32_t numSent = 0;
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  for (auto sent_it = m_sentList.begin (); sent_it != m_sentList.end (); ++sent_it)
     {
-      (*it)->Print (ss);
+      if (*sent_it != nullptr)
+        {
+          (*sent_it)->Print (ss);
+          ++numSent;
+        }
     }
 
   for (it = m_streamZeroList.begin (); it != m_streamZeroList.end (); ++it)
@@ -239,11 +250,12 @@ void QuicSocketTxBuffer::Print (std::ostream &os) const
 
   os << Simulator::Now ().GetSeconds () << "\nStream 0 list: \n" << as.str ()
      << "\n\nSent list: \n" << ss.str () << "\n\nCurrent Status: "
-     << "\nNumber of transmissions = " << m_sentList.size ()
+     << "\nNumber of transmissions = " << numSent
      << "\nSent Size = " << m_sentSize
      << "\nNumber of stream 0 packets waiting = "
      << m_streamZeroList.size () << "\nStream 0 waiting packet size = "
-     << m_streamZeroSize;
+     << m_streamZeroSize << "\nNumber of control frames waiting = "
+     << m_controlList.size () << "\nControl frames size = " << m_controlSize;
 }
 
 bool QuicSocketTxBuffer::Add (Ptr<Packet> p)
@@ -258,7 +270,16 @@ bool QuicSocketTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          Ptr<QuicSocketTxItem> item = CreateObject<QuicSocketTxItem> ();
+          if (headerSize and !qsb.IsStream ())
+            {
+              // control frames ride in the free space of the next packets
+              m_controlList.push_back (p);
+              m_controlSize += p->GetSize ();
+              NS_LOG_INFO ("Queued control frame, " << m_controlList.size () << " waiting");
+              return true;
+            }
+
+          Ptr<QuicSocketTxItem> item = m_itemPool->Allocate ();
           item->m_packet = p;
           // check to which stream this packet belongs to
           uint32_t streamId = 0;
@@ -274,6 +295,17 @@ bool QuicSocketTxBuffer::Add (Ptr<Packet> p)
             }
           item->m_isStream = isStream;
           item->m_isStream0 = (streamId == 0);
+          // describe the frame, so that it is not parsed again
+          QuicSocketTxFrame frame;
+          frame.m_size = p->GetSize ();
+          if (isStream)
+            {
+              frame.m_streamId = streamId;
+              frame.m_offset = qsb.GetOffset ();
+              frame.m_length = p->GetSize () - headerSize;
+              frame.m_fin = qsb.IsStreamFin ();
+            }
+          item->m_frames.push_back (frame);
           m_numFrameStream0InBuffer += (streamId == 0);
           if (streamId == 0)
             {
@@ -304,7 +336,7 @@ Ptr<Packet> QuicSocketTxBuffer::NextStream0Sequence (
 {
   NS_LOG_FUNCTION (this << seq);
 
-  Ptr<QuicSocketTxItem> outItem = CreateObject<QuicSocketTxItem> ();
+  Ptr<QuicSocketTxItem> outItem = m_itemPool->Allocate ();
 
   QuicTxPacketList::iterator it = m_streamZeroList.begin ();
   if (it != m_streamZeroList.end ())
@@ -316,8 +348,7 @@ Ptr<Packet> QuicSocketTxBuffer::NextStream0Sequence (
       outItem->m_isStream0 = (*it)->m_isStream0;
       m_streamZeroList.erase (it);
       m_streamZeroSize -= currentPacket->GetSize ();
-      m_sentList.insert (m_sentList.end (), outItem);
-      m_sentSize += outItem->m_packet->GetSize ();
+      AddToSentList (outItem);
       --m_numFrameStream0InBuffer;
       Ptr<Packet> toRet = outItem->m_packet;
       return toRet;
@@ -325,17 +356,41 @@ Ptr<Packet> QuicSocketTxBuffer::NextStream0Sequence (
   return 0;
 }
 
+Ptr<Packet> QuicSocketTxBuffer::NextControlSequence (uint32_t numBytes,
+                                                     const SequenceNumber32 seq)
+{
+  NS_LOG_FUNCTION (this << numBytes << seq);
+
+  if (m_controlList.empty ())
+    {
+      NS_LOG_INFO ("No control frames");
+      return Create<Packet> ();
+    }
+
+  Ptr<QuicSocketTxItem> outItem = m_itemPool->Allocate ();
+  outItem->m_packetNumber = seq;
+  outItem->m_lastSent = Now ();
+  outItem->m_packet = Create<Packet> ();
+  // in flight and declared lost as the packets of the scheduler
+  outItem->m_isStream = true;
+  PackControlFrames (outItem, std::max (numBytes, m_controlList.front ()->GetSize ()));
+  AddToSentList (outItem);
+
+  NS_LOG_INFO ("Extracting " << outItem->m_packet->GetSize () << " bytes of control frames");
+  Ptr<Packet> toRet = outItem->m_packet;
+  return toRet;
+}
+
 Ptr<Packet> QuicSocketTxBuffer::NextSequence (uint32_t numBytes,
                                               const SequenceNumber32 seq)
 {
   NS_LOG_FUNCTION (this << numBytes << seq);
 
-  Ptr<QuicSocketTxItem> outItem = GetNewSegment (numBytes);
+  Ptr<QuicSocketTxItem> outItem = GetNewSegment (numBytes, seq);
 
   if (outItem != nullptr)
     {
       NS_LOG_INFO ("Extracting " << outItem->m_packet->GetSize () << " bytes");
-      outItem->m_packetNumber = seq;
       outItem->m_lastSent = Now ();
       Ptr<Packet> toRet = outItem->m_packet;
       return toRet;
@@ -348,17 +403,19 @@ Ptr<Packet> QuicSocketTxBuffer::NextSequence (uint32_t numBytes,
 
 }
 
-Ptr<QuicSocketTxItem> QuicSocketTxBuffer::GetNewSegment (uint32_t numBytes)
+Ptr<QuicSocketTxItem> QuicSocketTxBuffer::GetNewSegment (uint32_t numBytes,
+                                                         const SequenceNumber32 seq)
 {
-  NS_LOG_FUNCTION (this << numBytes);
+  NS_LOG_FUNCTION (this << numBytes << seq);
 
   Ptr<QuicSocketTxItem> outItem = m_scheduler->GetNewSegment (numBytes);
+  outItem->m_packetNumber = seq;
+  PackControlFrames (outItem, numBytes);
 
   if (outItem->m_packet->GetSize () > 0)
     {
       NS_LOG_LOGIC ("Adding packet to sent buffer");
-      m_sentList.insert (m_sentList.end (), outItem);
-      m_sentSize += outItem->m_packet->GetSize ();
+      AddToSentList (outItem);
     }
 
   NS_LOG_INFO (
@@ -387,152 +444,184 @@ std::vector<Ptr<QuicSocketTxItem> > QuicSocketTxBuffer::OnAckUpdate (
   std::vector<uint32_t>::const_iterator ack_it = compAckBlocks.begin ();
   std::vector<uint32_t>::const_iterator gap_it = compGaps.begin ();
 
-  std::stringstream gap_print;
-  for (auto i = gaps.begin (); i != gaps.end (); ++i)
+#ifdef NS3_LOG_ENABLE
+  // format the ACK blocks only if they are going to be logged
+  if (g_log.IsEnabled (LOG_INFO))
     {
-      gap_print << (*i) << " ";
+      std::stringstream gap_print;
+      for (auto i = gaps.begin (); i != gaps.end (); ++i)
+        {
+          gap_print << (*i) << " ";
+        }
+
+      std::stringstream block_print;
+      for (auto i = compAckBlocks.begin (); i != compAckBlocks.end (); ++i)
+        {
+          block_print << (*i) << " ";
+        }
+
+      NS_LOG_INFO (
+        "Largest ACK: " << largestAcknowledged << ", blocks: " << block_print.str () << ", gaps: " << gap_print.str ());
     }
+#endif
 
-  std::stringstream block_print;
-  for (auto i = compAckBlocks.begin (); i != compAckBlocks.end (); ++i)
+  // Only an ACK of a sent packet moves the largest acked packet number
+  if (GetSentItem (largestAcknowledged) != nullptr)
     {
-      block_print << (*i) << " ";
+      m_largestAcked = std::max (m_largestAcked, largestAcknowledged);
     }
 
-  NS_LOG_INFO (
-    "Largest ACK: " << largestAcknowledged << ", blocks: " << block_print.str () << ", gaps: " << gap_print.str ());
-
-  // Iterate over the ACK blocks and gaps
+  // Iterate over the ACK blocks and gaps, from the highest block
   for (uint32_t numAckBlockAnalyzed = 0; numAckBlockAnalyzed < ackBlockCount;
        ++numAckBlockAnalyzed, ++ack_it, ++gap_it)
     {
-      for (auto sent_it = m_sentList.rbegin ();
-           sent_it != m_sentList.rend () and !m_sentList.empty (); ++sent_it)                    // Visit sentList in reverse Order for optimization
+      // The block starts after the next gap, or covers all the lower packets
+      bool bounded = (gap_it < compGaps.end ());
+      uint32_t low = bounded ? (*gap_it) + 1 : 0;
+      AckBlock (low, (*ack_it), newlyAcked);
+      // the start of the lowest block is not encoded, so the packets declared
+      // lost below its high end may have never been received
+      if (bounded)
         {
-          NS_LOG_LOGIC (
-            "Consider packet " << (*sent_it)->m_packetNumber << " (ACK block " << SequenceNumber32 ((*ack_it)) << ")");
-          // The packet is in the next gap
-          bool inGap = (gap_it < compGaps.end ())
-            && ((*sent_it)->m_packetNumber
-                <= SequenceNumber32 ((*gap_it)));
-          if (inGap)               // Just for optimization we suppose All is perfectly ordered
-            {
-              NS_LOG_LOGIC (
-                "Packet " << (*sent_it)->m_packetNumber << " missing");
-              break;
-            }
-          // The packet is in the current block: ACK it
-          NS_LOG_LOGIC ("Packet " << (*sent_it)->m_packetNumber << " ACKed");
-          bool notInGap =
-            ((gap_it >= compGaps.end ())
-             || ((*sent_it)->m_packetNumber
-                 > SequenceNumber32 ((*gap_it))));
-
-          if ((*sent_it)->m_packetNumber <= SequenceNumber32 ((*ack_it))
-              and notInGap and (*sent_it)->m_sacked == false)
-            {
-              (*sent_it)->m_sacked = true;
-              (*sent_it)->m_ackTime = Now ();
-              newlyAcked.push_back ((*sent_it));
-              UpdateRateSample ((*sent_it));
-            }
-
+          AckDeclaredLost (low, (*ack_it));
         }
     }
+
+  MarkLostPackets (tcbd, m_largestAcked);
+
+  // Clean up acked packets and return new ACKed packet vector
+  CleanSentList ();
+  NS_ASSERT_MSG (CheckCounters (), "Inconsistent byte counters after ACK");
+  return newlyAcked;
+}
+
+void QuicSocketTxBuffer::MarkLostPackets (Ptr<QuicSocketState> tcbd, uint32_t largestAcknowledged)
+{
+  NS_LOG_FUNCTION (this << largestAcknowledged);
   NS_LOG_LOGIC ("Mark lost packets");
-  // Mark packets as lost as in RFC (Sec. 4.2.1 of draft-ietf-quic-recovery-15)
-  uint32_t index = m_sentList.size ();
-  bool lost = false;
-  bool outstanding = false;
-  auto acked_it = m_sentList.rend ();
-  // Iterate over the sent packet list in reverse
-  for (auto sent_it = m_sentList.rbegin ();
-       sent_it != m_sentList.rend () and !m_sentList.empty ();
-       ++sent_it, --index)
+  // Mark packets as lost as in RFC 9002, Sec. 6.1
+  m_lossTime = Seconds (0);
+  uint32_t threshold = tcbd->m_kReorderingThreshold;
+  // The packets below the floor are already either acked or lost
+  uint32_t floor = std::max (m_lossDetectionFloor, m_sentListBase);
+  if (largestAcknowledged <= floor)
+    {
+      return;
+    }
+
+  // Without time-based detection, only the packets at least threshold
+  // packet numbers below the largest acked one can be lost
+  uint32_t top = largestAcknowledged;
+  Time lossDelay = Seconds (0);
+  if (!tcbd->m_kUsingTimeLossDetection)
+    {
+      top = (largestAcknowledged >= threshold) ? largestAcknowledged - threshold + 1 : 0;
+    }
+  else
+    {
+      Time rtt = std::max (tcbd->m_lastRtt.Get (), tcbd->m_smoothedRtt);
+      lossDelay = Seconds (tcbd->m_kTimeReorderingFraction * rtt.GetSeconds ());
+      lossDelay = std::max (lossDelay, tcbd->m_kGranularity);
+    }
+  Time lostSendTime = Simulator::Now () - lossDelay;
+  bool lost = !tcbd->m_kUsingTimeLossDetection;
+  // Iterate over the outstanding packets in reverse
+  for (uint32_t pn = top; pn > floor; )
     {
+      --pn;
+      Ptr<QuicSocketTxItem> item = GetSentItem (pn);
+      if (item == nullptr or item->m_sacked)
+        {
+          continue;
+        }
       // All previous packets are lost
       if (lost)
         {
-          if (!(*sent_it)->m_sacked)
-            {
-              (*sent_it)->m_lost = true;
-              NS_LOG_LOGIC (
-                "Packet " << (*sent_it)->m_packetNumber << " lost");
-            }
+          DeclareLost (item);
+          NS_LOG_LOGIC ("Packet " << item->m_packetNumber << " lost");
+          continue;
+        }
+      //ACK-based detection
+      if (largestAcknowledged - pn >= threshold)
+        {
+          DeclareLost (item);
+          lost = true;
+          NS_LOG_INFO (
+            "Largest ACK " << largestAcknowledged << ", lost packet " << pn << " - reordering " << threshold);
+        }
+      // Time-based detection (optional)
+      else if (item->m_lastSent <= lostSendTime)
+        {
+          NS_LOG_INFO (
+            "Largest ACK " << largestAcknowledged << ", lost packet " << pn << " - time " << lossDelay.GetSeconds ());
+          DeclareLost (item);
+          lost = true;
         }
       else
         {
-          // The packet is the last ACKed packet
-          if ((*sent_it)->m_packetNumber.GetValue () == largestAcknowledged)
-            {
-              // Mark the packet as ACKed
-              acked_it = sent_it;
-              outstanding = true;
-            }
-          else if (outstanding && !(*sent_it)->m_sacked)
-            {
-              //ACK-based detection
-              if (largestAcknowledged - (*sent_it)->m_packetNumber.GetValue ()
-                  >= tcbd->m_kReorderingThreshold)
-                {
-                  (*sent_it)->m_lost = true;
-                  lost = true;
-                  NS_LOG_INFO (
-                    "Largest ACK " << largestAcknowledged << ", lost packet " << (*sent_it)->m_packetNumber.GetValue () << " - reordering " << tcbd->m_kReorderingThreshold);
-                }
-              // Time-based detection (optional)
-              if (tcbd->m_kUsingTimeLossDetection)
-                {
-                  double lhsComparison = ((*acked_it)->m_ackTime
-                                          - (*sent_it)->m_lastSent).GetSeconds ();
-                  double rhsComparison = tcbd->m_kTimeReorderingFraction
-                    * tcbd->m_smoothedRtt.GetSeconds ();
-                  if (lhsComparison >= rhsComparison)
-                    {
-                      NS_LOG_UNCOND (
-                        "Largest ACK " << largestAcknowledged << ", lost packet " << (*sent_it)->m_packetNumber.GetValue () << " - time " << rhsComparison);
-                      (*sent_it)->m_lost = true;
-                      lost = true;
-                    }
-                }
-            }
+          // The packets are sent in order, so the last one met in the walk
+          // is the first that will cross the time threshold
+          m_lossTime = item->m_lastSent + lossDelay;
+        }
+      if (lost)
+        {
+          m_lossDetectionFloor = std::max (m_lossDetectionFloor, pn + 1);
         }
     }
+  if (largestAcknowledged >= threshold)
+    {
+      m_lossDetectionFloor = std::max (m_lossDetectionFloor,
+                                       largestAcknowledged - threshold + 1);
+    }
+  NS_LOG_INFO ("Loss time " << m_lossTime.GetSeconds ());
+}
 
-  // Clean up acked packets and return new ACKed packet vector
-  CleanSentList ();
-  return newlyAcked;
+void QuicSocketTxBuffer::OnLossTimeout (Ptr<TcpSocketState> tcb)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_lossTime.IsZero ())
+    {
+      return;
+    }
+  Ptr<QuicSocketState> tcbd = dynamic_cast<QuicSocketState*> (&(*tcb));
+  MarkLostPackets (tcbd, m_largestAcked);
+  NS_ASSERT_MSG (CheckCounters (), "Inconsistent byte counters after the loss timeout");
+}
+
+Time QuicSocketTxBuffer::GetLossTime () const
+{
+  return m_lossTime;
 }
 
 void QuicSocketTxBuffer::ResetSentList (uint32_t keepItems)
 {
   NS_LOG_FUNCTION (this << keepItems);
   uint32_t kept = 0;
-  for (auto sent_it = m_sentList.rbegin ();
-       sent_it != m_sentList.rend () and !m_sentList.empty ();
-       ++sent_it, kept++)
+  for (auto sent_it = m_sentList.rbegin (); sent_it != m_sentList.rend ();
+       ++sent_it)
     {
+      if (*sent_it == nullptr)
+        {
+          continue;
+        }
       if (kept >= keepItems && !(*sent_it)->m_sacked)
         {
-          (*sent_it)->m_lost = true;
+          SetLost (*sent_it);
         }
+      kept++;
     }
 }
 
 bool QuicSocketTxBuffer::MarkAsLost (const SequenceNumber32 seq)
 {
   NS_LOG_FUNCTION (this << seq);
-  bool found = false;
-  for (auto sent_it = m_sentList.begin ();
-       sent_it != m_sentList.end () and !m_sentList.empty (); ++sent_it)
+  Ptr<QuicSocketTxItem> item = GetSentItem (seq.GetValue ());
+  if (item != nullptr)
     {
-      if ((*sent_it)->m_packetNumber == seq)
-        {
-          found = true;
-          (*sent_it)->m_lost = true;
-        }
+      SetLost (item);
+      return true;
     }
-  return found;
+  return false;
 }
 
 uint32_t QuicSocketTxBuffer::Retransmission (SequenceNumber32 packetNumber)
@@ -540,111 +629,494 @@ uint32_t QuicSocketTxBuffer::Retransmission (SequenceNumber32 packetNumber)
   NS_LOG_FUNCTION (this);
   uint32_t toRetx = 0;
   // First pass: add lost packets to the application buffer
-  for (auto sent_it = m_sentList.rbegin (); sent_it != m_sentList.rend ();
-       ++sent_it)
+  for (auto lost_it = m_lostPackets.rbegin (); lost_it != m_lostPackets.rend ();
+       ++lost_it)
     {
-      Ptr<QuicSocketTxItem> item = *sent_it;
-      if (item->m_lost)
+      Ptr<QuicSocketTxItem> item = GetSentItem (*lost_it);
+      NS_ASSERT (item != nullptr and item->m_lost);
+      m_sentSize -= item->m_packet->GetSize ();
+      if (IsInFlight (item))
         {
-          // Add lost packet contents to app buffer
-          Ptr<QuicSocketTxItem> retx = CreateObject<QuicSocketTxItem> ();
-          retx->m_packetNumber = packetNumber++;
-          retx->m_isStream = item->m_isStream;
-          retx->m_isStream0 = item->m_isStream0;
-          retx->m_packet = Create<Packet>();
-          NS_LOG_INFO (
-            "Retx packet " << item->m_packetNumber << " as " << retx->m_packetNumber.GetValue ());
-          QuicSocketTxItem::MergeItems (*retx, *item);
-          retx->m_lost = false;
-          retx->m_retrans = true;
-          toRetx += retx->m_packet->GetSize ();
-          m_sentSize -= retx->m_packet->GetSize ();
-          if (retx->m_isStream0)
+          m_inFlightSize -= item->m_packet->GetSize ();
+        }
+      if (item->m_isStream0)
+        {
+          toRetx += RetransmitFrames (item, 0, item->m_packet->GetSize (), item->m_frames.begin (),
+                                      item->m_frames.end (), packetNumber++);
+          continue;
+        }
+      // Requeue each frame on its own, so that the scheduler does not need to parse the packet
+      uint32_t start = 0;
+      std::deque<Ptr<Packet> > lostControl;
+      for (auto frame_it = item->m_frames.begin (); frame_it != item->m_frames.end (); ++frame_it)
+        {
+          std::vector<QuicStreamTxRange> missing;
+          if (frame_it->m_control)
             {
-              NS_LOG_INFO ("Lost stream 0 packet, re-inserting in list");
-              m_streamZeroList.insert (m_streamZeroList.begin (), retx);
-              m_streamZeroSize += retx->m_packet->GetSize ();
-              m_numFrameStream0InBuffer++;
+              // lost control frames are packed again in the next packets,
+              // with the latest flow control limits rather than the stale ones
+              Ptr<Packet> frame = item->m_packet->CreateFragment (start, frame_it->m_size);
+              if (!m_lostControlFramesCb.IsNull ())
+                {
+                  frame = m_lostControlFramesCb (frame);
+                }
+              lostControl.push_back (frame);
+              m_controlSize += frame->GetSize ();
+              toRetx += frame->GetSize ();
+            }
+          else if (frame_it->m_length > 0 and !m_lostStreamDataCb.IsNull ()
+              and m_lostStreamDataCb (frame_it->m_streamId, frame_it->m_offset,
+                                      frame_it->m_length, missing))
+            {
+              // Only send again the data that has not been acknowledged in the meantime
+              for (const QuicStreamTxRange &range : missing)
+                {
+                  toRetx += RetransmitStreamData (item, *frame_it, range, packetNumber++);
+                }
             }
           else
             {
-              m_scheduler->Add (retx, true);
+              toRetx += RetransmitFrames (item, start, frame_it->m_size, frame_it, frame_it + 1,
+                                          packetNumber++);
             }
+          start += frame_it->m_size;
         }
+      NS_ASSERT_MSG (start == item->m_packet->GetSize (),
+                     "Frames do not cover packet " << item->m_packetNumber);
+      // the lost packets are visited from the most recent one, so the control
+      // frames of each packet go before the ones already queued, in their original order
+      m_controlList.insert (m_controlList.begin (), lostControl.begin (), lostControl.end ());
     }
 
   NS_LOG_LOGIC ("Remove retransmitted packets from sent list");
-  auto sent_it = m_sentList.begin ();
   // Remove lost packets from the sent list
-  while (!m_sentList.empty () && sent_it != m_sentList.end ())
+  for (auto lost_it = m_lostPackets.begin (); lost_it != m_lostPackets.end ();
+       ++lost_it)
     {
-      Ptr<QuicSocketTxItem> item = *sent_it;
-      if (item->m_lost)
-        {
-          // Remove lost packet from sent vector
-          sent_it = m_sentList.erase (sent_it);
-        }
-      else
-        {
-          sent_it++;
-        }
+      m_sentList.at (*lost_it - m_sentListBase) = nullptr;
     }
+  m_lostPackets.clear ();
+  m_lostSize = 0;
+  TrimSentList ();
+  NS_ASSERT_MSG (CheckCounters (), "Inconsistent byte counters after retransmission");
   return toRetx;
 }
 
+uint32_t QuicSocketTxBuffer::RetransmitFrames (Ptr<QuicSocketTxItem> item, uint32_t start,
+                                               uint32_t size, QuicTxFrameIterator first,
+                                               QuicTxFrameIterator last,
+                                               SequenceNumber32 packetNumber)
+{
+  NS_LOG_FUNCTION (this << item->m_packetNumber << start << size);
+  // Add lost packet contents to app buffer
+  Ptr<QuicSocketTxItem> retx = CreateRetransmission (item, packetNumber);
+  retx->m_packet = (start == 0 and size == item->m_packet->GetSize ()) ?
+    item->m_packet->Copy () : item->m_packet->CreateFragment (start, size);
+  retx->m_frames.assign (first, last);
+  return QueueRetransmission (retx);
+}
+
+uint32_t QuicSocketTxBuffer::RetransmitStreamData (Ptr<QuicSocketTxItem> item,
+                                                   const QuicSocketTxFrame &frame,
+                                                   const QuicStreamTxRange &range,
+                                                   SequenceNumber32 packetNumber)
+{
+  NS_LOG_FUNCTION (this << item->m_packetNumber << frame.m_streamId << range.first);
+  QuicSocketTxFrame missing = frame;
+  missing.m_offset = range.first;
+  missing.m_length = range.second->GetSize ();
+  missing.m_fin = frame.m_fin and missing.m_offset + missing.m_length == frame.m_offset + frame.m_length;
+
+  Ptr<QuicSocketTxItem> retx = CreateRetransmission (item, packetNumber);
+  retx->m_packet = range.second;
+  retx->m_packet->AddHeader (QuicSubheader::CreateStreamSubHeader (
+                               missing.m_streamId, missing.m_offset, missing.m_length,
+                               missing.m_offset != 0, true, missing.m_fin));
+  missing.m_size = retx->m_packet->GetSize ();
+  retx->m_frames.assign (1, missing);
+  return QueueRetransmission (retx);
+}
+
+Ptr<QuicSocketTxItem> QuicSocketTxBuffer::CreateRetransmission (Ptr<QuicSocketTxItem> item,
+                                                                SequenceNumber32 packetNumber)
+{
+  Ptr<QuicSocketTxItem> retx = m_itemPool->Allocate ();
+  retx->m_packetNumber = packetNumber;
+  retx->m_isStream = item->m_isStream;
+  retx->m_isStream0 = item->m_isStream0;
+  retx->m_retrans = true;
+  retx->m_lastSent = std::max (retx->m_lastSent, item->m_lastSent);
+  retx->m_generated = std::min (retx->m_generated, item->m_generated);
+  NS_LOG_INFO (
+    "Retx packet " << item->m_packetNumber << " as " << retx->m_packetNumber.GetValue ());
+  return retx;
+}
+
+void QuicSocketTxBuffer::PackControlFrames (Ptr<QuicSocketTxItem> item, uint32_t numBytes)
+{
+  NS_LOG_FUNCTION (this << numBytes);
+
+  while (!m_controlList.empty ()
+         and item->m_packet->GetSize () + m_controlList.front ()->GetSize () <= numBytes)
+    {
+      Ptr<Packet> frame = m_controlList.front ();
+      m_controlList.pop_front ();
+      m_controlSize -= frame->GetSize ();
+
+      QuicSocketTxFrame control;
+      control.m_size = frame->GetSize ();
+      control.m_control = true;
+      item->m_frames.push_back (control);
+      item->m_packet->AddAtEnd (frame);
+      NS_LOG_LOGIC ("Packed a control frame of size " << control.m_size);
+    }
+}
+
+uint32_t QuicSocketTxBuffer::QueueRetransmission (Ptr<QuicSocketTxItem> retx)
+{
+  uint32_t size = retx->m_packet->GetSize ();
+  if (retx->m_isStream0)
+    {
+      NS_LOG_INFO ("Lost stream 0 packet, re-inserting in list");
+      m_streamZeroList.insert (m_streamZeroList.begin (), retx);
+      m_streamZeroSize += size;
+      m_numFrameStream0InBuffer++;
+    }
+  else
+    {
+      m_scheduler->Add (retx, true);
+    }
+  return size;
+}
+
+void QuicSocketTxBuffer::SetLostStreamDataCallback (LostStreamDataCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_lostStreamDataCb = cb;
+}
+
+void QuicSocketTxBuffer::SetLostControlFramesCallback (LostControlFramesCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_lostControlFramesCb = cb;
+}
+
+void QuicSocketTxBuffer::SetExpiredStreamDataCallback (QuicSocketTxScheduler::ExpiredDataCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_expiredStreamDataCb = cb;
+  if (m_scheduler != nullptr)
+    {
+      m_scheduler->SetExpiredDataCallback (cb);
+    }
+}
+
 std::vector<Ptr<QuicSocketTxItem> > QuicSocketTxBuffer::DetectLostPackets ()
 {
   NS_LOG_FUNCTION (this);
   std::vector<Ptr<QuicSocketTxItem> > lost;
 
-  for (auto sent_it = m_sentList.begin ();
-       sent_it != m_sentList.end () and !m_sentList.empty (); ++sent_it)
+  for (auto lost_it = m_lostPackets.begin (); lost_it != m_lostPackets.end ();
+       ++lost_it)
     {
-      if ((*sent_it)->m_lost)
-        {
-          lost.push_back ((*sent_it));
-          NS_LOG_INFO ("Packet " << (*sent_it)->m_packetNumber << " is lost");
-        }
+      lost.push_back (GetSentItem (*lost_it));
+      NS_LOG_INFO ("Packet " << *lost_it << " is lost");
     }
   return lost;
 }
 
-uint32_t QuicSocketTxBuffer::GetLost ()
+std::vector<QuicSpuriousLoss> QuicSocketTxBuffer::DetectSpuriousLosses ()
 {
   NS_LOG_FUNCTION (this);
-  uint32_t lostCount = 0;
-  for (auto sent_it = m_sentList.begin ();
-       sent_it != m_sentList.end () and !m_sentList.empty (); ++sent_it)
+  std::vector<QuicSpuriousLoss> spurious;
+  // the blocks are visited from the highest one
+  spurious.swap (m_spuriousLosses);
+  std::sort (spurious.begin (), spurious.end (),
+             [] (const QuicSpuriousLoss &a, const QuicSpuriousLoss &b) { return a.m_packetNumber < b.m_packetNumber; });
+  return spurious;
+}
+
+bool QuicSocketTxBuffer::IsPersistentCongestion (const std::vector<Ptr<QuicSocketTxItem> > &lostPackets,
+                                                 Time duration) const
+{
+  NS_LOG_FUNCTION (this << duration);
+
+  if (lostPackets.size () < 2)
+    {
+      return false;
+    }
+  Ptr<QuicSocketTxItem> first = lostPackets.front ();
+  Ptr<QuicSocketTxItem> last = lostPackets.back ();
+  if (last->m_lastSent - first->m_lastSent <= duration)
+    {
+      return false;
+    }
+
+  // the lost packets are still in the sent list, and so are the ones between them
+  for (uint32_t pn = first->m_packetNumber.GetValue () + 1; pn < last->m_packetNumber.GetValue (); ++pn)
     {
-      if ((*sent_it)->m_lost)
+      Ptr<QuicSocketTxItem> item = GetSentItem (pn);
+      if (item != nullptr and item->m_sacked)
         {
-          lostCount += (*sent_it)->m_packet->GetSize ();
+          NS_LOG_LOGIC ("Packet " << pn << " acknowledged in the congestion period");
+          return false;
         }
     }
-  return lostCount;
+  return true;
+}
+
+uint32_t QuicSocketTxBuffer::GetLost ()
+{
+  NS_LOG_FUNCTION (this);
+  return m_lostSize;
 }
 
 void QuicSocketTxBuffer::CleanSentList ()
 {
   NS_LOG_FUNCTION (this);
-  auto sent_it = m_sentList.begin ();
   // All packets up to here are ACKed (already sent to the receiver app)
-  while (!m_sentList.empty () && (*sent_it)->m_sacked && !(*sent_it)->m_lost)
+  while (!m_sentList.empty ()
+         && (m_sentList.front () == nullptr
+             || (m_sentList.front ()->m_sacked && !m_sentList.front ()->m_lost)))
     {
       // Remove ACKed packet from sent vector
-      Ptr<QuicSocketTxItem> item = *sent_it;
-      item->m_acked = true;
-      m_sentSize -= item->m_packet->GetSize ();
-      m_sentList.erase (sent_it);
-      NS_LOG_LOGIC (
-        "Packet " << (*sent_it)->m_packetNumber << " received and ACKed. Removing from sent buffer");
-      sent_it = m_sentList.begin ();
+      Ptr<QuicSocketTxItem> item = m_sentList.front ();
+      if (item != nullptr)
+        {
+          item->m_acked = true;
+          m_sentSize -= item->m_packet->GetSize ();
+          NS_LOG_LOGIC (
+            "Packet " << item->m_packetNumber << " received and ACKed. Removing from sent buffer");
+        }
+      m_sentList.pop_front ();
+      ++m_sentListBase;
+    }
+  TrimSentList ();
+}
+
+void QuicSocketTxBuffer::TrimSentList ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_sentList.empty () && m_sentList.front () == nullptr)
+    {
+      m_sentList.pop_front ();
+      ++m_sentListBase;
+    }
+  while (!m_sentList.empty () && m_sentList.back () == nullptr)
+    {
+      m_sentList.pop_back ();
+    }
+
+  if (m_sentList.empty ())
+    {
+      m_sackedRanges.clear ();
+      return;
+    }
+
+  // Forget the ACK ranges below the sent list
+  while (!m_sackedRanges.empty () && m_sackedRanges.begin ()->second < m_sentListBase)
+    {
+      m_sackedRanges.erase (m_sackedRanges.begin ());
+    }
+}
+
+void QuicSocketTxBuffer::AddToSentList (Ptr<QuicSocketTxItem> item)
+{
+  NS_LOG_FUNCTION (this << item->m_packetNumber);
+  uint32_t packetNumber = item->m_packetNumber.GetValue ();
+
+  if (m_sentList.empty ())
+    {
+      m_sentListBase = packetNumber;
+    }
+  NS_ASSERT_MSG (packetNumber >= m_sentListBase + m_sentList.size (),
+                 "Packet " << packetNumber << " sent out of order");
+
+  // Leave an empty slot for the packet numbers not used by this buffer
+  m_sentList.resize (packetNumber - m_sentListBase, nullptr);
+  m_sentList.push_back (item);
+  m_sentSize += item->m_packet->GetSize ();
+  if (IsInFlight (item))
+    {
+      m_inFlightSize += item->m_packet->GetSize ();
+    }
+  if (item->m_lost)
+    {
+      SetLost (item);
+    }
+}
+
+Ptr<QuicSocketTxItem> QuicSocketTxBuffer::GetSentItem (uint32_t packetNumber) const
+{
+  if (packetNumber < m_sentListBase
+      or packetNumber - m_sentListBase >= m_sentList.size ())
+    {
+      return nullptr;
+    }
+  return m_sentList[packetNumber - m_sentListBase];
+}
+
+void QuicSocketTxBuffer::AckBlock (uint32_t low, uint32_t high,
+                                   std::vector<Ptr<QuicSocketTxItem> > &newlyAcked)
+{
+  NS_LOG_FUNCTION (this << low << high);
+
+  if (m_sentList.empty ())
+    {
+      return;
+    }
+  // Only consider the packets in the sent list
+  low = std::max (low, m_sentListBase);
+  high = std::min (high, (uint32_t)(m_sentListBase + m_sentList.size () - 1));
+  if (low > high)
+    {
+      return;
+    }
+
+  // Visit, in reverse order, the packet numbers of [low, high] that are not
+  // in a range already acknowledged by a previous block
+  auto range_it = std::map<uint32_t, uint32_t>::reverse_iterator (
+    m_sackedRanges.upper_bound (high));
+  uint32_t top = high;
+  bool done = false;
+  while (!done)
+    {
+      uint32_t bottom = low;
+      if (range_it != m_sackedRanges.rend () and range_it->second >= low)
+        {
+          if (range_it->second >= top)
+            {
+              // The top of the interval is already acknowledged: skip the range
+              done = (range_it->first <= low);
+              top = done ? top : range_it->first - 1;
+              ++range_it;
+              continue;
+            }
+          bottom = range_it->second + 1;
+        }
+      else
+        {
+          done = true;
+        }
+
+      for (uint32_t pn = top + 1; pn > bottom; )
+        {
+          --pn;
+          Ptr<QuicSocketTxItem> item = m_sentList[pn - m_sentListBase];
+          if (item != nullptr and !item->m_sacked)
+            {
+              NS_LOG_LOGIC ("Packet " << item->m_packetNumber << " ACKed");
+              if (IsInFlight (item))
+                {
+                  m_inFlightSize -= item->m_packet->GetSize ();
+                }
+              item->m_sacked = true;
+              item->m_ackTime = Now ();
+              newlyAcked.push_back (item);
+              UpdateRateSample (item);
+            }
+        }
+
+      if (!done)
+        {
+          // Continue below the acknowledged range that ends at bottom - 1
+          done = (range_it->first <= low);
+          top = done ? top : range_it->first - 1;
+          ++range_it;
+        }
+    }
+
+  // Merge [low, high] with the overlapping or adjacent acknowledged ranges
+  auto merge_it = m_sackedRanges.upper_bound (high + 1);
+  while (merge_it != m_sackedRanges.begin ())
+    {
+      auto prev_it = std::prev (merge_it);
+      if (prev_it->second + 1 < low)
+        {
+          break;
+        }
+      low = std::min (low, prev_it->first);
+      high = std::max (high, prev_it->second);
+      merge_it = m_sackedRanges.erase (prev_it);
+    }
+  m_sackedRanges[low] = high;
+}
+
+void QuicSocketTxBuffer::SetLost (Ptr<QuicSocketTxItem> item)
+{
+  item->m_lost = true;
+  if (m_lostPackets.insert (item->m_packetNumber.GetValue ()).second)
+    {
+      m_lostSize += item->m_packet->GetSize ();
+    }
+}
+
+void QuicSocketTxBuffer::DeclareLost (Ptr<QuicSocketTxItem> item)
+{
+  SetLost (item);
+  m_declaredLost[item->m_packetNumber.GetValue ()] = item->m_lastSent;
+  // Forget the oldest losses, which are not going to be acknowledged
+  while (m_declaredLost.size () > MAX_DECLARED_LOST)
+    {
+      m_declaredLost.erase (m_declaredLost.begin ());
+    }
+}
+
+void QuicSocketTxBuffer::AckDeclaredLost (uint32_t low, uint32_t high)
+{
+  NS_LOG_FUNCTION (this << low << high);
+  auto lost_it = m_declaredLost.lower_bound (low);
+  while (lost_it != m_declaredLost.end () and lost_it->first <= high)
+    {
+      QuicSpuriousLoss loss;
+      loss.m_packetNumber = SequenceNumber32 (lost_it->first);
+      loss.m_lastSent = lost_it->second;
+      loss.m_reordering = (m_largestAcked > lost_it->first) ? m_largestAcked - lost_it->first : 0;
+      NS_LOG_INFO ("Packet " << lost_it->first << " spuriously lost, reordering " << loss.m_reordering);
+      m_spuriousLosses.push_back (loss);
+      lost_it = m_declaredLost.erase (lost_it);
+    }
+}
+
+bool QuicSocketTxBuffer::IsInFlight (Ptr<const QuicSocketTxItem> item)
+{
+  return !item->m_isStream0 && item->m_isStream && !item->m_sacked;
+}
+
+bool QuicSocketTxBuffer::CheckCounters () const
+{
+  uint32_t sent = 0;
+  uint32_t inFlight = 0;
+  for (auto sent_it = m_sentList.begin (); sent_it != m_sentList.end (); ++sent_it)
+    {
+      if (*sent_it == nullptr)
+        {
+          continue;
+        }
+      sent += (*sent_it)->m_packet->GetSize ();
+      if (IsInFlight (*sent_it))
+        {
+          inFlight += (*sent_it)->m_packet->GetSize ();
+        }
+    }
+  uint32_t lost = 0;
+  for (auto lost_it = m_lostPackets.begin (); lost_it != m_lostPackets.end (); ++lost_it)
+    {
+      Ptr<QuicSocketTxItem> item = GetSentItem (*lost_it);
+      if (item == nullptr or !item->m_lost)
+        {
+          return false;
+        }
+      lost += item->m_packet->GetSize ();
     }
+  NS_LOG_LOGIC ("Sent " << sent << "/" << m_sentSize << ", in flight " << inFlight << "/"
+                        << m_inFlightSize << ", lost " << lost << "/" << m_lostSize);
+  return sent == m_sentSize && inFlight == m_inFlightSize && lost == m_lostSize;
 }
 
 uint32_t QuicSocketTxBuffer::Available (void) const
 {
-  return m_maxBuffer - m_streamZeroSize - m_scheduler->AppSize ();
+  return m_maxBuffer - m_streamZeroSize - m_controlSize - m_scheduler->AppSize ();
 }
 
 uint32_t QuicSocketTxBuffer::GetMaxBufferSize (void) const
@@ -659,7 +1131,7 @@ void QuicSocketTxBuffer::SetMaxBufferSize (uint32_t n)
 
 uint32_t QuicSocketTxBuffer::AppSize (void) const
 {
-  return m_streamZeroSize + m_scheduler->AppSize ();
+  return m_streamZeroSize + m_controlSize + m_scheduler->AppSize ();
 }
 
 uint32_t QuicSocketTxBuffer::GetNumFrameStream0InBuffer (void) const
@@ -667,26 +1139,17 @@ uint32_t QuicSocketTxBuffer::GetNumFrameStream0InBuffer (void) const
   return m_numFrameStream0InBuffer;
 }
 
+uint32_t QuicSocketTxBuffer::GetNumControlFramesInBuffer (void) const
+{
+  return m_controlList.size ();
+}
+
 uint32_t QuicSocketTxBuffer::BytesInFlight () const
 {
   NS_LOG_FUNCTION (this);
-
-  uint32_t inFlight = 0;
-
-  for (auto sent_it = m_sentList.begin ();
-       sent_it != m_sentList.end () and !m_sentList.empty (); ++sent_it)
-    {
-      if (!(*sent_it)->m_isStream0 && (*sent_it)->m_isStream
-          && !(*sent_it)->m_sacked)
-        {
-          inFlight += (*sent_it)->m_packet->GetSize ();
-        }
-    }
-
   NS_LOG_INFO (
-    "Compute bytes in flight " << inFlight << " m_sentSize " << m_sentSize << " m_appSize " << m_streamZeroSize + m_scheduler->AppSize ());
-  return inFlight;
-
+    "Bytes in flight " << m_inFlightSize << " m_sentSize " << m_sentSize << " m_appSize " << m_streamZeroSize + m_scheduler->AppSize ());
+  return m_inFlightSize;
 }
 
 void QuicSocketTxBuffer::SetQuicSocketState (Ptr<QuicSocketState> tcb)
@@ -699,6 +1162,13 @@ void QuicSocketTxBuffer::SetScheduler (Ptr<QuicSocketTxScheduler> sched)
 {
   NS_LOG_FUNCTION (this);
   m_scheduler = sched;
+  m_scheduler->SetItemPool (m_itemPool);
+  m_scheduler->SetExpiredDataCallback (m_expiredStreamDataCb);
+}
+
+Ptr<QuicSocketTxItemPool> QuicSocketTxBuffer::GetItemPool () const
+{
+  return m_itemPool;
 }
 
 void QuicSocketTxBuffer::UpdatePacketSent (SequenceNumber32 seq, uint32_t sz)
@@ -716,15 +1186,7 @@ void QuicSocketTxBuffer::UpdatePacketSent (SequenceNumber32 seq, uint32_t sz)
       m_tcb->m_deliveredTime = Simulator::Now ();
     }
 
-  Ptr<QuicSocketTxItem> item = nullptr;
-  for (auto it = m_sentList.rbegin (); it != m_sentList.rend (); ++it)
-    {
-      if ((*it)->m_packetNumber == seq)
-        {
-          item = *it;
-          break;
-        }
-    }
+  Ptr<QuicSocketTxItem> item = GetSentItem (seq.GetValue ());
   NS_ASSERT_MSG (item != nullptr, "not found seq " << seq);
   item->m_firstSentTime = m_tcb->m_firstSentTime;
   item->m_deliveredTime = m_tcb->m_deliveredTime;
@@ -862,4 +1324,61 @@ Time QuicSocketTxBuffer::GetDefaultLatency ()
   return GetLatency (0);
 }
 
+void QuicSocketTxBuffer::SetStreamPriority (uint32_t streamId, uint8_t urgency, bool incremental)
+{
+  // Only relevant for the priority scheduler
+  if (m_scheduler->GetTypeId () == QuicSocketTxPriorityScheduler::GetTypeId ())
+    {
+      (DynamicCast<QuicSocketTxPriorityScheduler> (m_scheduler))->SetPriority (streamId, urgency, incremental);
+    }
+}
+
+uint8_t QuicSocketTxBuffer::GetStreamUrgency (uint32_t streamId)
+{
+  // Only relevant for the priority scheduler
+  if (m_scheduler->GetTypeId () == QuicSocketTxPriorityScheduler::GetTypeId ())
+    {
+      return (DynamicCast<QuicSocketTxPriorityScheduler> (m_scheduler))->GetUrgency (streamId);
+    }
+  else
+    {
+      return 0;
+    }
+}
+
+bool QuicSocketTxBuffer::GetStreamIncremental (uint32_t streamId)
+{
+  // Only relevant for the priority scheduler
+  if (m_scheduler->GetTypeId () == QuicSocketTxPriorityScheduler::GetTypeId ())
+    {
+      return (DynamicCast<QuicSocketTxPriorityScheduler> (m_scheduler))->GetIncremental (streamId);
+    }
+  else
+    {
+      return false;
+    }
+}
+
+void QuicSocketTxBuffer::SetDropExpired (uint32_t streamId, bool drop)
+{
+  // Only relevant for the EDF scheduler
+  if (m_scheduler->GetTypeId () == QuicSocketTxEdfScheduler::GetTypeId ())
+    {
+      (DynamicCast<QuicSocketTxEdfScheduler> (m_scheduler))->SetDropExpired (streamId, drop);
+    }
+}
+
+bool QuicSocketTxBuffer::GetDropExpired (uint32_t streamId)
+{
+  // Only relevant for the EDF scheduler
+  if (m_scheduler->GetTypeId () == QuicSocketTxEdfScheduler::GetTypeId ())
+    {
+      return (DynamicCast<QuicSocketTxEdfScheduler> (m_scheduler))->GetDropExpired (streamId);
+    }
+  else
+    {
+      return false;
+    }
+}
+
 }
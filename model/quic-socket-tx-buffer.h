@@ -25,6 +25,10 @@
 #ifndef QUICSOCKETTXBUFFER_H
 #define QUICSOCKETTXBUFFER_H
 
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
 #include "ns3/object.h"
 #include "ns3/traced-value.h"
 #include "ns3/sequence-number.h"
@@ -33,7 +37,10 @@
 #include "ns3/packet.h"
 #include "ns3/tcp-socket-base.h"
 #include "ns3/data-rate.h"
+#include "ns3/callback.h"
 #include "quic-socket-tx-scheduler.h"
+#include "quic-stream-tx-buffer.h"
+#include "quic-tx-item-pool.h"
 
 namespace ns3 {
 
@@ -56,22 +63,51 @@ struct RateSample
   uint8_t m_ackBytesMaxWin { 0 };
 };
 
+/**
+ * \ingroup quic
+ *
+ * \brief Description of a frame enclosed in a QuicSocketTxItem
+ *
+ * The frame description is filled when the frame enters the socket buffer,
+ * so that the scheduling and the retransmission of the frame do not need to
+ * deserialize its subheader again.
+ */
+struct QuicSocketTxFrame
+{
+  uint64_t m_streamId { 0 };    //!< ID of the stream of the frame
+  uint64_t m_offset { 0 };      //!< Offset of the frame data in the stream
+  uint32_t m_length { 0 };      //!< Length of the frame data
+  uint32_t m_size { 0 };        //!< Size of the frame, including the subheader
+  bool m_fin { false };         //!< FIN bit of the frame
+  bool m_control { false };     //!< True for a control frame, queued again for retransmission
+};
+
+/**
+ * \ingroup quic
+ *
+ * \brief A packet declared lost by the reordering thresholds and acknowledged afterwards
+ */
+struct QuicSpuriousLoss
+{
+  SequenceNumber32 m_packetNumber;  //!< Packet number of the spuriously lost packet
+  Time m_lastSent;                  //!< Time at which the packet was sent
+  uint32_t m_reordering { 0 };      //!< Distance from the largest acked packet number when the packet was acked
+};
+
 /**
  * \ingroup quic
  *
  * \brief Item that encloses the application packet and some flags for it
+ *
+ * The items are lightweight reference-counted records, allocated from the
+ * QuicTxItemPool of the socket and recycled when they are released.
  */
-class QuicSocketTxItem : public Object
+class QuicSocketTxItem : public SimpleRefCount<QuicSocketTxItem, Empty, QuicTxItemPoolDeleter<QuicSocketTxItem> >
 {
 public:
-  /**
-   * \brief Get the type ID.
-   * \return the object TypeId
-   */
-  static TypeId GetTypeId (void);
-
   QuicSocketTxItem ();
   QuicSocketTxItem (const QuicSocketTxItem &other);
+  QuicSocketTxItem &operator= (const QuicSocketTxItem &other) = default;
 
   /**
    * \brief Merge two QuicSocketTxItem
@@ -85,7 +121,17 @@ public:
    */
   static void MergeItems (QuicSocketTxItem &t1, QuicSocketTxItem &t2);
 
-  // Available only for streams
+  /**
+   * \brief Split a QuicSocketTxItem
+   *
+   * Available only for items with a single STREAM frame. t1 keeps the first
+   * size bytes of the frame data, and t2 gets the rest. The subheaders of the
+   * two frames are built from the frame description.
+   *
+   * \param t1 the item to split
+   * \param t2 the item receiving the second part of the frame
+   * \param size the data bytes kept in t1
+   */
   static void SplitItems (QuicSocketTxItem &t1, QuicSocketTxItem &t2,
                           uint32_t size);
 
@@ -96,6 +142,7 @@ public:
   void Print (std::ostream &os) const;
 
   Ptr<Packet> m_packet;              //!< packet associated to this QuicSocketTxItem
+  std::vector<QuicSocketTxFrame> m_frames;  //!< frames in the packet, in order
   SequenceNumber32 m_packetNumber;        //!< sequence number
   bool m_lost;                            //!< true if the packet is lost
   bool m_retrans;                         //!< true if it is a retx
@@ -112,8 +159,16 @@ public:
   Time m_firstSentTime { Seconds (0) };      //!< Connection's first sent time at the time the packet was sent
   bool m_isAppLimited { false };       //!< Connection's app limited at the time the packet was sent
   uint32_t m_ackBytesSent { 0 };       //!< Connection's ACK-only bytes sent at the time the packet was sent
+
+private:
+  friend class QuicTxItemPool<QuicSocketTxItem>;
+  friend struct QuicTxItemPoolDeleter<QuicSocketTxItem>;
+
+  Ptr<QuicTxItemPool<QuicSocketTxItem> > m_pool;  //!< The pool the item is returned to, if any
 };
 
+typedef QuicTxItemPool<QuicSocketTxItem> QuicSocketTxItemPool;  //!< Pool of QuicSocketTxItem
+
 /**
  * \ingroup quic
  *
@@ -143,6 +198,10 @@ public:
   /**
    * Add a packet to the tx buffer
    *
+   * The control frames, i.e., all the frames but STREAM, are kept in a
+   * separate queue, and packed in the free space of the packets built by
+   * NextSequence, or sent on their own if there is no stream data.
+   *
    * \param p a smart pointer to a packet
    * \return true if the insertion was successful
    */
@@ -161,9 +220,10 @@ public:
    * \brief Get a block of data not transmitted yet and move it into SentList
    *
    * \param numBytes number of bytes of the QuicSocketTxItem requested
+   * \param seq the sequence number of the packet that carries the block
    * \return the item that contains the right packet
    */
-  Ptr<QuicSocketTxItem> GetNewSegment (uint32_t numBytes);
+  Ptr<QuicSocketTxItem> GetNewSegment (uint32_t numBytes, const SequenceNumber32 seq);
 
   /**
    * Process an acknowledgment, set the packets in the send buffer as acknowledged, mark
@@ -183,6 +243,23 @@ public:
                                                    const std::vector<uint32_t> &additionalAckBlocks,
                                                    const std::vector<uint32_t> &gaps);
 
+  /**
+   * \brief Declare the packets that crossed the time threshold since the last ACK
+   *
+   * Called when the loss time expires, it marks the late packets as lost and
+   * computes the next loss time
+   *
+   * \param tcb The state of the socket (used for loss detection)
+   */
+  void OnLossTimeout (Ptr<TcpSocketState> tcb);
+
+  /**
+   * \brief Get the earliest time at which an outstanding packet crosses the time threshold
+   *
+   * \return the loss time, or zero if no packet can be lost by time
+   */
+  Time GetLossTime () const;
+
   /**
    * Get the max size of the buffer
    *
@@ -204,6 +281,28 @@ public:
    */
   std::vector<Ptr<QuicSocketTxItem> > DetectLostPackets ();
 
+  /**
+   * \brief Get the packets declared lost that were acknowledged by the last ACKs
+   *
+   * Each spurious loss is reported only once
+   *
+   * \return a vector containing the spurious losses, by increasing packet number
+   */
+  std::vector<QuicSpuriousLoss> DetectSpuriousLosses ();
+
+  /**
+   * \brief Check whether lost packets declare persistent congestion (RFC 9002, Sec. 7.6)
+   *
+   * The first and the last lost packets must be sent more than duration apart,
+   * and no packet sent between them can be acknowledged
+   *
+   * \param lostPackets the lost packets, by increasing packet number
+   * \param duration the persistent congestion duration
+   * \return true if the losses declare persistent congestion
+   */
+  bool IsPersistentCongestion (const std::vector<Ptr<QuicSocketTxItem> > &lostPackets,
+                               Time duration) const;
+
   /**
    * \brief Count the amount of lost bytes
    *
@@ -239,6 +338,13 @@ public:
    */
   uint32_t GetNumFrameStream0InBuffer (void) const;
 
+  /**
+   * Return the number of control frames waiting to be sent
+   *
+   * \return the number of control frames in the buffer
+   */
+  uint32_t GetNumControlFramesInBuffer (void) const;
+
   /**
    * Return the next frame for stream 0 to be sent
    * and add this packet to the sent list
@@ -248,6 +354,16 @@ public:
    */
   Ptr<Packet> NextStream0Sequence (const SequenceNumber32 seq);
 
+  /**
+   * Return a packet made only of the control frames waiting to be sent
+   * and add this packet to the sent list
+   *
+   * \param numBytes the maximum size of the packet, at least the first control frame is packed
+   * \param seq the sequence number of the packet
+   * \return a smart pointer to the packet, empty if there are no control frames
+   */
+  Ptr<Packet> NextControlSequence (uint32_t numBytes, const SequenceNumber32 seq);
+
   /**
    * \brief Reset the sent list
    *
@@ -269,11 +385,52 @@ public:
 
   /**
    * Put the lost packets at the beginning of the application buffer to retransmit them
+   *
+   * If a callback for lost stream data is set, only the parts of the lost
+   * stream frames that have not been acknowledged in the meantime are put
+   * back in the buffer.
+   *
    * \param the sequence number of the retransmitted packet
-   * \return the number of lost bytes
+   * \return the number of bytes to retransmit
    */
   uint32_t Retransmission (SequenceNumber32 packetNumber);
 
+  /**
+   * \brief Callback for the data of a lost stream frame
+   *
+   * The arguments are the stream ID, the offset and the length of the lost
+   * data, and the vector to fill with the data that is still missing. The
+   * callback returns false if the stream is unknown.
+   */
+  typedef Callback<bool, uint64_t, uint64_t, uint32_t, std::vector<QuicStreamTxRange> &> LostStreamDataCallback;
+
+  /**
+   * Set the callback used to find the still missing data of lost stream frames
+   * \param cb the callback
+   */
+  void SetLostStreamDataCallback (LostStreamDataCallback cb);
+
+  /**
+   * \brief Callback for the frames of a lost control packet
+   *
+   * The argument is a control packet, as added to the buffer, and the
+   * callback returns the frames to send again, with the flow control limits
+   * updated to their latest value.
+   */
+  typedef Callback<Ptr<Packet>, Ptr<Packet> > LostControlFramesCallback;
+
+  /**
+   * Set the callback used to refresh the lost control frames before they are queued again
+   * \param cb the callback
+   */
+  void SetLostControlFramesCallback (LostControlFramesCallback cb);
+
+  /**
+   * Set the callback notified of the stream data that the scheduler drops because expired
+   * \param cb the callback
+   */
+  void SetExpiredStreamDataCallback (QuicSocketTxScheduler::ExpiredDataCallback cb);
+
   /**
    * Set the TcpSocketState (tcb)
    * \param The TcpSocketState object
@@ -286,6 +443,12 @@ public:
    */
   void SetScheduler (Ptr<QuicSocketTxScheduler> sched);
 
+  /**
+   * Get the pool from which the transmission items of the socket are allocated
+   * \return The item pool, shared with the scheduler
+   */
+  Ptr<QuicSocketTxItemPool> GetItemPool () const;
+
   /**
    * Updates per packet variables required for rate sampling on each packet transmission
    * \param The sequence number of the sent packet
@@ -349,26 +512,224 @@ public:
    */
   Time GetDefaultLatency ();
 
+  /**
+   * Set the priority of a specified stream
+   *
+   * \param streamId The stream ID
+   * \param urgency The stream's urgency, from 0 (highest) to 7 (lowest)
+   * \param incremental True if the stream's data can be interleaved with other streams
+   */
+  void SetStreamPriority (uint32_t streamId, uint8_t urgency, bool incremental);
+
+  /**
+   * Get the urgency of a specified stream
+   *
+   * \param streamId The stream ID
+   * \return The stream's urgency, or 0 if the scheduler does not use priorities
+   */
+  uint8_t GetStreamUrgency (uint32_t streamId);
+
+  /**
+   * Get the incremental flag of a specified stream
+   *
+   * \param streamId The stream ID
+   * \return The stream's incremental flag, or false if the scheduler does not use priorities
+   */
+  bool GetStreamIncremental (uint32_t streamId);
+
+  /**
+   * Enable or disable the drop of the expired frames of a specified stream
+   *
+   * \param streamId The stream ID
+   * \param drop True if the frames sent after their deadline are dropped
+   */
+  void SetDropExpired (uint32_t streamId, bool drop);
+
+  /**
+   * Check whether the expired frames of a specified stream are dropped
+   *
+   * \param streamId The stream ID
+   * \return True if the expired frames are dropped, false if the scheduler does not use deadlines
+   */
+  bool GetDropExpired (uint32_t streamId);
+
 private:
   typedef std::list<Ptr<QuicSocketTxItem> > QuicTxPacketList;      //!< container for data stored in the buffer
+  typedef std::deque<Ptr<QuicSocketTxItem> > QuicTxSentPacketList;  //!< container for sent packets, indexed by packet number
 
   /**
    * Discard acknowledged data from the sent list
    */
   void CleanSentList ();
 
+  /**
+   * Discard the empty slots at the edges of the sent list
+   */
+  void TrimSentList ();
+
+  /**
+   * \brief Append a sent packet to the sent list
+   *
+   * Packet numbers are increasing, and the packet numbers that are not used by
+   * items of this buffer (e.g., ACK-only packets) are left as empty slots
+   *
+   * \param item the sent item
+   */
+  void AddToSentList (Ptr<QuicSocketTxItem> item);
+
+  /**
+   * \brief Find a packet in the sent list
+   *
+   * \param packetNumber the packet number
+   * \return the item sent with the packet number, or 0 if it is not in the sent list
+   */
+  Ptr<QuicSocketTxItem> GetSentItem (uint32_t packetNumber) const;
+
+  /**
+   * \brief Acknowledge the packets of an ACK block
+   *
+   * Only the packet numbers that were not covered by a previous ACK block are
+   * visited, starting from the highest one
+   *
+   * \param low the lowest packet number of the block
+   * \param high the highest packet number of the block
+   * \param newlyAcked the vector to which the newly acked packets are appended
+   */
+  void AckBlock (uint32_t low, uint32_t high,
+                 std::vector<Ptr<QuicSocketTxItem> > &newlyAcked);
+
+  /**
+   * \brief Mark a packet in the sent list as lost
+   * \param item the lost item
+   */
+  void SetLost (Ptr<QuicSocketTxItem> item);
 
+  typedef std::vector<QuicSocketTxFrame>::const_iterator QuicTxFrameIterator;  //!< Iterator over the frames of an item
 
-  QuicTxPacketList m_sentList;        //!< List of sent packets with additional info
+  /**
+   * \brief Put frames of a lost packet back in the application buffer
+   *
+   * \param item the lost item
+   * \param start the position of the first frame in the packet
+   * \param size the size of the frames in the packet
+   * \param first the first frame to retransmit
+   * \param last the end of the frames to retransmit
+   * \param packetNumber the packet number of the retransmission item
+   * \return the number of bytes put back in the buffer
+   */
+  uint32_t RetransmitFrames (Ptr<QuicSocketTxItem> item, uint32_t start, uint32_t size,
+                             QuicTxFrameIterator first, QuicTxFrameIterator last,
+                             SequenceNumber32 packetNumber);
+
+  /**
+   * \brief Put a missing range of a lost stream frame back in the application buffer
+   *
+   * \param item the lost item
+   * \param frame the lost frame
+   * \param range the missing data of the frame
+   * \param packetNumber the packet number of the retransmission item
+   * \return the number of bytes put back in the buffer
+   */
+  uint32_t RetransmitStreamData (Ptr<QuicSocketTxItem> item, const QuicSocketTxFrame &frame,
+                                 const QuicStreamTxRange &range, SequenceNumber32 packetNumber);
+
+  /**
+   * \brief Create the item that retransmits data of a lost packet
+   *
+   * \param item the lost item
+   * \param packetNumber the packet number of the retransmission item
+   * \return the retransmission item, without data
+   */
+  Ptr<QuicSocketTxItem> CreateRetransmission (Ptr<QuicSocketTxItem> item,
+                                              SequenceNumber32 packetNumber);
+
+  /**
+   * \brief Put a retransmission item in the application buffer
+   *
+   * \param retx the retransmission item
+   * \return the size of the item
+   */
+  uint32_t QueueRetransmission (Ptr<QuicSocketTxItem> retx);
+
+  /**
+   * \brief Append the waiting control frames that fit in a packet
+   *
+   * \param item the item of the packet
+   * \param numBytes the maximum size of the packet
+   */
+  void PackControlFrames (Ptr<QuicSocketTxItem> item, uint32_t numBytes);
+
+  /**
+   * \brief Mark the outstanding packets below the largest acked one as lost
+   *
+   * A packet is lost if it is threshold packet numbers below the largest
+   * acked one or, with time-based detection, if it was sent more than the
+   * loss delay ago. The loss time is set for the earliest packet that is
+   * not lost yet.
+   *
+   * \param tcbd the state of the socket
+   * \param largestAcknowledged the largest acknowledged packet number
+   */
+  void MarkLostPackets (Ptr<QuicSocketState> tcbd, uint32_t largestAcknowledged);
+
+  /**
+   * \brief Mark a packet as lost by the reordering thresholds, and remember it
+   *   until it is acknowledged or forgotten
+   * \param item the lost item
+   */
+  void DeclareLost (Ptr<QuicSocketTxItem> item);
+
+  /**
+   * \brief Move the packets declared lost in [low, high] to the spurious losses
+   * \param low the lowest acknowledged packet number
+   * \param high the highest acknowledged packet number
+   */
+  void AckDeclaredLost (uint32_t low, uint32_t high);
+
+  /**
+   * \brief Check if a packet in the sent list counts as in flight
+   * \param item the sent item
+   * \return true if the item is an unacknowledged stream packet
+   */
+  static bool IsInFlight (Ptr<const QuicSocketTxItem> item);
+
+  /**
+   * \brief Check the byte counters against the content of the sent list
+   *
+   * The check walks the whole sent list, and it is only meant to be used
+   * in assertions.
+   *
+   * \return true if the counters are consistent
+   */
+  bool CheckCounters () const;
+
+  QuicTxSentPacketList m_sentList;        //!< List of sent packets with additional info, indexed by packet number
+  uint32_t m_sentListBase;                //!< Packet number of the first slot of the sent list
+  std::map<uint32_t, uint32_t> m_sackedRanges;  //!< Ranges [first, second] of packet numbers already covered by ACK blocks
+  std::set<uint32_t> m_lostPackets;       //!< Packet numbers of the sent packets marked as lost
+  uint32_t m_lossDetectionFloor;          //!< All the sent packets below this packet number are acked or lost
+  uint32_t m_largestAcked;                //!< Largest packet number acknowledged so far
+  Time m_lossTime;                        //!< Time at which the next packet will be lost by time threshold
+  std::map<uint32_t, Time> m_declaredLost;       //!< Send time of the packets declared lost, by packet number
+  std::vector<QuicSpuriousLoss> m_spuriousLosses; //!< Spurious losses not reported yet
+  static const uint32_t MAX_DECLARED_LOST = 1024; //!< Maximum number of declared losses remembered
   QuicTxPacketList m_streamZeroList;       //!< List of waiting stream 0 packets with additional info
   uint32_t m_maxBuffer;            //!< Max number of data bytes in buffer (SND.WND)
   uint32_t m_streamZeroSize;       //!< Size of all stream 0 data in the application list
   uint32_t m_sentSize;                       //!< Size of all data in the sent list
+  uint32_t m_inFlightSize;                   //!< Size of the unacknowledged stream packets in the sent list
+  uint32_t m_lostSize;                       //!< Size of the packets marked as lost
   uint32_t m_numFrameStream0InBuffer;        //!< Number of Stream 0 frames buffered
+  std::deque<Ptr<Packet> > m_controlList;    //!< Control frames waiting to be packed in a packet
+  uint32_t m_controlSize;                    //!< Size of the control frames waiting to be sent
 
   Ptr<QuicSocketTxScheduler> m_scheduler { nullptr };         //!< Scheduler
+  Ptr<QuicSocketTxItemPool> m_itemPool;    //!< Pool of the transmission items of the socket
   Ptr<QuicSocketState> m_tcb { nullptr };
   struct RateSample m_rs;
+  LostStreamDataCallback m_lostStreamDataCb;  //!< Callback for the missing data of lost stream frames
+  LostControlFramesCallback m_lostControlFramesCb;  //!< Callback for the refreshed lost control frames
+  QuicSocketTxScheduler::ExpiredDataCallback m_expiredStreamDataCb;  //!< Callback for the expired data dropped by the scheduler
 };
 
 } // namepsace ns3
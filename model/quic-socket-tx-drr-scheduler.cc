@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "quic-socket-tx-drr-scheduler.h"
+
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include "quic-socket-tx-buffer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QuicSocketTxDrrScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (QuicSocketTxDrrScheduler);
+
+TypeId QuicSocketTxDrrScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::QuicSocketTxDrrScheduler")
+    .SetParent<QuicSocketTxScheduler> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<QuicSocketTxDrrScheduler> ()
+    .AddAttribute ("Quantum", "Bytes added to the deficit of a stream at each round",
+                   UintegerValue (1200),
+                   MakeUintegerAccessor (&QuicSocketTxDrrScheduler::m_quantum),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+QuicSocketTxDrrScheduler::QuicSocketTxDrrScheduler () :
+  QuicSocketTxScheduler (), m_quantum (1200)
+{}
+
+QuicSocketTxDrrScheduler::QuicSocketTxDrrScheduler (
+  const QuicSocketTxDrrScheduler &other) :
+  QuicSocketTxScheduler (other), m_streams (other.m_streams),
+  m_activeStreams (other.m_activeStreams), m_quantum (other.m_quantum)
+{}
+
+QuicSocketTxDrrScheduler::~QuicSocketTxDrrScheduler (void)
+{}
+
+void
+QuicSocketTxDrrScheduler::Add (Ptr<QuicSocketTxItem> item, bool retx)
+{
+  NS_LOG_FUNCTION (this << item);
+  NS_ASSERT_MSG (!item->m_frames.empty (), "No frame description in the item");
+  const QuicSocketTxFrame &frame = item->m_frames.front ();
+  AddScheduleItem (CreateScheduleItem (frame.m_streamId, frame.m_offset, 0, item), retx);
+}
+
+void
+QuicSocketTxDrrScheduler::Enqueue (Ptr<QuicSocketTxScheduleItem> item, bool retx)
+{
+  uint64_t streamId = item->GetStreamId ();
+  StreamQueue &queue = m_streams[streamId];
+  if (retx)
+    {
+      queue.m_retx.push_back (item);
+    }
+  else
+    {
+      queue.m_items.push_back (item);
+    }
+  if (!queue.m_active)
+    {
+      NS_LOG_LOGIC ("Stream " << streamId << " joins the ring");
+      queue.m_active = true;
+      m_activeStreams.push_back (streamId);
+    }
+}
+
+Ptr<QuicSocketTxScheduleItem>
+QuicSocketTxDrrScheduler::Dequeue ()
+{
+  NS_ASSERT_MSG (!m_activeStreams.empty (), "No stream with data to send");
+  while (true)
+    {
+      uint64_t streamId = m_activeStreams.front ();
+      auto stream_it = m_streams.find (streamId);
+      NS_ASSERT (stream_it != m_streams.end ());
+      StreamQueue &queue = stream_it->second;
+      if (!queue.m_visited)
+        {
+          queue.m_deficit += m_quantum;
+          queue.m_visited = true;
+        }
+
+      std::deque<Ptr<QuicSocketTxScheduleItem> > &list =
+        queue.m_retx.empty () ? queue.m_items : queue.m_retx;
+      Ptr<QuicSocketTxScheduleItem> item = list.front ();
+      uint32_t size = item->GetItem ()->m_packet->GetSize ();
+      if (size <= queue.m_deficit)
+        {
+          list.pop_front ();
+          queue.m_deficit -= size;
+          if (queue.m_retx.empty () and queue.m_items.empty ())
+            {
+              // an idle stream does not keep its deficit
+              NS_LOG_LOGIC ("Stream " << streamId << " leaves the ring");
+              m_activeStreams.pop_front ();
+              m_streams.erase (stream_it);
+            }
+          return item;
+        }
+
+      // the turn of the stream is over, move to the next one
+      NS_LOG_LOGIC ("Stream " << streamId << " deficit " << queue.m_deficit << ", next turn");
+      queue.m_visited = false;
+      m_activeStreams.pop_front ();
+      m_activeStreams.push_back (streamId);
+    }
+}
+
+void
+QuicSocketTxDrrScheduler::Requeue (Ptr<QuicSocketTxScheduleItem> item)
+{
+  uint64_t streamId = item->GetStreamId ();
+  StreamQueue &queue = m_streams[streamId];
+  queue.m_retx.push_front (item);
+  // the bytes that were not sent are not charged to the stream
+  queue.m_deficit += item->GetItem ()->m_packet->GetSize ();
+  if (!queue.m_active)
+    {
+      // the stream left the ring in Dequeue, it keeps its turn
+      queue.m_active = true;
+      queue.m_visited = true;
+      m_activeStreams.push_front (streamId);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUICSOCKETTXDRRSCHEDULER_H
+#define QUICSOCKETTXDRRSCHEDULER_H
+
+#include "quic-socket-tx-scheduler.h"
+#include <deque>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \brief The DRR implementation
+ *
+ * This class is a Deficit Round Robin implementation of the socket scheduler.
+ * Each stream has its own queue, and the streams with data to send are
+ * served in turn from a ring: at each turn, a stream can send frames up to
+ * its deficit, which grows by a quantum of bytes per turn. Retransmissions
+ * are sent before new data within each stream. Adding and extracting a frame
+ * take constant time, regardless of the number of buffered frames.
+ */
+class QuicSocketTxDrrScheduler : public QuicSocketTxScheduler
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  QuicSocketTxDrrScheduler ();
+  QuicSocketTxDrrScheduler (const QuicSocketTxDrrScheduler &other);
+  virtual ~QuicSocketTxDrrScheduler (void);
+
+  /**
+   * Add a tx item to the queue of its stream
+   *
+   * \param item a smart pointer to a transmission item
+   * \param retx true if the transmission item is being retransmitted
+   */
+  void Add (Ptr<QuicSocketTxItem> item, bool retx) override;
+
+protected:
+  void Enqueue (Ptr<QuicSocketTxScheduleItem> item, bool retx) override;
+  Ptr<QuicSocketTxScheduleItem> Dequeue () override;
+  void Requeue (Ptr<QuicSocketTxScheduleItem> item) override;
+
+private:
+  /**
+   * \brief The queue and the round robin state of a stream
+   */
+  struct StreamQueue
+  {
+    std::deque<Ptr<QuicSocketTxScheduleItem> > m_retx;   //!< Retransmitted items, sent first
+    std::deque<Ptr<QuicSocketTxScheduleItem> > m_items;  //!< New items
+    uint32_t m_deficit {0};                              //!< Bytes the stream can still send
+    bool m_active {false};                               //!< True if the stream is in the ring
+    bool m_visited {false};                              //!< True if the quantum of the current turn was added
+  };
+
+  std::unordered_map<uint64_t, StreamQueue> m_streams;  //!< Queues of the streams with data to send
+  std::deque<uint64_t> m_activeStreams;                 //!< Ring of the streams with data to send
+  uint32_t m_quantum;                                   //!< Bytes added to the deficit of a stream at each turn
+};
+
+} // namespace ns3
+
+#endif /* QUIC_SOCKET_TX_DRR_SCHEDULER_H */
@@ -67,6 +67,7 @@ QuicSocketTxEdfScheduler::QuicSocketTxEdfScheduler (
 {
   m_defaultLatency = other.m_defaultLatency;
   m_latencyMap = other.m_latencyMap;
+  m_dropExpired = other.m_dropExpired;
 }
 
 QuicSocketTxEdfScheduler::~QuicSocketTxEdfScheduler (void)
@@ -75,76 +76,21 @@ QuicSocketTxEdfScheduler::~QuicSocketTxEdfScheduler (void)
 void QuicSocketTxEdfScheduler::Add (Ptr<QuicSocketTxItem> item, bool retx)
 {
   NS_LOG_FUNCTION (this << item);
+  NS_ASSERT_MSG (!item->m_frames.empty (), "No frame description in the item");
+  // the socket buffer requeues the frames of a lost packet one by one,
+  // so each item carries a single frame
+  const QuicSocketTxFrame &frame = item->m_frames.front ();
 
-  if (retx)
+  if (retx && m_retxFirst)
     {
-      if (m_retxFirst)
-        {
-          QuicSubheader sub;
-          item->m_packet->PeekHeader (sub);
-          NS_LOG_INFO ("Adding retransmitted packet with highest priority");
-          AddScheduleItem (CreateObject<QuicSocketTxScheduleItem> (sub.GetStreamId (), sub.GetOffset (), -1, item), retx);
-        }
-      else
-        {
-          uint32_t dataSizeByte = item->m_packet->GetSize ();
-          QuicSubheader sub;
-          item->m_packet->PeekHeader (sub);
-          if (sub.GetSerializedSize () + sub.GetLength ()
-              < dataSizeByte)
-            {
-
-              NS_LOG_INFO (
-                "Disgregate packet to be retransmitted" << dataSizeByte << "; first fragment size" << sub.GetSerializedSize () + sub.GetLength ());
-              Ptr<Packet> remaining = item->m_packet->Copy ();
-
-              // the packet could contain multiple frames
-              // each of them starts with a subheader
-              // cycle through the data packet and extract the frames
-              for (uint32_t start = 0; start < dataSizeByte;)
-                {
-                  item->m_packet->RemoveHeader (sub);
-                  Ptr<Packet> nextFragment = Create<Packet> ();
-                  if (sub.IsStream ())
-                    {
-                      NS_LOG_INFO (
-                        "subheader " << sub << " dataSizeByte " << dataSizeByte << " remaining " << item->m_packet->GetSize () << " frame size " << sub.GetLength ());
-                      nextFragment = item->m_packet->Copy ();
-                      NS_LOG_INFO ("fragment size " << nextFragment->GetSize () << " " << sub.GetLength ());
-                      nextFragment->RemoveAtEnd (
-                        nextFragment->GetSize () - sub.GetLength ());
-                      NS_LOG_INFO ("fragment size " << nextFragment->GetSize ());
-
-                      // remove the first portion of the packet
-                      item->m_packet->RemoveAtStart (sub.GetLength ());
-                    }
-                  nextFragment->AddHeader (sub);
-                  start += nextFragment->GetSize ();
-                  Ptr<QuicSocketTxItem> it = CreateObject<QuicSocketTxItem> (
-                    *item);
-                  uint64_t streamId = sub.GetStreamId ();
-                  uint64_t offset = sub.GetOffset ();
-                  it->m_packet = nextFragment;
-                  NS_LOG_INFO (
-                    "Added retx fragment on stream " << streamId << " with offset " << offset << " and length " << it->m_packet->GetSize () << ", pointer " << GetPointer (it->m_packet));
-                  AddScheduleItem (CreateObject<QuicSocketTxScheduleItem> (streamId, offset, GetDeadline (it).GetSeconds (), it), false);
-                }
-            }
-          else
-            {
-              NS_LOG_INFO (
-                "Added retx packet on stream " << sub.GetStreamId () << " with offset " << sub.GetOffset ());
-              AddScheduleItem (CreateObject<QuicSocketTxScheduleItem> (sub.GetStreamId (), sub.GetOffset (), GetDeadline (item).GetSeconds (), item), false);
-            }
-        }
+      NS_LOG_INFO ("Adding retransmitted packet with highest priority");
+      AddScheduleItem (CreateScheduleItem (frame.m_streamId, frame.m_offset, -1, item), retx);
     }
   else
     {
-      QuicSubheader sub;
-      item->m_packet->PeekHeader (sub);
       NS_LOG_INFO (
-        "Added packet on stream " << sub.GetStreamId () << " with offset " << sub.GetOffset ());
-      AddScheduleItem (CreateObject<QuicSocketTxScheduleItem> (sub.GetStreamId (), sub.GetOffset (), GetDeadline (item).GetSeconds (), item), retx);
+        "Added " << (retx ? "retx " : "") << "packet on stream " << frame.m_streamId << " with offset " << frame.m_offset);
+      AddScheduleItem (CreateScheduleItem (frame.m_streamId, frame.m_offset, GetDeadline (item).GetSeconds (), item), false);
     }
 }
 
@@ -178,12 +124,36 @@ const Time QuicSocketTxEdfScheduler::GetDefaultLatency ()
   return m_defaultLatency;
 }
 
+void QuicSocketTxEdfScheduler::SetDropExpired (uint32_t streamId, bool drop)
+{
+  NS_LOG_FUNCTION (this << streamId << drop);
+  if (drop)
+    {
+      m_dropExpired.insert (streamId);
+    }
+  else
+    {
+      m_dropExpired.erase (streamId);
+    }
+}
+
+bool QuicSocketTxEdfScheduler::GetDropExpired (uint32_t streamId) const
+{
+  return m_dropExpired.count (streamId) > 0;
+}
+
 Time QuicSocketTxEdfScheduler::GetDeadline (Ptr<QuicSocketTxItem> item)
 {
-  Ptr<Packet> packet = item->m_packet;
-  QuicSubheader sub;
-  packet->PeekHeader (sub);
-  return item->m_generated + GetLatency (sub.GetStreamId ());
+  return item->m_generated + GetLatency (item->m_frames.front ().m_streamId);
+}
+
+bool QuicSocketTxEdfScheduler::IsExpired (Ptr<QuicSocketTxScheduleItem> item)
+{
+  // the deadline is checked for every item, since retransmissions may be
+  // sent first regardless of their deadline
+  Ptr<QuicSocketTxItem> txItem = item->GetItem ();
+  return txItem->m_isStream and GetDropExpired (item->GetStreamId ())
+         and GetDeadline (txItem) < Simulator::Now ();
 }
 
 }
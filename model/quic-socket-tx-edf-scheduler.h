@@ -29,6 +29,7 @@
 #include "quic-socket-tx-scheduler.h"
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/nstime.h"
 
@@ -92,6 +93,28 @@ public:
    */
   const Time GetDefaultLatency ();
 
+  /**
+   * Enable or disable the drop of the expired frames of a specified stream
+   *
+   * The frames of the stream that are still waiting to be sent, or
+   * retransmitted, after their deadline are dropped instead of sent.
+   *
+   * \param streamId The stream ID
+   * \param drop True if the expired frames of the stream are dropped
+   */
+  void SetDropExpired (uint32_t streamId, bool drop);
+
+  /**
+   * Check whether the expired frames of a specified stream are dropped
+   *
+   * \param streamId The stream ID
+   * \return True if the expired frames of the stream are dropped
+   */
+  bool GetDropExpired (uint32_t streamId) const;
+
+protected:
+  bool IsExpired (Ptr<QuicSocketTxScheduleItem> item) override;
+
 private:
   /**
    * Gets the deadline for a transmission item
@@ -102,6 +125,7 @@ private:
   bool m_retxFirst;
   Time m_defaultLatency;
   std::map<uint32_t, Time> m_latencyMap;
+  std::set<uint32_t> m_dropExpired;   //!< Streams whose expired frames are dropped
 };
 
 } // namepsace ns3
@@ -71,18 +71,18 @@ void
 QuicSocketTxPFifoScheduler::Add (Ptr<QuicSocketTxItem> item, bool retx)
 {
   NS_LOG_FUNCTION (this << item);
-  QuicSubheader qsb;
-  item->m_packet->PeekHeader (qsb);
-  NS_LOG_INFO ("Adding packet on stream " << qsb.GetStreamId ());
+  NS_ASSERT_MSG (!item->m_frames.empty (), "No frame description in the item");
+  const QuicSocketTxFrame &frame = item->m_frames.front ();
+  NS_LOG_INFO ("Adding packet on stream " << frame.m_streamId);
   if (!retx)
     {
-      NS_LOG_INFO ("Standard item, add at end (offset " << qsb.GetOffset () << ")");
+      NS_LOG_INFO ("Standard item, add at end (offset " << frame.m_offset << ")");
     }
   else
     {
-      NS_LOG_INFO ("Retransmitted item, add at beginning (offset " << qsb.GetOffset () << ")");
+      NS_LOG_INFO ("Retransmitted item, add at beginning (offset " << frame.m_offset << ")");
     }
-  AddScheduleItem (CreateObject<QuicSocketTxScheduleItem> (qsb.GetStreamId (), qsb.GetOffset (), 0, item), (retx && m_retxFirst));
+  AddScheduleItem (CreateScheduleItem (frame.m_streamId, frame.m_offset, 0, item), (retx && m_retxFirst));
 }
 
 
@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "quic-socket-tx-priority-scheduler.h"
+
+#include <algorithm>
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "quic-socket-tx-buffer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QuicSocketTxPriorityScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (QuicSocketTxPriorityScheduler);
+
+TypeId QuicSocketTxPriorityScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::QuicSocketTxPriorityScheduler")
+    .SetParent<QuicSocketTxScheduler> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<QuicSocketTxPriorityScheduler> ()
+    .AddAttribute ("DefaultUrgency", "Urgency of the streams with no priority set",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&QuicSocketTxPriorityScheduler::m_defaultUrgency),
+                   MakeUintegerChecker<uint8_t> (0, NUM_URGENCIES - 1))
+    .AddAttribute ("DefaultIncremental", "Incremental flag of the streams with no priority set",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QuicSocketTxPriorityScheduler::m_defaultIncremental),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+QuicSocketTxPriorityScheduler::QuicSocketTxPriorityScheduler () :
+  QuicSocketTxScheduler (), m_defaultUrgency (3), m_defaultIncremental (false)
+{}
+
+QuicSocketTxPriorityScheduler::QuicSocketTxPriorityScheduler (
+  const QuicSocketTxPriorityScheduler &other) :
+  QuicSocketTxScheduler (other), m_priorities (other.m_priorities),
+  m_streams (other.m_streams), m_sequential (other.m_sequential),
+  m_incremental (other.m_incremental), m_defaultUrgency (other.m_defaultUrgency),
+  m_defaultIncremental (other.m_defaultIncremental)
+{}
+
+QuicSocketTxPriorityScheduler::~QuicSocketTxPriorityScheduler (void)
+{}
+
+void
+QuicSocketTxPriorityScheduler::Add (Ptr<QuicSocketTxItem> item, bool retx)
+{
+  NS_LOG_FUNCTION (this << item);
+  NS_ASSERT_MSG (!item->m_frames.empty (), "No frame description in the item");
+  const QuicSocketTxFrame &frame = item->m_frames.front ();
+  AddScheduleItem (CreateScheduleItem (frame.m_streamId, frame.m_offset,
+                                       GetPriority (frame.m_streamId).m_urgency, item), retx);
+}
+
+void
+QuicSocketTxPriorityScheduler::SetPriority (uint32_t streamId, uint8_t urgency, bool incremental)
+{
+  NS_LOG_FUNCTION (this << streamId << (uint32_t) urgency << incremental);
+  NS_ABORT_MSG_IF (urgency >= NUM_URGENCIES, "Invalid urgency " << (uint32_t) urgency);
+  StreamPriority priority {urgency, incremental};
+  m_priorities[streamId] = priority;
+
+  // a stream with data to send moves to its new urgency level right away
+  auto stream_it = m_streams.find (streamId);
+  if (stream_it != m_streams.end ())
+    {
+      Deactivate (streamId, stream_it->second.m_priority);
+      stream_it->second.m_priority = priority;
+      Activate (streamId, priority, false);
+    }
+}
+
+uint8_t
+QuicSocketTxPriorityScheduler::GetUrgency (uint32_t streamId) const
+{
+  return GetPriority (streamId).m_urgency;
+}
+
+bool
+QuicSocketTxPriorityScheduler::GetIncremental (uint32_t streamId) const
+{
+  return GetPriority (streamId).m_incremental;
+}
+
+QuicSocketTxPriorityScheduler::StreamPriority
+QuicSocketTxPriorityScheduler::GetPriority (uint64_t streamId) const
+{
+  auto it = m_priorities.find (streamId);
+  if (it != m_priorities.end ())
+    {
+      return it->second;
+    }
+  return StreamPriority {m_defaultUrgency, m_defaultIncremental};
+}
+
+void
+QuicSocketTxPriorityScheduler::Activate (uint64_t streamId, const StreamPriority &priority, bool front)
+{
+  NS_LOG_LOGIC ("Stream " << streamId << " scheduled with urgency " << (uint32_t) priority.m_urgency
+                          << (priority.m_incremental ? ", incremental" : ""));
+  if (!priority.m_incremental)
+    {
+      m_sequential[priority.m_urgency].insert (streamId);
+    }
+  else if (front)
+    {
+      m_incremental[priority.m_urgency].push_front (streamId);
+    }
+  else
+    {
+      m_incremental[priority.m_urgency].push_back (streamId);
+    }
+}
+
+void
+QuicSocketTxPriorityScheduler::Deactivate (uint64_t streamId, const StreamPriority &priority)
+{
+  if (!priority.m_incremental)
+    {
+      m_sequential[priority.m_urgency].erase (streamId);
+      return;
+    }
+  // the stream is usually the last one served, search from the back
+  std::deque<uint64_t> &ring = m_incremental[priority.m_urgency];
+  auto it = std::find (ring.rbegin (), ring.rend (), streamId);
+  if (it != ring.rend ())
+    {
+      ring.erase (std::next (it).base ());
+    }
+}
+
+void
+QuicSocketTxPriorityScheduler::Enqueue (Ptr<QuicSocketTxScheduleItem> item, bool retx)
+{
+  uint64_t streamId = item->GetStreamId ();
+  auto stream_it = m_streams.find (streamId);
+  if (stream_it == m_streams.end ())
+    {
+      stream_it = m_streams.emplace (streamId, StreamQueue ()).first;
+      stream_it->second.m_priority = GetPriority (streamId);
+      Activate (streamId, stream_it->second.m_priority, false);
+    }
+  StreamQueue &queue = stream_it->second;
+  if (retx)
+    {
+      queue.m_retx.push_back (item);
+    }
+  else
+    {
+      queue.m_items.push_back (item);
+    }
+}
+
+Ptr<QuicSocketTxScheduleItem>
+QuicSocketTxPriorityScheduler::Dequeue ()
+{
+  for (uint8_t urgency = 0; urgency < NUM_URGENCIES; urgency++)
+    {
+      uint64_t streamId;
+      if (!m_sequential[urgency].empty ())
+        {
+          // the non-incremental streams are sent one after the other
+          streamId = *m_sequential[urgency].begin ();
+        }
+      else if (!m_incremental[urgency].empty ())
+        {
+          // the incremental streams take turns, one frame each
+          streamId = m_incremental[urgency].front ();
+          m_incremental[urgency].pop_front ();
+          m_incremental[urgency].push_back (streamId);
+        }
+      else
+        {
+          continue;
+        }
+
+      auto stream_it = m_streams.find (streamId);
+      NS_ASSERT (stream_it != m_streams.end ());
+      StreamQueue &queue = stream_it->second;
+      std::deque<Ptr<QuicSocketTxScheduleItem> > &list =
+        queue.m_retx.empty () ? queue.m_items : queue.m_retx;
+      Ptr<QuicSocketTxScheduleItem> item = list.front ();
+      list.pop_front ();
+      if (queue.m_retx.empty () and queue.m_items.empty ())
+        {
+          NS_LOG_LOGIC ("Stream " << streamId << " has no more data to send");
+          Deactivate (streamId, queue.m_priority);
+          m_streams.erase (stream_it);
+        }
+      return item;
+    }
+  NS_ABORT_MSG ("No stream with data to send");
+  return 0;
+}
+
+void
+QuicSocketTxPriorityScheduler::Requeue (Ptr<QuicSocketTxScheduleItem> item)
+{
+  uint64_t streamId = item->GetStreamId ();
+  auto stream_it = m_streams.find (streamId);
+  if (stream_it == m_streams.end ())
+    {
+      stream_it = m_streams.emplace (streamId, StreamQueue ()).first;
+      stream_it->second.m_priority = GetPriority (streamId);
+    }
+  else
+    {
+      Deactivate (streamId, stream_it->second.m_priority);
+    }
+  stream_it->second.m_retx.push_front (item);
+  // the stream was just served, so an incremental stream keeps its turn
+  Activate (streamId, stream_it->second.m_priority, true);
+}
+
+} // namespace ns3
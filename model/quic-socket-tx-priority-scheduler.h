@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUICSOCKETTXPRIORITYSCHEDULER_H
+#define QUICSOCKETTXPRIORITYSCHEDULER_H
+
+#include "quic-socket-tx-scheduler.h"
+#include <array>
+#include <deque>
+#include <set>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \brief The extensible priority scheduler
+ *
+ * This class implements the extensible prioritization scheme of RFC 9218.
+ * Each stream has an urgency, from 0 (highest) to 7 (lowest), and an
+ * incremental flag. The streams with the lowest urgency are always served
+ * first. Within an urgency level, the non-incremental streams are sent one
+ * at a time in stream ID order, each until its queue is empty, and then the
+ * incremental streams share the capacity, one frame per turn. Retransmissions
+ * are sent before new data within each stream.
+ */
+class QuicSocketTxPriorityScheduler : public QuicSocketTxScheduler
+{
+public:
+  static const uint8_t NUM_URGENCIES = 8;  //!< Number of urgency levels
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  QuicSocketTxPriorityScheduler ();
+  QuicSocketTxPriorityScheduler (const QuicSocketTxPriorityScheduler &other);
+  virtual ~QuicSocketTxPriorityScheduler (void);
+
+  /**
+   * Add a tx item to the queue of its stream
+   *
+   * \param item a smart pointer to a transmission item
+   * \param retx true if the transmission item is being retransmitted
+   */
+  void Add (Ptr<QuicSocketTxItem> item, bool retx) override;
+
+  /**
+   * Set the priority of a specified stream
+   *
+   * \param streamId The stream ID
+   * \param urgency The stream's urgency, from 0 (highest) to 7 (lowest)
+   * \param incremental True if the stream's data can be interleaved with other streams
+   */
+  void SetPriority (uint32_t streamId, uint8_t urgency, bool incremental);
+
+  /**
+   * Get the urgency of a specified stream
+   *
+   * \param streamId The stream ID
+   * \return The stream's urgency, or the default one if the stream is not registered
+   */
+  uint8_t GetUrgency (uint32_t streamId) const;
+
+  /**
+   * Get the incremental flag of a specified stream
+   *
+   * \param streamId The stream ID
+   * \return The stream's incremental flag, or the default one if the stream is not registered
+   */
+  bool GetIncremental (uint32_t streamId) const;
+
+protected:
+  void Enqueue (Ptr<QuicSocketTxScheduleItem> item, bool retx) override;
+  Ptr<QuicSocketTxScheduleItem> Dequeue () override;
+  void Requeue (Ptr<QuicSocketTxScheduleItem> item) override;
+
+private:
+  /**
+   * \brief The priority of a stream
+   */
+  struct StreamPriority
+  {
+    uint8_t m_urgency;    //!< Urgency, from 0 (highest) to 7 (lowest)
+    bool m_incremental;   //!< True if the stream is served round robin
+  };
+
+  /**
+   * \brief The queue of a stream with data to send
+   */
+  struct StreamQueue
+  {
+    std::deque<Ptr<QuicSocketTxScheduleItem> > m_retx;   //!< Retransmitted items, sent first
+    std::deque<Ptr<QuicSocketTxScheduleItem> > m_items;  //!< New items
+    StreamPriority m_priority;                           //!< Priority the stream is scheduled with
+  };
+
+  /**
+   * \brief Get the priority of a stream
+   * \param streamId the stream ID
+   * \return the stream priority, or the default one
+   */
+  StreamPriority GetPriority (uint64_t streamId) const;
+
+  /**
+   * \brief Insert a stream in the schedule of its urgency level
+   * \param streamId the stream ID
+   * \param priority the stream priority
+   * \param front true if an incremental stream keeps its turn
+   */
+  void Activate (uint64_t streamId, const StreamPriority &priority, bool front);
+
+  /**
+   * \brief Remove a stream from the schedule of its urgency level
+   * \param streamId the stream ID
+   * \param priority the stream priority
+   */
+  void Deactivate (uint64_t streamId, const StreamPriority &priority);
+
+  std::unordered_map<uint64_t, StreamPriority> m_priorities;       //!< Priorities set for the streams
+  std::unordered_map<uint64_t, StreamQueue> m_streams;             //!< Queues of the streams with data to send
+  std::array<std::set<uint64_t>, NUM_URGENCIES> m_sequential;      //!< Non-incremental streams with data, by urgency
+  std::array<std::deque<uint64_t>, NUM_URGENCIES> m_incremental;   //!< Rings of incremental streams with data, by urgency
+  uint8_t m_defaultUrgency;                                        //!< Urgency of the streams with no priority set
+  bool m_defaultIncremental;                                       //!< Incremental flag of the streams with no priority set
+};
+
+} // namespace ns3
+
+#endif /* QUIC_SOCKET_TX_PRIORITY_SCHEDULER_H */
@@ -40,18 +40,6 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("QuicSocketTxScheduler");
 
 NS_OBJECT_ENSURE_REGISTERED (QuicSocketTxScheduler);
-NS_OBJECT_ENSURE_REGISTERED (QuicSocketTxScheduleItem);
-
-TypeId
-QuicSocketTxScheduleItem::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::QuicSocketTxScheduleItem")
-    .SetParent<Object> ()
-    .SetGroupName ("Internet")
-  ;
-  return tid;
-}
-
 int
 QuicSocketTxScheduleItem::Compare (const QuicSocketTxScheduleItem & o) const
 {
@@ -73,6 +61,13 @@ QuicSocketTxScheduleItem::Compare (const QuicSocketTxScheduleItem & o) const
 
 
 
+QuicSocketTxScheduleItem::QuicSocketTxScheduleItem ()
+  : m_streamId (0),
+    m_offset (0),
+    m_priority (0),
+    m_item (0)
+{}
+
 QuicSocketTxScheduleItem::QuicSocketTxScheduleItem (uint64_t id, uint64_t off, double p, Ptr<QuicSocketTxItem> it)
   : m_streamId (id), 
     m_offset (off), 
@@ -85,7 +80,7 @@ QuicSocketTxScheduleItem::QuicSocketTxScheduleItem (const QuicSocketTxScheduleIt
     m_offset (other.m_offset), 
     m_priority (other.m_priority)
 {
-  m_item = CreateObject<QuicSocketTxItem> (*(other.m_item));
+  m_item = Create<QuicSocketTxItem> (*(other.m_item));
 }
 
 
@@ -136,11 +131,16 @@ QuicSocketTxScheduler::GetTypeId (void)
 QuicSocketTxScheduler::QuicSocketTxScheduler () : m_appSize (0)
 {
   m_appList = QuicTxPacketList ();
+  m_itemPool = Create<QuicSocketTxItemPool> ();
+  m_scheduleItemPool = Create<QuicSocketTxScheduleItemPool> ();
 }
 
 QuicSocketTxScheduler::QuicSocketTxScheduler (const QuicSocketTxScheduler &other) : m_appSize (other.m_appSize)
 {
   m_appList = other.m_appList;
+  m_itemPool = other.m_itemPool;
+  m_scheduleItemPool = other.m_scheduleItemPool;
+  m_expiredDataCb = other.m_expiredDataCb;
 }
 
 QuicSocketTxScheduler::~QuicSocketTxScheduler (void)
@@ -154,20 +154,20 @@ void
 QuicSocketTxScheduler::Add (Ptr<QuicSocketTxItem> item, bool retx)
 {
   NS_LOG_FUNCTION (this << item);
-  QuicSubheader qsb;
-  item->m_packet->PeekHeader (qsb);
+  NS_ASSERT_MSG (!item->m_frames.empty (), "No frame description in the item");
+  const QuicSocketTxFrame &frame = item->m_frames.front ();
   double priority = -1;
-  NS_LOG_INFO ("Adding packet on stream " << qsb.GetStreamId ());
+  NS_LOG_INFO ("Adding packet on stream " << frame.m_streamId);
   if (!retx)
     {
-      NS_LOG_INFO ("Standard item, add at end (offset " << qsb.GetOffset () << ")");
+      NS_LOG_INFO ("Standard item, add at end (offset " << frame.m_offset << ")");
       priority = Simulator::Now ().GetSeconds ();
     }
   else
     {
-      NS_LOG_INFO ("Retransmitted item, add at beginning (offset " << qsb.GetOffset () << ")");
+      NS_LOG_INFO ("Retransmitted item, add at beginning (offset " << frame.m_offset << ")");
     }
-  Ptr<QuicSocketTxScheduleItem> sched = CreateObject<QuicSocketTxScheduleItem> (qsb.GetStreamId (), qsb.GetOffset (), priority, item);
+  Ptr<QuicSocketTxScheduleItem> sched = CreateScheduleItem (frame.m_streamId, frame.m_offset, priority, item);
   AddScheduleItem (sched, retx);
 }
 
@@ -176,21 +176,71 @@ void
 QuicSocketTxScheduler::AddScheduleItem (Ptr<QuicSocketTxScheduleItem> item, bool retx)
 {
   NS_LOG_FUNCTION (this << item);
-  m_appList.push (item);
+  Enqueue (item, retx);
   m_appSize += item->GetItem ()->m_packet->GetSize ();
-  QuicSubheader qsb;
-  item->GetItem ()->m_packet->PeekHeader (qsb);
-  NS_LOG_INFO ("Adding packet on stream " << qsb.GetStreamId () << " with priority " << item->GetPriority ());
+  NS_LOG_INFO ("Adding packet on stream " << item->GetStreamId () << " with priority " << item->GetPriority ());
   if (!retx)
     {
-      NS_LOG_INFO ("Standard item, add at end (offset " << qsb.GetOffset () << ")");
+      NS_LOG_INFO ("Standard item, add at end (offset " << item->GetOffset () << ")");
     }
   else
     {
-      NS_LOG_INFO ("Retransmitted item, add at beginning (offset " << qsb.GetOffset () << ")");
+      NS_LOG_INFO ("Retransmitted item, add at beginning (offset " << item->GetOffset () << ")");
     }
 }
 
+void
+QuicSocketTxScheduler::Enqueue (Ptr<QuicSocketTxScheduleItem> item, bool retx)
+{
+  m_appList.push (item);
+}
+
+Ptr<QuicSocketTxScheduleItem>
+QuicSocketTxScheduler::Dequeue ()
+{
+  Ptr<QuicSocketTxScheduleItem> item = m_appList.top ();
+  m_appList.pop ();
+  return item;
+}
+
+void
+QuicSocketTxScheduler::Requeue (Ptr<QuicSocketTxScheduleItem> item)
+{
+  m_appList.push (item);
+}
+
+bool
+QuicSocketTxScheduler::IsExpired (Ptr<QuicSocketTxScheduleItem> item)
+{
+  return false;
+}
+
+Ptr<QuicSocketTxScheduleItem>
+QuicSocketTxScheduler::CreateScheduleItem (uint64_t id, uint64_t off, double p, Ptr<QuicSocketTxItem> it)
+{
+  return m_scheduleItemPool->Allocate (id, off, p, it);
+}
+
+void
+QuicSocketTxScheduler::SetItemPool (Ptr<QuicSocketTxItemPool> pool)
+{
+  NS_LOG_FUNCTION (this);
+  m_itemPool = pool;
+}
+
+Ptr<QuicSocketTxItemPool>
+QuicSocketTxScheduler::GetItemPool () const
+{
+  return m_itemPool;
+}
+
+void
+QuicSocketTxScheduler::SetExpiredDataCallback (ExpiredDataCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_expiredDataCb = cb;
+}
+
 Ptr<QuicSocketTxItem>
 QuicSocketTxScheduler::GetNewSegment (uint32_t numBytes)
 {
@@ -199,20 +249,27 @@ QuicSocketTxScheduler::GetNewSegment (uint32_t numBytes)
   bool firstSegment = true;
   Ptr<Packet> currentPacket = 0;
   Ptr<QuicSocketTxItem> currentItem = 0;
-  Ptr<QuicSocketTxItem> outItem = CreateObject<QuicSocketTxItem>();
+  Ptr<QuicSocketTxItem> outItem = m_itemPool->Allocate ();
   outItem->m_isStream = true;   // Packets sent with this method are always stream packets
   outItem->m_isStream0 = false;
   outItem->m_packet = Create<Packet> ();
   uint32_t outItemSize = 0;
+  std::vector<Ptr<QuicSocketTxItem> > expired;
 
 
   while (m_appSize > 0 && outItemSize < numBytes)
     {
-      Ptr<QuicSocketTxScheduleItem> scheduleItem = m_appList.top ();
+      Ptr<QuicSocketTxScheduleItem> scheduleItem = Dequeue ();
       currentItem = scheduleItem->GetItem ();
       currentPacket = currentItem->m_packet;
       m_appSize -= currentPacket->GetSize ();
-      m_appList.pop ();
+
+      if (IsExpired (scheduleItem))
+        {
+          NS_LOG_INFO ("Dropping expired item on stream " << scheduleItem->GetStreamId () << ", offset " << scheduleItem->GetOffset ());
+          expired.push_back (currentItem);
+          continue;
+        }
 
       if (outItemSize + currentItem->m_packet->GetSize ()   /*- subheaderSize*/
           <= numBytes)       // Merge
@@ -220,9 +277,7 @@ QuicSocketTxScheduler::GetNewSegment (uint32_t numBytes)
           NS_LOG_LOGIC ("Add complete frame to the outItem - size "
                         << currentItem->m_packet->GetSize ()
                         << " m_appSize " << m_appSize);
-          QuicSubheader qsb;
-          currentPacket->PeekHeader (qsb);
-          NS_LOG_INFO ("Packet: stream " << qsb.GetStreamId () << ", offset " << qsb.GetOffset ());
+          NS_LOG_INFO ("Packet: stream " << scheduleItem->GetStreamId () << ", offset " << scheduleItem->GetOffset ());
           QuicSocketTxItem::MergeItems (*outItem, *currentItem);
           outItemSize += currentItem->m_packet->GetSize ();
 
@@ -233,73 +288,35 @@ QuicSocketTxScheduler::GetNewSegment (uint32_t numBytes)
         {
           firstSegment = false;
 
-          // get the currentPacket subheader
-          QuicSubheader qsb;
-          currentPacket->PeekHeader (qsb);
-
-          // new packet size
-          int newPacketSizeInt = (int)numBytes - outItemSize - qsb.GetSerializedSize ();
-          if (newPacketSizeInt <= 0)
+          // the frame data that fits in the packet, after the subheader
+          const QuicSocketTxFrame &frame = currentItem->m_frames.front ();
+          uint32_t headerSize = frame.m_size - frame.m_length;
+          int newPacketSizeInt = (int)numBytes - outItemSize - headerSize;
+          if (newPacketSizeInt <= 0 or currentItem->m_frames.size () > 1)
             {
               NS_LOG_INFO ("Not enough bytes even for the header");
-              m_appList.push (scheduleItem);
+              Requeue (scheduleItem);
               m_appSize += currentPacket->GetSize ();
               break;
             }
           else
             {
-              NS_LOG_INFO ("Split packet on stream " << qsb.GetStreamId () << ", sending " << newPacketSizeInt << " bytes from offset " << qsb.GetOffset ());
-
-              currentPacket->RemoveHeader (qsb);
               uint32_t newPacketSize = (uint32_t)newPacketSizeInt;
+              NS_LOG_INFO ("Split packet on stream " << frame.m_streamId << ", sending " << newPacketSize << " bytes from offset " << frame.m_offset);
 
               NS_LOG_LOGIC ("Add incomplete frame to the outItem");
-              uint32_t totPacketSize = currentItem->m_packet->GetSize ();
               NS_LOG_LOGIC ("Extracted " << outItemSize << " bytes");
 
-              uint32_t oldOffset = qsb.GetOffset ();
-              uint32_t newOffset = oldOffset + newPacketSize;
-              bool oldOffBit = !(oldOffset == 0);
-              bool newOffBit = true;
-              uint32_t oldLength = qsb.GetLength ();
-              uint32_t newLength = 0;
-              bool newLengthBit = true;
-              newLength = totPacketSize - newPacketSize;
-              if (oldLength == 0)
-                {
-                  newLengthBit = false;
-                }
-              bool lengthBit = true;
-              bool oldFinBit = qsb.IsStreamFin ();
-              bool newFinBit = false;
-
-              QuicSubheader newQsbToTx = QuicSubheader::CreateStreamSubHeader (qsb.GetStreamId (),
-                                                                               oldOffset, newPacketSize, oldOffBit, lengthBit, newFinBit);
-              QuicSubheader newQsbToBuffer = QuicSubheader::CreateStreamSubHeader (qsb.GetStreamId (),
-                                                                                   newOffset, newLength, newOffBit, newLengthBit, oldFinBit);
-
-              Ptr<Packet> firstPartPacket = currentItem->m_packet->CreateFragment (
-                0, newPacketSize);
-              NS_ASSERT_MSG (firstPartPacket->GetSize () == newPacketSize,
-                             "Wrong size " << firstPartPacket->GetSize ());
-              firstPartPacket->AddHeader (newQsbToTx);
-              firstPartPacket->Print (std::cerr);
-
-              NS_LOG_INFO ("Split packet, putting second part back in application buffer - stream " << newQsbToBuffer.GetStreamId () << ", storing from offset " << newQsbToBuffer.GetOffset ());
-
-
-              Ptr<Packet> secondPartPacket = currentItem->m_packet->CreateFragment (
-                newPacketSize, newLength);
-              secondPartPacket->AddHeader (newQsbToBuffer);
-
-              Ptr<QuicSocketTxItem> toBeBuffered = CreateObject<QuicSocketTxItem> (*currentItem);
-              toBeBuffered->m_packet = secondPartPacket;
-              currentItem->m_packet = firstPartPacket;
+              Ptr<QuicSocketTxItem> toBeBuffered = m_itemPool->Allocate (*currentItem);
+              QuicSocketTxItem::SplitItems (*currentItem, *toBeBuffered, newPacketSize);
+              NS_LOG_LOGIC ("First part of the split packet " << *(currentItem->m_packet));
+
+              NS_LOG_INFO ("Split packet, putting second part back in application buffer - stream " << toBeBuffered->m_frames.front ().m_streamId << ", storing from offset " << toBeBuffered->m_frames.front ().m_offset);
 
               QuicSocketTxItem::MergeItems (*outItem, *currentItem);
               outItemSize += currentItem->m_packet->GetSize ();
 
-              m_appList.push (CreateObject<QuicSocketTxScheduleItem> (scheduleItem->GetStreamId (), scheduleItem->GetOffset (), scheduleItem->GetPriority (), toBeBuffered));
+              Requeue (CreateScheduleItem (scheduleItem->GetStreamId (), scheduleItem->GetOffset (), scheduleItem->GetPriority (), toBeBuffered));
               m_appSize += toBeBuffered->m_packet->GetSize ();
 
 
@@ -309,6 +326,18 @@ QuicSocketTxScheduler::GetNewSegment (uint32_t numBytes)
         }
     }
 
+  // notify the dropped data only now, since the callback may add new frames
+  if (!m_expiredDataCb.IsNull ())
+    {
+      for (const Ptr<QuicSocketTxItem> &item : expired)
+        {
+          for (const QuicSocketTxFrame &frame : item->m_frames)
+            {
+              m_expiredDataCb (frame.m_streamId, frame.m_offset, frame.m_length, frame.m_fin);
+            }
+        }
+    }
+
   NS_LOG_INFO ("Update: remaining App Size " << m_appSize << ", object size " << outItemSize);
 
   //Print(std::cout);
@@ -25,6 +25,8 @@
 #define QUICSOCKETTXSCHEDULER_H
 
 #include "quic-socket.h"
+#include "quic-tx-item-pool.h"
+#include "ns3/callback.h"
 #include <queue>
 #include <vector>
 
@@ -36,18 +38,17 @@ class QuicSocketTxItem;
  * \ingroup quic
  *
  * \brief Tx item for QUIC with priority
+ *
+ * Like QuicSocketTxItem, the schedule items are reference-counted records
+ * recycled through a QuicTxItemPool.
  */
-class QuicSocketTxScheduleItem : public Object
+class QuicSocketTxScheduleItem : public SimpleRefCount<QuicSocketTxScheduleItem, Empty, QuicTxItemPoolDeleter<QuicSocketTxScheduleItem> >
 {
 public:
-  /**
-   * \brief Get the type ID.
-   * \return the object TypeId
-   */
-  static TypeId GetTypeId (void);
-
+  QuicSocketTxScheduleItem ();
   QuicSocketTxScheduleItem (uint64_t id, uint64_t off, double p, Ptr<QuicSocketTxItem> it);
   QuicSocketTxScheduleItem (const QuicSocketTxScheduleItem &other);
+  QuicSocketTxScheduleItem &operator= (const QuicSocketTxScheduleItem &other) = default;
 
   /**
    *  Compare \p this to another QuicSocketTxScheduleItem
@@ -109,8 +110,15 @@ private:
   uint64_t m_offset;                  //!< offset on the stream
   double m_priority;                  //!< Priority level of the item (lowest is sent first)
   Ptr<QuicSocketTxItem> m_item;       //!< TxItem containing the packet
+
+  friend class QuicTxItemPool<QuicSocketTxScheduleItem>;
+  friend struct QuicTxItemPoolDeleter<QuicSocketTxScheduleItem>;
+
+  Ptr<QuicTxItemPool<QuicSocketTxScheduleItem> > m_pool;  //!< The pool the item is returned to, if any
 };
 
+typedef QuicTxItemPool<QuicSocketTxScheduleItem> QuicSocketTxScheduleItemPool;  //!< Pool of QuicSocketTxScheduleItem
+
 
 class CompareScheduleItems
 {
@@ -169,10 +177,85 @@ public:
    */
   void AddScheduleItem (Ptr<QuicSocketTxScheduleItem> item, bool retx);
 
+  /**
+   * Create a schedule tx item, recycling a released one if possible
+   *
+   * \param id the stream ID
+   * \param off the offset on the stream
+   * \param p the priority of the item
+   * \param it the transmission item
+   * \return the schedule item
+   */
+  Ptr<QuicSocketTxScheduleItem> CreateScheduleItem (uint64_t id, uint64_t off, double p, Ptr<QuicSocketTxItem> it);
+
+  /**
+   * Set the pool from which the transmission items are allocated
+   *
+   * \param pool the item pool of the socket
+   */
+  void SetItemPool (Ptr<QuicTxItemPool<QuicSocketTxItem> > pool);
+
+  /**
+   * Get the pool from which the transmission items are allocated
+   *
+   * \return the item pool
+   */
+  Ptr<QuicTxItemPool<QuicSocketTxItem> > GetItemPool () const;
+
+  /**
+   * \brief Callback for the data of the expired frames dropped by the scheduler
+   *
+   * The arguments are the stream ID, the offset and the length of the dropped
+   * data, and whether the dropped data carried the FIN of the stream.
+   */
+  typedef Callback<void, uint64_t, uint64_t, uint32_t, bool> ExpiredDataCallback;
+
+  /**
+   * Set the callback notified of the stream data dropped because expired
+   * \param cb the callback
+   */
+  void SetExpiredDataCallback (ExpiredDataCallback cb);
+
+protected:
+  /**
+   * Insert a schedule item in the scheduling list
+   *
+   * The default list is a priority queue ordered by priority, stream and offset.
+   *
+   * \param item a scheduling item with priority
+   * \param retx true if the item is being retransmitted
+   */
+  virtual void Enqueue (Ptr<QuicSocketTxScheduleItem> item, bool retx);
+
+  /**
+   * Remove the next schedule item from the scheduling list
+   *
+   * \return the next item, the list must not be empty
+   */
+  virtual Ptr<QuicSocketTxScheduleItem> Dequeue ();
+
+  /**
+   * Put back an item, or what is left of it, that was just removed with Dequeue
+   *
+   * \param item the schedule item
+   */
+  virtual void Requeue (Ptr<QuicSocketTxScheduleItem> item);
+
+  /**
+   * Check whether an item removed with Dequeue must be dropped instead of sent
+   *
+   * \param item the schedule item
+   * \return true if the item has expired (by default, items never expire)
+   */
+  virtual bool IsExpired (Ptr<QuicSocketTxScheduleItem> item);
+
 private:
   typedef std::priority_queue<Ptr<QuicSocketTxScheduleItem>, std::vector<Ptr<QuicSocketTxScheduleItem> >, CompareScheduleItems> QuicTxPacketList;        //!< container for data stored in the buffer
   QuicTxPacketList m_appList;
   uint32_t m_appSize;
+  Ptr<QuicTxItemPool<QuicSocketTxItem> > m_itemPool;                 //!< Pool of the transmission items
+  Ptr<QuicSocketTxScheduleItemPool> m_scheduleItemPool;             //!< Pool of the schedule items
+  ExpiredDataCallback m_expiredDataCb;                              //!< Callback for the dropped expired data
 };
 
 } // namespace ns-3
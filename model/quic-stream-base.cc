@@ -34,11 +34,13 @@
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
 #include "quic-stream-base.h"
 #include "quic-header.h"
 #include "quic-transport-parameters.h"
+#include "quic-l4-protocol.h"
 
 namespace ns3 {
 
@@ -68,6 +70,16 @@ QuicStreamBase::GetTypeId (void)
                    UintegerValue (15000),                 // 10 packets
                    MakeUintegerAccessor (&QuicStreamBase::m_maxDataInterval),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AutoTuning",
+                   "Grow the receive window with the measured RTT and drain rate",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QuicStreamBase::m_autoTuning),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxStreamRcvBufSize",
+                   "Maximum size of the receive window with autotuning (bytes)",
+                   UintegerValue (16777216), // 16M
+                   MakeUintegerAccessor (&QuicStreamBase::m_maxStreamRxBufferSize),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -89,8 +101,12 @@ QuicStreamBase::QuicStreamBase (void)
   m_connectionId (0),
   m_streamId (0),
   m_quicl5 (0),
+  m_quicl4 (0),
   m_maxStreamData (0),
   m_maxAdvertisedData (0),
+  m_autoTunedSize (0),
+  m_lastWindowUpdate (Seconds (0)),
+  m_blockedOffset (0),
   m_sentSize (0),
   m_recvSize (0),
   m_fin (false)
@@ -103,6 +119,16 @@ QuicStreamBase::QuicStreamBase (void)
 QuicStreamBase::~QuicStreamBase (void)
 {
   NS_LOG_FUNCTION (this);
+  ReleaseRcvBuf ();
+}
+
+void
+QuicStreamBase::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ReleaseRcvBuf ();
+  m_quicl4 = 0;
+  QuicStream::DoDispose ();
 }
 
 void
@@ -136,6 +162,10 @@ QuicStreamBase::Send (Ptr<Packet> frame)
               m_streamSendPendingDataEvent = Simulator::Schedule (TimeStep (1), &QuicStreamBase::SendPendingData, this);
             }
         }
+      else
+        {
+          MaybeNotifyBlocked ();
+        }
       return sent;
     }
   else
@@ -225,6 +255,8 @@ QuicStreamBase::SendPendingData (void)
 
     }
 
+  MaybeNotifyBlocked ();
+
   if (nFrameSent > 0)
     {
       NS_LOG_INFO ("SendPendingData sent " << nFrameSent << " frames");
@@ -283,9 +315,24 @@ uint32_t
 QuicStreamBase::StreamWindow () const
 {
   NS_LOG_FUNCTION (this);
-  uint32_t inFlight = m_txBuffer->BytesInFlight ();
+  // the limit applies to the highest offset sent, so retransmissions do not count
+  uint64_t sentOffset = m_txBuffer->GetSentOffset ();
+
+  return (sentOffset > m_maxStreamData) ? 0 : m_maxStreamData - sentOffset;
+}
+
+void
+QuicStreamBase::OnAckedData (uint64_t offset, uint32_t length)
+{
+  NS_LOG_FUNCTION (this << offset << length);
+  m_txBuffer->OnAck (offset, length);
+}
 
-  return (inFlight > m_maxStreamData) ? 0 : m_maxStreamData - inFlight;
+std::vector<QuicStreamTxRange>
+QuicStreamBase::OnLostData (uint64_t offset, uint32_t length)
+{
+  NS_LOG_FUNCTION (this << offset << length);
+  return m_txBuffer->OnLost (offset, length);
 }
 
 int
@@ -341,7 +388,15 @@ QuicStreamBase::Recv (Ptr<Packet> frame, const QuicSubheader& sub, Address &addr
         }
       else
         {
-          SetMaxStreamData (sub.GetMaxStreamData ());
+          // the limit never decreases, stale updates are ignored
+          if (sub.GetMaxStreamData () > m_maxStreamData)
+            {
+              SetMaxStreamData (sub.GetMaxStreamData ());
+              if (m_txBuffer->AppSize () > 0 and !m_streamSendPendingDataEvent.IsRunning ())
+                {
+                  m_streamSendPendingDataEvent = Simulator::Schedule (TimeStep (1), &QuicStreamBase::SendPendingData, this);
+                }
+            }
           NS_LOG_INFO ("Max stream data (flow control) - " << m_maxStreamData);
         }
 
@@ -369,6 +424,55 @@ QuicStreamBase::Recv (Ptr<Packet> frame, const QuicSubheader& sub, Address &addr
 
       break;
 
+    case QuicSubheader::EXPIRED_STREAM_DATA:
+      if (!(m_streamDirectionType == RECEIVER or m_streamDirectionType == BIDIRECTIONAL))
+        {
+          m_quicl5->SignalAbortConnection (QuicSubheader::TransportErrorCodes_t::PROTOCOL_VIOLATION,
+                                           "Received EXPIRED_STREAM_DATA in send-only Stream");
+          return -1;
+        }
+
+      if (m_fin and sub.GetOffset () + sub.GetExpiredLength () > m_rxBuffer->GetFinalSize ())
+        {
+          m_quicl5->SignalAbortConnection (QuicSubheader::TransportErrorCodes_t::FINAL_OFFSET_ERROR,
+                                           "EXPIRED_STREAM_DATA beyond the final offset of a Stream");
+          return -1;
+        }
+
+      if (sub.IsStreamFin ())
+        {
+          if (m_fin and m_rxBuffer->GetFinalSize () != sub.GetOffset () + sub.GetExpiredLength ())
+            {
+              m_quicl5->SignalAbortConnection (QuicSubheader::TransportErrorCodes_t::FINAL_OFFSET_ERROR,
+                                               "EXPIRED_STREAM_DATA causes final offset to change for a Stream");
+              return -1;
+            }
+          // the abandoned data ended the stream, whose final size is now known
+          m_fin = true;
+          m_rxBuffer->SetFinalSize (sub.GetOffset () + sub.GetExpiredLength ());
+          SetStreamStateRecvIf (m_streamStateRecv == IDLE, RECV);
+          SetStreamStateRecvIf (m_streamStateRecv == RECV, SIZE_KNOWN);
+        }
+
+      if (sub.GetOffset () + sub.GetExpiredLength () > m_recvSize)
+        {
+          // only the abandoned range is skipped: the data before it may still
+          // be retransmitted, so the range is skipped once that is delivered
+          NS_LOG_INFO ("Expired data from offset " << sub.GetOffset () << " to " << sub.GetOffset () + sub.GetExpiredLength ());
+          uint64_t &end = m_expiredRanges[sub.GetOffset ()];
+          end = std::max (end, sub.GetOffset () + sub.GetExpiredLength ());
+
+          Ptr<Packet> payload = ExtractDeliverable ();
+          if (payload->GetSize () > 0)
+            {
+              m_quicl5->Recv (payload, address);
+            }
+        }
+      SetStreamStateRecvIf (m_streamStateRecv == SIZE_KNOWN and m_rxBuffer->Size () == 0
+                            and m_recvSize == m_rxBuffer->GetFinalSize (), DATA_RECVD);
+
+      break;
+
     case QuicSubheader::STREAM000:
     case QuicSubheader::STREAM001:
     case QuicSubheader::STREAM010:
@@ -416,7 +520,8 @@ QuicStreamBase::Recv (Ptr<Packet> frame, const QuicSubheader& sub, Address &addr
           return -1;
         }
 
-      m_fin = sub.IsStreamFin ();
+      // the final size may be known from an EXPIRED_STREAM_DATA frame
+      m_fin = m_fin or sub.IsStreamFin ();
 
       if (m_fin && m_streamId == 0)
         {
@@ -433,7 +538,11 @@ QuicStreamBase::Recv (Ptr<Packet> frame, const QuicSubheader& sub, Address &addr
           NS_LOG_INFO ("Received a frame with the correct order of size " << sub.GetLength ());
           m_recvSize += sub.GetLength ();
 
-          if (m_maxAdvertisedData == 0 || m_recvSize + m_rxBuffer->Available () > m_maxAdvertisedData + m_maxDataInterval)
+          if (m_autoTuning and m_streamId != 0)
+            {
+              MaybeSendWindowUpdate ();
+            }
+          else if (m_maxAdvertisedData == 0 || m_recvSize + m_rxBuffer->Available () > m_maxAdvertisedData + m_maxDataInterval)
             {
               m_maxAdvertisedData = m_recvSize + m_rxBuffer->Available ();
               QuicSubheader sub = QuicSubheader::CreateMaxData (m_recvSize + m_rxBuffer->Available ());
@@ -445,14 +554,7 @@ QuicStreamBase::Recv (Ptr<Packet> frame, const QuicSubheader& sub, Address &addr
 
           NS_LOG_LOGIC ("Try to Flush RxBuffer if Available - offset " << m_recvSize);
           // check if the packets in the RX buffer can be released (in order release)
-          std::pair<uint64_t, uint64_t> offSetLength = m_rxBuffer->GetDeliverable (m_recvSize);
-          NS_LOG_LOGIC ("Extracting " << offSetLength.second << " bytes from RxBuffer");
-          if (offSetLength.second > 0)
-            {
-              Ptr<Packet> payload = m_rxBuffer->Extract (offSetLength.second);
-              m_recvSize += offSetLength.second;
-              frame->AddAtEnd (payload);
-            }
+          frame->AddAtEnd (ExtractDeliverable ());
           NS_LOG_LOGIC ("Flushed RxBuffer - new offset " << m_recvSize << ", " << m_rxBuffer->Available () << "bytes available");
 
           SetStreamStateRecvIf (m_streamStateRecv == SIZE_KNOWN and m_rxBuffer->Size () == 0, DATA_RECVD);
@@ -472,6 +574,10 @@ QuicStreamBase::Recv (Ptr<Packet> frame, const QuicSubheader& sub, Address &addr
             }
 
           SetStreamStateRecvIf (m_streamStateRecv == DATA_RECVD, DATA_READ);
+          if (m_streamStateRecv == DATA_READ)
+            {
+              ReleaseRcvBuf ();
+            }
 
         }
       else
@@ -481,6 +587,11 @@ QuicStreamBase::Recv (Ptr<Packet> frame, const QuicSubheader& sub, Address &addr
               SetMaxStreamData (sub.GetMaxStreamData ());
               NS_LOG_LOGIC ("Received window set to offset " << sub.GetMaxStreamData ());
             }
+          if (sub.GetOffset () + frame->GetSize () <= m_recvSize)
+            {
+              NS_LOG_INFO ("Discarding already delivered frame - offset " << m_recvSize << ", frame offset " << sub.GetOffset ());
+              break;
+            }
           NS_LOG_INFO ("Buffering unordered received frame - offset " << m_recvSize << ", frame offset " << sub.GetOffset ());
           if (!m_rxBuffer->Add (frame, sub) && frame->GetSize () > 0)
             {
@@ -554,6 +665,113 @@ QuicStreamBase::SendMaxStreamData ()
   return m_recvSize + m_rxBuffer->Available ();
 }
 
+Ptr<Packet>
+QuicStreamBase::ExtractDeliverable ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<Packet> payload = Create<Packet> ();
+  while (true)
+    {
+      // skip the abandoned ranges that start within the delivered data
+      std::map<uint64_t, uint64_t>::iterator it = m_expiredRanges.begin ();
+      while (it != m_expiredRanges.end () and it->first <= m_recvSize)
+        {
+          if (it->second > m_recvSize)
+            {
+              NS_LOG_INFO ("Skipping expired data from offset " << m_recvSize << " to " << it->second);
+              m_recvSize = it->second;
+            }
+          it = m_expiredRanges.erase (it);
+        }
+
+      std::pair<uint64_t, uint64_t> offSetLength = m_rxBuffer->GetDeliverable (m_recvSize);
+      NS_LOG_LOGIC ("Extracting " << offSetLength.second << " bytes from RxBuffer");
+      if (offSetLength.second == 0)
+        {
+          break;
+        }
+      Ptr<Packet> data = m_rxBuffer->Extract (offSetLength.second);
+      if (data == 0)
+        {
+          break;
+        }
+      m_recvSize += data->GetSize ();
+      payload->AddAtEnd (data);
+    }
+
+  return payload;
+}
+
+void
+QuicStreamBase::MaybeSendWindowUpdate ()
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t window = m_rxBuffer->GetMaxBufferSize ();
+  if (m_maxAdvertisedData > 0 and m_recvSize + window / 2 < m_maxAdvertisedData)
+    {
+      NS_LOG_LOGIC ("Less than half of the window consumed, no update");
+      return;
+    }
+
+  Time rtt = m_quicl5->GetSmoothedRtt ();
+  Time now = Simulator::Now ();
+  if (m_maxAdvertisedData > 0 and !rtt.IsZero () and now - m_lastWindowUpdate < 2 * rtt
+      and window < m_maxStreamRxBufferSize)
+    {
+      // the peer consumes the window faster than it is updated, double it
+      uint32_t increase = std::min (window, m_maxStreamRxBufferSize - window);
+      // keep the protocol that grants the memory, to return it there
+      if (m_quicl4 == 0 and m_node != 0)
+        {
+          m_quicl4 = m_node->GetObject<QuicL4Protocol> ();
+        }
+      if (m_quicl4 != 0)
+        {
+          increase = m_quicl4->ReserveRcvBuf (increase);
+        }
+      if (increase > 0)
+        {
+          m_autoTunedSize += increase;
+          SetStreamRcvBufSize (window + increase);
+          NS_LOG_INFO ("Receive window increased from " << window << " to " << window + increase);
+        }
+    }
+  m_lastWindowUpdate = now;
+
+  m_maxAdvertisedData = SendMaxStreamData ();
+  Ptr<Packet> update = Create<Packet> ();
+  update->AddHeader (QuicSubheader::CreateMaxData (m_quicl5->GetMaxData ()));
+  update->AddHeader (QuicSubheader::CreateMaxStreamData (m_streamId, m_maxAdvertisedData));
+  m_quicl5->Send (update);
+}
+
+void
+QuicStreamBase::ReleaseRcvBuf ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_autoTunedSize > 0 and m_quicl4 != 0)
+    {
+      NS_LOG_INFO ("Release " << m_autoTunedSize << " bytes of receive buffer");
+      m_quicl4->ReleaseRcvBuf (m_autoTunedSize);
+      m_autoTunedSize = 0;
+    }
+}
+
+void
+QuicStreamBase::MaybeNotifyBlocked ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_streamId != 0 and m_txBuffer->AppSize () > 0 and AvailableWindow () == 0
+      and m_maxStreamData != m_blockedOffset)
+    {
+      m_blockedOffset = m_maxStreamData;
+      m_quicl5->SignalStreamBlocked (m_streamId, m_maxStreamData);
+    }
+}
+
 void
 QuicStreamBase::SetMaxStreamData (uint32_t maxStreamData)
 {
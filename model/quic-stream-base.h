@@ -29,16 +29,20 @@
 #include "ns3/traced-value.h"
 #include "quic-stream.h"
 #include "ns3/event-id.h"
+#include "ns3/nstime.h"
 #include "quic-stream-rx-buffer.h"
 #include "quic-stream-tx-buffer.h"
 #include "quic-subheader.h"
 #include "quic-header.h"
 #include "quic-l5-protocol.h"
 //#include "quic-frame-manager.h"
+#include <map>
 
 
 namespace ns3 {
 
+class QuicL4Protocol;
+
 /**
  * \ingroup quic
  *
@@ -100,6 +104,23 @@ public:
    */
   uint32_t StreamWindow () const;
 
+  /**
+   * \brief Called by the QuicL5Protocol class when stream data is acknowledged
+   *
+   * \param offset the offset of the acknowledged data
+   * \param length the length of the acknowledged data
+   */
+  void OnAckedData (uint64_t offset, uint32_t length);
+
+  /**
+   * \brief Called by the QuicL5Protocol class when stream data is lost
+   *
+   * \param offset the offset of the lost data
+   * \param length the length of the lost data
+   * \return the lost data that has not been acknowledged in the meantime
+   */
+  std::vector<QuicStreamTxRange> OnLostData (uint64_t offset, uint32_t length);
+
   /**
    * \brief Called by the QuicL5Protocol class to forward a frame for this stream
    *
@@ -181,6 +202,38 @@ public:
    */
   uint32_t GetStreamRcvBufSize (void) const;
 
+  /**
+   * \brief Advertise new flow-control credit when half of the receive window has been consumed
+   *
+   * If the previous update was sent less than two RTTs before, the peer is draining
+   * the window faster than it is updated, and the window is doubled, up to
+   * MaxStreamRcvBufSize and within the receive buffer budget of the node
+   */
+  void MaybeSendWindowUpdate ();
+
+  /**
+   * \brief Return the receive buffer memory reserved by the autotuning to the node budget
+   *
+   * This is done when all the data of the stream has been read, and when the
+   * stream or its connection is closed.
+   */
+  void ReleaseRcvBuf ();
+
+  /**
+   * \brief Report the blocking of the stream if it has data to send but no credit
+   */
+  void MaybeNotifyBlocked ();
+
+  /**
+   * \brief Extract the in-order data from the RX buffer
+   *
+   * The data abandoned by the sender is skipped when all the data before it
+   * has been delivered, so that the following data can be delivered too.
+   *
+   * \return the deliverable data, possibly empty
+   */
+  Ptr<Packet> ExtractDeliverable ();
+
   // Implementation of QuicStream virtuals
   std::string StreamDirectionTypeToString () const;
   void SetStreamDirectionType (const QuicStreamDirectionTypes_t& streamDirectionType);
@@ -197,6 +250,8 @@ public:
   uint32_t GetStreamTxAvailable (void) const;
 
 protected:
+  virtual void DoDispose (void);
+
   QuicStreamTypes_t m_streamType;                    //!< The stream type
   QuicStreamDirectionTypes_t m_streamDirectionType;  //!< The stream direction
   QuicStreamStates_t m_streamStateSend;              //!< The state of the send stream
@@ -205,14 +260,21 @@ protected:
   uint64_t m_connectionId;                           //!< The connection ID
   uint64_t m_streamId;                               //!< The stream ID
   Ptr<QuicL5Protocol>  m_quicl5;                     //!< The L5 Protocol this stack is associated with
+  Ptr<QuicL4Protocol> m_quicl4;                      //!< The L4 Protocol that granted the receive buffer memory
 
   // Flow Control Parameters
   uint32_t m_maxStreamData;                          //!< Maximum amount of data that can be sent/received on the stream
   uint32_t m_maxAdvertisedData;                                          //!< Last advertised MaxData
   uint32_t m_maxDataInterval;                                            //!< Interval between MaxData frames
+  bool m_autoTuning;                                 //!< Grow the receive window with the drain rate of the peer
+  uint32_t m_maxStreamRxBufferSize;                  //!< Upper bound of the autotuned receive window
+  uint32_t m_autoTunedSize;                          //!< Receive buffer memory reserved from the node budget
+  Time m_lastWindowUpdate;                           //!< Time of the last flow-control update sent
+  uint64_t m_blockedOffset;                          //!< MAX_STREAM_DATA limit of the last blocking reported
   uint64_t m_sentSize;                               //!< Amount of data sent in this stream
   uint64_t m_recvSize;                               //!< Amount of data received in this stream
   bool m_fin;                                        //!< A flag indicating if the FIN bit has already been received/sent
+  std::map<uint64_t, uint64_t> m_expiredRanges;      //!< Data abandoned by the sender and not skipped yet (offset, end)
   Ptr<QuicStreamRxBuffer> m_rxBuffer;                //!< Rx buffer (reordering buffer)
   Ptr<QuicStreamTxBuffer> m_txBuffer;                //!< Tx buffer
   uint32_t m_streamTxBufferSize;                     //!< Size of the stream TX buffer
@@ -33,6 +33,7 @@
 // #include "ns3/ipv6-l3-protocol.h"
 // #include "ns3/ipv6-routing-protocol.h"
 #include <algorithm>
+#include <iterator>
 #include "quic-stream-rx-buffer.h"
 #include "quic-subheader.h"
 
@@ -101,66 +102,84 @@ QuicStreamRxBuffer::Add (Ptr<Packet> p, const QuicSubheader& sub)
   NS_LOG_INFO (
     "Try to append " << p->GetSize () << " bytes " << ", availSize=" << Available ());
 
-  if (p->GetSize () <= Available ())
+  if (p->GetSize () == 0)
     {
-      if (p->GetSize () > 0)
+      NS_LOG_WARN ("Discarded. Trying to insert empty packet.");
+      return false;
+    }
+
+  uint64_t start = sub.GetOffset ();
+  uint64_t end = start + p->GetSize ();
+
+  // Find the portions of [start, end) that are not in the buffer yet
+  std::vector<std::pair<uint64_t, uint64_t> > pieces;
+  uint64_t cursor = start;
+  QuicStreamRxPacketList::iterator it = m_streamRecvList.upper_bound (start);
+  if (it != m_streamRecvList.begin ())
+    {
+      QuicStreamRxPacketList::iterator prev = std::prev (it);
+      cursor = std::max (cursor, prev->first + prev->second.m_packet->GetSize ());
+    }
+  for (; it != m_streamRecvList.end () and it->first < end and cursor < end; ++it)
+    {
+      if (it->first > cursor)
         {
+          pieces.push_back (std::make_pair (cursor, it->first));
+        }
+      cursor = std::max (cursor, it->first + it->second.m_packet->GetSize ());
+    }
+  if (cursor < end)
+    {
+      pieces.push_back (std::make_pair (cursor, end));
+    }
 
-          QuicStreamRxItem *item = new QuicStreamRxItem ();
-          item->m_packet = p->Copy ();
-          item->m_offset = sub.GetOffset ();
-          item->m_fin = sub.IsStreamFin ();
-
-          QuicStreamRxPacketList::iterator it;
-
-          // FIN packet for the stream
-          if (sub.IsStreamFin ())
-            {
-              NS_LOG_LOGIC ("FIN packet for the stream");
-              m_finalSize = sub.GetOffset () + p->GetSize ();
-              m_recvFin = true;
-              m_streamRecvList.insert (m_streamRecvList.end (), item);
-              return true;
-            }
-
-          // Find the right place to insert packet (TODO: binary search would be more efficient)
-          bool inserted = false;
-          for (it = m_streamRecvList.begin (); it < m_streamRecvList.end ();
-               ++it)
-            {
-              if (item->m_offset == (*it)->m_offset)
-                {
-                  // Duplicate packet
-                  NS_LOG_WARN ("Discarded duplicate packet.");
-                  return false;
-                }
-              if (item->m_offset < (*it)->m_offset)
-                {
-                  m_streamRecvList.insert (it, item);
-                  NS_LOG_LOGIC ("Inserted packet");
-                  inserted = true;
-                  break;
-                }
-            }
-          // The packet is not in the buffer, append it to the end
-          if (!inserted)
-            {
-              NS_LOG_LOGIC ("Appending packet");
-              m_streamRecvList.insert (m_streamRecvList.end (), item);
-            }
-          m_numBytesInBuffer += p->GetSize ();
-          NS_LOG_INFO ("Update: Received Size = " << m_numBytesInBuffer);
-          return true;
+  uint64_t newBytes = 0;
+  for (auto &piece : pieces)
+    {
+      newBytes += piece.second - piece.first;
+    }
+
+  if (newBytes > Available ())
+    {
+      NS_LOG_WARN ("Rejected. Not enough room to buffer packet.");
+      return false;
+    }
+
+  // FIN packet for the stream
+  if (sub.IsStreamFin ())
+    {
+      NS_LOG_LOGIC ("FIN packet for the stream");
+      m_finalSize = end;
+      m_recvFin = true;
+    }
+
+  if (pieces.empty ())
+    {
+      // Duplicate packet
+      NS_LOG_WARN ("Discarded duplicate packet.");
+      return false;
+    }
 
+  for (auto &piece : pieces)
+    {
+      QuicStreamRxItem item;
+      if (piece.first == start and piece.second == end)
+        {
+          item.m_packet = p;
         }
       else
         {
-          NS_LOG_WARN ("Discarded. Trying to insert empty packet.");
-          return false;
+          NS_LOG_LOGIC ("Partial duplicate, inserting bytes [" << piece.first << ", " << piece.second << ")");
+          item.m_packet = p->CreateFragment (piece.first - start, piece.second - piece.first);
         }
+      item.m_offset = piece.first;
+      item.m_fin = sub.IsStreamFin () and piece.second == end;
+      m_streamRecvList.emplace (piece.first, item);
     }
-  NS_LOG_WARN ("Rejected. Not enough room to buffer packet.");
-  return false;
+
+  m_numBytesInBuffer += newBytes;
+  NS_LOG_INFO ("Update: Received Size = " << m_numBytesInBuffer);
+  return true;
 }
 
 Ptr<Packet>
@@ -179,32 +198,23 @@ QuicStreamRxBuffer::Extract (uint32_t maxSize)
 
   Ptr<Packet> outPkt = Create<Packet> ();
 
-  QuicStreamRxPacketList::iterator it = m_streamRecvList.begin ();
-
-  while (extractSize > 0 && !m_streamRecvList.empty ()
-         && it != m_streamRecvList.end ())
+  while (extractSize > 0 && !m_streamRecvList.empty ())
     {
-      it = m_streamRecvList.begin ();
-      Ptr<Packet> currentPacket = (*it)->m_packet;
-
-      if (currentPacket->GetSize () <= extractSize)   // Merge
-        {
-
-          outPkt->AddAtEnd (currentPacket);
-          m_streamRecvList.erase (it);
-          NS_LOG_LOGIC ("Extracted and removed packet " << (*it)->m_offset << " from RxBuffer, bytes to extract: " << extractSize);
-
-          m_numBytesInBuffer -= currentPacket->GetSize ();
-          extractSize -= currentPacket->GetSize ();
+      QuicStreamRxPacketList::iterator it = m_streamRecvList.begin ();
+      Ptr<Packet> currentPacket = it->second.m_packet;
 
-          continue;
-        }
-      else
+      if (currentPacket->GetSize () > extractSize)
         {
           break;
         }
 
-      it++;
+      // Merge
+      outPkt->AddAtEnd (currentPacket);
+      NS_LOG_LOGIC ("Extracted and removed packet " << it->first << " from RxBuffer, bytes to extract: " << extractSize);
+      m_streamRecvList.erase (it);
+
+      m_numBytesInBuffer -= currentPacket->GetSize ();
+      extractSize -= currentPacket->GetSize ();
     }
 
   if (outPkt->GetSize () == 0)
@@ -224,16 +234,33 @@ QuicStreamRxBuffer::GetDeliverable (uint64_t currRecvOffset)
   uint64_t lengthToExtract = 0;
   NS_LOG_LOGIC ("Calculating deliverable size");
 
-  QuicStreamRxPacketList::iterator i;
-
-  for (i = m_streamRecvList.begin (); i != m_streamRecvList.end (); ++i)
+  // Discard the data that has already been delivered
+  while (!m_streamRecvList.empty () and m_streamRecvList.begin ()->first < currRecvOffset)
     {
-      if ((*i)->m_offset == currRecvOffset + lengthToExtract)
+      QuicStreamRxItem item = m_streamRecvList.begin ()->second;
+      m_streamRecvList.erase (m_streamRecvList.begin ());
+      uint32_t size = item.m_packet->GetSize ();
+      m_numBytesInBuffer -= size;
+      if (item.m_offset + size > currRecvOffset)
         {
-          offsetToExtract = (*i)->m_offset;
-          lengthToExtract += (*i)->m_packet->GetSize ();
+          // keep the bytes from currRecvOffset onwards
+          uint32_t delivered = currRecvOffset - item.m_offset;
+          item.m_packet = item.m_packet->CreateFragment (delivered, size - delivered);
+          item.m_offset = currRecvOffset;
+          m_numBytesInBuffer += item.m_packet->GetSize ();
+          m_streamRecvList.emplace (currRecvOffset, item);
+          break;
         }
-      NS_LOG_LOGIC ("Inspected packet with offset " << (*i)->m_offset);
+      NS_LOG_LOGIC ("Discarded already delivered packet with offset " << item.m_offset);
+    }
+
+  // Follow the contiguous packets from currRecvOffset
+  for (QuicStreamRxPacketList::iterator i = m_streamRecvList.find (currRecvOffset);
+       i != m_streamRecvList.end () and i->first == currRecvOffset + lengthToExtract; ++i)
+    {
+      offsetToExtract = i->first;
+      lengthToExtract += i->second.m_packet->GetSize ();
+      NS_LOG_LOGIC ("Inspected packet with offset " << i->first);
     }
 
   return std::make_pair (offsetToExtract, lengthToExtract);
@@ -277,6 +304,14 @@ QuicStreamRxBuffer::GetFinalSize () const
   return m_finalSize;
 }
 
+void
+QuicStreamRxBuffer::SetFinalSize (uint32_t finalSize)
+{
+  NS_LOG_FUNCTION (this << finalSize);
+  m_finalSize = finalSize;
+  m_recvFin = true;
+}
+
 void
 QuicStreamRxBuffer::Print (std::ostream & os) const
 {
@@ -287,7 +322,7 @@ QuicStreamRxBuffer::Print (std::ostream & os) const
 
   for (it = m_streamRecvList.begin (); it != m_streamRecvList.end (); ++it)
     {
-      (*it)->Print (ss);
+      it->second.Print (ss);
     }
 
   os << "Stream Recv list: \n" << ss.str () << "\n\nCurrent Status: "
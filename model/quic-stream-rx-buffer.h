@@ -128,6 +128,9 @@ public:
    * Check how many bytes can be released from the buffer (i.e., how many in-order bytes
    * are present from a certain offset)
    *
+   * The data below currRecvOffset has already been delivered, and is discarded
+   * from the buffer.
+   *
    * \param currRecvOffset the current offset in the stream sequence
    * \return a pair with the offset of the last packet to extract and the total number of bytes to extract
    */
@@ -136,9 +139,15 @@ public:
   /**
    * Add a packet to the receive buffer
    *
+   * Only the bytes not already in the buffer are stored, so that frames that
+   * partially overlap with the buffered ones are accepted. The buffer takes
+   * ownership of the packet, which is stored without being copied, and must
+   * not be modified by the caller afterwards
+   *
    * \param p a smart pointer to a packet
    * \param sub the QuicSubheader of the packet
-   * \return true if the insertion was successful
+   * \return true if the insertion was successful, false if the packet is empty,
+   *   already in the buffer, or larger than the available space
    */
   bool Add (Ptr<Packet> p, const QuicSubheader& sub);
 
@@ -158,6 +167,14 @@ public:
    */
   uint32_t GetFinalSize () const;
 
+  /**
+   * Set the final size of a stream whose FIN was not received in a frame
+   * with data, e.g., because the sender abandoned the last frame
+   *
+   * \param finalSize the final size of the stream
+   */
+  void SetFinalSize (uint32_t finalSize);
+
   /**
    * Return the number of bytes in the buffer
    *
@@ -166,10 +183,9 @@ public:
   uint32_t Size (void) const;
 
 private:
-  // TODO consider replacing std::vector with a ordered data structure
-  typedef std::vector<QuicStreamRxItem*> QuicStreamRxPacketList;  //!< container for data stored in the buffer
+  typedef std::map<uint64_t, QuicStreamRxItem> QuicStreamRxPacketList;  //!< container for data stored in the buffer, indexed by offset
 
-  QuicStreamRxPacketList m_streamRecvList;  //!< List of received packets with additional info
+  QuicStreamRxPacketList m_streamRecvList;  //!< Non-overlapping received packets with additional info
   uint32_t m_numBytesInBuffer;              //!< Current buffer occupancy
   uint32_t m_finalSize;                     //!< Final buffer size
   uint32_t m_maxBuffer;                     //!< Maximum buffer size
@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 
 #include "ns3/packet.h"
 #include "ns3/log.h"
@@ -36,49 +37,6 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("QuicStreamTxBuffer");
 
-QuicStreamTxItem::QuicStreamTxItem ()
-  : m_packetNumberSequence (0),
-    m_packet (0),
-    m_lost (false),
-    m_retrans (false),
-    m_sacked (false),
-    m_lastSent (Time::Min ()),
-    m_id (0)
-{}
-
-QuicStreamTxItem::QuicStreamTxItem (const QuicStreamTxItem &other)
-  : m_packetNumberSequence (other.m_packetNumberSequence),
-    m_packet (other.m_packet),
-    m_lost (other.m_lost),
-    m_retrans (other.m_retrans),
-    m_sacked (other.m_sacked),
-    m_lastSent (other.m_lastSent),
-    m_id (other.m_id)
-{}
-
-QuicStreamTxItem::~QuicStreamTxItem ()
-{}
-
-void
-QuicStreamTxItem::Print (std::ostream &os) const
-{
-  NS_LOG_FUNCTION (this);
-  os << "[ID " << m_id << " SN " << m_packetNumberSequence.GetValue () << " - Last Sent: " << m_lastSent << "]";
-
-  if (m_lost)
-    {
-      os << "|lost|";
-    }
-  if (m_retrans)
-    {
-      os << "|retr|";
-    }
-  if (m_sacked)
-    {
-      os << "|ackd|";
-    }
-}
-
 NS_OBJECT_ENSURE_REGISTERED (QuicStreamTxBuffer);
 
 TypeId
@@ -88,21 +46,17 @@ QuicStreamTxBuffer::GetTypeId (void)
     .SetParent<Object> ()
     .SetGroupName ("Internet")
     .AddConstructor<QuicStreamTxBuffer> ()
-//    .AddTraceSource ("UnackSequence",
-//                     "First unacknowledged sequence number (SND.UNA)",
-//                     MakeTraceSourceAccessor (&QuicStreamTxBuffer::m_sentSize),
-//                     "ns3::SequenceNumber32TracedValueCallback")
   ;
   return tid;
 }
 
 QuicStreamTxBuffer::QuicStreamTxBuffer ()
   : m_maxBuffer (131072),
-    m_appSize (0),
-    m_sentSize (0)
+    m_ackedOffset (0),
+    m_ackedSize (0),
+    m_sentOffset (0),
+    m_endOffset (0)
 {
-  m_appList = QuicTxPacketList ();
-  m_sentList = QuicTxPacketList ();
 }
 
 QuicStreamTxBuffer::~QuicStreamTxBuffer (void)
@@ -112,26 +66,20 @@ void
 QuicStreamTxBuffer::Print (std::ostream & os) const
 {
   NS_LOG_FUNCTION (this);
-  QuicStreamTxBuffer::QuicTxPacketList::const_iterator it;
-  std::stringstream ss;
   std::stringstream as;
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  for (auto it = m_acked.begin (); it != m_acked.end (); ++it)
     {
-      (*it)->Print (ss);
+      as << "[" << it->first << ", " << it->second << ") ";
     }
 
-  for (it = m_appList.begin (); it != m_appList.end (); ++it)
-    {
-      (*it)->Print (as);
-    }
-
-  os << "App list: \n" << as.str () <<
-    "\n\nSent list: \n" << ss.str () <<
+  os << "Acked ranges: \n" << as.str () <<
     "\n\nCurrent Status: " <<
-    "\nNumber of transmissions = " << m_sentList.size () <<
-    "\nApplication Size = " << m_appSize <<
-    "\nSent Size = " << m_sentSize;
+    "\nAcked offset = " << m_ackedOffset <<
+    "\nSent offset = " << m_sentOffset <<
+    "\nEnd offset = " << m_endOffset <<
+    "\nApplication Size = " << AppSize () <<
+    "\nBytes in flight = " << BytesInFlight ();
 }
 
 bool
@@ -144,12 +92,11 @@ QuicStreamTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          Ptr<QuicStreamTxItem> item = CreateObject<QuicStreamTxItem> ();
-          item->m_packet = p;
-          m_appList.insert (m_appList.end (), item);
-          m_appSize += p->GetSize ();
+          // the buffered packets are never modified, so they are stored without copying
+          m_data.push_back (std::make_pair (m_endOffset, p));
+          m_endOffset += p->GetSize ();
 
-          NS_LOG_INFO ("Update: Application Size = " << m_appSize);
+          NS_LOG_INFO ("Update: Application Size = " << AppSize ());
           return true;
         }
       else
@@ -167,231 +114,160 @@ bool
 QuicStreamTxBuffer::Rejected (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
-  QuicSubheader qsb;
-  p->PeekHeader (qsb);
-  NS_LOG_INFO ("Packet of size " << p->GetSize () << " bytes rejected, reappending. Offset " << qsb.GetOffset ());
+  uint32_t size = p->GetSize ();
+  NS_LOG_INFO ("Packet of size " << size << " bytes rejected, rewinding from offset " << m_sentOffset);
 
-  if (p->GetSize () <= Available ())
+  if (size == 0)
     {
-      if (p->GetSize () > 0)
-        {
-          Ptr<QuicStreamTxItem> item = CreateObject<QuicStreamTxItem> ();
-          item->m_packet = p;
-          m_appList.insert (m_appList.begin (), item);
-          m_appSize += p->GetSize ();
-          m_sentList.pop_back ();
-          m_sentSize -= p->GetSize ();
-          Ptr<Packet> added = (*m_appList.begin ())->m_packet;
-          added->PeekHeader (qsb);
-          NS_LOG_INFO ("Update: Application Size = " << m_appSize << " added packet with offset " << qsb.GetOffset ());
-          return true;
-        }
-      else
-        {
-          NS_LOG_WARN ("Discarded. Try to insert empty packet.");
-          return false;
-        }
+      NS_LOG_WARN ("Discarded. Try to insert empty packet.");
+      return false;
     }
-  NS_LOG_WARN ("Rejected. Not enough room to buffer packet.");
-  return false;
+  if (size > m_sentOffset - m_ackedOffset)
+    {
+      NS_LOG_WARN ("Rejected data was not in flight.");
+      return false;
+    }
+  // the data is still in the buffer, so it is enough to move the sent offset back
+  m_sentOffset -= size;
+  NS_LOG_INFO ("Update: Application Size = " << AppSize () << ", sent offset " << m_sentOffset);
+  return true;
 }
 
-
 Ptr<Packet>
 QuicStreamTxBuffer::NextSequence (uint32_t numBytes, const SequenceNumber32 seq)
 {
   NS_LOG_FUNCTION (this << numBytes << seq);
 
-  Ptr<QuicStreamTxItem> outItem = GetNewSegment (numBytes);
-
-  if (outItem != nullptr)
-    {
-      outItem->m_packetNumberSequence = seq;
-      outItem->m_lastSent = Simulator::Now ();
-      Ptr<Packet> toRet = outItem->m_packet->Copy ();
-      return toRet;
-    }
-  else
-    {
-      return Create<Packet> ();
-    }
+  uint32_t size = std::min<uint64_t> (numBytes, m_endOffset - m_sentOffset);
+  Ptr<Packet> frame = GetData (m_sentOffset, size);
+  m_sentOffset += size;
 
+  NS_LOG_INFO ("Update: Sent offset = " << m_sentOffset);
+  return frame;
 }
 
-Ptr<QuicStreamTxItem>
-QuicStreamTxBuffer::GetNewSegment (uint32_t numBytes)
+Ptr<Packet>
+QuicStreamTxBuffer::GetData (uint64_t offset, uint32_t length) const
 {
-  NS_LOG_FUNCTION (this << numBytes);
+  NS_LOG_FUNCTION (this << offset << length);
 
-  bool toInsert = false;
-  Ptr<Packet> currentPacket = 0;
-  Ptr<QuicStreamTxItem> currentItem = 0;
-  Ptr<QuicStreamTxItem> outItem = CreateObject<QuicStreamTxItem> ();
-  outItem->m_packet = Create<Packet> ();
-  uint32_t outItemSize = 0;
-  QuicTxPacketList::iterator it = m_appList.begin ();
-
-  while (it != m_appList.end () && outItemSize < numBytes)
+  if (length == 0)
     {
-      currentItem = *it;
-      currentPacket = currentItem->m_packet;
-
-//	  uint32_t subheaderSize = 0;
-//	  if(m_TxBufferType == SOCKET)
-//	  {
-//		  QuicSubheader sub;
-//		  currentItem->m_packet->PeekHeader(sub);
-//		  subheaderSize = sub.GetSerializedSize();
-//	  }
-
-      if (outItemSize + currentItem->m_packet->GetSize () /*- subheaderSize*/ <= numBytes)   // Merge
+      return Create<Packet> ();
+    }
+  NS_ASSERT_MSG (!m_data.empty () and offset >= m_data.front ().first
+                 and offset + length <= m_endOffset,
+                 "Data [" << offset << ", " << offset + length << ") not in the buffer");
+
+  // find the packet that contains the first byte
+  auto it = std::upper_bound (m_data.begin (), m_data.end (), offset,
+                              [] (uint64_t off, const QuicStreamTxRange &range)
+                              { return off < range.first; });
+  --it;
+
+  Ptr<Packet> data = 0;
+  while (length > 0)
+    {
+      uint32_t start = offset - it->first;
+      uint32_t size = std::min (length, it->second->GetSize () - start);
+      // the buffered packets are shared, so the data is always copied or fragmented
+      Ptr<Packet> fragment = (start == 0 and size == it->second->GetSize ()) ?
+        it->second->Copy () : it->second->CreateFragment (start, size);
+      if (data == 0)
         {
-          QuicSubheader qsb;
-          NS_LOG_LOGIC ("Extracting packet from stream TX buffer");
-          toInsert = true;
-          MergeItems (*outItem, *currentItem);
-          outItemSize += currentItem->m_packet->GetSize ();
-
-          m_appList.erase (it);
-          m_appSize -= currentItem->m_packet->GetSize ();
-
-          it = m_appList.begin (); // Restart to find other possible merges
-          continue;
+          data = fragment;
         }
       else
         {
-          // The packet is too large, split it
-          uint32_t split = numBytes - outItemSize;
-
-          Ptr<QuicStreamTxItem> toBeBuffered = CreateObject<QuicStreamTxItem> ();
-          SplitItems (*currentItem, *toBeBuffered, split);
-
-          // Add left part of the split to subframe
-          NS_LOG_LOGIC ("Add incomplete subframe to the outItem");
-          MergeItems (*outItem, *currentItem);
-          outItemSize += currentItem->m_packet->GetSize ();
-
-          m_appList.erase (it);
-          m_appSize -= currentItem->m_packet->GetSize ();
-
-          m_appList.push_front (toBeBuffered);
-
+          data->AddAtEnd (fragment);
         }
-
-      it++;
+      offset += size;
+      length -= size;
+      ++it;
     }
-
-  if (toInsert)
-    {
-      m_sentList.insert (m_sentList.end (), outItem);
-      m_sentSize += outItem->m_packet->GetSize ();
-    }
-
-  NS_LOG_INFO ("Update: Sent Size = " << m_sentSize);
-
-  return outItem;
+  return data;
 }
 
 void
-QuicStreamTxBuffer::OnAckUpdate (const uint64_t largestAcknowledged, const std::vector<uint64_t> &additionalAckBlocks, const std::vector<uint64_t> &gaps)
+QuicStreamTxBuffer::OnAck (uint64_t offset, uint32_t length)
 {
-  NS_LOG_FUNCTION (this);
-  std::vector<uint64_t> compAckBlocks = additionalAckBlocks;
-  std::vector<uint64_t> compGaps = additionalAckBlocks;
-
-  NS_LOG_INFO ("Handling Ack - highest packet " << largestAcknowledged);
-  compAckBlocks.insert (compAckBlocks.begin (), largestAcknowledged);
-  compGaps.push_back (0);
-  uint64_t ackBlockCount = compAckBlocks.size ();
-
-  std::vector<uint64_t>::const_iterator ack_it = compAckBlocks.begin ();
-  std::vector<uint64_t>::const_iterator gap_it = compGaps.begin ();
+  NS_LOG_FUNCTION (this << offset << length);
 
-  for (uint64_t numAckBlockAnalyzed = 0; numAckBlockAnalyzed < ackBlockCount; numAckBlockAnalyzed++, ack_it++, gap_it++)
+  // only the data in flight can be acknowledged
+  uint64_t start = std::max (offset, m_ackedOffset);
+  uint64_t end = std::min (offset + length, m_sentOffset);
+  if (start >= end)
     {
-      for (auto sent_it = m_sentList.rbegin (); sent_it != m_sentList.rend () and !m_sentList.empty (); ++sent_it)       // Visit sentList in reverse Order for optimization
-        {
-          if ((*sent_it)->m_packetNumberSequence < (SequenceNumber32)(*gap_it) )              // Just for optimization we suppose All is perfectly ordered
-            {
-              break;
-            }
-
-          if ((*sent_it)->m_packetNumberSequence <= (SequenceNumber32)(*ack_it) and (*sent_it)->m_packetNumberSequence > (SequenceNumber32)(*gap_it) and (*sent_it)->m_sacked == false)
-            {
-              NS_LOG_LOGIC ("Acked packet " << (*sent_it)->m_packetNumberSequence);
-              (*sent_it)->m_sacked = true;
-            }
-
-        }
+      return;
     }
-}
 
-
-void
-QuicStreamTxBuffer::MergeItems (QuicStreamTxItem &t1, QuicStreamTxItem &t2) const
-{
-  NS_LOG_FUNCTION (this);
-
-  if (t1.m_sacked == true && t2.m_sacked == true)
+  // merge the range with the overlapping and adjacent ones
+  auto it = m_acked.upper_bound (start);
+  if (it != m_acked.begin () and std::prev (it)->second >= start)
     {
-      t1.m_sacked = true;
+      --it;
     }
-  else
+  while (it != m_acked.end () and it->first <= end)
     {
-      t1.m_sacked = false;
+      start = std::min (start, it->first);
+      end = std::max (end, it->second);
+      m_ackedSize -= it->second - it->first;
+      it = m_acked.erase (it);
     }
 
-  if (t2.m_retrans == true && t1.m_retrans == false)
+  if (start == m_ackedOffset)
     {
-      t1.m_retrans = true;
-    }
-  if (t1.m_lastSent < t2.m_lastSent)
-    {
-      t1.m_lastSent = t2.m_lastSent;
+      // all the data up to end is acknowledged, release it
+      m_ackedOffset = end;
+      while (!m_data.empty ()
+             and m_data.front ().first + m_data.front ().second->GetSize () <= m_ackedOffset)
+        {
+          m_data.pop_front ();
+        }
+      NS_LOG_INFO ("Update: Acked offset = " << m_ackedOffset);
     }
-  if (t2.m_lost)
+  else
     {
-      t1.m_lost = true;
+      m_acked[start] = end;
+      m_ackedSize += end - start;
     }
-
-  t1.m_packet->AddAtEnd (t2.m_packet);
 }
 
-void
-QuicStreamTxBuffer::SplitItems (QuicStreamTxItem &t1, QuicStreamTxItem &t2, uint32_t size) const
+std::vector<QuicStreamTxRange>
+QuicStreamTxBuffer::OnLost (uint64_t offset, uint32_t length) const
 {
-  uint32_t initialSize = t1.m_packet->GetSize ();
+  NS_LOG_FUNCTION (this << offset << length);
+
+  std::vector<QuicStreamTxRange> missing;
+  uint64_t start = std::max (offset, m_ackedOffset);
+  uint64_t end = std::min (offset + length, m_sentOffset);
 
-  t2.m_sacked = t1.m_sacked;
-  t2.m_retrans = t1.m_retrans;
-  t2.m_lastSent = t1.m_lastSent;
-  t2.m_lost = t1.m_lost;
-  if (t1.m_lastSent < t2.m_lastSent)
+  // skip the acknowledged range that contains start, if any
+  auto it = m_acked.upper_bound (start);
+  if (it != m_acked.begin () and std::prev (it)->second > start)
     {
-      t1.m_lastSent = t2.m_lastSent;
+      start = std::prev (it)->second;
     }
-  if (t2.m_lost)
+  // collect the gaps between the acknowledged ranges
+  while (start < end)
     {
-      t1.m_lost = true;
+      uint64_t stop = (it != m_acked.end ()) ? std::min (end, it->first) : end;
+      NS_LOG_LOGIC ("Missing data [" << start << ", " << stop << ")");
+      missing.push_back (std::make_pair (start, GetData (start, stop - start)));
+      if (it == m_acked.end ())
+        {
+          break;
+        }
+      start = it->second;
+      ++it;
     }
-  // Copy the packet into t2
-  t2.m_packet = t1.m_packet->Copy ();
-  // Remove the first size bytes from t2
-  t2.m_packet->RemoveAtStart (size);
-
-  NS_ASSERT_MSG (t2.m_packet->GetSize () == initialSize - size,
-                 "Wrong size " << t2.m_packet->GetSize ());
-  // Remove the bytes from size to end from t1
-  t1.m_packet->RemoveAtEnd (t1.m_packet->GetSize () - size);
-  NS_ASSERT_MSG (t1.m_packet->GetSize () == size,
-                 "Wrong size " << t1.m_packet->GetSize ());
+  return missing;
 }
 
-
 uint32_t
 QuicStreamTxBuffer::Available (void) const
 {
-  return m_maxBuffer - m_appSize;
+  return m_maxBuffer - AppSize ();
 }
 
 uint32_t
@@ -409,7 +285,7 @@ QuicStreamTxBuffer::SetMaxBufferSize (uint32_t n)
 uint32_t
 QuicStreamTxBuffer::AppSize (void) const
 {
-  return m_appSize;
+  return m_endOffset - m_sentOffset;
 }
 
 uint32_t
@@ -417,8 +293,19 @@ QuicStreamTxBuffer::BytesInFlight () const
 {
   NS_LOG_FUNCTION (this);
 
-  return m_sentSize;
+  return m_sentOffset - m_ackedOffset - m_ackedSize;
+}
 
+uint64_t
+QuicStreamTxBuffer::GetSentOffset () const
+{
+  return m_sentOffset;
+}
+
+uint64_t
+QuicStreamTxBuffer::GetAckedOffset () const
+{
+  return m_ackedOffset;
 }
 
 
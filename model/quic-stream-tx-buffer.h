@@ -25,7 +25,11 @@
 #ifndef QUICSTREAMTXBUFFER_H
 #define QUICSTREAMTXBUFFER_H
 
+#include <deque>
+#include <map>
+#include <vector>
 #include "ns3/object.h"
+#include "ns3/packet.h"
 #include "ns3/traced-value.h"
 #include "ns3/sequence-number.h"
 #include "ns3/nstime.h"
@@ -36,36 +40,22 @@ namespace ns3 {
 /**
  * \ingroup quic
  *
- * \brief Item that encloses the frame packet and some flags for it
+ * \brief Stream data starting at a given offset
  */
-class QuicStreamTxItem : public Object
-{
-public:
-  QuicStreamTxItem ();
-  QuicStreamTxItem (const QuicStreamTxItem &other);
-  ~QuicStreamTxItem ();
-
-  /**
-   * \brief Print the Item
-   * \param os ostream
-   */
-  void Print (std::ostream &os) const;
-
-  SequenceNumber32 m_packetNumberSequence;  //!< Sequence number of the application packet associated with this frame
-  Ptr<Packet> m_packet;                     //!< packet associated to this QuicStreamTxItem
-  bool m_lost;                              //!< true if the frame is lost
-  bool m_retrans;                           //!< true if it is a retx
-  bool m_sacked;                            //!< true if already acknowledged
-  Time m_lastSent;                          //!< time at which it was sent
-  uint64_t m_id; // UNUSED !!?
-
-
-};
+typedef std::pair<uint64_t, Ptr<Packet> > QuicStreamTxRange;
 
 /**
  * \ingroup quic
  *
  * \brief Tx stream buffer for QUIC
+ *
+ * The buffer holds the data of the stream as a contiguous sequence of bytes,
+ * addressed by stream offset, from the first byte not yet acknowledged to the
+ * last byte written by the application. The data below the sent offset has
+ * been handed to the socket, and is kept until it is acknowledged, so that the
+ * ranges of a lost frame that are still missing can be retransmitted. The
+ * data that is acknowledged out of order is tracked as a set of ranges, and
+ * is released as soon as all the previous data is acknowledged as well.
  */
 class QuicStreamTxBuffer : public Object
 {
@@ -81,15 +71,14 @@ public:
 
   /**
    * Print the buffer information to a string,
-   * including the list of sent packets
+   * including the acknowledged ranges
    *
    * \param os the std::ostream object
    */
   void Print (std::ostream & os) const;
-  //friend std::ostream & operator<< (std::ostream & os, QuicTxBuffer const & quicTxBuf);
 
   /**
-   * Add a packet to the tx buffer
+   * Add a packet at the end of the stream
    *
    * \param p a smart pointer to a packet
    * \return true if the insertion was successful
@@ -97,10 +86,11 @@ public:
   bool Add (Ptr<Packet> p);
 
   /**
-   * ReAdd a rejected packet from the socket tx buffer to the stream tx buffer
+   * Take back the last frame returned by NextSequence, which was rejected by
+   * the socket tx buffer, so that its data is sent again
    *
-   * \param p a smart pointer to a packet
-   * \return true if the insertion was successful
+   * \param p a smart pointer to the rejected packet
+   * \return true if the data was taken back
    */
   bool Rejected (Ptr<Packet> p);
 
@@ -114,24 +104,26 @@ public:
   Ptr<Packet> NextSequence (uint32_t numBytes, const SequenceNumber32 seq);
 
   /**
-   * \brief Get a block of data not transmitted yet and move it into SentList
+   * \brief Process the acknowledgment of a range of stream data
+   *
+   * The data is released when all the previous data has been acknowledged.
    *
-   * \param numBytes number of bytes of the QuicSocketTxItem requested
-   * \return the item that contains the right packet
+   * \param offset the offset of the acknowledged data
+   * \param length the length of the acknowledged data
    */
-  Ptr<QuicStreamTxItem> GetNewSegment (uint32_t numBytes);
+  void OnAck (uint64_t offset, uint32_t length);
 
   /**
-   * Process an acknowledgment, set the frames in the send buffer as acknowledged, mark
-   * lost frames (according to the QUIC IETF draft)
+   * \brief Process the loss of a range of stream data
    *
-   * \brief Process an ACK
+   * The parts of the range that have been acknowledged in the meantime, e.g.,
+   * by an earlier retransmission, are skipped.
    *
-   * \param largestAcknowledged The largest acknowledged sequence number
-   * \param additionalAckBlocks The sequence numbers that were just acknowledged
-   * \param gaps The gaps in the acknowledgment
+   * \param offset the offset of the lost data
+   * \param length the length of the lost data
+   * \return the data that is still missing, in increasing offset order
    */
-  void OnAckUpdate (const uint64_t largestAcknowledged, const std::vector<uint64_t> &additionalAckBlocks, const std::vector<uint64_t> &gaps);
+  std::vector<QuicStreamTxRange> OnLost (uint64_t offset, uint32_t length) const;
 
   /**
    * Get the max size of the buffer
@@ -164,41 +156,43 @@ public:
   /**
    * \brief Return total bytes in flight
    *
-   * \returns total bytes in flight
+   * \returns total bytes sent and not acknowledged yet
    */
   uint32_t BytesInFlight () const;
 
-private:
-  typedef std::list<Ptr<QuicStreamTxItem>> QuicTxPacketList;  //!< container for data stored in the buffer
-
   /**
-   * \brief Merge two QuicStreamTxItem
-   *
-   * Merge t2 in t1. It consists in copying the lastSent field if t2 is more
-   * recent than t1. Retransmitted field is copied only if it set in t2 but not
-   * in t1. Sacked is copied only if it is true in both items.
+   * \brief Get the offset of the next byte to be sent for the first time
    *
-   * \param t1 first item
-   * \param t2 second item
+   * \return the sent offset
    */
-  void MergeItems (QuicStreamTxItem &t1, QuicStreamTxItem &t2) const;
+  uint64_t GetSentOffset () const;
 
   /**
-   * \brief Split one QuicStreamTxItem
-   *
-   * Move "size" bytes from t2 into t1, copying all the fields.
+   * \brief Get the offset below which all the data has been acknowledged
    *
-   * \param t1 first item
-   * \param t2 second item
-   * \param size Size to split
+   * \return the acknowledged offset
    */
-  void SplitItems (QuicStreamTxItem &t1, QuicStreamTxItem &t2, uint32_t size) const; // Available only for streams
+  uint64_t GetAckedOffset () const;
 
-  QuicTxPacketList m_appList;   //!< List of buffered application data to be transmitted with additional info
-  QuicTxPacketList m_sentList;  //!< List of sent frame with additional info
-  uint32_t m_maxBuffer;         //!< Max number of data bytes in buffer (SND.WND)
-  uint32_t m_appSize;           //!< Size of all data in the application list
-  uint32_t m_sentSize;          //!< Size of all data in the sent list
+private:
+  typedef std::deque<QuicStreamTxRange> QuicStreamTxData;  //!< container for data stored in the buffer
+
+  /**
+   * \brief Get a copy of a range of the buffered data
+   *
+   * \param offset the offset of the data
+   * \param length the length of the data
+   * \return a new packet with the data
+   */
+  Ptr<Packet> GetData (uint64_t offset, uint32_t length) const;
+
+  QuicStreamTxData m_data;               //!< Buffered data, as packets in increasing offset order
+  std::map<uint64_t, uint64_t> m_acked;  //!< Ranges [start, end) acknowledged above m_ackedOffset
+  uint32_t m_maxBuffer;                  //!< Max number of data bytes in buffer (SND.WND)
+  uint64_t m_ackedOffset;                //!< All the data below this offset is acknowledged
+  uint64_t m_ackedSize;                  //!< Size of the ranges in m_acked
+  uint64_t m_sentOffset;                 //!< Offset of the first byte not sent yet
+  uint64_t m_endOffset;                  //!< Offset of the end of the buffered data
 
 };
 
@@ -52,7 +52,11 @@ QuicSubheader::QuicSubheader ()
     m_ackBlockCount (0),
     m_firstAckBlock (0),
     m_data (0),
-    m_length (0)
+    m_length (0),
+    m_ackElicitingThreshold (0),
+    m_requestMaxAckDelay (0),
+    m_expiredLength (0),
+    m_fin (false)
 {
   m_reasonPhrase = std::vector<uint8_t> ();
   m_additionalAckBlocks = std::vector<uint32_t> ();
@@ -82,7 +86,7 @@ QuicSubheader::GetInstanceTypeId (void) const
 std::string
 QuicSubheader::FrameTypeToString () const
 {
-  static const char* frameTypeNames[24] = {
+  static const char* frameTypeNames[27] = {
     "PADDING",
     "RST_STREAM",
     "CONNECTION_CLOSE",
@@ -106,7 +110,10 @@ QuicSubheader::FrameTypeToString () const
     "STREAM100",
     "STREAM101",
     "STREAM110",
-    "STREAM111"
+    "STREAM111",
+    "EXPIRED_STREAM_DATA",
+    "ACK_FREQUENCY",
+    "IMMEDIATE_ACK"
   };
   std::string typeDescription = "";
 
@@ -153,7 +160,7 @@ uint32_t
 QuicSubheader::CalculateSubHeaderLength () const
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_frameType >= PADDING and m_frameType <= STREAM111);
+  NS_ASSERT (m_frameType >= PADDING and m_frameType <= IMMEDIATE_ACK);
   uint32_t len = 8;
 
   switch (m_frameType)
@@ -308,6 +315,25 @@ QuicSubheader::CalculateSubHeaderLength () const
         // The frame marks the end of the stream
         break;
 
+      case EXPIRED_STREAM_DATA:
+
+        len += GetVarInt64Size (m_streamId);
+        len += GetVarInt64Size (m_offset);
+        len += GetVarInt64Size (m_expiredLength);
+        len += 8;
+        break;
+
+      case ACK_FREQUENCY:
+
+        len += GetVarInt64Size (m_sequence);
+        len += GetVarInt64Size (m_ackElicitingThreshold);
+        len += GetVarInt64Size (m_requestMaxAckDelay);
+        break;
+
+      case IMMEDIATE_ACK:
+
+        break;
+
     }
 
   NS_LOG_LOGIC ("CalculateSubHeaderLength - len" << len << " " << len / 8);
@@ -322,7 +348,7 @@ void
 QuicSubheader::Serialize (Buffer::Iterator start) const
 {
   NS_LOG_FUNCTION (this << (uint64_t)m_frameType);
-  NS_ASSERT (m_frameType >= PADDING and m_frameType <= STREAM111);
+  NS_ASSERT (m_frameType >= PADDING and m_frameType <= IMMEDIATE_ACK);
 
   Buffer::Iterator i = start;
   i.WriteU8 ((uint8_t)m_frameType);
@@ -485,6 +511,25 @@ QuicSubheader::Serialize (Buffer::Iterator start) const
         // The frame marks the end of the stream
         break;
 
+      case EXPIRED_STREAM_DATA:
+
+        WriteVarInt64 (i, m_streamId);
+        WriteVarInt64 (i, m_offset);
+        WriteVarInt64 (i, m_expiredLength);
+        i.WriteU8 (m_fin ? 1 : 0);
+        break;
+
+      case ACK_FREQUENCY:
+
+        WriteVarInt64 (i, m_sequence);
+        WriteVarInt64 (i, m_ackElicitingThreshold);
+        WriteVarInt64 (i, m_requestMaxAckDelay);
+        break;
+
+      case IMMEDIATE_ACK:
+
+        break;
+
     }
 }
 
@@ -496,7 +541,7 @@ QuicSubheader::Deserialize (Buffer::Iterator start)
 
   NS_LOG_FUNCTION (this << (uint64_t)m_frameType);
 
-  NS_ASSERT (m_frameType >= PADDING and m_frameType <= STREAM111);
+  NS_ASSERT (m_frameType >= PADDING and m_frameType <= IMMEDIATE_ACK);
 
   switch (m_frameType)
     {
@@ -656,6 +701,25 @@ QuicSubheader::Deserialize (Buffer::Iterator start)
         // The frame marks the end of the stream
         break;
 
+      case EXPIRED_STREAM_DATA:
+
+        m_streamId = ReadVarInt64 (i);
+        m_offset = ReadVarInt64 (i);
+        m_expiredLength = ReadVarInt64 (i);
+        m_fin = (i.ReadU8 () != 0);
+        break;
+
+      case ACK_FREQUENCY:
+
+        m_sequence = ReadVarInt64 (i);
+        m_ackElicitingThreshold = ReadVarInt64 (i);
+        m_requestMaxAckDelay = ReadVarInt64 (i);
+        break;
+
+      case IMMEDIATE_ACK:
+
+        break;
+
     }
 
   NS_LOG_INFO ("Deserialized a subheader of size " << GetSerializedSize ());
@@ -666,7 +730,7 @@ void
 QuicSubheader::Print (std::ostream &os) const
 {
   NS_LOG_FUNCTION (this << (uint64_t) m_frameType);
-  NS_ASSERT (m_frameType >= PADDING and m_frameType <= STREAM111);
+  NS_ASSERT (m_frameType >= PADDING and m_frameType <= IMMEDIATE_ACK);
 
   os << "|" << FrameTypeToString () << "|\n";
   switch (m_frameType)
@@ -828,6 +892,25 @@ QuicSubheader::Print (std::ostream &os) const
         os << "|Length " << m_length << "|\n";
         // The frame marks the end of the stream
         break;
+
+      case EXPIRED_STREAM_DATA:
+
+        os << "|Stream Id " << m_streamId << "|\n";
+        os << "|Offset " << m_offset << "|\n";
+        os << "|Expired Length " << m_expiredLength << "|\n";
+        os << "|Fin " << m_fin << "|\n";
+        break;
+
+      case ACK_FREQUENCY:
+
+        os << "|Sequence " << m_sequence << "|\n";
+        os << "|Ack-Eliciting Threshold " << m_ackElicitingThreshold << "|\n";
+        os << "|Request Max Ack Delay " << m_requestMaxAckDelay << "|\n";
+        break;
+
+      case IMMEDIATE_ACK:
+
+        break;
     }
 }
 
@@ -1223,6 +1306,46 @@ QuicSubheader::CreateStreamSubHeader (uint64_t streamId, uint64_t offset, uint64
   return sub;
 }
 
+QuicSubheader
+QuicSubheader::CreateExpiredStreamData (uint64_t streamId, uint64_t offset, uint64_t length, bool fin)
+{
+  NS_LOG_INFO ("Created ExpiredStreamData Header");
+
+  QuicSubheader sub;
+  sub.SetFrameType (EXPIRED_STREAM_DATA);
+  sub.SetStreamId (streamId);
+  sub.SetOffset (offset);
+  sub.SetExpiredLength (length);
+  sub.m_fin = fin;
+
+  return sub;
+}
+
+QuicSubheader
+QuicSubheader::CreateAckFrequency (uint64_t sequence, uint64_t ackElicitingThreshold, uint64_t requestMaxAckDelay)
+{
+  NS_LOG_INFO ("Created AckFrequency Header");
+
+  QuicSubheader sub;
+  sub.SetFrameType (ACK_FREQUENCY);
+  sub.SetSequence (sequence);
+  sub.SetAckElicitingThreshold (ackElicitingThreshold);
+  sub.SetRequestMaxAckDelay (requestMaxAckDelay);
+
+  return sub;
+}
+
+QuicSubheader
+QuicSubheader::CreateImmediateAck (void)
+{
+  NS_LOG_INFO ("Created ImmediateAck Header");
+
+  QuicSubheader sub;
+  sub.SetFrameType (IMMEDIATE_ACK);
+
+  return sub;
+}
+
 bool
 QuicSubheader::IsPadding () const
 {
@@ -1328,9 +1451,31 @@ QuicSubheader::IsStream () const
 bool
 QuicSubheader::IsStreamFin () const
 {
+  if (m_frameType == EXPIRED_STREAM_DATA)
+    {
+      return m_fin;
+    }
   return m_frameType & 0b00000001;
 }
 
+bool
+QuicSubheader::IsExpiredStreamData () const
+{
+  return m_frameType == EXPIRED_STREAM_DATA;
+}
+
+bool
+QuicSubheader::IsAckFrequency () const
+{
+  return m_frameType == ACK_FREQUENCY;
+}
+
+bool
+QuicSubheader::IsImmediateAck () const
+{
+  return m_frameType == IMMEDIATE_ACK;
+}
+
 uint32_t QuicSubheader::GetAckBlockCount () const
 {
   return m_ackBlockCount;
@@ -1501,6 +1646,36 @@ void QuicSubheader::SetSequence (uint64_t sequence)
   m_sequence = sequence;
 }
 
+uint64_t QuicSubheader::GetAckElicitingThreshold () const
+{
+  return m_ackElicitingThreshold;
+}
+
+void QuicSubheader::SetAckElicitingThreshold (uint64_t ackElicitingThreshold)
+{
+  m_ackElicitingThreshold = ackElicitingThreshold;
+}
+
+uint64_t QuicSubheader::GetRequestMaxAckDelay () const
+{
+  return m_requestMaxAckDelay;
+}
+
+void QuicSubheader::SetRequestMaxAckDelay (uint64_t requestMaxAckDelay)
+{
+  m_requestMaxAckDelay = requestMaxAckDelay;
+}
+
+uint64_t QuicSubheader::GetExpiredLength () const
+{
+  return m_expiredLength;
+}
+
+void QuicSubheader::SetExpiredLength (uint64_t expiredLength)
+{
+  m_expiredLength = expiredLength;
+}
+
 uint64_t QuicSubheader::GetStreamId () const
 {
   return m_streamId;
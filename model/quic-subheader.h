@@ -130,7 +130,10 @@ public:
     STREAM100 = 0x14,          //!< Stream (offset=1, length=0, fin=0)
     STREAM101 = 0x15,          //!< Stream (offset=1, length=0, fin=1)
     STREAM110 = 0x16,          //!< Stream (offset=1, length=1, fin=0)
-    STREAM111 = 0x17           //!< Stream (offset=1, length=1, fin=1)
+    STREAM111 = 0x17,          //!< Stream (offset=1, length=1, fin=1)
+    EXPIRED_STREAM_DATA = 0x18, //!< Expired Stream Data (partial reliability extension)
+    ACK_FREQUENCY = 0x19,      //!< Ack Frequency (ack frequency extension)
+    IMMEDIATE_ACK = 0x1A       //!< Immediate Ack (ack frequency extension)
   } TypeFrame_t;
 
   /**
@@ -363,6 +366,34 @@ public:
    */
   static QuicSubheader CreateStreamSubHeader (uint64_t streamId, uint64_t offset, uint64_t length, bool offBit = false, bool lengthBit = false, bool finBit = false);
 
+  /**
+   * Create an Expired Stream Data subheader
+   *
+   * \param streamId the stream whose data was abandoned by the sender
+   * \param offset the offset of the abandoned data
+   * \param length the length of the abandoned data
+   * \param fin true if the abandoned data ends the stream
+   * \return the generated QuicSubheader
+   */
+  static QuicSubheader CreateExpiredStreamData (uint64_t streamId, uint64_t offset, uint64_t length, bool fin);
+
+  /**
+   * Create an Ack Frequency subheader
+   *
+   * \param sequence the sequence number of the frame, increased at each update
+   * \param ackElicitingThreshold the number of ack-eliciting packets the peer can receive without sending an ACK
+   * \param requestMaxAckDelay the maximum time the peer can delay an ACK (in microseconds)
+   * \return the generated QuicSubheader
+   */
+  static QuicSubheader CreateAckFrequency (uint64_t sequence, uint64_t ackElicitingThreshold, uint64_t requestMaxAckDelay);
+
+  /**
+   * Create an Immediate Ack subheader
+   *
+   * \return the generated QuicSubheader
+   */
+  static QuicSubheader CreateImmediateAck (void);
+
   // Getters, Setters and Controls
 
   /**
@@ -569,6 +600,42 @@ public:
    */
   void SetSequence (uint64_t sequence);
 
+  /**
+   * \brief Get the ack-eliciting threshold
+   * \return The ack-eliciting threshold for this QuicSubheader
+   */
+  uint64_t GetAckElicitingThreshold () const;
+
+  /**
+   * \brief Set the ack-eliciting threshold
+   * \param ackElicitingThreshold the ack-eliciting threshold for this QuicSubheader
+   */
+  void SetAckElicitingThreshold (uint64_t ackElicitingThreshold);
+
+  /**
+   * \brief Get the requested max ack delay
+   * \return The requested max ack delay (in microseconds) for this QuicSubheader
+   */
+  uint64_t GetRequestMaxAckDelay () const;
+
+  /**
+   * \brief Set the requested max ack delay
+   * \param requestMaxAckDelay the requested max ack delay (in microseconds) for this QuicSubheader
+   */
+  void SetRequestMaxAckDelay (uint64_t requestMaxAckDelay);
+
+  /**
+   * \brief Get the length of the expired stream data
+   * \return The length of the data abandoned by the sender for this QuicSubheader
+   */
+  uint64_t GetExpiredLength () const;
+
+  /**
+   * \brief Set the length of the expired stream data
+   * \param expiredLength the length of the data abandoned by the sender for this QuicSubheader
+   */
+  void SetExpiredLength (uint64_t expiredLength);
+
   /**
    * \brief Get the stream Id
    * \return The stream Id for this QuicSubheader
@@ -700,11 +767,29 @@ public:
   bool IsStream () const;
 
   /**
-   * \brief Check if the subheader is Stream and the FIN bit is true
-   * \return true if the subheader is Stream and the FIN bit is true, false otherwise
+   * \brief Check if the subheader is Stream or Expired Stream Data and the FIN bit is true
+   * \return true if the subheader is Stream or Expired Stream Data and the FIN bit is true, false otherwise
    */
   bool IsStreamFin () const;
 
+  /**
+   * \brief Check if the subheader is Expired Stream Data
+   * \return true if the subheader is Expired Stream Data, false otherwise
+   */
+  bool IsExpiredStreamData () const;
+
+  /**
+   * \brief Check if the subheader is Ack Frequency
+   * \return true if the subheader is Ack Frequency, false otherwise
+   */
+  bool IsAckFrequency () const;
+
+  /**
+   * \brief Check if the subheader is Immediate Ack
+   * \return true if the subheader is Immediate Ack, false otherwise
+   */
+  bool IsImmediateAck () const;
+
   /**
    * Comparison operator
    * \param lhs left operand
@@ -744,6 +829,10 @@ private:
   std::vector<uint32_t> m_gaps;                 //!< Gaps vector
   uint8_t m_data;                               //!< Data word
   uint64_t m_length;                            //!< Length
+  uint64_t m_ackElicitingThreshold;             //!< Ack-eliciting threshold
+  uint64_t m_requestMaxAckDelay;                //!< Requested max ack delay (in microseconds)
+  uint64_t m_expiredLength;                     //!< Length of the expired stream data
+  bool m_fin;                                   //!< FIN of the expired stream data
 };
 
 } // namespace ns3
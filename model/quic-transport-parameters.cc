@@ -44,7 +44,8 @@ QuicTransportParameters::QuicTransportParameters ()
   m_max_packet_size (65527),
   //m_stateless_reset_token(0),
   m_ack_delay_exponent (3),
-  m_initial_max_stream_id_uni (0)
+  m_initial_max_stream_id_uni (0),
+  m_min_ack_delay (0)
 {
 }
 
@@ -82,7 +83,7 @@ QuicTransportParameters::GetSerializedSize (void) const
 uint32_t
 QuicTransportParameters::CalculateHeaderLength () const
 {
-  uint32_t len = 32 * 4 + 16 * 2 + 8 * 2;
+  uint32_t len = 32 * 5 + 16 * 2 + 8 * 2;
 
   return len / 8;
 }
@@ -105,6 +106,7 @@ QuicTransportParameters::Serialize (Buffer::Iterator start) const
   //i.WriteHtonU128(m_stateless_reset_token);
   i.WriteU8 (m_ack_delay_exponent);
   i.WriteHtonU32 (m_initial_max_stream_id_uni);
+  i.WriteHtonU32 (m_min_ack_delay);
 
 }
 
@@ -124,6 +126,7 @@ QuicTransportParameters::Deserialize (Buffer::Iterator start)
   //m_stateless_reset_token = i.ReadNtohU128();
   m_ack_delay_exponent = i.ReadU8 ();
   m_initial_max_stream_id_uni = i.ReadNtohU32 ();
+  m_min_ack_delay = i.ReadNtohU32 ();
 
   NS_LOG_INFO ("Deserialize::Serialized Size " << CalculateHeaderLength ());
 
@@ -141,12 +144,14 @@ QuicTransportParameters::Print (std::ostream &os) const
   os << "|max_packet_size " << m_max_packet_size << "|\n";
   //os << "|stateless_reset_token " << m_stateless_reset_token << "|\n";
   os << "|ack_delay_exponent " << (uint16_t)m_ack_delay_exponent << "|\n";
-  os << "|initial_max_stream_id_uni " << m_initial_max_stream_id_uni << "]\n";
+  os << "|initial_max_stream_id_uni " << m_initial_max_stream_id_uni << "|\n";
+  os << "|min_ack_delay " << m_min_ack_delay << "]\n";
 }
 
 QuicTransportParameters
 QuicTransportParameters::CreateTransportParameters (uint32_t initial_max_stream_data, uint32_t initial_max_data, uint32_t initial_max_stream_id_bidi, uint16_t idleTimeout,
-                                                    uint8_t omit_connection, uint16_t max_packet_size, /*uint128_t stateless_reset_token,*/ uint8_t ack_delay_exponent, uint32_t initial_max_stream_id_uni)
+                                                    uint8_t omit_connection, uint16_t max_packet_size, /*uint128_t stateless_reset_token,*/ uint8_t ack_delay_exponent, uint32_t initial_max_stream_id_uni,
+                                                    uint32_t min_ack_delay)
 {
   NS_LOG_INFO ("Create Transport Parameters Helper called");
 
@@ -160,6 +165,7 @@ QuicTransportParameters::CreateTransportParameters (uint32_t initial_max_stream_
   //transport.SetStatelessResetToken(stateless_reset_token);
   transport.SetAckDelayExponent (ack_delay_exponent);
   transport.SetInitialMaxStreamIdUni (initial_max_stream_id_uni);
+  transport.SetMinAckDelay (min_ack_delay);
 
   return transport;
 }
@@ -178,6 +184,7 @@ operator== (const QuicTransportParameters &lhs, const QuicTransportParameters &r
     //&& lhs.m_stateless_reset_token == rhs.m_stateless_reset_token
     && lhs.m_ack_delay_exponent == rhs.m_ack_delay_exponent
     && lhs.m_initial_max_stream_id_uni == rhs.m_initial_max_stream_id_uni
+    && lhs.m_min_ack_delay == rhs.m_min_ack_delay
     );
 }
 
@@ -268,5 +275,15 @@ void QuicTransportParameters::SetOmitConnection (uint8_t omitConnection)
   m_omit_connection = omitConnection;
 }
 
+uint32_t QuicTransportParameters::GetMinAckDelay () const
+{
+  return m_min_ack_delay;
+}
+
+void QuicTransportParameters::SetMinAckDelay (uint32_t minAckDelay)
+{
+  m_min_ack_delay = minAckDelay;
+}
+
 } // namespace ns3
 
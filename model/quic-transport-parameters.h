@@ -90,10 +90,12 @@ public:
    * \param stateless_reset_token the stateless reset token
    * \param ack_delay_exponent the exponent used to decode the ack delay field in the ACK frame
    * \param initial_max_stream_id_uni the initial maximum number of application-owned unidirectional streams the peer may initiate
+   * \param min_ack_delay the minimum ack delay in microseconds, 0 if the ack frequency extension is not supported
    * \return the generated QuicTransportParameters
    */
   static QuicTransportParameters CreateTransportParameters (uint32_t initial_max_stream_data, uint32_t initial_max_data, uint32_t initial_max_stream_id_bidi, uint16_t idleTimeout,
-                                                            uint8_t omit_connection, uint16_t max_packet_size, /*uint128_t stateless_reset_token,*/ uint8_t ack_delay_exponent, uint32_t initial_max_stream_id_uni);
+                                                            uint8_t omit_connection, uint16_t max_packet_size, /*uint128_t stateless_reset_token,*/ uint8_t ack_delay_exponent, uint32_t initial_max_stream_id_uni,
+                                                            uint32_t min_ack_delay = 0);
 
   // Getters, Setters and Controls
 
@@ -193,6 +195,18 @@ public:
    */
   void SetOmitConnection (uint8_t omitConnection);
 
+  /**
+   * \brief Get the min ack delay
+   * \return The min ack delay (in microseconds) for this QuicTransportParameters, 0 if the ack frequency extension is not supported
+   */
+  uint32_t GetMinAckDelay () const;
+
+  /**
+   * \brief Set the min ack delay
+   * \param minAckDelay the min ack delay (in microseconds) for this QuicTransportParameters
+   */
+  void SetMinAckDelay (uint32_t minAckDelay);
+
   /**
    * Comparison operator
    * \param lhs left operand
@@ -221,6 +235,7 @@ private:
   //uint128_t m_stateless_reset_token;    //!< The stateless reset token
   uint8_t m_ack_delay_exponent;           //!< The exponent used to decode the ack delay field in the ACK frame
   uint32_t m_initial_max_stream_id_uni;   //!< The initial maximum number of application-owned unidirectional streams the peer may initiate
+  uint32_t m_min_ack_delay;               //!< The minimum ack delay in microseconds (ack frequency extension), 0 if not supported
 };
 
 } // namespace ns3
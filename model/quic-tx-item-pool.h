@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUICTXITEMPOOL_H
+#define QUICTXITEMPOOL_H
+
+#include <utility>
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+template <typename T>
+class QuicTxItemPool;
+
+/**
+ * \ingroup quic
+ *
+ * \brief Deleter for the items allocated by a QuicTxItemPool
+ *
+ * When the last reference to an item is dropped, the item is returned to the
+ * pool it was allocated from, if any, instead of being deleted.
+ */
+template <typename T>
+struct QuicTxItemPoolDeleter
+{
+  /**
+   * \brief Return the item to its pool, or delete it
+   * \param item the item
+   */
+  static void Delete (T *item)
+  {
+    // keep the pool alive while the item is released
+    Ptr<QuicTxItemPool<T> > pool = item->m_pool;
+    if (pool != nullptr)
+      {
+        pool->Release (item);
+      }
+    else
+      {
+        delete item;
+      }
+  }
+};
+
+/**
+ * \ingroup quic
+ *
+ * \brief Free-list pool of reference-counted transmission items
+ *
+ * The transmission items are plain bookkeeping records, which are created
+ * and dropped several times for each sent packet. The pool keeps the
+ * released items in a free list, and recycles them for the next
+ * allocations, so that in steady state the send path does not allocate
+ * memory for them.
+ *
+ * The items must derive from SimpleRefCount with QuicTxItemPoolDeleter as
+ * deleter, and have a m_pool member accessible by the pool and the deleter.
+ * Each item keeps a reference to its pool while it is in use, so that the
+ * pool outlives the items allocated from it.
+ */
+template <typename T>
+class QuicTxItemPool : public SimpleRefCount<QuicTxItemPool<T> >
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param maxFree the maximum number of released items kept for reuse
+   */
+  QuicTxItemPool (uint32_t maxFree = 1024)
+    : m_maxFree (maxFree),
+      m_numCreated (0)
+  {
+  }
+
+  ~QuicTxItemPool ()
+  {
+    for (T *item : m_free)
+      {
+        delete item;
+      }
+  }
+
+  /**
+   * \brief Get an item, recycling a released one if possible
+   *
+   * \param args the arguments of the item constructor
+   * \return the item
+   */
+  template <typename... Args>
+  Ptr<T> Allocate (Args&&... args)
+  {
+    if (m_free.empty ())
+      {
+        m_numCreated++;
+        T *item = new T (std::forward<Args> (args)...);
+        item->m_pool = this;
+        return Ptr<T> (item, false);
+      }
+    T *item = m_free.back ();
+    m_free.pop_back ();
+    // copy, rather than move, so that the item keeps the storage of its containers
+    const T fresh (std::forward<Args> (args)...);
+    *item = fresh;
+    item->m_pool = this;
+    // the reference count of a released item is zero
+    return Ptr<T> (item);
+  }
+
+  /**
+   * \brief Take back an item that is no longer referenced
+   *
+   * The references held by the item are dropped, so that packets are not
+   * kept alive in the free list.
+   *
+   * \param item the item
+   */
+  void Release (T *item)
+  {
+    *item = m_blank;
+    if (m_free.size () < m_maxFree)
+      {
+        m_free.push_back (item);
+      }
+    else
+      {
+        delete item;
+      }
+  }
+
+  /**
+   * \brief Get the number of released items available for reuse
+   * \return the number of items in the free list
+   */
+  uint32_t GetNumFree () const
+  {
+    return m_free.size ();
+  }
+
+  /**
+   * \brief Get the number of items created by the pool, i.e., not recycled
+   * \return the number of created items
+   */
+  uint64_t GetNumCreated () const
+  {
+    return m_numCreated;
+  }
+
+private:
+  std::vector<T *> m_free;  //!< Released items, available for reuse
+  uint32_t m_maxFree;       //!< Maximum number of items in the free list
+  uint64_t m_numCreated;    //!< Number of items created by the pool
+  T m_blank;                //!< Item with no references, used to clear the released items
+};
+
+} // namespace ns3
+
+#endif /* QUIC_TX_ITEM_POOL_H */
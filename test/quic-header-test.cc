@@ -402,9 +402,11 @@ QuicSubHeaderTestCase::TestQuicSubHeaderSerializeDeserialize ()
       std::vector<uint32_t> additionalAckBlocks(10, 1);
       uint8_t data = GET_RANDOM_UINT8 (x);
       uint64_t length = GET_RANDOM_UINT64 (x);
+      uint64_t ackElicitingThreshold = GET_RANDOM_UINT64 (x);
+      uint64_t requestMaxAckDelay = GET_RANDOM_UINT64 (x);
 
       for ( int h_case = QuicSubheader::PADDING; 
-        h_case != QuicSubheader::STREAM111 +1; h_case++ )
+        h_case != QuicSubheader::IMMEDIATE_ACK +1; h_case++ )
         {
           switch ( h_case )
           {
@@ -1173,6 +1175,92 @@ QuicSubHeaderTestCase::TestQuicSubHeaderSerializeDeserialize ()
                   NS_TEST_ASSERT_MSG_EQ (copyHead.GetSerializedSize (), headSize, 
                     "QuicSubHeader for STREAM111 frame is not as expected in deserialized subheader");
                   break;
+              case QuicSubheader::EXPIRED_STREAM_DATA:
+                  head = QuicSubheader::CreateExpiredStreamData (streamId, offset, length, true);
+
+                  headSize = 1 + QuicSubheader::GetVarInt64Size(streamId)/8 + QuicSubheader::GetVarInt64Size(offset)/8 + QuicSubheader::GetVarInt64Size(length)/8 + 1;
+
+                  NS_TEST_ASSERT_MSG_EQ (head.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for EXPIRED_STREAM_DATA frame is not as expected");
+
+                  buffer.AddAtStart (head.GetSerializedSize ());
+                  head.Serialize (buffer.Begin ());
+
+                  copyHead.Deserialize (buffer.Begin ());
+
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetFrameType (), QuicSubheader::EXPIRED_STREAM_DATA,
+                                             "Different frame type found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetStreamId (), streamId,
+                                             "Different stream id found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetOffset (), offset,
+                                             "Different offset in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetExpiredLength (), length,
+                                             "Different expired length found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetLength (), 0,
+                                             "EXPIRED_STREAM_DATA frame with a payload length in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.IsStreamFin (), true,
+                                             "Different FIN found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for EXPIRED_STREAM_DATA frame is not as expected in deserialized subheader");
+                  break;
+              case QuicSubheader::ACK_FREQUENCY:
+                  head = QuicSubheader::CreateAckFrequency (sequence, ackElicitingThreshold, requestMaxAckDelay);
+
+                  headSize = 1 + QuicSubheader::GetVarInt64Size(sequence)/8 + QuicSubheader::GetVarInt64Size(ackElicitingThreshold)/8 + QuicSubheader::GetVarInt64Size(requestMaxAckDelay)/8;
+
+                  NS_TEST_ASSERT_MSG_EQ (head.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for ACK_FREQUENCY frame is not as expected");
+
+                  buffer.AddAtStart (head.GetSerializedSize ());
+                  head.Serialize (buffer.Begin ());
+
+                  NS_TEST_ASSERT_MSG_EQ (head.GetFrameType (), QuicSubheader::ACK_FREQUENCY,
+                                             "Different frame type found");
+                  NS_TEST_ASSERT_MSG_EQ (head.GetSequence (), sequence,
+                                             "Different sequence found");
+                  NS_TEST_ASSERT_MSG_EQ (head.GetAckElicitingThreshold (), ackElicitingThreshold,
+                                             "Different ack-eliciting threshold found");
+                  NS_TEST_ASSERT_MSG_EQ (head.GetRequestMaxAckDelay (), requestMaxAckDelay,
+                                             "Different request max ack delay found");
+                  NS_TEST_ASSERT_MSG_EQ (head.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for ACK_FREQUENCY frame is not as expected");
+
+                  copyHead.Deserialize (buffer.Begin ());
+
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetFrameType (), QuicSubheader::ACK_FREQUENCY,
+                                             "Different frame type found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetSequence (), sequence,
+                                             "Different sequence found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetAckElicitingThreshold (), ackElicitingThreshold,
+                                             "Different ack-eliciting threshold found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetRequestMaxAckDelay (), requestMaxAckDelay,
+                                             "Different request max ack delay found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for ACK_FREQUENCY frame is not as expected in deserialized subheader");
+                  break;
+              case QuicSubheader::IMMEDIATE_ACK:
+                  head = QuicSubheader::CreateImmediateAck ();
+
+                  headSize = 1;
+
+                  NS_TEST_ASSERT_MSG_EQ (head.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for IMMEDIATE_ACK frame is not as expected");
+
+                  buffer.AddAtStart (head.GetSerializedSize ());
+                  head.Serialize (buffer.Begin ());
+
+                  NS_TEST_ASSERT_MSG_EQ (head.GetFrameType (), QuicSubheader::IMMEDIATE_ACK,
+                                             "Different frame type found");
+                  NS_TEST_ASSERT_MSG_EQ (head.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for IMMEDIATE_ACK frame is not as expected");
+
+                  copyHead.Deserialize (buffer.Begin ());
+
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetFrameType (), QuicSubheader::IMMEDIATE_ACK,
+                                             "Different frame type found in deserialized subheader");
+                  NS_TEST_ASSERT_MSG_EQ (copyHead.GetSerializedSize (), headSize, 
+                    "QuicSubHeader for IMMEDIATE_ACK frame is not as expected in deserialized subheader");
+                  break;
                default:
                   break;
           }
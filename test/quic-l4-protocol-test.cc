@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+#include "ns3/quic-l4-protocol.h"
+#include "ns3/quic-socket-base.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QuicL4ProtocolTestSuite");
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicL4Protocol connection demultiplexing Test
+ *
+ * A number of sockets is associated with a single QuicL4Protocol, and each
+ * of them must be found through its connection ID, as ForwardUp does for
+ * every received packet. Removed sockets must leave the index. The cost of
+ * the lookup is measured by the quic-demux-scaling example.
+ */
+class QuicL4DemuxTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param numConnections the number of connections to be tested
+   */
+  QuicL4DemuxTestCase (uint32_t numConnections);
+
+private:
+  virtual void
+  DoRun (void);
+
+  uint32_t m_numConnections;  //!< The number of connections to be tested
+};
+
+QuicL4DemuxTestCase::QuicL4DemuxTestCase (uint32_t numConnections) :
+    TestCase ("QuicL4Protocol connection demultiplexing Test"),
+    m_numConnections (numConnections)
+{
+}
+
+void
+QuicL4DemuxTestCase::DoRun ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  std::vector<Ptr<QuicSocketBase> > sockets;
+  std::vector<uint64_t> connectionIds;
+  for (uint32_t i = 0; i < m_numConnections; i++)
+    {
+      Ptr<QuicSocketBase> socket = DynamicCast<QuicSocketBase> (quicL4->CreateSocket ());
+      sockets.push_back (socket);
+      connectionIds.push_back (socket->GetConnectionId ());
+    }
+
+  // every socket must be reachable through its connection ID
+  for (uint32_t i = 0; i < m_numConnections; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (quicL4->LookupSocket (connectionIds[i]), sockets[i],
+                             "Wrong socket for connection ID " << connectionIds[i]);
+    }
+
+  // an unknown connection ID must not match any socket
+  uint64_t unknownId = *std::max_element (connectionIds.begin (), connectionIds.end ()) + 1;
+  NS_TEST_EXPECT_MSG_EQ ((quicL4->LookupSocket (unknownId) == nullptr), true,
+                         "Socket found for an unknown connection ID");
+
+  // removed sockets must disappear from the index, the others must be unaffected
+  NS_TEST_EXPECT_MSG_EQ (quicL4->RemoveSocket (sockets.back ()), true, "Failed to remove a socket");
+  NS_TEST_EXPECT_MSG_EQ ((quicL4->LookupSocket (connectionIds.back ()) == nullptr), true,
+                         "Removed socket still reachable");
+  NS_TEST_EXPECT_MSG_EQ (quicL4->RemoveSocket (sockets.back ()), false, "Removed a socket twice");
+  for (uint32_t i = 0; i + 1 < m_numConnections; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (quicL4->LookupSocket (connectionIds[i]), sockets[i],
+                             "Wrong socket after removal for connection ID " << connectionIds[i]);
+    }
+
+  node->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicL4Protocol receive buffer budget Test
+ *
+ * The receive buffer memory used by the flow-control autotuning of the
+ * streams is granted from a budget shared by the node, and given back when
+ * the streams are destroyed.
+ */
+class QuicL4RcvBufBudgetTestCase : public TestCase
+{
+public:
+  /** \brief Constructor */
+  QuicL4RcvBufBudgetTestCase ();
+
+private:
+  virtual void
+  DoRun (void);
+};
+
+QuicL4RcvBufBudgetTestCase::QuicL4RcvBufBudgetTestCase () :
+    TestCase ("QuicL4Protocol receive buffer budget Test")
+{
+}
+
+void
+QuicL4RcvBufBudgetTestCase::DoRun ()
+{
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  quicL4->SetAttribute ("RcvBufBudget", UintegerValue (100000));
+
+  NS_TEST_ASSERT_MSG_EQ (quicL4->ReserveRcvBuf (60000), 60000, "Request within the budget not granted");
+  NS_TEST_ASSERT_MSG_EQ (quicL4->ReserveRcvBuf (60000), 40000, "Request beyond the budget not capped");
+  NS_TEST_ASSERT_MSG_EQ (quicL4->ReserveRcvBuf (1000), 0, "Request granted with an exhausted budget");
+  NS_TEST_ASSERT_MSG_EQ (quicL4->GetRcvBufReserved (), 100000, "Wrong reserved memory");
+
+  // released memory can be granted to another stream
+  quicL4->ReleaseRcvBuf (60000);
+  NS_TEST_ASSERT_MSG_EQ (quicL4->GetRcvBufReserved (), 40000, "Wrong reserved memory after a release");
+  NS_TEST_ASSERT_MSG_EQ (quicL4->ReserveRcvBuf (30000), 30000, "Released memory not granted again");
+
+  quicL4->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the QuicL4Protocol test cases
+ */
+class QuicL4ProtocolTestSuite : public TestSuite
+{
+public:
+  QuicL4ProtocolTestSuite () :
+      TestSuite ("quic-l4-protocol", UNIT)
+  {
+    AddTestCase (new QuicL4DemuxTestCase (1000), TestCase::QUICK);
+    AddTestCase (new QuicL4RcvBufBudgetTestCase (), TestCase::QUICK);
+  }
+};
+
+static QuicL4ProtocolTestSuite g_quicL4ProtocolTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,440 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+#include "ns3/quic-l4-protocol.h"
+#include "ns3/quic-l5-protocol.h"
+#include "ns3/quic-socket-base.h"
+#include "ns3/quic-stream-base.h"
+#include "ns3/quic-subheader.h"
+#include "ns3/quic-frame-iterator.h"
+
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QuicL5ProtocolTestSuite");
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicL5Protocol frame disaggregation Test
+ *
+ * Received packets aggregating a growing number of STREAM frames are
+ * disaggregated with QuicFrameIterator, and then go through the whole
+ * DispatchRecv path, down to the socket reception buffer. The cost of this
+ * path is measured by the quic-frame-dispatch example.
+ */
+class QuicL5DispatchRecvTestCase : public TestCase
+{
+public:
+  QuicL5DispatchRecvTestCase ();
+
+private:
+  virtual void
+  DoRun (void);
+  virtual void
+  DoTeardown (void);
+
+  /**
+   * \brief Check the frames returned by QuicFrameIterator
+   */
+  void
+  TestFrameIterator ();
+
+  /**
+   * \brief Check the data delivered by DispatchRecv with a given number of frames per packet
+   *
+   * \param framesPerPacket the number of STREAM frames in each packet
+   * \param numPackets the number of received packets
+   */
+  void
+  TestDispatchRecv (uint32_t framesPerPacket, uint32_t numPackets);
+
+  /**
+   * \brief Check the delivery of a stream with data abandoned by the sender
+   */
+  void
+  TestExpiredStreamData ();
+
+  /**
+   * \brief Check that frames and data reach the stream with their stream ID
+   */
+  void
+  TestStreamLookup ();
+
+  /**
+   * \brief Check the flow control limits of the lost control frames sent again
+   */
+  void
+  TestLostControlFrames ();
+
+  /**
+   * \brief Build a packet with consecutive STREAM frames
+   *
+   * \param streamId the stream of the frames
+   * \param offset the offset of the first frame
+   * \param numFrames the number of frames
+   * \param frameSize the payload size of each frame
+   * \return the packet, without the QUIC header
+   */
+  Ptr<Packet>
+  BuildPacket (uint64_t streamId, uint64_t offset, uint32_t numFrames, uint32_t frameSize);
+};
+
+QuicL5DispatchRecvTestCase::QuicL5DispatchRecvTestCase () :
+    TestCase ("QuicL5Protocol frame disaggregation Test")
+{
+}
+
+Ptr<Packet>
+QuicL5DispatchRecvTestCase::BuildPacket (uint64_t streamId, uint64_t offset,
+                                         uint32_t numFrames, uint32_t frameSize)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  for (uint32_t i = 0; i < numFrames; i++)
+    {
+      Ptr<Packet> frame = Create<Packet> (frameSize);
+      QuicSubheader sub = QuicSubheader::CreateStreamSubHeader (streamId, offset + i * frameSize,
+                                                                frameSize, true, true, false);
+      frame->AddHeader (sub);
+      packet->AddAtEnd (frame);
+    }
+  return packet;
+}
+
+void
+QuicL5DispatchRecvTestCase::TestFrameIterator ()
+{
+  // a single frame is handed over without copying the packet
+  Ptr<Packet> packet = BuildPacket (1, 0, 1, 1200);
+  Packet *received = PeekPointer (packet);
+  QuicFrameIterator single (packet);
+  packet = 0;
+
+  NS_TEST_ASSERT_MSG_EQ (single.HasNext (), true, "No frame in the packet");
+  QuicSubheader sub;
+  Ptr<Packet> payload = single.Next (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.IsStream (), true, "Wrong frame type");
+  NS_TEST_ASSERT_MSG_EQ (payload->GetSize (), 1200, "Wrong payload size");
+  NS_TEST_ASSERT_MSG_EQ ((PeekPointer (payload) == received), true, "The last frame was copied");
+  NS_TEST_ASSERT_MSG_EQ (single.HasNext (), false, "Unexpected frame");
+
+  // multiple frames, followed by a frame without payload
+  packet = BuildPacket (2, 300, 4, 300);
+  Ptr<Packet> maxData = Create<Packet> ();
+  maxData->AddHeader (QuicSubheader::CreateMaxData (10000));
+  packet->AddAtEnd (maxData);
+
+  QuicFrameIterator multiple (packet);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (multiple.HasNext (), true, "Missing frame " << i);
+      payload = multiple.Next (sub);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetStreamId (), 2, "Wrong stream of frame " << i);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetOffset (), 300 * (i + 1), "Wrong offset of frame " << i);
+      NS_TEST_ASSERT_MSG_EQ (payload->GetSize (), 300, "Wrong payload size of frame " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (multiple.HasNext (), true, "Missing MAX_DATA frame");
+  payload = multiple.Next (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.IsMaxData (), true, "Wrong frame type");
+  NS_TEST_ASSERT_MSG_EQ (payload->GetSize (), 0, "Wrong payload size");
+  NS_TEST_ASSERT_MSG_EQ (multiple.HasNext (), false, "Unexpected frame");
+}
+
+void
+QuicL5DispatchRecvTestCase::TestDispatchRecv (uint32_t framesPerPacket, uint32_t numPackets)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicSocketBase> socket = DynamicCast<QuicSocketBase> (quicL4->CreateSocket ());
+  socket->Listen ();
+
+  Ptr<QuicL5Protocol> quicL5 = CreateObject<QuicL5Protocol> ();
+  quicL5->SetSocket (socket);
+  quicL5->SetNode (node);
+  quicL5->SetConnectionId (socket->GetConnectionId ());
+
+  const uint32_t packetSize = 1200;
+  uint32_t frameSize = packetSize / framesPerPacket;
+
+  // every packet is delivered in full and in order, whatever the number of frames
+  Address address;
+  for (uint32_t i = 0; i < numPackets; i++)
+    {
+      quicL5->DispatchRecv (BuildPacket (1, uint64_t (i) * framesPerPacket * frameSize,
+                                         framesPerPacket, frameSize), address);
+      Ptr<Packet> data = socket->Recv (UINT32_MAX, 0);
+      NS_TEST_ASSERT_MSG_NE (data, 0, "No data delivered for packet " << i
+                             << " with " << framesPerPacket << " frames per packet");
+      NS_TEST_ASSERT_MSG_EQ (data->GetSize (), framesPerPacket * frameSize,
+                             "Wrong amount of delivered data for packet " << i
+                             << " with " << framesPerPacket << " frames per packet");
+    }
+  NS_TEST_ASSERT_MSG_EQ (socket->Recv (UINT32_MAX, 0), 0, "Unexpected delivered data");
+
+  node->Dispose ();
+}
+
+void
+QuicL5DispatchRecvTestCase::TestExpiredStreamData ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicSocketBase> socket = DynamicCast<QuicSocketBase> (quicL4->CreateSocket ());
+  socket->Listen ();
+
+  Ptr<QuicL5Protocol> quicL5 = CreateObject<QuicL5Protocol> ();
+  quicL5->SetSocket (socket);
+  quicL5->SetNode (node);
+  quicL5->SetConnectionId (socket->GetConnectionId ());
+
+  Address address;
+
+  // the data after the abandoned range is buffered
+  quicL5->DispatchRecv (BuildPacket (1, 600, 1, 300), address);
+  NS_TEST_ASSERT_MSG_EQ (socket->Recv (UINT32_MAX, 0), 0, "Out of order data delivered");
+
+  // the data before the abandoned range is still missing, and is not skipped
+  Ptr<Packet> expired = Create<Packet> ();
+  expired->AddHeader (QuicSubheader::CreateExpiredStreamData (1, 300, 300, false));
+  quicL5->DispatchRecv (expired, address);
+  NS_TEST_ASSERT_MSG_EQ (socket->Recv (UINT32_MAX, 0), 0, "Data delivered before the missing data");
+
+  // when the missing data arrives, the abandoned range is skipped
+  quicL5->DispatchRecv (BuildPacket (1, 0, 1, 300), address);
+  Ptr<Packet> data = socket->Recv (UINT32_MAX, 0);
+  NS_TEST_ASSERT_MSG_NE (data, 0, "No data delivered");
+  NS_TEST_ASSERT_MSG_EQ (data->GetSize (), 600, "Wrong amount of data around the abandoned range");
+
+  // the abandoned FIN ends the stream without delivering data
+  expired = Create<Packet> ();
+  expired->AddHeader (QuicSubheader::CreateExpiredStreamData (1, 900, 300, true));
+  quicL5->DispatchRecv (expired, address);
+  NS_TEST_ASSERT_MSG_EQ (socket->Recv (UINT32_MAX, 0), 0, "Data delivered for the abandoned FIN");
+
+  // the frame carries no payload, so a following frame in the same packet is intact
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (QuicSubheader::CreateExpiredStreamData (2, 0, 300, false));
+  packet->AddAtEnd (BuildPacket (2, 300, 1, 300));
+
+  QuicFrameIterator frames (packet->Copy ());
+  QuicSubheader sub;
+  Ptr<Packet> payload = frames.Next (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.IsExpiredStreamData (), true, "Wrong frame type");
+  NS_TEST_ASSERT_MSG_EQ (sub.GetExpiredLength (), 300, "Wrong expired length");
+  NS_TEST_ASSERT_MSG_EQ (payload->GetSize (), 0, "Payload for an EXPIRED_STREAM_DATA frame");
+  NS_TEST_ASSERT_MSG_EQ (frames.HasNext (), true, "Missing STREAM frame");
+  payload = frames.Next (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.IsStream (), true, "Wrong frame type");
+  NS_TEST_ASSERT_MSG_EQ (sub.GetOffset (), 300, "Wrong offset of the STREAM frame");
+  NS_TEST_ASSERT_MSG_EQ (payload->GetSize (), 300, "Wrong payload size of the STREAM frame");
+
+  quicL5->DispatchRecv (packet, address);
+  data = socket->Recv (UINT32_MAX, 0);
+  NS_TEST_ASSERT_MSG_NE (data, 0, "No data delivered after the abandoned range");
+  NS_TEST_ASSERT_MSG_EQ (data->GetSize (), 300, "Wrong amount of data after the abandoned range");
+
+  node->Dispose ();
+}
+
+void
+QuicL5DispatchRecvTestCase::TestStreamLookup ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicSocketBase> socket = DynamicCast<QuicSocketBase> (quicL4->CreateSocket ());
+  socket->SetAttribute ("MaxStreamIdBidi", UintegerValue (8));
+  socket->Listen ();
+
+  Ptr<QuicL5Protocol> quicL5 = CreateObject<QuicL5Protocol> ();
+  quicL5->SetSocket (socket);
+  quicL5->SetNode (node);
+  quicL5->SetConnectionId (socket->GetConnectionId ());
+
+  Address address;
+
+  // a frame on stream 7 opens all the streams below it
+  quicL5->DispatchRecv (BuildPacket (7, 0, 1, 300), address);
+  std::vector<Ptr<QuicStreamBase> > streams;
+  for (uint64_t id = 0; id <= 7; id++)
+    {
+      Ptr<QuicStreamBase> stream = quicL5->SearchStream (id);
+      NS_TEST_ASSERT_MSG_NE (stream, 0, "Stream " << id << " not opened");
+      NS_TEST_ASSERT_MSG_EQ (stream->GetStreamId (), id, "Wrong stream found for stream " << id);
+      streams.push_back (stream);
+    }
+  NS_TEST_ASSERT_MSG_EQ (quicL5->SearchStream (8), 0, "Stream opened beyond the received one");
+  Ptr<Packet> data = socket->Recv (UINT32_MAX, 0);
+  NS_TEST_ASSERT_MSG_NE (data, 0, "No data delivered on stream 7");
+  NS_TEST_ASSERT_MSG_EQ (data->GetSize (), 300, "Wrong amount of data on stream 7");
+
+  // frames on the existing streams are delivered to them, without opening them again
+  quicL5->DispatchRecv (BuildPacket (3, 0, 2, 300), address);
+  quicL5->DispatchRecv (BuildPacket (7, 300, 1, 300), address);
+  for (uint64_t id = 0; id <= 7; id++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (quicL5->SearchStream (id), streams[id], "Stream " << id << " opened again");
+    }
+  NS_TEST_ASSERT_MSG_EQ (quicL5->SearchStream (8), 0, "Stream opened by a frame on an existing stream");
+  data = socket->Recv (UINT32_MAX, 0);
+  NS_TEST_ASSERT_MSG_NE (data, 0, "No data delivered on the existing streams");
+  NS_TEST_ASSERT_MSG_EQ (data->GetSize (), 900, "Wrong amount of data on the existing streams");
+
+  // data sent on a stream reaches that stream only
+  uint32_t available = streams[4]->GetStreamTxAvailable ();
+  NS_TEST_ASSERT_MSG_EQ (quicL5->DispatchSend (Create<Packet> (500), 5), 500, "Data not sent on stream 5");
+  NS_TEST_ASSERT_MSG_EQ (streams[5]->GetStreamTxAvailable (), available - 500, "Data not buffered by stream 5");
+  NS_TEST_ASSERT_MSG_EQ (streams[4]->GetStreamTxAvailable (), available, "Data buffered by stream 4");
+
+  // sending on a stream not opened yet opens it
+  NS_TEST_ASSERT_MSG_EQ (quicL5->DispatchSend (Create<Packet> (500), 8), 500, "Data not sent on stream 8");
+  Ptr<QuicStreamBase> stream = quicL5->SearchStream (8);
+  NS_TEST_ASSERT_MSG_NE (stream, 0, "Stream 8 not opened by DispatchSend");
+  NS_TEST_ASSERT_MSG_EQ (stream->GetStreamId (), 8, "Wrong stream found for stream 8");
+  NS_TEST_ASSERT_MSG_EQ (quicL5->SearchStream (7), streams[7], "Stream 7 opened again");
+
+  node->Dispose ();
+}
+
+void
+QuicL5DispatchRecvTestCase::TestLostControlFrames ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicSocketBase> socket = DynamicCast<QuicSocketBase> (quicL4->CreateSocket ());
+  socket->Listen ();
+
+  Ptr<QuicL5Protocol> quicL5 = CreateObject<QuicL5Protocol> ();
+  quicL5->SetSocket (socket);
+  quicL5->SetNode (node);
+  quicL5->SetConnectionId (socket->GetConnectionId ());
+
+  Address address;
+  quicL5->DispatchRecv (BuildPacket (1, 0, 1, 300), address);
+  Ptr<QuicStreamBase> stream = quicL5->SearchStream (1);
+  NS_TEST_ASSERT_MSG_NE (stream, 0, "Stream 1 not opened");
+
+  // the limits were advertised before the data was received
+  Ptr<Packet> lost = Create<Packet> ();
+  lost->AddHeader (QuicSubheader::CreatePing ());
+  lost->AddHeader (QuicSubheader::CreateMaxStreamData (1, 100));
+  lost->AddHeader (QuicSubheader::CreateMaxData (200));
+
+  // the limits are refreshed, and the frames keep their order
+  QuicFrameIterator frames (quicL5->OnLostControlFrames (lost));
+  QuicSubheader sub;
+  NS_TEST_ASSERT_MSG_EQ (frames.HasNext (), true, "No frames sent again");
+  frames.Next (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.IsMaxData (), true, "MAX_DATA not first");
+  NS_TEST_ASSERT_MSG_EQ (sub.GetMaxData (), quicL5->GetMaxData (), "Stale MAX_DATA");
+  NS_TEST_ASSERT_MSG_EQ (frames.HasNext (), true, "MAX_STREAM_DATA not sent again");
+  frames.Next (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.IsMaxStreamData (), true, "MAX_STREAM_DATA not second");
+  NS_TEST_ASSERT_MSG_EQ (sub.GetStreamId (), 1, "Wrong stream of MAX_STREAM_DATA");
+  NS_TEST_ASSERT_MSG_EQ (sub.GetMaxStreamData (), stream->SendMaxStreamData (), "Stale MAX_STREAM_DATA");
+  NS_TEST_ASSERT_MSG_EQ (frames.HasNext (), true, "PING not sent again");
+  frames.Next (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.IsPing (), true, "PING not last");
+  NS_TEST_ASSERT_MSG_EQ (frames.HasNext (), false, "Unexpected frames sent again");
+
+  node->Dispose ();
+}
+
+void
+QuicL5DispatchRecvTestCase::DoRun ()
+{
+  /*
+   * Test the frame iterator:
+   * -> a single frame is not copied
+   * -> multiple frames, followed by a frame without payload, are returned in order
+   */
+  TestFrameIterator ();
+
+  /*
+   * Test the disaggregation in DispatchRecv:
+   * -> receive packets with 1 to 8 STREAM frames each
+   * -> check that the socket receives all the data of each packet
+   */
+  for (uint32_t frames : { 1, 2, 4, 8 })
+    {
+      TestDispatchRecv (frames, 10);
+    }
+
+  /*
+   * Test the data abandoned by the sender:
+   * -> an EXPIRED_STREAM_DATA frame leaves the missing data before its range
+   * -> the range is skipped when the missing data is received
+   * -> the FIN of the abandoned data sets the final size
+   * -> a STREAM frame after the EXPIRED_STREAM_DATA frame in a packet is delivered
+   */
+  TestExpiredStreamData ();
+
+  /*
+   * Test the stream lookup by stream ID:
+   * -> a frame on stream 7 opens streams 0 to 7
+   * -> the frames on existing streams do not open them again
+   * -> DispatchSend buffers the data on the given stream, and opens it if needed
+   */
+  TestStreamLookup ();
+
+  /*
+   * Test the lost control frames:
+   * -> MAX_DATA and MAX_STREAM_DATA are sent again with the latest limits
+   * -> the other frames are sent again unchanged, in the same order
+   */
+  TestLostControlFrames ();
+
+  Simulator::Destroy ();
+}
+
+void
+QuicL5DispatchRecvTestCase::DoTeardown ()
+{
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the QuicL5Protocol test cases
+ */
+class QuicL5ProtocolTestSuite : public TestSuite
+{
+public:
+  QuicL5ProtocolTestSuite () :
+      TestSuite ("quic-l5-protocol", UNIT)
+  {
+    AddTestCase (new QuicL5DispatchRecvTestCase, TestCase::QUICK);
+  }
+};
+
+static QuicL5ProtocolTestSuite g_quicL5ProtocolTestSuite; //!< Static variable for test initialization
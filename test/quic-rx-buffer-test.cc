@@ -28,6 +28,9 @@
 
 #include "ns3/quic-socket-rx-buffer.h"
 #include "ns3/quic-stream-rx-buffer.h"
+#include "ns3/quic-ack-range-set.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -60,6 +63,11 @@ private:
    */
   void
   TestSocketExtract ();
+  /**
+   * \brief Test the partial extraction and the draining of a deep Socket RX buffer
+   */
+  void
+  TestSocketDrain ();
   /**
    * \brief Test the insertion of packets in the Stream RX buffer
    */
@@ -70,6 +78,16 @@ private:
    */
   void
   TestStreamExtract ();
+  /**
+   * \brief Test the reassembly of overlapping frames in the Stream RX buffer
+   */
+  void
+  TestStreamOverlap ();
+  /**
+   * \brief Test the tracking of received packet numbers for the ACK frames
+   */
+  void
+  TestAckRanges ();
 };
 
 QuicRxBufferTestCase::QuicRxBufferTestCase () :
@@ -97,6 +115,15 @@ QuicRxBufferTestCase::DoRun ()
    */
   TestSocketExtract ();
 
+  /*
+   * Test the draining of a deep Socket RX buffer:
+   * -> add 100000 small frames with known content
+   * -> extract with a size that is not a multiple of the frame size
+   * -> check the content and the size of the extracted packets
+   * -> report the cost of the insertion and of the extraction
+   */
+  TestSocketDrain ();
+
   /*
    * Test the insertion of packets in the Stream RX buffer:
    * -> add packets till stream tx buffer overflow
@@ -115,6 +142,25 @@ QuicRxBufferTestCase::DoRun ()
    * -> check correctness of buffer application size and available size
    */
   TestStreamExtract ();
+
+  /*
+   * Test the reassembly of overlapping frames in the Stream RX buffer:
+   * -> add a frame that partially overlaps with a buffered one
+   * -> add a frame that is entirely covered by the buffered ones
+   * -> check that the already delivered data is discarded
+   * -> check correctness of the deliverable size and of the extracted data
+   */
+  TestStreamOverlap ();
+
+  /*
+   * Test the tracking of received packet numbers:
+   * -> receive packets out of order and with duplicates
+   * -> check the merged ranges and the generated ACK blocks
+   * -> check the bound on the number of ranges and the pruning, which
+   *    must never make the ACK blocks cover a missing packet
+   * -> check the detection of the packets that open or fill a gap
+   */
+  TestAckRanges ();
 }
 
 void
@@ -179,21 +225,21 @@ QuicRxBufferTestCase::TestSocketExtract ()
   NS_TEST_ASSERT_MSG_EQ(out->GetSize (), 1200,
                         "Packet size differs from expected");
 
-  // extract another packet
+  // extract another packet and part of the next one
   out = rxBuf.Extract (1800);
-  NS_TEST_ASSERT_MSG_EQ(rxBuf.Available (), 2400,
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Available (), 3000,
                         "Availability differs from expected");
-  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 1200,
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 600,
                         "Buffer size differs from expected");
-  NS_TEST_ASSERT_MSG_EQ(out->GetSize (), 1200,
+  NS_TEST_ASSERT_MSG_EQ(out->GetSize (), 1800,
                         "Packet size differs from expected");
 
-  // extract another packet
+  // extract the rest of the packet
   out = rxBuf.Extract (2400);
   NS_TEST_ASSERT_MSG_EQ(rxBuf.Available (), 3600,
                         "Availability differs from expected");
   NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 0, "Buffer size differs from expected");
-  NS_TEST_ASSERT_MSG_EQ(out->GetSize (), 1200,
+  NS_TEST_ASSERT_MSG_EQ(out->GetSize (), 600,
                         "Packet size differs from expected");
 
   // test empty buffer
@@ -204,6 +250,57 @@ QuicRxBufferTestCase::TestSocketExtract ()
   NS_TEST_ASSERT_MSG_EQ(out, 0, "Packet size differs from expected");
 }
 
+void
+QuicRxBufferTestCase::TestSocketDrain ()
+{
+  const uint32_t numFrames = 100000;
+  const uint32_t frameSize = 20;
+  const uint32_t extractSize = 150;
+
+  // create the buffer
+  QuicSocketRxBuffer rxBuf;
+  rxBuf.SetMaxBufferSize (numFrames * frameSize);
+
+  // each byte carries its position in the stream, modulo 256
+  std::vector<uint8_t> data (frameSize);
+  for (uint32_t i = 0; i < numFrames; i++)
+    {
+      for (uint32_t j = 0; j < frameSize; j++)
+        {
+          data[j] = (i * frameSize + j) % 256;
+        }
+      bool pos = rxBuf.Add (Create<Packet> (data.data (), frameSize));
+      NS_TEST_ASSERT_MSG_EQ(pos, true, "Failed to add packet " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), numFrames * frameSize,
+                        "Buffer size differs from expected");
+
+  // extract packets which span several frames, and start and end within a frame
+  uint64_t extracted = 0;
+  bool correct = true;
+  std::vector<uint8_t> out (extractSize);
+  Ptr<Packet> p = rxBuf.Extract (extractSize);
+  while (p != nullptr)
+    {
+      uint32_t size = p->GetSize ();
+      correct = correct && (size == std::min<uint64_t> (extractSize, numFrames * frameSize - extracted));
+      p->CopyData (out.data (), size);
+      for (uint32_t j = 0; j < size; j++)
+        {
+          correct = correct && (out[j] == (extracted + j) % 256);
+        }
+      extracted += size;
+      p = rxBuf.Extract (extractSize);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ(correct, true, "Extracted data differs from expected");
+  NS_TEST_ASSERT_MSG_EQ(extracted, uint64_t (numFrames) * frameSize,
+                        "Extracted size differs from expected");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 0, "Buffer size differs from expected");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Available (), numFrames * frameSize,
+                        "Availability differs from expected");
+}
+
 void
 QuicRxBufferTestCase::TestStreamAdd ()
 {
@@ -361,6 +458,153 @@ QuicRxBufferTestCase::TestStreamExtract ()
   NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 0, "Wrong buffer size");
 }
 
+void
+QuicRxBufferTestCase::TestStreamOverlap ()
+{
+  // create the buffer
+  QuicStreamRxBuffer rxBuf;
+  rxBuf.SetMaxBufferSize (18000);
+
+  Ptr<Packet> p = Create<Packet> (1200);
+  QuicSubheader sub = QuicSubheader::CreateStreamSubHeader (1, 0, p->GetSize (), false,
+                                                            true, false);
+
+  // buffer [1200, 2400)
+  sub.SetOffset (1200);
+  bool pos = rxBuf.Add (p, sub);
+  NS_TEST_ASSERT_MSG_EQ(pos, true, "Failed to add packet");
+
+  // [600, 1800) only brings the bytes in [600, 1200)
+  sub.SetOffset (600);
+  pos = rxBuf.Add (p, sub);
+  NS_TEST_ASSERT_MSG_EQ(pos, true, "Failed to add partially overlapping packet");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 1800, "Wrong buffer size");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Available (), 16200, "Wrong available data size");
+
+  // [900, 1500) is already in the buffer
+  Ptr<Packet> small = Create<Packet> (600);
+  sub.SetOffset (900);
+  bool neg = rxBuf.Add (small, sub);
+  NS_TEST_ASSERT_MSG_EQ(neg, false, "Added duplicate packet");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 1800, "Wrong buffer size");
+
+  // [0, 600) is missing
+  std::pair<uint64_t, uint64_t> deliverable = rxBuf.GetDeliverable (0);
+  NS_TEST_ASSERT_MSG_EQ(deliverable.second, 0, "Wrong deliverable packet size");
+
+  // [0, 900) has been delivered: the buffered bytes below 900 are discarded
+  deliverable = rxBuf.GetDeliverable (900);
+  NS_TEST_ASSERT_MSG_EQ(deliverable.second, 1500, "Wrong deliverable packet size");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 1500, "Wrong buffer size");
+
+  // [3000, 4200), then [2400, 3600) fills the gap
+  sub.SetOffset (3000);
+  rxBuf.Add (p, sub);
+  sub.SetOffset (2400);
+  pos = rxBuf.Add (p, sub);
+  NS_TEST_ASSERT_MSG_EQ(pos, true, "Failed to add partially overlapping packet");
+  deliverable = rxBuf.GetDeliverable (900);
+  NS_TEST_ASSERT_MSG_EQ(deliverable.first, 3000, "Wrong deliverable offset value");
+  NS_TEST_ASSERT_MSG_EQ(deliverable.second, 3300, "Wrong deliverable packet size");
+
+  Ptr<Packet> outPkt = rxBuf.Extract (deliverable.second);
+  NS_TEST_ASSERT_MSG_NE(outPkt, 0, "Failed to extract packets");
+  NS_TEST_ASSERT_MSG_EQ(outPkt->GetSize (), 3300, "Wrong packet size");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Size (), 0, "Wrong buffer size");
+  NS_TEST_ASSERT_MSG_EQ(rxBuf.Available (), 18000, "Wrong available data size");
+}
+
+void
+QuicRxBufferTestCase::TestAckRanges ()
+{
+  QuicAckRangeSet ranges;
+  NS_TEST_ASSERT_MSG_EQ (ranges.IsEmpty (), true, "New set is not empty");
+
+  // receive 1-4, 6, 8-9, 12 (7 is received after 8 and 9)
+  uint32_t received[] = { 1, 2, 3, 4, 6, 8, 9, 7, 12 };
+  for (uint32_t pn : received)
+    {
+      NS_TEST_ASSERT_MSG_EQ (ranges.Add (SequenceNumber32 (pn)), true, "Failed to add packet number " << pn);
+    }
+  NS_TEST_ASSERT_MSG_EQ (ranges.Add (SequenceNumber32 (8)), false, "Duplicate packet number not detected");
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetLargest (), SequenceNumber32 (12), "Wrong largest packet number");
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetNumRanges (), 3, "Wrong number of ranges");
+
+  std::vector<uint32_t> gaps;
+  std::vector<uint32_t> additionalAckBlocks;
+  ranges.GetAckBlocks (20, gaps, additionalAckBlocks);
+  NS_TEST_ASSERT_MSG_EQ (gaps.size (), 2, "Wrong number of gaps");
+  NS_TEST_ASSERT_MSG_EQ (gaps[0], 11, "Wrong first gap");
+  NS_TEST_ASSERT_MSG_EQ (additionalAckBlocks[0], 9, "Wrong first additional block");
+  NS_TEST_ASSERT_MSG_EQ (gaps[1], 5, "Wrong second gap");
+  NS_TEST_ASSERT_MSG_EQ (additionalAckBlocks[1], 4, "Wrong second additional block");
+
+  // fill the gap at 5, then 10 and 11
+  ranges.Add (SequenceNumber32 (5));
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetNumRanges (), 2, "Gap fill did not merge the ranges");
+  ranges.Add (SequenceNumber32 (11));
+  ranges.Add (SequenceNumber32 (10));
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetNumRanges (), 1, "Gap fill did not merge the ranges");
+
+  // the number of gaps in an ACK is limited
+  ranges.Add (SequenceNumber32 (14));
+  ranges.Add (SequenceNumber32 (16));
+  ranges.Add (SequenceNumber32 (18));
+  gaps.clear ();
+  additionalAckBlocks.clear ();
+  ranges.GetAckBlocks (2, gaps, additionalAckBlocks);
+  NS_TEST_ASSERT_MSG_EQ (gaps.size (), 2, "Wrong number of gaps");
+  NS_TEST_ASSERT_MSG_EQ (additionalAckBlocks[0], 16, "Wrong first additional block");
+  // the last block is the lowest range, which implicitly covers the lower
+  // packet numbers, so the unreported range [14, 14] falls in the last gap
+  NS_TEST_ASSERT_MSG_EQ (gaps[1], 15, "Wrong last gap");
+  NS_TEST_ASSERT_MSG_EQ (additionalAckBlocks[1], 12, "Wrong last additional block");
+
+  // the ranges above the lowest one are forgotten when the bound is exceeded
+  ranges.SetMaxRanges (3);
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetNumRanges (), 3, "Bound on the number of ranges not enforced");
+  ranges.Add (SequenceNumber32 (20));
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetNumRanges (), 3, "Bound on the number of ranges not enforced");
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetLargest (), SequenceNumber32 (20), "Wrong largest packet number");
+  gaps.clear ();
+  additionalAckBlocks.clear ();
+  ranges.GetAckBlocks (20, gaps, additionalAckBlocks);
+  NS_TEST_ASSERT_MSG_EQ (gaps.size (), 2, "Wrong number of gaps");
+  NS_TEST_ASSERT_MSG_EQ (gaps[1], 17, "Forgotten range not merged into the gap");
+  NS_TEST_ASSERT_MSG_EQ (additionalAckBlocks[1], 12, "Lowest range forgotten");
+
+  // after an ACK of ACK, the ranges below its largest acknowledged are dropped,
+  // but the lowest and the highest range are always kept, so that the pruned
+  // gaps are still reported as missing
+  ranges.PruneBelow (SequenceNumber32 (19));
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetNumRanges (), 2, "Ranges not pruned");
+  ranges.PruneBelow (SequenceNumber32 (100));
+  NS_TEST_ASSERT_MSG_EQ (ranges.GetNumRanges (), 2, "Lowest or highest range pruned");
+  gaps.clear ();
+  additionalAckBlocks.clear ();
+  ranges.GetAckBlocks (20, gaps, additionalAckBlocks);
+  NS_TEST_ASSERT_MSG_EQ (gaps.size (), 1, "Wrong number of gaps");
+  NS_TEST_ASSERT_MSG_EQ (gaps[0], 19, "Pruned gap acknowledged");
+  NS_TEST_ASSERT_MSG_EQ (additionalAckBlocks[0], 12, "Wrong last additional block");
+
+  // the packets that open or fill a gap are reported as received out of order
+  QuicAckRangeSet reordered;
+  reordered.Add (SequenceNumber32 (1));
+  NS_TEST_ASSERT_MSG_EQ (reordered.HasReceivedMissing (), false, "First packet reported out of order");
+  reordered.Add (SequenceNumber32 (2));
+  NS_TEST_ASSERT_MSG_EQ (reordered.HasReceivedMissing (), false, "In-order packet reported out of order");
+  reordered.Add (SequenceNumber32 (5));
+  NS_TEST_ASSERT_MSG_EQ (reordered.HasReceivedMissing (), true, "New gap not detected");
+  reordered.Add (SequenceNumber32 (6));
+  NS_TEST_ASSERT_MSG_EQ (reordered.HasReceivedMissing (), false, "In-order packet reported out of order");
+  reordered.Add (SequenceNumber32 (3));
+  NS_TEST_ASSERT_MSG_EQ (reordered.HasReceivedMissing (), true, "Partial gap fill not detected");
+  reordered.Add (SequenceNumber32 (4));
+  NS_TEST_ASSERT_MSG_EQ (reordered.HasReceivedMissing (), true, "Gap fill not detected");
+  reordered.Add (SequenceNumber32 (4));
+  NS_TEST_ASSERT_MSG_EQ (reordered.HasReceivedMissing (), false, "Duplicate packet reported out of order");
+}
+
 void
 QuicRxBufferTestCase::DoTeardown ()
 {
@@ -0,0 +1,1337 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/config.h"
+
+#include "ns3/quic-l4-protocol.h"
+#include "ns3/quic-l5-protocol.h"
+#include "ns3/quic-socket-base.h"
+#include "ns3/quic-stream-base.h"
+#include "ns3/quic-subheader.h"
+#include "ns3/quic-congestion-ops.h"
+#include "ns3/quic-bbr.h"
+
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QuicSocketBaseTestSuite");
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicBbr with its send quantum exposed
+ */
+class QuicBbrQuantumTester : public QuicBbr
+{
+public:
+  using QuicBbr::SetSendQuantum;
+};
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicSocketBase whose pacer is driven as by the sending loop
+ *
+ * Every packet allowed by the pacer is charged to it, and every wakeup of
+ * the pacing timer is counted instead of calling SendPendingData, so that
+ * no connection is needed.
+ */
+class QuicPacerTester : public QuicSocketBase
+{
+public:
+  QuicPacerTester ();
+
+  /**
+   * \brief Send at the pacing rate until a given time
+   *
+   * \param rate the pacing rate
+   * \param algo the congestion control that sets the send quantum
+   * \param segmentSize the size of each packet
+   * \param duration the duration of the transfer
+   */
+  void Start (DataRate rate, Ptr<QuicBbrQuantumTester> algo, uint32_t segmentSize, Time duration);
+
+  /**
+   * \brief Get the send quantum set by the congestion control
+   * \return the send quantum
+   */
+  uint32_t GetQuantum () const;
+
+  uint64_t m_sentBytes;  //!< Bytes released by the pacer
+  uint32_t m_wakeups;    //!< Number of expirations of the pacing timer
+
+private:
+  /**
+   * \brief Send packets as long as the pacer allows it
+   */
+  void SendBurst ();
+
+  /**
+   * \brief Expiration of the pacing timer
+   */
+  void Wakeup ();
+
+  Time m_end;  //!< End of the transfer
+};
+
+QuicPacerTester::QuicPacerTester ()
+  : m_sentBytes (0),
+    m_wakeups (0)
+{
+}
+
+void
+QuicPacerTester::Start (DataRate rate, Ptr<QuicBbrQuantumTester> algo, uint32_t segmentSize, Time duration)
+{
+  m_tcb->m_pacing = true;
+  m_tcb->m_segmentSize = segmentSize;
+  m_tcb->m_pacingRate = rate;
+  algo->SetSendQuantum (m_tcb);
+
+  m_pacingTimer.SetFunction (&QuicPacerTester::Wakeup, this);
+  m_pacingLastUpdate = Simulator::Now ();
+  m_end = Simulator::Now () + duration;
+  SendBurst ();
+}
+
+uint32_t
+QuicPacerTester::GetQuantum () const
+{
+  return GetPacingQuantum ();
+}
+
+void
+QuicPacerTester::SendBurst ()
+{
+  while (Simulator::Now () < m_end and PacerAllowsSend ())
+    {
+      m_pacingTokens -= GetSegSize ();
+      m_sentBytes += GetSegSize ();
+    }
+}
+
+void
+QuicPacerTester::Wakeup ()
+{
+  if (Simulator::Now () < m_end)
+    {
+      m_wakeups++;
+      SendBurst ();
+    }
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicSocketBase pacer Test
+ *
+ * A sender always backlogged is paced at a fixed rate, with the send
+ * quantum set by BBR for that rate. The long-run rate must be the pacing
+ * rate, and each wakeup of the pacing timer must release a whole quantum.
+ */
+class QuicPacerTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param rate the pacing rate
+   * \param quantum the expected send quantum in bytes
+   */
+  QuicPacerTestCase (DataRate rate, uint32_t quantum);
+
+private:
+  virtual void
+  DoRun (void);
+
+  DataRate m_rate;      //!< The pacing rate
+  uint32_t m_quantum;   //!< The expected send quantum
+};
+
+QuicPacerTestCase::QuicPacerTestCase (DataRate rate, uint32_t quantum) :
+    TestCase ("QuicSocketBase pacer Test at " + std::to_string (rate.GetBitRate ()) + " bps"),
+    m_rate (rate),
+    m_quantum (quantum)
+{
+}
+
+void
+QuicPacerTestCase::DoRun ()
+{
+  const uint32_t segmentSize = 1200;
+  const Time duration = Seconds (1);
+
+  Ptr<QuicPacerTester> socket = CreateObject<QuicPacerTester> ();
+  Ptr<QuicBbrQuantumTester> bbr = CreateObject<QuicBbrQuantumTester> ();
+  Simulator::ScheduleNow (&QuicPacerTester::Start, socket, m_rate, bbr, segmentSize, duration);
+  Simulator::Stop (duration + MilliSeconds (100));
+  Simulator::Run ();
+
+  // the quantum is about 1 ms of data at high rates, and one or two packets otherwise
+  NS_TEST_ASSERT_MSG_EQ (socket->GetQuantum (), m_quantum, "Wrong send quantum");
+
+  double rate = socket->m_sentBytes * 8 / duration.GetSeconds ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (rate, m_rate.GetBitRate (), 0.01 * m_rate.GetBitRate (),
+                             "Long-run rate different from the pacing rate");
+
+  // each wakeup releases the packets of a whole quantum
+  uint32_t packetsPerWakeup = std::ceil ((double) m_quantum / segmentSize);
+  double wakeups = (double) socket->m_sentBytes / (packetsPerWakeup * segmentSize);
+  NS_TEST_ASSERT_MSG_EQ_TOL (socket->m_wakeups, wakeups, 1, "Wrong number of wakeups per quantum");
+
+  socket->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicSocketBase in an open connection
+ *
+ * The socket is attached to a QuicL4Protocol without any UDP binding, so
+ * that the frames it sends are dropped, and no peer is needed. The testers
+ * of each case derive from it to expose the members they check.
+ */
+class QuicOpenSocketTester : public QuicSocketBase
+{
+public:
+  /**
+   * \brief Create a socket with 1000-byte segments in an open connection
+   *
+   * \param node the node
+   * \param quicL4 the QUIC L4 protocol of the node
+   * \return the socket
+   */
+  template <class T>
+  static Ptr<T> CreateOpen (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4);
+
+  using QuicSocketBase::m_tcb;
+  using QuicSocketBase::m_txBuffer;
+
+private:
+  /**
+   * \brief Attach the socket to a node and mark the connection as established
+   *
+   * \param node the node
+   * \param quicL4 the QUIC L4 protocol of the node
+   */
+  void Open (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4);
+};
+
+template <class T>
+Ptr<T>
+QuicOpenSocketTester::CreateOpen (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4)
+{
+  Ptr<T> socket = CreateObject<T> ();
+  socket->SetSegSize (1000);
+  socket->Open (node, quicL4);
+  return socket;
+}
+
+void
+QuicOpenSocketTester::Open (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4)
+{
+  SetNode (node);
+  SetQuicL4 (quicL4);
+  InitializeScheduling ();
+  m_socketState = OPEN;
+  m_connected = true;
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicOpenSocketTester with the ACK frequency state exposed
+ */
+class QuicAckFrequencyTester : public QuicOpenSocketTester
+{
+public:
+  using QuicSocketBase::MaybeSendAckFrequency;
+  using QuicSocketBase::OnReceivedAckFrequencyFrame;
+  using QuicSocketBase::OnReceivedFrame;
+  using QuicSocketBase::MaybeQueueAck;
+
+  using QuicSocketBase::m_transportErrorCode;
+  using QuicSocketBase::m_receivedPacketNumbers;
+  using QuicSocketBase::m_sendAckEvent;
+  using QuicSocketBase::m_delAckEvent;
+  using QuicSocketBase::m_peerMinAckDelay;
+  using QuicSocketBase::m_ackFrequencySequence;
+  using QuicSocketBase::m_sentAckElicitingThreshold;
+  using QuicSocketBase::m_ackElicitingThreshold;
+  using QuicSocketBase::m_maxAckDelay;
+};
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicSocketBase ACK frequency Test
+ *
+ * The sender requests an ACK every m_ackFrequencyRatio-th of the congestion
+ * window with ACK_FREQUENCY frames, and the receiver applies the most recent
+ * request, rejects the invalid ones, and answers IMMEDIATE_ACK right away.
+ */
+class QuicAckFrequencyTestCase : public TestCase
+{
+public:
+  /** \brief Constructor */
+  QuicAckFrequencyTestCase ();
+
+private:
+  virtual void
+  DoRun (void);
+
+  /**
+   * \brief Create a socket in an open connection, with a min_ack_delay
+   * \return the socket
+   */
+  Ptr<QuicAckFrequencyTester> CreateOpenSocket ();
+
+  /**
+   * \brief Check the threshold requested for each congestion window
+   */
+  void TestRequestedThreshold ();
+
+  /**
+   * \brief Check that reordered ACK_FREQUENCY frames are ignored
+   */
+  void TestStaleSequence ();
+
+  /**
+   * \brief Check that the invalid ACK_FREQUENCY frames close the connection
+   */
+  void TestProtocolViolation ();
+
+  /**
+   * \brief Check that an IMMEDIATE_ACK frame is answered without delay
+   */
+  void TestImmediateAck ();
+
+  Ptr<Node> m_node;               //!< The node of the sockets
+  Ptr<QuicL4Protocol> m_quicL4;   //!< The QUIC L4 protocol of the node
+};
+
+QuicAckFrequencyTestCase::QuicAckFrequencyTestCase () :
+    TestCase ("QuicSocketBase ACK frequency Test")
+{
+}
+
+Ptr<QuicAckFrequencyTester>
+QuicAckFrequencyTestCase::CreateOpenSocket ()
+{
+  Ptr<QuicAckFrequencyTester> socket = QuicOpenSocketTester::CreateOpen<QuicAckFrequencyTester> (m_node, m_quicL4);
+  socket->SetAttribute ("MinAckDelay", TimeValue (MilliSeconds (1)));
+  socket->SetAttribute ("AckFrequencyRatio", UintegerValue (8));
+  return socket;
+}
+
+void
+QuicAckFrequencyTestCase::TestRequestedThreshold ()
+{
+  Ptr<QuicAckFrequencyTester> socket = CreateOpenSocket ();
+
+  // no request if the peer does not support the extension
+  socket->m_tcb->m_cWnd = 80000;
+  socket->MaybeSendAckFrequency ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackFrequencySequence, 0, "ACK_FREQUENCY sent to a peer without min_ack_delay");
+
+  socket->m_peerMinAckDelay = MilliSeconds (1);
+
+  // small window: the default threshold is kept, nothing to send
+  socket->m_tcb->m_cWnd = 16000;
+  socket->MaybeSendAckFrequency ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackFrequencySequence, 0, "ACK_FREQUENCY sent for the default threshold");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_txBuffer->GetNumControlFramesInBuffer (), 0, "Unexpected control frame");
+
+  // 10 packets per ACK: an ACK after more than 9 packets
+  socket->m_tcb->m_cWnd = 80000;
+  socket->MaybeSendAckFrequency ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackFrequencySequence, 1, "No ACK_FREQUENCY for a larger window");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_sentAckElicitingThreshold, 9, "Wrong threshold requested");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_txBuffer->GetNumControlFramesInBuffer (), 1, "ACK_FREQUENCY not queued");
+
+  // an increase below 25% of the requested threshold is not worth a frame
+  socket->m_tcb->m_cWnd = 88000;
+  socket->MaybeSendAckFrequency ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackFrequencySequence, 1, "ACK_FREQUENCY sent for a small increase");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_sentAckElicitingThreshold, 9, "Threshold changed for a small increase");
+
+  // an increase of 25% is
+  socket->m_tcb->m_cWnd = 96000;
+  socket->MaybeSendAckFrequency ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackFrequencySequence, 2, "No ACK_FREQUENCY for a large increase");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_sentAckElicitingThreshold, 11, "Wrong threshold after a large increase");
+
+  // any reduction is followed right away
+  socket->m_tcb->m_cWnd = 88000;
+  socket->MaybeSendAckFrequency ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackFrequencySequence, 3, "No ACK_FREQUENCY for a reduction");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_sentAckElicitingThreshold, 10, "Wrong threshold after a reduction");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_txBuffer->GetNumControlFramesInBuffer (), 3, "ACK_FREQUENCY frames not queued");
+
+  socket->Dispose ();
+}
+
+void
+QuicAckFrequencyTestCase::TestStaleSequence ()
+{
+  Ptr<QuicAckFrequencyTester> socket = CreateOpenSocket ();
+
+  QuicSubheader first = QuicSubheader::CreateAckFrequency (0, 5, 10000);
+  socket->OnReceivedAckFrequencyFrame (first);
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackElicitingThreshold, 5, "ACK_FREQUENCY not applied");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_maxAckDelay, MilliSeconds (10), "Requested max ACK delay not applied");
+
+  // skipped sequence numbers are fine, only the order matters
+  QuicSubheader third = QuicSubheader::CreateAckFrequency (2, 9, 20000);
+  socket->OnReceivedAckFrequencyFrame (third);
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackElicitingThreshold, 9, "Newer ACK_FREQUENCY not applied");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_maxAckDelay, MilliSeconds (20), "Newer max ACK delay not applied");
+
+  // a reordered frame, or a retransmission of the last one, is ignored
+  QuicSubheader second = QuicSubheader::CreateAckFrequency (1, 3, 5000);
+  socket->OnReceivedAckFrequencyFrame (second);
+  QuicSubheader again = QuicSubheader::CreateAckFrequency (2, 4, 5000);
+  socket->OnReceivedAckFrequencyFrame (again);
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackElicitingThreshold, 9, "Stale ACK_FREQUENCY applied");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_maxAckDelay, MilliSeconds (20), "Stale max ACK delay applied");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_transportErrorCode, QuicSubheader::TransportErrorCodes_t::NO_ERROR,
+                         "Connection closed for a stale ACK_FREQUENCY");
+
+  socket->Dispose ();
+}
+
+void
+QuicAckFrequencyTestCase::TestProtocolViolation ()
+{
+  // ACK_FREQUENCY without advertising a min_ack_delay
+  Ptr<QuicAckFrequencyTester> socket = CreateOpenSocket ();
+  socket->SetAttribute ("MinAckDelay", TimeValue (Seconds (0)));
+  QuicSubheader frame = QuicSubheader::CreateAckFrequency (0, 5, 10000);
+  socket->OnReceivedAckFrequencyFrame (frame);
+  NS_TEST_ASSERT_MSG_EQ (socket->m_transportErrorCode, QuicSubheader::TransportErrorCodes_t::PROTOCOL_VIOLATION,
+                         "ACK_FREQUENCY accepted without min_ack_delay");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackElicitingThreshold, 2, "Invalid ACK_FREQUENCY applied");
+  NS_TEST_ASSERT_MSG_NE (socket->GetSocketState (), QuicSocket::OPEN, "Connection still open");
+  socket->Dispose ();
+
+  // requested max ACK delay below the advertised min_ack_delay
+  socket = CreateOpenSocket ();
+  QuicSubheader shortDelay = QuicSubheader::CreateAckFrequency (0, 5, 500);
+  socket->OnReceivedAckFrequencyFrame (shortDelay);
+  NS_TEST_ASSERT_MSG_EQ (socket->m_transportErrorCode, QuicSubheader::TransportErrorCodes_t::PROTOCOL_VIOLATION,
+                         "ACK_FREQUENCY accepted with a delay below min_ack_delay");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_ackElicitingThreshold, 2, "Invalid ACK_FREQUENCY applied");
+  NS_TEST_ASSERT_MSG_NE (socket->GetSocketState (), QuicSocket::OPEN, "Connection still open");
+  socket->Dispose ();
+}
+
+void
+QuicAckFrequencyTestCase::TestImmediateAck ()
+{
+  Ptr<QuicAckFrequencyTester> socket = CreateOpenSocket ();
+
+  QuicSubheader frequency = QuicSubheader::CreateAckFrequency (0, 9, 20000);
+  socket->OnReceivedAckFrequencyFrame (frequency);
+
+  // below the threshold, the ACK is delayed
+  socket->m_receivedPacketNumbers.Add (SequenceNumber32 (1));
+  socket->MaybeQueueAck ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_delAckEvent.IsRunning (), true, "ACK not delayed");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_sendAckEvent.IsRunning (), false, "ACK not delayed");
+
+  // a packet with an IMMEDIATE_ACK is acknowledged right away
+  QuicSubheader immediate = QuicSubheader::CreateImmediateAck ();
+  socket->m_receivedPacketNumbers.Add (SequenceNumber32 (2));
+  socket->OnReceivedFrame (immediate);
+  socket->MaybeQueueAck ();
+  NS_TEST_ASSERT_MSG_EQ (socket->m_sendAckEvent.IsRunning (), true, "IMMEDIATE_ACK not answered");
+
+  socket->Dispose ();
+}
+
+void
+QuicAckFrequencyTestCase::DoRun ()
+{
+  m_node = CreateObject<Node> ();
+  m_quicL4 = CreateObject<QuicL4Protocol> ();
+  m_node->AggregateObject (m_quicL4);
+
+  // The sender asks for an ACK every 1/8 of the window, but not less often
+  // than by default, and does not send a frame for each small increase of
+  // the window. The frames are queued as control frames.
+  TestRequestedThreshold ();
+
+  // The receiver applies only the ACK_FREQUENCY frames with a sequence
+  // number above the last one applied.
+  TestStaleSequence ();
+
+  // The receiver closes the connection with a PROTOCOL_VIOLATION if it did
+  // not advertise a min_ack_delay, or if the requested delay is below it.
+  TestProtocolViolation ();
+
+  // An IMMEDIATE_ACK frame bypasses the threshold and the ACK delay.
+  TestImmediateAck ();
+
+  m_node->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicOpenSocketTester with its sending loop exposed
+ */
+class QuicFlowControlTester : public QuicOpenSocketTester
+{
+public:
+  using QuicSocketBase::SendPendingData;
+};
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicSocketBase flow control Test
+ *
+ * With autotuning, the receive window of a stream grows when the peer
+ * consumes it quickly, within the receive buffer budget of the node. A
+ * sender blocked by the connection or by the stream limit reports it once
+ * for each limit.
+ */
+class QuicFlowControlTestCase : public TestCase
+{
+public:
+  /** \brief Constructor */
+  QuicFlowControlTestCase ();
+
+private:
+  virtual void
+  DoRun (void);
+
+  /**
+   * \brief Create a socket in an open connection, with its L5 protocol
+   *
+   * \param node the node
+   * \param quicL4 the QUIC L4 protocol of the node
+   * \param socket filled with the socket
+   * \return the L5 protocol of the socket
+   */
+  Ptr<QuicL5Protocol> CreateOpenSocket (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4,
+                                        Ptr<QuicFlowControlTester> &socket);
+
+  /**
+   * \brief Receive in order frames of 1000 bytes on stream 1
+   *
+   * \param quicL5 the L5 protocol of the receiver
+   * \param offset the offset of the first frame
+   * \param numFrames the number of frames
+   */
+  void ReceiveFrames (Ptr<QuicL5Protocol> quicL5, uint64_t offset, uint32_t numFrames);
+
+  /**
+   * \brief Check the growth of the receive window within the budget
+   */
+  void TestWindowUpdate ();
+
+  /**
+   * \brief Check that the memory reserved by the autotuning returns to the budget
+   */
+  void TestBudgetRelease ();
+
+  /**
+   * \brief Check the traces of the connection and stream blocking
+   */
+  void TestBlocked ();
+
+  /**
+   * \brief Trace sink of the connection blocking
+   * \param limit the MAX_DATA limit
+   */
+  void Blocked (uint64_t limit);
+
+  /**
+   * \brief Trace sink of the stream blocking
+   * \param streamId the stream
+   * \param limit the MAX_STREAM_DATA limit
+   */
+  void StreamBlocked (uint64_t streamId, uint64_t limit);
+
+  std::vector<uint64_t> m_blocked;                               //!< Limits of the connection blocking
+  std::vector<std::pair<uint64_t, uint64_t> > m_streamBlocked;   //!< Streams and limits of the stream blocking
+};
+
+QuicFlowControlTestCase::QuicFlowControlTestCase () :
+    TestCase ("QuicSocketBase flow control Test")
+{
+}
+
+Ptr<QuicL5Protocol>
+QuicFlowControlTestCase::CreateOpenSocket (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4,
+                                           Ptr<QuicFlowControlTester> &socket)
+{
+  socket = QuicOpenSocketTester::CreateOpen<QuicFlowControlTester> (node, quicL4);
+
+  Ptr<QuicL5Protocol> quicL5 = CreateObject<QuicL5Protocol> ();
+  quicL5->SetSocket (socket);
+  quicL5->SetNode (node);
+  quicL5->SetConnectionId (socket->GetConnectionId ());
+  return quicL5;
+}
+
+void
+QuicFlowControlTestCase::ReceiveFrames (Ptr<QuicL5Protocol> quicL5, uint64_t offset,
+                                        uint32_t numFrames)
+{
+  Address address;
+  for (uint32_t i = 0; i < numFrames; i++)
+    {
+      Ptr<Packet> frame = Create<Packet> (1000);
+      frame->AddHeader (QuicSubheader::CreateStreamSubHeader (1, offset + i * 1000, 1000,
+                                                              true, true, false));
+      quicL5->DispatchRecv (frame, address);
+    }
+}
+
+void
+QuicFlowControlTestCase::TestWindowUpdate ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  quicL4->SetAttribute ("RcvBufBudget", UintegerValue (15000));
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicFlowControlTester> socket;
+  Ptr<QuicL5Protocol> quicL5 = CreateOpenSocket (node, quicL4, socket);
+  socket->m_tcb->m_smoothedRtt = MilliSeconds (100);
+
+  quicL5->CreateStream (QuicStream::RECEIVER, 1);
+  Ptr<QuicStreamBase> stream = quicL5->SearchStream (1);
+  stream->SetAttribute ("AutoTuning", BooleanValue (true));
+  stream->SetAttribute ("MaxStreamRcvBufSize", UintegerValue (40000));
+  stream->SetStreamRcvBufSize (10000);
+
+  // no time passes, so each update comes less than 2 RTTs after the previous one:
+  // the window doubles when half of it is consumed
+  ReceiveFrames (quicL5, 0, 6);
+  NS_TEST_ASSERT_MSG_EQ (stream->GetStreamRcvBufSize (), 20000, "Receive window not doubled");
+  NS_TEST_ASSERT_MSG_EQ (quicL4->GetRcvBufReserved (), 10000, "Growth not charged to the budget");
+
+  // the next doubling is capped by the budget
+  ReceiveFrames (quicL5, 6000, 10);
+  NS_TEST_ASSERT_MSG_EQ (stream->GetStreamRcvBufSize (), 25000, "Growth not capped by the budget");
+  NS_TEST_ASSERT_MSG_EQ (quicL4->GetRcvBufReserved (), 15000, "Budget not exhausted");
+
+  // with the budget exhausted, the window is still updated, but does not grow
+  ReceiveFrames (quicL5, 16000, 14);
+  NS_TEST_ASSERT_MSG_EQ (stream->GetStreamRcvBufSize (), 25000, "Window grown beyond the budget");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_txBuffer->GetNumControlFramesInBuffer (), 4,
+                         "Wrong number of window updates");
+
+  node->Dispose ();
+}
+
+void
+QuicFlowControlTestCase::TestBlocked ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicFlowControlTester> socket;
+  Ptr<QuicL5Protocol> quicL5 = CreateOpenSocket (node, quicL4, socket);
+  socket->TraceConnectWithoutContext ("Blocked",
+                                      MakeCallback (&QuicFlowControlTestCase::Blocked, this));
+  socket->TraceConnectWithoutContext ("StreamBlocked",
+                                      MakeCallback (&QuicFlowControlTestCase::StreamBlocked, this));
+
+  // the stream sends up to its limit, and reports the blocking once
+  quicL5->CreateStream (QuicStream::SENDER, 1);
+  Ptr<QuicStreamBase> stream = quicL5->SearchStream (1);
+  stream->SetMaxStreamData (2000);
+  stream->Send (Create<Packet> (5000));
+  stream->SendPendingData ();
+  NS_TEST_ASSERT_MSG_EQ (m_streamBlocked.size (), 1, "Stream blocking not reported");
+  NS_TEST_ASSERT_MSG_EQ (m_streamBlocked.back ().first, 1, "Wrong blocked stream");
+  NS_TEST_ASSERT_MSG_EQ (m_streamBlocked.back ().second, 2000, "Wrong stream limit");
+  stream->SendPendingData ();
+  NS_TEST_ASSERT_MSG_EQ (m_streamBlocked.size (), 1, "Stream blocking reported twice at the same limit");
+
+  // a new limit is reported again
+  stream->SetMaxStreamData (4000);
+  stream->SendPendingData ();
+  NS_TEST_ASSERT_MSG_EQ (m_streamBlocked.size (), 2, "Stream blocking at a new limit not reported");
+  NS_TEST_ASSERT_MSG_EQ (m_streamBlocked.back ().second, 4000, "Wrong new stream limit");
+
+  // the connection cannot send a full packet, and reports the blocking once
+  socket->SetConnectionMaxData (500);
+  socket->SendPendingData ();
+  NS_TEST_ASSERT_MSG_EQ (m_blocked.size (), 1, "Connection blocking not reported");
+  NS_TEST_ASSERT_MSG_EQ (m_blocked.back (), 500, "Wrong connection limit");
+  socket->SendPendingData ();
+  NS_TEST_ASSERT_MSG_EQ (m_blocked.size (), 1, "Connection blocking reported twice at the same limit");
+
+  socket->SetConnectionMaxData (700);
+  socket->SendPendingData ();
+  NS_TEST_ASSERT_MSG_EQ (m_blocked.size (), 2, "Connection blocking at a new limit not reported");
+  NS_TEST_ASSERT_MSG_EQ (m_blocked.back (), 700, "Wrong new connection limit");
+
+  node->Dispose ();
+}
+
+void
+QuicFlowControlTestCase::Blocked (uint64_t limit)
+{
+  m_blocked.push_back (limit);
+}
+
+void
+QuicFlowControlTestCase::StreamBlocked (uint64_t streamId, uint64_t limit)
+{
+  m_streamBlocked.push_back (std::make_pair (streamId, limit));
+}
+
+void
+QuicFlowControlTestCase::TestBudgetRelease ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  quicL4->SetAttribute ("RcvBufBudget", UintegerValue (15000));
+  node->AggregateObject (quicL4);
+
+  // the window of a stream on each of three connections doubles once
+  std::vector<Ptr<QuicL5Protocol> > connections;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<QuicFlowControlTester> socket;
+      Ptr<QuicL5Protocol> quicL5 = CreateOpenSocket (node, quicL4, socket);
+      socket->m_tcb->m_smoothedRtt = MilliSeconds (100);
+
+      quicL5->CreateStream (QuicStream::RECEIVER, 1);
+      Ptr<QuicStreamBase> stream = quicL5->SearchStream (1);
+      stream->SetAttribute ("AutoTuning", BooleanValue (true));
+      stream->SetAttribute ("MaxStreamRcvBufSize", UintegerValue (20000));
+      stream->SetStreamRcvBufSize (10000);
+
+      ReceiveFrames (quicL5, 0, 6);
+      NS_TEST_ASSERT_MSG_EQ (stream->GetStreamRcvBufSize (), 20000, "Receive window not doubled");
+      NS_TEST_ASSERT_MSG_EQ (quicL4->GetRcvBufReserved (), 10000, "Growth not charged to the budget");
+
+      if (i == 0)
+        {
+          // all the data of the stream is read
+          Address address;
+          Ptr<Packet> frame = Create<Packet> (1000);
+          frame->AddHeader (QuicSubheader::CreateStreamSubHeader (1, 6000, 1000, true, true, true));
+          quicL5->DispatchRecv (frame, address);
+        }
+      else if (i == 1)
+        {
+          // the connection is closed
+          quicL5->ReleaseRcvBuf ();
+        }
+      else
+        {
+          quicL5->Dispose ();
+        }
+      NS_TEST_ASSERT_MSG_EQ (quicL4->GetRcvBufReserved (), 0, "Budget not released, case " << i);
+      connections.push_back (quicL5);
+    }
+
+  // the memory is not released twice
+  for (Ptr<QuicL5Protocol> quicL5 : connections)
+    {
+      quicL5->Dispose ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (quicL4->GetRcvBufReserved (), 0, "Budget released twice");
+
+  node->Dispose ();
+}
+
+void
+QuicFlowControlTestCase::DoRun ()
+{
+  // A stream with autotuning receives data without any time passing, as from
+  // a fast peer: the window doubles until the budget of the node (15000
+  // bytes above a window of 10000) is exhausted, and is still updated then.
+  TestWindowUpdate ();
+
+  // The memory reserved by the autotuning of a stream returns to the budget
+  // when all the data of the stream is read, when the connection is closed,
+  // and when the streams are disposed.
+  TestBudgetRelease ();
+
+  // A stream and then the connection are blocked by flow control: each
+  // blocking is traced once for each limit.
+  TestBlocked ();
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicOpenSocketTester with the ACK frequency support of the peer exposed
+ */
+class QuicProbeTimeoutTester : public QuicOpenSocketTester
+{
+public:
+  using QuicSocketBase::m_peerMinAckDelay;
+};
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicSocketBase probe timeout Test
+ *
+ * A packet is never acknowledged: the probe timeout expires after
+ * srtt + 4 rttvar + max_ack_delay, and then after twice as long at each
+ * expiration. Each expiration sends two ack-eliciting probes, which carry
+ * an IMMEDIATE_ACK if the peer supports the ACK frequency extension, and
+ * no more data than the MAX_DATA of the peer allows.
+ */
+class QuicProbeTimeoutTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param ackFrequency true if the peer supports the ACK frequency extension
+   */
+  QuicProbeTimeoutTestCase (bool ackFrequency);
+
+private:
+  virtual void
+  DoRun (void);
+
+  /**
+   * \brief Create a socket with a 165 ms probe timeout, whose packets are traced
+   *
+   * \param node the node
+   * \param quicL4 the QUIC L4 protocol of the node
+   * \return the socket
+   */
+  Ptr<QuicProbeTimeoutTester> CreateOpenSocket (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4);
+
+  /**
+   * \brief Check the expirations of the probe timeout and the probes
+   */
+  void TestBackoff ();
+
+  /**
+   * \brief Check that the probes do not send data beyond the MAX_DATA of the peer
+   */
+  void TestFlowControlLimit ();
+
+  /**
+   * \brief Trace sink of the sent packets
+   *
+   * \param packet the frames of the packet
+   * \param header the QUIC header
+   * \param socket the socket
+   */
+  void Tx (Ptr<const Packet> packet, const QuicHeader &header, Ptr<const QuicSocketBase> socket);
+
+  bool m_ackFrequency;                  //!< True if the peer supports the ACK frequency extension
+  std::vector<Time> m_txTimes;          //!< Time of each sent packet
+  std::vector<Ptr<Packet> > m_txFrames; //!< Frames of each sent packet
+};
+
+QuicProbeTimeoutTestCase::QuicProbeTimeoutTestCase (bool ackFrequency) :
+    TestCase (std::string ("QuicSocketBase probe timeout Test") + (ackFrequency ? " with ACK frequency" : "")),
+    m_ackFrequency (ackFrequency)
+{
+}
+
+void
+QuicProbeTimeoutTestCase::Tx (Ptr<const Packet> packet, const QuicHeader &header,
+                              Ptr<const QuicSocketBase> socket)
+{
+  m_txTimes.push_back (Simulator::Now ());
+  m_txFrames.push_back (packet->Copy ());
+}
+
+Ptr<QuicProbeTimeoutTester>
+QuicProbeTimeoutTestCase::CreateOpenSocket (Ptr<Node> node, Ptr<QuicL4Protocol> quicL4)
+{
+  // the probe timeout is selected by the attribute of the socket state
+  Config::SetDefault ("ns3::QuicSocketState::kUsingProbeTimeout", BooleanValue (true));
+  Ptr<QuicProbeTimeoutTester> socket = QuicOpenSocketTester::CreateOpen<QuicProbeTimeoutTester> (node, quicL4);
+  Config::SetDefault ("ns3::QuicSocketState::kUsingProbeTimeout", BooleanValue (false));
+  NS_TEST_ASSERT_MSG_EQ (socket->m_tcb->m_kUsingProbeTimeout, true, "Probe timeout not selected by the attribute");
+
+  // the packets are never acknowledged, so only the loss recovery alarm is left
+  socket->SetCongestionControlAlgorithm (CreateObject<QuicCongestionOps> ());
+  socket->TraceConnectWithoutContext ("Tx", MakeCallback (&QuicProbeTimeoutTestCase::Tx, this));
+
+  // PTO = 100 ms + 4 * 10 ms + 25 ms (kDelayedAckTimeout, above the peer min_ack_delay)
+  socket->m_tcb->m_pacing = false;
+  socket->m_tcb->m_cWnd = 10000;
+  socket->m_tcb->m_smoothedRtt = MilliSeconds (100);
+  socket->m_tcb->m_rttVar = MilliSeconds (10);
+  if (m_ackFrequency)
+    {
+      socket->m_peerMinAckDelay = MilliSeconds (1);
+    }
+  return socket;
+}
+
+void
+QuicProbeTimeoutTestCase::TestBackoff ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicProbeTimeoutTester> socket = CreateOpenSocket (node, quicL4);
+  Time pto = MilliSeconds (165);
+
+  Ptr<Packet> frame = Create<Packet> (500);
+  frame->AddHeader (QuicSubheader::CreateStreamSubHeader (1, 0, 500, false, true, false));
+  socket->AppendingTx (frame);
+
+  // three expirations: after 1, 2 and 4 PTOs
+  Simulator::Stop (pto * 8);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_txTimes.size (), 7, "Wrong number of sent packets");
+  NS_TEST_ASSERT_MSG_EQ (socket->m_tcb->m_ptoCount, 3, "Wrong number of probe timeouts");
+
+  // each expiration sends two probes at once, the timeout doubles every time
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      uint32_t first = 1 + 2 * i;
+      Time previous = m_txTimes[first - 1];
+      NS_TEST_ASSERT_MSG_EQ (m_txTimes[first] - previous, pto * (1 << i),
+                             "Wrong timeout before probe " << first);
+      NS_TEST_ASSERT_MSG_EQ (m_txTimes[first + 1], m_txTimes[first], "Probes not sent together");
+    }
+
+  // without data to send, the probes are made ack-eliciting with a PING
+  for (uint32_t i = 1; i < m_txFrames.size (); i++)
+    {
+      QuicSubheader sub;
+      m_txFrames[i]->RemoveHeader (sub);
+      NS_TEST_ASSERT_MSG_EQ (sub.IsPing (), true, "Probe " << i << " without PING");
+      bool immediateAck = false;
+      if (m_txFrames[i]->GetSize () > 0)
+        {
+          m_txFrames[i]->RemoveHeader (sub);
+          immediateAck = sub.IsImmediateAck ();
+        }
+      NS_TEST_ASSERT_MSG_EQ (immediateAck, m_ackFrequency, "Wrong IMMEDIATE_ACK in probe " << i);
+    }
+
+  node->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+QuicProbeTimeoutTestCase::TestFlowControlLimit ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicProbeTimeoutTester> socket = CreateOpenSocket (node, quicL4);
+
+  Ptr<Packet> frame = Create<Packet> (500);
+  frame->AddHeader (QuicSubheader::CreateStreamSubHeader (1, 0, 500, false, true, false));
+  socket->AppendingTx (frame);
+  NS_TEST_ASSERT_MSG_EQ (m_txTimes.size (), 1, "First packet not sent");
+
+  // the first packet uses all the MAX_DATA of the peer, the next data waits
+  socket->SetConnectionMaxData (socket->m_txBuffer->BytesInFlight ());
+  frame = Create<Packet> (500);
+  frame->AddHeader (QuicSubheader::CreateStreamSubHeader (1, 500, 500, true, true, false));
+  socket->AppendingTx (frame);
+  uint32_t sent = m_txTimes.size ();
+
+  // first expiration
+  Simulator::Stop (MilliSeconds (200));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (socket->m_tcb->m_ptoCount, 1, "Probe timeout not expired");
+  NS_TEST_ASSERT_MSG_EQ (m_txTimes.size (), sent + 2, "Wrong number of probes");
+
+  // the probes are a PING sent alone, and the data is still waiting for MAX_DATA
+  for (uint32_t i = sent; i < m_txFrames.size (); i++)
+    {
+      bool ping = false;
+      bool immediateAck = false;
+      while (m_txFrames[i]->GetSize () > 0)
+        {
+          QuicSubheader sub;
+          m_txFrames[i]->RemoveHeader (sub);
+          NS_TEST_ASSERT_MSG_EQ (sub.IsStream (), false, "Probe " << i << " beyond the MAX_DATA of the peer");
+          ping |= sub.IsPing ();
+          immediateAck |= sub.IsImmediateAck ();
+          m_txFrames[i]->RemoveAtStart (sub.GetLength ());
+        }
+      NS_TEST_ASSERT_MSG_EQ (ping, true, "Probe " << i << " without PING");
+      NS_TEST_ASSERT_MSG_EQ (immediateAck, m_ackFrequency, "Wrong IMMEDIATE_ACK in probe " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (socket->m_txBuffer->AppSize (), frame->GetSize (), "Data sent beyond MAX_DATA");
+
+  node->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+QuicProbeTimeoutTestCase::DoRun ()
+{
+  // A packet is never acknowledged: three expirations, each followed by two
+  // probes, after 1, 2 and 4 PTOs.
+  TestBackoff ();
+
+  m_txTimes.clear ();
+  m_txFrames.clear ();
+
+  // The peer MAX_DATA is used up by the first packet: the probes carry a
+  // PING, but none of the data that waits for a higher limit.
+  TestFlowControlLimit ();
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicCongestionOps that records the ACK summaries it receives
+ */
+class QuicAckEventRecorder : public QuicCongestionOps
+{
+public:
+  virtual void OnAckReceived (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent,
+                              const struct RateSample *rs);
+
+  std::vector<QuicAckEvent> m_events;  //!< The received ACK summaries, without the acknowledged packets
+};
+
+void
+QuicAckEventRecorder::OnAckReceived (Ptr<TcpSocketState> tcb, const QuicAckEvent &ackEvent,
+                                     const struct RateSample *rs)
+{
+  m_events.push_back (ackEvent);
+  m_events.back ().m_newAcks = 0;
+  QuicCongestionOps::OnAckReceived (tcb, ackEvent, rs);
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief QuicOpenSocketTester with the ACK processing exposed
+ */
+class QuicAckTester : public QuicOpenSocketTester
+{
+public:
+  using QuicSocketBase::OnReceivedAckFrame;
+  using QuicSocketBase::CreateStreamController;
+
+  using QuicSocketBase::m_quicl5;
+};
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief The QuicCongestionOps Test
+ *
+ * The NewReno window grows with the summary of each ACK frame: the bytes
+ * acknowledged beyond the slow start threshold grow the window as in
+ * congestion avoidance, and only the packets sent after the recovery period
+ * grow it when an ACK ends that period. The RTT is sampled only when the
+ * largest acknowledged packet is newly acknowledged, and smoothed as in
+ * RFC 6298.
+ */
+class QuicCongestionOpsTestCase : public TestCase
+{
+public:
+  /** \brief Constructor */
+  QuicCongestionOpsTestCase ();
+
+private:
+  virtual void
+  DoRun (void);
+
+  /**
+   * \brief Create a congestion state with 1000-byte segments
+   *
+   * \param cWnd the congestion window
+   * \param ssThresh the slow start threshold
+   * \return the congestion state
+   */
+  Ptr<QuicSocketState> CreateState (uint32_t cWnd, uint32_t ssThresh);
+
+  /**
+   * \brief Check the growth of the window for an ACK that crosses the slow start threshold
+   */
+  void TestSlowStartExit ();
+
+  /**
+   * \brief Check the growth of the window for an ACK that ends the recovery period
+   */
+  void TestEndOfRecovery ();
+
+  /**
+   * \brief Check the smoothed RTT and RTT variance after two samples
+   */
+  void TestRttSmoothing ();
+
+  /**
+   * \brief Check that the RTT is sampled only when the largest acknowledged packet is newly acked
+   */
+  void TestRttSample ();
+
+  /**
+   * \brief Trace sink of the sent packets
+   *
+   * \param packet the frames of the packet
+   * \param header the QUIC header
+   * \param socket the socket
+   */
+  void Tx (Ptr<const Packet> packet, const QuicHeader &header, Ptr<const QuicSocketBase> socket);
+
+  std::vector<uint32_t> m_txPacketNumbers;  //!< Packet number of each sent packet
+};
+
+QuicCongestionOpsTestCase::QuicCongestionOpsTestCase () :
+    TestCase ("QuicCongestionOps NewReno Test")
+{
+}
+
+Ptr<QuicSocketState>
+QuicCongestionOpsTestCase::CreateState (uint32_t cWnd, uint32_t ssThresh)
+{
+  Ptr<QuicSocketState> tcb = CreateObject<QuicSocketState> ();
+  tcb->m_segmentSize = 1000;
+  tcb->m_kMinimumWindow = 2000;
+  tcb->m_cWnd = cWnd;
+  tcb->m_ssThresh = ssThresh;
+  return tcb;
+}
+
+void
+QuicCongestionOpsTestCase::TestSlowStartExit ()
+{
+  Ptr<QuicCongestionOps> cc = CreateObject<QuicCongestionOps> ();
+  Ptr<QuicSocketState> tcb = CreateState (9000, 10000);
+
+  // 3000 bytes acknowledged: 1000 to reach ssthresh, 2000 in congestion avoidance
+  QuicAckEvent ackEvent;
+  ackEvent.m_largestAcked = SequenceNumber32 (12);
+  ackEvent.m_largestNewlyAcked = SequenceNumber32 (12);
+  ackEvent.m_smallestNewlyAcked = SequenceNumber32 (10);
+  ackEvent.m_ackedBytes = 3000;
+  ackEvent.m_ackElicitingAcked = 3;
+  cc->OnAckReceived (tcb, ackEvent, 0);
+
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_cWnd.Get (), 10000 + 1000 * 2000 / 10000,
+                         "Slow start not capped at ssthresh");
+
+  // without an RTT sample, the RTT estimate is not touched
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_smoothedRtt, Seconds (0), "RTT updated without a sample");
+}
+
+void
+QuicCongestionOpsTestCase::TestEndOfRecovery ()
+{
+  Ptr<QuicCongestionOps> cc = CreateObject<QuicCongestionOps> ();
+  Ptr<QuicSocketState> tcb = CreateState (10000, 10000);
+  tcb->m_endOfRecovery = SequenceNumber32 (20);
+
+  // packets 19 to 22 acknowledged, from the highest packet number
+  std::vector<Ptr<QuicSocketTxItem> > newAcks;
+  for (uint32_t pn = 22; pn >= 19; pn--)
+    {
+      Ptr<QuicSocketTxItem> item = Create<QuicSocketTxItem> ();
+      item->m_packetNumber = SequenceNumber32 (pn);
+      item->m_packet = Create<Packet> (1000);
+      item->m_acked = true;
+      newAcks.push_back (item);
+    }
+
+  QuicAckEvent ackEvent;
+  ackEvent.m_largestAcked = SequenceNumber32 (22);
+  ackEvent.m_largestNewlyAcked = SequenceNumber32 (22);
+  ackEvent.m_smallestNewlyAcked = SequenceNumber32 (19);
+  ackEvent.m_ackedBytes = 4000;
+  ackEvent.m_ackElicitingAcked = 4;
+  ackEvent.m_newAcks = &newAcks;
+
+  // an ACK of packets 17 and 18, within the recovery period, does not grow the window
+  QuicAckEvent recoveryEvent;
+  recoveryEvent.m_largestAcked = SequenceNumber32 (18);
+  recoveryEvent.m_largestNewlyAcked = SequenceNumber32 (18);
+  recoveryEvent.m_smallestNewlyAcked = SequenceNumber32 (17);
+  recoveryEvent.m_ackedBytes = 2000;
+  recoveryEvent.m_ackElicitingAcked = 2;
+  cc->OnAckReceived (tcb, recoveryEvent, 0);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_cWnd.Get (), 10000, "Window grown in recovery");
+
+  // only packets 21 and 22, sent after the recovery period, grow the window
+  cc->OnAckReceived (tcb, ackEvent, 0);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_cWnd.Get (), 10000 + 1000 * 2000 / 10000,
+                         "Window grown by the packets of the recovery period");
+}
+
+void
+QuicCongestionOpsTestCase::TestRttSmoothing ()
+{
+  Ptr<QuicCongestionOps> cc = CreateObject<QuicCongestionOps> ();
+  Ptr<QuicSocketState> tcb = CreateState (10000, 10000);
+
+  // the first sample initializes the estimate
+  QuicAckEvent ackEvent;
+  ackEvent.m_rttSample = MilliSeconds (100);
+  cc->OnAckReceived (tcb, ackEvent, 0);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_smoothedRtt, MilliSeconds (100), "Wrong first smoothed RTT");
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_rttVar, MilliSeconds (50), "Wrong first RTT variance");
+
+  // srtt = 7/8 * 100 + 1/8 * 200, rttvar = 3/4 * 50 + 1/4 * |100 - 200|
+  ackEvent.m_rttSample = MilliSeconds (200);
+  cc->OnAckReceived (tcb, ackEvent, 0);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_smoothedRtt, MicroSeconds (112500), "Wrong smoothed RTT");
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_rttVar, MicroSeconds (62500), "Wrong RTT variance");
+}
+
+void
+QuicCongestionOpsTestCase::Tx (Ptr<const Packet> packet, const QuicHeader &header,
+                               Ptr<const QuicSocketBase> socket)
+{
+  m_txPacketNumbers.push_back (header.GetPacketNumber ().GetValue ());
+}
+
+void
+QuicCongestionOpsTestCase::TestRttSample ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<QuicL4Protocol> quicL4 = CreateObject<QuicL4Protocol> ();
+  node->AggregateObject (quicL4);
+
+  Ptr<QuicAckTester> socket = QuicOpenSocketTester::CreateOpen<QuicAckTester> (node, quicL4);
+  socket->m_quicl5 = socket->CreateStreamController ();
+  Ptr<QuicAckEventRecorder> cc = CreateObject<QuicAckEventRecorder> ();
+  socket->SetCongestionControlAlgorithm (cc);
+  socket->TraceConnectWithoutContext ("Tx", MakeCallback (&QuicCongestionOpsTestCase::Tx, this));
+  socket->m_tcb->m_pacing = false;
+  socket->m_tcb->m_cWnd = 10000;
+  // the first probe timeout (325 ms without RTT samples) comes after the ACKs
+  socket->m_tcb->m_kUsingProbeTimeout = true;
+
+  // three packets, one for each frame
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> frame = Create<Packet> (500);
+      frame->AddHeader (QuicSubheader::CreateStreamSubHeader (1, i * 500, 500, i > 0, true, false));
+      socket->AppendingTx (frame);
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_txPacketNumbers.size (), 3, "Wrong number of sent packets");
+  uint32_t first = m_txPacketNumbers[0];
+  uint32_t second = m_txPacketNumbers[1];
+  uint32_t third = m_txPacketNumbers[2];
+
+  Simulator::Stop (MilliSeconds (50));
+  Simulator::Run ();
+
+  // ACK of the last packet: the largest acknowledged is newly acked
+  std::vector<uint32_t> gaps (1, second);
+  std::vector<uint32_t> blocks;
+  QuicSubheader ack = QuicSubheader::CreateAck (third, 0, 0, gaps, blocks);
+  socket->OnReceivedAckFrame (ack);
+  NS_TEST_ASSERT_MSG_EQ (cc->m_events.size (), 1, "No ACK summary");
+  NS_TEST_ASSERT_MSG_EQ (cc->m_events.back ().m_rttSample, MilliSeconds (50), "Wrong RTT sample");
+
+  // ACK of the first packet, with the last one again: no RTT sample
+  blocks.push_back (first);
+  ack = QuicSubheader::CreateAck (third, 0, 0, gaps, blocks);
+  socket->OnReceivedAckFrame (ack);
+  NS_TEST_ASSERT_MSG_EQ (cc->m_events.size (), 2, "No ACK summary");
+  NS_TEST_ASSERT_MSG_EQ (cc->m_events.back ().m_largestNewlyAcked.GetValue (), first, "Wrong newly acked packet");
+  NS_TEST_ASSERT_MSG_EQ (cc->m_events.back ().m_rttSample, Seconds (0),
+                         "RTT sampled without a newly acked largest packet");
+
+  node->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+QuicCongestionOpsTestCase::DoRun ()
+{
+  // A window of 9000 bytes with an ssthresh of 10000 bytes receives an ACK
+  // of 3000 bytes: slow start stops at ssthresh, and the other 2000 bytes
+  // grow the window as in congestion avoidance.
+  TestSlowStartExit ();
+
+  // The recovery period ends at packet 20: an ACK of packets 17 and 18
+  // does not grow the window, an ACK of packets 19 to 22 grows it by the
+  // 2000 bytes of packets 21 and 22 only.
+  TestEndOfRecovery ();
+
+  // Two RTT samples of 100 and 200 ms.
+  TestRttSmoothing ();
+
+  // Three packets, the last one acknowledged first: the ACK of the first
+  // packet does not carry an RTT sample.
+  TestRttSample ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the QuicSocketBase test cases
+ */
+class QuicSocketBaseTestSuite : public TestSuite
+{
+public:
+  QuicSocketBaseTestSuite () :
+      TestSuite ("quic-socket-base", UNIT)
+  {
+    AddTestCase (new QuicPacerTestCase (DataRate ("1Mbps"), 1200), TestCase::QUICK);
+    AddTestCase (new QuicPacerTestCase (DataRate ("10Mbps"), 2400), TestCase::QUICK);
+    AddTestCase (new QuicPacerTestCase (DataRate ("100Mbps"), 12500), TestCase::QUICK);
+    AddTestCase (new QuicAckFrequencyTestCase (), TestCase::QUICK);
+    AddTestCase (new QuicFlowControlTestCase (), TestCase::QUICK);
+    AddTestCase (new QuicProbeTimeoutTestCase (false), TestCase::QUICK);
+    AddTestCase (new QuicProbeTimeoutTestCase (true), TestCase::QUICK);
+    AddTestCase (new QuicCongestionOpsTestCase (), TestCase::QUICK);
+  }
+};
+
+static QuicSocketBaseTestSuite g_quicSocketBaseTestSuite; //!< Static variable for test initialization
@@ -26,11 +26,18 @@
 #include "ns3/quic-socket-tx-buffer.h"
 #include "ns3/quic-stream-tx-buffer.h"
 #include "ns3/quic-socket-tx-scheduler.h"
+#include "ns3/quic-socket-tx-drr-scheduler.h"
+#include "ns3/quic-socket-tx-priority-scheduler.h"
+#include "ns3/quic-socket-tx-edf-scheduler.h"
 
 #include "ns3/quic-socket-base.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <tuple>
 
 using namespace ns3;
 
@@ -84,6 +91,81 @@ private:
   /** \brief Test the Socket TX buffer retransmission of lost packets */
   void
   TestRetransmission ();
+  /** \brief Test the acknowledgment of sparse packet numbers with repeated ACK blocks */
+  void
+  TestSparseAck ();
+  /** \brief Test the recycling of the transmission items */
+  void
+  TestItemPool ();
+  /** \brief Test the byte counters with a large number of packets in flight */
+  void
+  TestLargeWindow ();
+  /** \brief Test the splitting and the retransmission of frames from their description */
+  void
+  TestFrameMetadata ();
+  /** \brief Test the packing of the control frames in the free space of the packets */
+  void
+  TestControlFrames ();
+  /** \brief Test the range tracking of the Stream TX buffer and the retransmission of missing ranges */
+  void
+  TestStreamRanges ();
+  /** \brief Test the round robin among streams of the DRR scheduler */
+  void
+  TestRoundRobin ();
+  /** \brief Test the urgency levels and the incremental streams of the priority scheduler */
+  void
+  TestExtensiblePriority ();
+  /** \brief Send a frame and buffer more frames with a deadline, and check the drop later */
+  void
+  TestDeadlineDrop ();
+  /**
+   * \brief Check that the expired frames are dropped, and the other ones sent
+   * \param txBuf the buffer
+   */
+  void
+  CheckDeadlineDrop (Ptr<QuicSocketTxBuffer> txBuf);
+
+  /** \brief Send packets over a period, and check the detection of persistent congestion on their loss */
+  void
+  TestPersistentCongestion ();
+  /**
+   * \brief Send a packet with a single frame
+   * \param txBuf the buffer
+   * \param frameSize the size of the frame
+   * \param packetNumber the packet number
+   */
+  void
+  SendFrame (Ptr<QuicSocketTxBuffer> txBuf, uint32_t frameSize, uint32_t packetNumber);
+  /**
+   * \brief Lose packets with and without acknowledgments between them, and check persistent congestion
+   * \param txBuf the buffer
+   */
+  void
+  CheckPersistentCongestion (Ptr<QuicSocketTxBuffer> txBuf);
+
+  /** \brief Send packets over a period, and check the time threshold loss detection */
+  void
+  TestTimeLossDetection ();
+  /**
+   * \brief Acknowledge the last packet, and check the lost packets and the loss time
+   * \param txBuf the buffer
+   * \param tcbd the socket state
+   */
+  void
+  CheckLossTime (Ptr<QuicSocketTxBuffer> txBuf, Ptr<QuicSocketState> tcbd);
+  /**
+   * \brief Expire the loss time, and check the lost packets
+   * \param txBuf the buffer
+   * \param tcbd the socket state
+   */
+  void
+  CheckLossTimeout (Ptr<QuicSocketTxBuffer> txBuf, Ptr<QuicSocketState> tcbd);
+
+  /** \brief Acknowledge a packet after its retransmission, and check the detection of the spurious loss */
+  void
+  TestSpuriousLoss ();
+
+  std::vector<std::tuple<uint64_t, uint64_t, bool> > m_expiredData;  //!< Stream, offset and FIN of the dropped expired frames
 };
 
 QuicTxBufferTestCase::QuicTxBufferTestCase () :
@@ -193,6 +275,125 @@ QuicTxBufferTestCase::DoRun ()
    * -> check correctness of acked and lost packets list
    */
   TestRetransmission ();
+
+  /*
+   * Test the acknowledgment of sparse packet numbers:
+   * -> send 30 packets, skipping one packet number every two packets
+   * -> ack the first 10 packets except the first one
+   * -> ack the first 20 packets except the first one, with the same gap
+   * -> check that only the newly acked packets are returned
+   * -> retransmit the first packet and ack everything
+   * -> check correctness of bytes in flight count
+   */
+  TestSparseAck ();
+
+  /*
+   * Test the recycling of the transmission items:
+   * -> release an item and allocate a new one from the same pool
+   * -> check that the released item is reused and cleared
+   * -> send and ack a packet at a time through the socket tx buffer
+   * -> check that no items are created in steady state
+   */
+  TestItemPool ();
+
+  /*
+   * Test the byte counters with a large number of packets in flight:
+   * -> send 20000 packets
+   * -> ack the second half of the packets, so that the first half is lost
+   * -> check correctness of bytes in flight and lost bytes
+   * -> retransmit the lost packets
+   * -> check that no bytes are in flight or lost
+   */
+  TestLargeWindow ();
+
+  /*
+   * Test the splitting and the retransmission of frames from their description:
+   * -> send a packet with two frames
+   * -> send a frame larger than the packet, which is split in two
+   * -> check the subheaders of the two parts
+   * -> mark the first packet as lost and retransmit it
+   * -> check that each frame is retransmitted on its own
+   */
+  TestFrameMetadata ();
+
+  /*
+   * Test the packing of the control frames:
+   * -> add a stream frame and a MAX_DATA frame, and send them in a packet
+   * -> check that the control frame follows the stream frame
+   * -> mark the packet as lost and retransmit it
+   * -> check that the control frame is sent alone in the next packet
+   * -> add a stream frame and two control frames, and send a control packet
+   * -> check that it carries only the control frames, and is in flight
+   */
+  TestControlFrames ();
+
+  /*
+   * Test the range tracking of the Stream TX buffer:
+   * -> send 3 frames from the stream tx buffer
+   * -> ack the second frame, and check the missing data of a loss of all frames
+   * -> ack the first and the third frames, and check that no data is missing
+   * -> send 2 frames in the same packet from the socket tx buffer
+   * -> ack the first frame at the stream, and mark the packet as lost
+   * -> check that only the second frame is retransmitted
+   */
+  TestStreamRanges ();
+
+  /*
+   * Test the round robin among streams of the DRR scheduler:
+   * -> add 3 frames on stream 1 and then 3 frames on stream 2
+   * -> extract one frame at a time, with a quantum of one frame
+   * -> check that the streams alternate
+   * -> retransmit a frame of stream 1
+   * -> check that it is sent before the new data of stream 1
+   */
+  TestRoundRobin ();
+
+  /*
+   * Test the extensible priorities of the priority scheduler:
+   * -> set urgency 1 on stream 2, and make streams 3 and 4 incremental
+   * -> add 2 frames on each of the streams 4, 3, 1 and 2
+   * -> check that stream 2 is sent first, then the non-incremental stream 1
+   * -> check that the incremental streams 4 and 3 alternate
+   */
+  TestExtensiblePriority ();
+
+  /*
+   * Test the drop of the expired frames of the EDF scheduler:
+   * -> enable the drop on stream 1 only, with a latency of 10 ms on both streams
+   * -> add 2 frames on stream 1 and 1 frame on stream 2, and send the first one
+   * -> after 20 ms, mark the first packet as lost and retransmit it
+   * -> check that the frames of stream 1 are dropped and the frame of stream 2 is sent
+   */
+  Simulator::Schedule (Seconds (0.0), &QuicTxBufferTestCase::TestDeadlineDrop, this);
+
+  /*
+   * Test the detection of persistent congestion:
+   * -> send 4 packets, 100 ms apart
+   * -> mark the last 2 packets as lost, and check the duration threshold
+   * -> ack the second packet and mark the first one as lost
+   * -> check that the acknowledgment in the period prevents persistent congestion
+   */
+  Simulator::Schedule (Seconds (0.0), &QuicTxBufferTestCase::TestPersistentCongestion, this);
+
+  /*
+   * Test the time threshold loss detection:
+   * -> send 3 packets, 10 ms apart, with an RTT of 100 ms
+   * -> ack the last packet after 120 ms, so that only the first one is lost by time
+   * -> check that the loss time is set for the second packet
+   * -> check that the second packet is lost when the loss time expires
+   */
+  Simulator::Schedule (Seconds (0.0), &QuicTxBufferTestCase::TestTimeLossDetection, this);
+
+  /*
+   * Test the detection of spurious losses:
+   * -> send 5 packets and ack the last one, so that the first two are lost
+   * -> retransmit the lost packets
+   * -> ack a lowest block above them, whose start is unknown, and check that no loss is spurious
+   * -> ack the first packet, and check that it is reported as a spurious loss once
+   */
+  Simulator::Schedule (Seconds (0.0), &QuicTxBufferTestCase::TestSpuriousLoss, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
 }
 
 void
@@ -933,6 +1134,809 @@ QuicTxBufferTestCase::TestStream0 ()
                         "TxBuf miscalculates size of in flight segments");
 }
 
+void
+QuicTxBufferTestCase::TestSparseAck ()
+{
+  // create the buffer
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf.SetScheduler(sched);
+  Ptr<QuicSocketState> tcbd;
+
+  tcbd = CreateObject<QuicSocketState> ();
+
+  const uint32_t numPackets = 30;
+  txBuf.SetMaxBufferSize (numPackets * 1200);
+
+  // send the packets, leaving a packet number for an ACK-only packet every two packets
+  std::vector<uint32_t> packetNumbers;
+  for (uint32_t i = 0; i < numPackets; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1196);
+      QuicSubheader sub = QuicSubheader::CreateStreamSubHeader (1, i * 1196, p->GetSize (),
+                                                                false, true, false);
+      p->AddHeader (sub);
+      txBuf.Add (p);
+      packetNumbers.push_back (1 + i + i / 2);
+      Ptr<Packet> ptx = txBuf.NextSequence (1200, SequenceNumber32 (packetNumbers.back ()));
+      NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 1200, "TxBuf miscalculates size");
+    }
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), numPackets * 1200,
+                        "TxBuf miscalculates size of in flight segments");
+
+  // acknowledge the first 10 packets except the first one
+  std::vector<uint32_t> additionalAckBlocks;
+  std::vector<uint32_t> gaps;
+  gaps.push_back (packetNumbers.at (0));
+  additionalAckBlocks.push_back (packetNumbers.at (0) - 1);
+
+  std::vector<Ptr<QuicSocketTxItem>> acked = txBuf.OnAckUpdate (tcbd,
+                                                            packetNumbers.at (9),
+                                                            additionalAckBlocks,
+                                                            gaps);
+  NS_TEST_ASSERT_MSG_EQ(acked.size (), 9, "Wrong acked packet vector size");
+  NS_TEST_ASSERT_MSG_EQ(acked.front ()->m_packetNumber.GetValue (), packetNumbers.at (9),
+                        "TxBuf does not correctly detect the IDs of ACKed packets");
+  NS_TEST_ASSERT_MSG_EQ(acked.back ()->m_packetNumber.GetValue (), packetNumbers.at (1),
+                        "TxBuf does not correctly detect the IDs of ACKed packets");
+
+  std::vector<Ptr<QuicSocketTxItem>> lost = txBuf.DetectLostPackets ();
+  NS_TEST_ASSERT_MSG_EQ(lost.size (), 1, "TxBuf misses a loss");
+  NS_TEST_ASSERT_MSG_EQ(lost.at (0)->m_packetNumber.GetValue (), packetNumbers.at (0),
+                        "TxBuf does not correctly detect the IDs of lost packets");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), (numPackets - 9) * 1200,
+                        "TxBuf miscalculates size of in flight segments");
+
+  // acknowledge the first 20 packets: the ACK block repeats the previous one
+  acked = txBuf.OnAckUpdate (tcbd, packetNumbers.at (19), additionalAckBlocks, gaps);
+  NS_TEST_ASSERT_MSG_EQ(acked.size (), 10, "Previously acked packets acked again");
+  for (uint32_t i = 0; i < acked.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ(acked.at (i)->m_packetNumber.GetValue (), packetNumbers.at (19 - i),
+                            "TxBuf does not correctly detect the IDs of ACKed packets");
+    }
+  lost = txBuf.DetectLostPackets ();
+  NS_TEST_ASSERT_MSG_EQ(lost.size (), 1, "TxBuf detects a non-existent loss");
+
+  // retransmit the first packet and acknowledge everything
+  uint32_t next = packetNumbers.back () + 1;
+  uint32_t toRetx = txBuf.Retransmission (SequenceNumber32 (next));
+  NS_TEST_ASSERT_MSG_EQ(toRetx, 1200, "wrong number of lost bytes");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetLost (), 0, "Retransmitted packet still lost");
+  Ptr<Packet> ptx = txBuf.NextSequence (toRetx, SequenceNumber32 (next));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 1200, "TxBuf miscalculates size");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), (numPackets - 19) * 1200,
+                        "TxBuf miscalculates size of in flight segments");
+
+  additionalAckBlocks.clear ();
+  gaps.clear ();
+  acked = txBuf.OnAckUpdate (tcbd, next, additionalAckBlocks, gaps);
+  NS_TEST_ASSERT_MSG_EQ(acked.size (), numPackets - 19, "Wrong acked packet vector size");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), 0,
+                        "TxBuf miscalculates size of in flight segments");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.DetectLostPackets ().empty (), true,
+                        "TxBuf detects a non-existent loss");
+}
+
+void
+QuicTxBufferTestCase::TestItemPool ()
+{
+  // a released item is reused for the next allocation
+  Ptr<QuicSocketTxItemPool> pool = Create<QuicSocketTxItemPool> ();
+  Ptr<QuicSocketTxItem> item = pool->Allocate ();
+  item->m_packet = Create<Packet> (1200);
+  QuicSocketTxItem *released = PeekPointer (item);
+  item = 0;
+  NS_TEST_ASSERT_MSG_EQ(pool->GetNumFree (), 1, "Released item not in the free list");
+
+  item = pool->Allocate ();
+  NS_TEST_ASSERT_MSG_EQ((PeekPointer (item) == released), true, "Released item not reused");
+  NS_TEST_ASSERT_MSG_EQ((item->m_packet == nullptr), true, "Reused item not cleared");
+  NS_TEST_ASSERT_MSG_EQ(pool->GetNumCreated (), 1, "Pool creates a new item");
+  NS_TEST_ASSERT_MSG_EQ(pool->GetNumFree (), 0, "Reused item still in the free list");
+
+  // the items of the socket tx buffer are recycled once acknowledged
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf.SetScheduler(sched);
+  Ptr<QuicSocketState> tcbd;
+
+  tcbd = CreateObject<QuicSocketState> ();
+
+  const uint32_t numPackets = 100;
+  const uint32_t warmup = 10;
+  uint64_t created = 0;
+  std::vector<uint32_t> additionalAckBlocks;
+  std::vector<uint32_t> gaps;
+  for (uint32_t i = 0; i < numPackets; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1196);
+      QuicSubheader sub = QuicSubheader::CreateStreamSubHeader (1, i * 1196, p->GetSize (),
+                                                                false, true, false);
+      p->AddHeader (sub);
+      txBuf.Add (p);
+      Ptr<Packet> ptx = txBuf.NextSequence (1200, SequenceNumber32 (i + 1));
+      NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 1200, "TxBuf miscalculates size");
+      std::vector<Ptr<QuicSocketTxItem>> acked = txBuf.OnAckUpdate (tcbd, i + 1,
+                                                                additionalAckBlocks,
+                                                                gaps);
+      NS_TEST_ASSERT_MSG_EQ(acked.size (), 1, "Wrong acked packet vector size");
+      if (i + 1 == warmup)
+        {
+          created = txBuf.GetItemPool ()->GetNumCreated ();
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), 0,
+                        "TxBuf miscalculates size of in flight segments");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetItemPool ()->GetNumCreated (), created,
+                        "Items are not recycled in steady state");
+}
+
+void
+QuicTxBufferTestCase::TestLargeWindow ()
+{
+  // create the buffer
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf.SetScheduler(sched);
+  Ptr<QuicSocketState> tcbd;
+
+  tcbd = CreateObject<QuicSocketState> ();
+
+  const uint32_t numPackets = 20000;
+  txBuf.SetMaxBufferSize (numPackets * 1200);
+
+  for (uint32_t i = 0; i < numPackets; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1196);
+      QuicSubheader sub = QuicSubheader::CreateStreamSubHeader (1, i * 1196, p->GetSize (),
+                                                                false, true, false);
+      p->AddHeader (sub);
+      txBuf.Add (p);
+      Ptr<Packet> ptx = txBuf.NextSequence (1200, SequenceNumber32 (i + 1));
+      NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 1200, "TxBuf miscalculates size");
+    }
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), numPackets * 1200,
+                        "TxBuf miscalculates size of in flight segments");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetLost (), 0, "TxBuf detects a non-existent loss");
+
+  // acknowledge the second half of the packets
+  std::vector<uint32_t> additionalAckBlocks;
+  std::vector<uint32_t> gaps;
+  gaps.push_back (numPackets / 2);
+  std::vector<Ptr<QuicSocketTxItem>> acked = txBuf.OnAckUpdate (tcbd, numPackets,
+                                                            additionalAckBlocks,
+                                                            gaps);
+  NS_TEST_ASSERT_MSG_EQ(acked.size (), numPackets / 2, "Wrong acked packet vector size");
+  // the lost packets are not acknowledged, so they are still in flight
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), numPackets / 2 * 1200,
+                        "TxBuf miscalculates size of in flight segments");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetLost (), numPackets / 2 * 1200, "TxBuf miscalculates lost bytes");
+
+  uint32_t toRetx = txBuf.Retransmission (SequenceNumber32 (numPackets + 1));
+  NS_TEST_ASSERT_MSG_EQ(toRetx, numPackets / 2 * 1200, "wrong number of lost bytes");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), 0,
+                        "TxBuf miscalculates size of in flight segments");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetLost (), 0, "Retransmitted packets still lost");
+}
+
+void
+QuicTxBufferTestCase::TestFrameMetadata ()
+{
+  // create the buffer
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf.SetScheduler(sched);
+  txBuf.SetMaxBufferSize (10000);
+
+  // send two frames on different streams in the same packet
+  for (uint64_t streamId = 1; streamId <= 2; streamId++)
+    {
+      Ptr<Packet> p = Create<Packet> (500);
+      p->AddHeader (QuicSubheader::CreateStreamSubHeader (streamId, 0, 500, false, true, false));
+      txBuf.Add (p);
+    }
+  uint32_t frameSize = txBuf.AppSize () / 2;
+  Ptr<Packet> ptx = txBuf.NextSequence (1200, SequenceNumber32 (1));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 2 * frameSize, "TxBuf miscalculates size");
+
+  // send a frame larger than the packet
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddHeader (QuicSubheader::CreateStreamSubHeader (3, 0, 1000, false, true, true));
+  txBuf.Add (p);
+
+  QuicSubheader sub;
+  ptx = txBuf.NextSequence (600, SequenceNumber32 (2));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 600, "Wrong size of the first part of the frame");
+  ptx->RemoveHeader (sub);
+  uint32_t firstLength = ptx->GetSize ();
+  NS_TEST_ASSERT_MSG_EQ(sub.GetStreamId (), 3, "Wrong stream of the first part");
+  NS_TEST_ASSERT_MSG_EQ(sub.GetOffset (), 0, "Wrong offset of the first part");
+  NS_TEST_ASSERT_MSG_EQ(sub.GetLength (), firstLength, "Wrong length of the first part");
+  NS_TEST_ASSERT_MSG_EQ(sub.IsStreamFin (), false, "FIN bit set in the first part");
+
+  ptx = txBuf.NextSequence (1200, SequenceNumber32 (3));
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.GetStreamId (), 3, "Wrong stream of the second part");
+  NS_TEST_ASSERT_MSG_EQ(sub.GetOffset (), firstLength, "Wrong offset of the second part");
+  NS_TEST_ASSERT_MSG_EQ(sub.GetLength (), ptx->GetSize (), "Wrong length of the second part");
+  NS_TEST_ASSERT_MSG_EQ(firstLength + ptx->GetSize (), 1000, "Data lost in the split");
+  NS_TEST_ASSERT_MSG_EQ(sub.IsStreamFin (), true, "FIN bit not set in the second part");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.AppSize (), 0, "Data left in the application buffer");
+
+  // the frames of the lost packet are retransmitted one by one
+  txBuf.MarkAsLost (SequenceNumber32 (1));
+  uint32_t toRetx = txBuf.Retransmission (SequenceNumber32 (4));
+  NS_TEST_ASSERT_MSG_EQ(toRetx, 2 * frameSize, "wrong number of lost bytes");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.AppSize (), 2 * frameSize, "Lost frames not in the application buffer");
+
+  for (uint64_t streamId = 1; streamId <= 2; streamId++)
+    {
+      ptx = txBuf.NextSequence (frameSize, SequenceNumber32 (3 + streamId));
+      NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), frameSize, "Wrong size of retransmitted frame");
+      ptx->RemoveHeader (sub);
+      NS_TEST_ASSERT_MSG_EQ(sub.GetStreamId (), streamId, "Wrong stream of retransmitted frame");
+      NS_TEST_ASSERT_MSG_EQ(sub.GetOffset (), 0, "Wrong offset of retransmitted frame");
+      NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 500, "Wrong data size of retransmitted frame");
+    }
+}
+
+/**
+ * \brief Refresh the MAX_DATA frame of a lost control packet
+ *
+ * \param frames the lost control frames
+ * \return the frames with the latest MAX_DATA
+ */
+static Ptr<Packet>
+RefreshMaxData (Ptr<Packet> frames)
+{
+  QuicSubheader sub;
+  frames->PeekHeader (sub);
+  if (!sub.IsMaxData ())
+    {
+      return frames;
+    }
+  Ptr<Packet> refreshed = Create<Packet> ();
+  refreshed->AddHeader (QuicSubheader::CreateMaxData (300000));
+  return refreshed;
+}
+
+void
+QuicTxBufferTestCase::TestControlFrames ()
+{
+  // create the buffer
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf.SetScheduler(sched);
+  txBuf.SetMaxBufferSize (10000);
+
+  Ptr<Packet> p = Create<Packet> (500);
+  p->AddHeader (QuicSubheader::CreateStreamSubHeader (1, 0, 500, false, true, false));
+  txBuf.Add (p);
+  uint32_t streamSize = txBuf.AppSize ();
+
+  QuicSubheader maxData = QuicSubheader::CreateMaxData (100000);
+  Ptr<Packet> control = Create<Packet> ();
+  control->AddHeader (maxData);
+  NS_TEST_ASSERT_MSG_EQ(txBuf.Add (control), true, "Control frame rejected");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetNumControlFramesInBuffer (), 1, "Control frame not queued");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.AppSize (), streamSize + maxData.GetSerializedSize (),
+                        "Control frame not counted in the application size");
+
+  // the control frame fills the free space of the packet
+  Ptr<Packet> ptx = txBuf.NextSequence (1200, SequenceNumber32 (1));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), streamSize + maxData.GetSerializedSize (),
+                        "Wrong size of the packet");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetNumControlFramesInBuffer (), 0, "Control frame not sent");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.AppSize (), 0, "Data left in the application buffer");
+
+  QuicSubheader sub;
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.IsStream (), true, "Stream frame not first in the packet");
+  ptx->RemoveAtStart (sub.GetLength ());
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.IsMaxData (), true, "Control frame not packed");
+  NS_TEST_ASSERT_MSG_EQ(sub.GetMaxData (), 100000, "Wrong value of the control frame");
+
+  // the lost control frame is queued again, and sent alone
+  txBuf.MarkAsLost (SequenceNumber32 (1));
+  txBuf.Retransmission (SequenceNumber32 (2));
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetNumControlFramesInBuffer (), 1, "Lost control frame not queued");
+
+  ptx = txBuf.NextSequence (streamSize, SequenceNumber32 (2));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), streamSize, "Wrong size of the retransmitted stream frame");
+  ptx = txBuf.NextSequence (1200, SequenceNumber32 (3));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), maxData.GetSerializedSize (),
+                        "Wrong size of the retransmitted control frame");
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.IsMaxData (), true, "Wrong retransmitted control frame");
+
+  // with no room for data, the control frames are sent on their own
+  p = Create<Packet> (500);
+  p->AddHeader (QuicSubheader::CreateStreamSubHeader (1, 500, 500, true, true, false));
+  txBuf.Add (p);
+  streamSize = txBuf.AppSize ();
+  control = Create<Packet> ();
+  control->AddHeader (QuicSubheader::CreateMaxData (200000));
+  txBuf.Add (control);
+  control = Create<Packet> ();
+  control->AddHeader (QuicSubheader::CreateMaxStreamData (1, 50000));
+  txBuf.Add (control);
+  uint32_t controlSize = txBuf.AppSize () - streamSize;
+  uint32_t inFlight = txBuf.BytesInFlight ();
+
+  ptx = txBuf.NextControlSequence (1200, SequenceNumber32 (4));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), controlSize, "Wrong size of the control packet");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetNumControlFramesInBuffer (), 0, "Control frames not sent");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.AppSize (), streamSize, "Stream data sent with the control frames");
+  NS_TEST_ASSERT_MSG_EQ(txBuf.BytesInFlight (), inFlight + controlSize, "Control packet not in flight");
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.IsMaxData (), true, "MAX_DATA not packed");
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.IsMaxStreamData (), true, "MAX_STREAM_DATA not packed");
+
+  ptx = txBuf.NextControlSequence (1200, SequenceNumber32 (5));
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 0, "Control packet without control frames");
+
+  // the lost control frames are queued again in their order, with the latest limits
+  txBuf.SetLostControlFramesCallback (MakeCallback (&RefreshMaxData));
+  txBuf.MarkAsLost (SequenceNumber32 (4));
+  txBuf.Retransmission (SequenceNumber32 (6));
+  NS_TEST_ASSERT_MSG_EQ(txBuf.GetNumControlFramesInBuffer (), 2, "Lost control frames not queued");
+
+  ptx = txBuf.NextControlSequence (1200, SequenceNumber32 (6));
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.IsMaxData (), true, "Lost control frames reordered");
+  NS_TEST_ASSERT_MSG_EQ(sub.GetMaxData (), 300000, "Stale MAX_DATA sent again");
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ(sub.IsMaxStreamData (), true, "Lost control frames reordered");
+  NS_TEST_ASSERT_MSG_EQ(sub.GetMaxStreamData (), 50000, "Wrong value of the control frame");
+  NS_TEST_ASSERT_MSG_EQ(ptx->GetSize (), 0, "Unexpected frames in the control packet");
+}
+
+/**
+ * \brief Get the missing data of a lost frame from a Stream TX buffer
+ *
+ * \param streamTxBuf the stream tx buffer
+ * \param streamId the ID of the stream
+ * \param offset the offset of the lost data
+ * \param length the length of the lost data
+ * \param ranges filled with the missing data
+ * \return true
+ */
+static bool
+GetLostStreamData (Ptr<QuicStreamTxBuffer> streamTxBuf, uint64_t streamId, uint64_t offset,
+                   uint32_t length, std::vector<QuicStreamTxRange> &ranges)
+{
+  ranges = streamTxBuf->OnLost (offset, length);
+  return true;
+}
+
+void
+QuicTxBufferTestCase::TestStreamRanges ()
+{
+  // create the stream buffer
+  Ptr<QuicStreamTxBuffer> streamTxBuf = CreateObject<QuicStreamTxBuffer> ();
+  streamTxBuf->SetMaxBufferSize (18000);
+
+  // add 3600 bytes and send them in 3 frames, the first across two packets
+  streamTxBuf->Add (Create<Packet> (1000));
+  streamTxBuf->Add (Create<Packet> (2600));
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> frame = streamTxBuf->NextSequence (1200, SequenceNumber32 (i * 1200));
+      NS_TEST_ASSERT_MSG_EQ (frame->GetSize (), 1200, "Wrong frame size");
+    }
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->AppSize (), 0, "Wrong buffer size");
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->BytesInFlight (), 3600, "Wrong bytes in flight");
+
+  // ack the second frame
+  streamTxBuf->OnAck (1200, 1200);
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->BytesInFlight (), 2400, "Wrong bytes in flight");
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->GetAckedOffset (), 0, "Out of order data released");
+
+  std::vector<QuicStreamTxRange> missing = streamTxBuf->OnLost (0, 3600);
+  NS_TEST_ASSERT_MSG_EQ (missing.size (), 2, "Wrong number of missing ranges");
+  NS_TEST_ASSERT_MSG_EQ (missing.at (0).first, 0, "Wrong offset of the first missing range");
+  NS_TEST_ASSERT_MSG_EQ (missing.at (0).second->GetSize (), 1200, "Wrong size of the first missing range");
+  NS_TEST_ASSERT_MSG_EQ (missing.at (1).first, 2400, "Wrong offset of the second missing range");
+  NS_TEST_ASSERT_MSG_EQ (missing.at (1).second->GetSize (), 1200, "Wrong size of the second missing range");
+
+  // ack the first frame, so that the data is released up to the third one
+  streamTxBuf->OnAck (0, 1200);
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->GetAckedOffset (), 2400, "Acked data not released");
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->BytesInFlight (), 1200, "Wrong bytes in flight");
+  missing = streamTxBuf->OnLost (0, 2400);
+  NS_TEST_ASSERT_MSG_EQ (missing.size (), 0, "Acked data reported as missing");
+
+  // ack the third frame
+  streamTxBuf->OnAck (2400, 1200);
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->GetAckedOffset (), 3600, "Acked data not released");
+  NS_TEST_ASSERT_MSG_EQ (streamTxBuf->BytesInFlight (), 0, "Wrong bytes in flight");
+
+  // send two frames in the same packet from the socket tx buffer
+  QuicSocketTxBuffer socketTxBuf;
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  socketTxBuf.SetScheduler(sched);
+  socketTxBuf.SetMaxBufferSize (10000);
+  socketTxBuf.SetLostStreamDataCallback (MakeBoundCallback (&GetLostStreamData, streamTxBuf));
+
+  streamTxBuf->Add (Create<Packet> (1000));
+  for (uint64_t offset = 3600; offset < 4600; offset += 500)
+    {
+      Ptr<Packet> frame = streamTxBuf->NextSequence (500, SequenceNumber32 (offset));
+      frame->AddHeader (QuicSubheader::CreateStreamSubHeader (1, offset, 500, true, true, false));
+      socketTxBuf.Add (frame);
+    }
+  Ptr<Packet> ptx = socketTxBuf.NextSequence (1200, SequenceNumber32 (1));
+  uint32_t frameSize = ptx->GetSize () / 2;
+
+  // the first frame is acked, e.g., through an earlier copy, and the packet is lost
+  streamTxBuf->OnAck (3600, 500);
+  socketTxBuf.MarkAsLost (SequenceNumber32 (1));
+  uint32_t toRetx = socketTxBuf.Retransmission (SequenceNumber32 (2));
+  NS_TEST_ASSERT_MSG_EQ (toRetx, frameSize, "Acked data retransmitted");
+  NS_TEST_ASSERT_MSG_EQ (socketTxBuf.AppSize (), frameSize, "Wrong buffer size");
+
+  QuicSubheader sub;
+  ptx = socketTxBuf.NextSequence (1200, SequenceNumber32 (2));
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.GetStreamId (), 1, "Wrong stream of retransmitted frame");
+  NS_TEST_ASSERT_MSG_EQ (sub.GetOffset (), 4100, "Wrong offset of retransmitted frame");
+  NS_TEST_ASSERT_MSG_EQ (ptx->GetSize (), 500, "Wrong data size of retransmitted frame");
+}
+
+void
+QuicTxBufferTestCase::TestRoundRobin ()
+{
+  // create the buffer
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxDrrScheduler> sched = CreateObject<QuicSocketTxDrrScheduler>();
+  txBuf.SetScheduler(sched);
+  txBuf.SetMaxBufferSize (10000);
+
+  // add 3 frames on stream 1, then 3 frames on stream 2
+  for (uint64_t streamId = 1; streamId <= 2; streamId++)
+    {
+      for (uint64_t offset = 1000; offset < 2500; offset += 500)
+        {
+          Ptr<Packet> p = Create<Packet> (500);
+          p->AddHeader (QuicSubheader::CreateStreamSubHeader (streamId, offset, 500, true, true, false));
+          txBuf.Add (p);
+        }
+    }
+  uint32_t frameSize = txBuf.AppSize () / 6;
+  sched->SetAttribute ("Quantum", UintegerValue (frameSize));
+
+  // the streams alternate, one frame per turn
+  QuicSubheader sub;
+  uint32_t packetNumber = 1;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<Packet> ptx = txBuf.NextSequence (frameSize, SequenceNumber32 (packetNumber++));
+      ptx->RemoveHeader (sub);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetStreamId (), 1 + i % 2, "Wrong stream in turn " << i);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetOffset (), 1000 + 500 * (i / 2), "Wrong offset in turn " << i);
+    }
+
+  // the first packet is lost, its retransmission comes before the new data of stream 1
+  txBuf.MarkAsLost (SequenceNumber32 (1));
+  uint32_t toRetx = txBuf.Retransmission (SequenceNumber32 (packetNumber));
+  NS_TEST_ASSERT_MSG_EQ (toRetx, frameSize, "Wrong number of lost bytes");
+
+  uint64_t expectedStream[] = { 1, 2, 1 };
+  uint64_t expectedOffset[] = { 1000, 2000, 2000 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> ptx = txBuf.NextSequence (frameSize, SequenceNumber32 (packetNumber++));
+      ptx->RemoveHeader (sub);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetStreamId (), expectedStream[i], "Wrong stream after the loss in turn " << i);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetOffset (), expectedOffset[i], "Wrong offset after the loss in turn " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.AppSize (), 0, "Data left in the application buffer");
+}
+
+void
+QuicTxBufferTestCase::TestExtensiblePriority ()
+{
+  // create the buffer
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxPriorityScheduler> sched = CreateObject<QuicSocketTxPriorityScheduler>();
+  txBuf.SetScheduler(sched);
+  txBuf.SetMaxBufferSize (10000);
+
+  txBuf.SetStreamPriority (2, 1, false);
+  txBuf.SetStreamPriority (3, 3, true);
+  txBuf.SetStreamPriority (4, 3, true);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) txBuf.GetStreamUrgency (1), 3, "Wrong default urgency");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetStreamIncremental (1), false, "Wrong default incremental flag");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) txBuf.GetStreamUrgency (2), 1, "Wrong urgency of stream 2");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetStreamIncremental (3), true, "Wrong incremental flag of stream 3");
+
+  // the streams are added in the opposite order of their priority
+  uint64_t streams[] = { 4, 3, 1, 2 };
+  for (uint64_t streamId : streams)
+    {
+      for (uint64_t offset = 0; offset < 1000; offset += 500)
+        {
+          Ptr<Packet> p = Create<Packet> (500);
+          p->AddHeader (QuicSubheader::CreateStreamSubHeader (streamId, offset, 500, true, true, false));
+          txBuf.Add (p);
+        }
+    }
+  uint32_t frameSize = txBuf.AppSize () / 8;
+
+  uint64_t expectedStream[] = { 2, 2, 1, 1, 4, 3, 4, 3 };
+  uint64_t expectedOffset[] = { 0, 500, 0, 500, 0, 0, 500, 500 };
+  QuicSubheader sub;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      Ptr<Packet> ptx = txBuf.NextSequence (frameSize, SequenceNumber32 (i + 1));
+      ptx->RemoveHeader (sub);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetStreamId (), expectedStream[i], "Wrong stream in turn " << i);
+      NS_TEST_ASSERT_MSG_EQ (sub.GetOffset (), expectedOffset[i], "Wrong offset in turn " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.AppSize (), 0, "Data left in the application buffer");
+}
+
+/**
+ * \brief Record the stream data dropped by the scheduler
+ * \param expired the vector of dropped stream data
+ * \param streamId the stream ID
+ * \param offset the offset of the dropped data
+ * \param length the length of the dropped data
+ * \param fin the FIN of the dropped data
+ */
+static void
+RecordExpiredData (std::vector<std::tuple<uint64_t, uint64_t, bool> > *expired, uint64_t streamId,
+                   uint64_t offset, uint32_t length, bool fin)
+{
+  expired->push_back (std::make_tuple (streamId, offset, fin));
+}
+
+void
+QuicTxBufferTestCase::TestDeadlineDrop ()
+{
+  // create the buffer
+  Ptr<QuicSocketTxBuffer> txBuf = CreateObject<QuicSocketTxBuffer> ();
+  Ptr<QuicSocketTxEdfScheduler> sched = CreateObject<QuicSocketTxEdfScheduler>();
+  txBuf->SetScheduler(sched);
+  txBuf->SetMaxBufferSize (10000);
+  txBuf->SetExpiredStreamDataCallback (MakeBoundCallback (&RecordExpiredData, &m_expiredData));
+
+  txBuf->SetLatency (1, MilliSeconds (10));
+  txBuf->SetLatency (2, MilliSeconds (10));
+  txBuf->SetDropExpired (1, true);
+  NS_TEST_ASSERT_MSG_EQ (txBuf->GetDropExpired (1), true, "Drop not enabled on stream 1");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->GetDropExpired (2), false, "Drop enabled on stream 2");
+
+  uint64_t streams[] = { 1, 1, 2 };
+  uint64_t offsets[] = { 0, 500, 0 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (500);
+      p->AddHeader (QuicSubheader::CreateStreamSubHeader (streams[i], offsets[i], 500, true, true, i == 1));
+      txBuf->Add (p);
+    }
+  uint32_t frameSize = txBuf->AppSize () / 3;
+
+  // the first frame is sent before its deadline
+  Ptr<Packet> ptx = txBuf->NextSequence (frameSize, SequenceNumber32 (1));
+  NS_TEST_ASSERT_MSG_EQ (ptx->GetSize (), frameSize, "Frame not sent before the deadline");
+
+  Simulator::Schedule (MilliSeconds (20), &QuicTxBufferTestCase::CheckDeadlineDrop, this, txBuf);
+}
+
+void
+QuicTxBufferTestCase::CheckDeadlineDrop (Ptr<QuicSocketTxBuffer> txBuf)
+{
+  uint32_t frameSize = txBuf->AppSize () / 2;
+
+  // the lost frame has expired too
+  txBuf->MarkAsLost (SequenceNumber32 (1));
+  uint32_t toRetx = txBuf->Retransmission (SequenceNumber32 (2));
+  NS_TEST_ASSERT_MSG_EQ (toRetx, frameSize, "Wrong number of lost bytes");
+
+  QuicSubheader sub;
+  Ptr<Packet> ptx = txBuf->NextSequence (3 * frameSize, SequenceNumber32 (3));
+  NS_TEST_ASSERT_MSG_EQ (ptx->GetSize (), frameSize, "Expired frames sent");
+  ptx->RemoveHeader (sub);
+  NS_TEST_ASSERT_MSG_EQ (sub.GetStreamId (), 2, "Wrong stream of the sent frame");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->AppSize (), 0, "Data left in the application buffer");
+
+  std::sort (m_expiredData.begin (), m_expiredData.end ());
+  NS_TEST_ASSERT_MSG_EQ (m_expiredData.size (), 2, "Wrong number of dropped frames");
+  NS_TEST_ASSERT_MSG_EQ (std::get<0> (m_expiredData[0]), 1, "Dropped frame on the wrong stream");
+  NS_TEST_ASSERT_MSG_EQ (std::get<1> (m_expiredData[0]), 0, "Wrong offset of the first dropped frame");
+  NS_TEST_ASSERT_MSG_EQ (std::get<2> (m_expiredData[0]), false, "FIN reported for the first dropped frame");
+  NS_TEST_ASSERT_MSG_EQ (std::get<0> (m_expiredData[1]), 1, "Dropped frame on the wrong stream");
+  NS_TEST_ASSERT_MSG_EQ (std::get<1> (m_expiredData[1]), 500, "Wrong offset of the second dropped frame");
+  NS_TEST_ASSERT_MSG_EQ (std::get<2> (m_expiredData[1]), true, "FIN of the second dropped frame lost");
+}
+
+void
+QuicTxBufferTestCase::TestPersistentCongestion ()
+{
+  // create the buffer
+  Ptr<QuicSocketTxBuffer> txBuf = CreateObject<QuicSocketTxBuffer> ();
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf->SetScheduler(sched);
+  txBuf->SetMaxBufferSize (10000);
+
+  for (uint64_t streamId = 1; streamId <= 4; streamId++)
+    {
+      Ptr<Packet> p = Create<Packet> (500);
+      p->AddHeader (QuicSubheader::CreateStreamSubHeader (streamId, 0, 500, false, true, false));
+      txBuf->Add (p);
+    }
+  uint32_t frameSize = txBuf->AppSize () / 4;
+
+  for (uint32_t packetNumber = 1; packetNumber <= 4; packetNumber++)
+    {
+      Simulator::Schedule (MilliSeconds (100 * (packetNumber - 1)), &QuicTxBufferTestCase::SendFrame,
+                           this, txBuf, frameSize, packetNumber);
+    }
+  Simulator::Schedule (MilliSeconds (400), &QuicTxBufferTestCase::CheckPersistentCongestion, this, txBuf);
+}
+
+void
+QuicTxBufferTestCase::SendFrame (Ptr<QuicSocketTxBuffer> txBuf, uint32_t frameSize, uint32_t packetNumber)
+{
+  Ptr<Packet> ptx = txBuf->NextSequence (frameSize, SequenceNumber32 (packetNumber));
+  NS_TEST_ASSERT_MSG_EQ (ptx->GetSize (), frameSize, "Wrong size of the sent frame");
+}
+
+void
+QuicTxBufferTestCase::CheckPersistentCongestion (Ptr<QuicSocketTxBuffer> txBuf)
+{
+  Ptr<QuicSocketState> tcbd = CreateObject<QuicSocketState> ();
+
+  // the last two packets are sent 100 ms apart
+  txBuf->MarkAsLost (SequenceNumber32 (3));
+  txBuf->MarkAsLost (SequenceNumber32 (4));
+  std::vector<Ptr<QuicSocketTxItem> > lost = txBuf->DetectLostPackets ();
+  NS_TEST_ASSERT_MSG_EQ (lost.size (), 2, "Wrong number of lost packets");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->IsPersistentCongestion (lost, MilliSeconds (50)), true,
+                         "Persistent congestion not detected");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->IsPersistentCongestion (lost, MilliSeconds (150)), false,
+                         "Persistent congestion detected over a short period");
+
+  // the second packet is acknowledged, between the first and the last lost ones
+  std::vector<uint32_t> additionalAckBlocks;
+  std::vector<uint32_t> gaps;
+  additionalAckBlocks.push_back (0);
+  gaps.push_back (1);
+  std::vector<Ptr<QuicSocketTxItem> > acked = txBuf->OnAckUpdate (tcbd, 2, additionalAckBlocks, gaps);
+  NS_TEST_ASSERT_MSG_EQ (acked.size (), 1, "Wrong number of acked packets");
+
+  txBuf->MarkAsLost (SequenceNumber32 (1));
+  lost = txBuf->DetectLostPackets ();
+  NS_TEST_ASSERT_MSG_EQ (lost.size (), 3, "Wrong number of lost packets");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->IsPersistentCongestion (lost, MilliSeconds (50)), false,
+                         "Persistent congestion detected with an acknowledgment in the period");
+}
+
+void
+QuicTxBufferTestCase::TestTimeLossDetection ()
+{
+  // create the buffer
+  Ptr<QuicSocketTxBuffer> txBuf = CreateObject<QuicSocketTxBuffer> ();
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf->SetScheduler(sched);
+  txBuf->SetMaxBufferSize (10000);
+
+  Ptr<QuicSocketState> tcbd = CreateObject<QuicSocketState> ();
+  tcbd->m_kUsingTimeLossDetection = true;
+  tcbd->m_smoothedRtt = MilliSeconds (100);
+  tcbd->m_lastRtt = MilliSeconds (100);
+
+  for (uint64_t streamId = 1; streamId <= 3; streamId++)
+    {
+      Ptr<Packet> p = Create<Packet> (500);
+      p->AddHeader (QuicSubheader::CreateStreamSubHeader (streamId, 0, 500, false, true, false));
+      txBuf->Add (p);
+    }
+  uint32_t frameSize = txBuf->AppSize () / 3;
+
+  for (uint32_t packetNumber = 1; packetNumber <= 3; packetNumber++)
+    {
+      Simulator::Schedule (MilliSeconds (10 * (packetNumber - 1)), &QuicTxBufferTestCase::SendFrame,
+                           this, txBuf, frameSize, packetNumber);
+    }
+  Simulator::Schedule (MilliSeconds (120), &QuicTxBufferTestCase::CheckLossTime, this, txBuf, tcbd);
+  Simulator::Schedule (MilliSeconds (130), &QuicTxBufferTestCase::CheckLossTimeout, this, txBuf, tcbd);
+}
+
+void
+QuicTxBufferTestCase::CheckLossTime (Ptr<QuicSocketTxBuffer> txBuf, Ptr<QuicSocketState> tcbd)
+{
+  // ack the last packet only: the loss delay is 9/8 of the RTT, 112.5 ms
+  std::vector<uint32_t> additionalAckBlocks;
+  std::vector<uint32_t> gaps;
+  additionalAckBlocks.push_back (0);
+  gaps.push_back (2);
+  std::vector<Ptr<QuicSocketTxItem> > acked = txBuf->OnAckUpdate (tcbd, 3, additionalAckBlocks, gaps);
+  NS_TEST_ASSERT_MSG_EQ (acked.size (), 1, "Wrong number of acked packets");
+
+  std::vector<Ptr<QuicSocketTxItem> > lost = txBuf->DetectLostPackets ();
+  NS_TEST_ASSERT_MSG_EQ (lost.size (), 1, "Wrong number of packets lost by time");
+  NS_TEST_ASSERT_MSG_EQ (lost.at (0)->m_packetNumber, SequenceNumber32 (1), "Wrong packet lost by time");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->GetLossTime (), MicroSeconds (122500), "Wrong loss time");
+
+  // the loss time does not expire yet
+  txBuf->OnLossTimeout (tcbd);
+  NS_TEST_ASSERT_MSG_EQ (txBuf->DetectLostPackets ().size (), 1, "Packet lost before the loss time");
+}
+
+void
+QuicTxBufferTestCase::CheckLossTimeout (Ptr<QuicSocketTxBuffer> txBuf, Ptr<QuicSocketState> tcbd)
+{
+  txBuf->OnLossTimeout (tcbd);
+  std::vector<Ptr<QuicSocketTxItem> > lost = txBuf->DetectLostPackets ();
+  NS_TEST_ASSERT_MSG_EQ (lost.size (), 2, "Packet not lost at the loss time");
+  NS_TEST_ASSERT_MSG_EQ (lost.at (1)->m_packetNumber, SequenceNumber32 (2), "Wrong packet lost at the loss time");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->GetLossTime (), Seconds (0), "Loss time set with no outstanding packets");
+}
+
+void
+QuicTxBufferTestCase::TestSpuriousLoss ()
+{
+  // create the buffer
+  QuicSocketTxBuffer txBuf;
+  Ptr<QuicSocketTxScheduler> sched = CreateObject<QuicSocketTxScheduler>();
+  txBuf.SetScheduler(sched);
+  Ptr<QuicSocketState> tcbd = CreateObject<QuicSocketState> ();
+
+  for (uint64_t streamId = 1; streamId <= 5; streamId++)
+    {
+      Ptr<Packet> p = Create<Packet> (1196);
+      p->AddHeader (QuicSubheader::CreateStreamSubHeader (streamId, 0, 1196, false, true, false));
+      txBuf.Add (p);
+    }
+  uint32_t frameSize = txBuf.AppSize () / 5;
+  for (uint32_t packetNumber = 1; packetNumber <= 5; packetNumber++)
+    {
+      txBuf.NextSequence (frameSize, SequenceNumber32 (packetNumber));
+    }
+
+  // ack packet 5: packets 1 and 2 are beyond the reordering threshold
+  std::vector<uint32_t> additionalAckBlocks;
+  std::vector<uint32_t> gaps;
+  additionalAckBlocks.push_back (0);
+  gaps.push_back (4);
+  txBuf.OnAckUpdate (tcbd, 5, additionalAckBlocks, gaps);
+  std::vector<Ptr<QuicSocketTxItem>> lost = txBuf.DetectLostPackets ();
+  NS_TEST_ASSERT_MSG_EQ (lost.size (), 2, "Wrong number of lost packets");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.DetectSpuriousLosses ().size (), 0, "Spurious loss without a late ACK");
+
+  txBuf.Retransmission (SequenceNumber32 (6));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.DetectLostPackets ().size (), 0, "Lost packets not retransmitted");
+
+  // ack packets 3 and 5: the last block ends above the lost packets, but its start is unknown
+  additionalAckBlocks.clear ();
+  gaps.clear ();
+  additionalAckBlocks.push_back (3);
+  gaps.push_back (4);
+  txBuf.OnAckUpdate (tcbd, 5, additionalAckBlocks, gaps);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.DetectSpuriousLosses ().size (), 0, "Spurious loss in the unbounded block");
+
+  // ack packets 1 and 5: the first packet was only reordered
+  additionalAckBlocks.clear ();
+  gaps.clear ();
+  additionalAckBlocks.push_back (1);
+  gaps.push_back (4);
+  gaps.push_back (0);
+  txBuf.OnAckUpdate (tcbd, 5, additionalAckBlocks, gaps);
+  std::vector<QuicSpuriousLoss> spurious = txBuf.DetectSpuriousLosses ();
+  NS_TEST_ASSERT_MSG_EQ (spurious.size (), 1, "Spurious loss not detected");
+  NS_TEST_ASSERT_MSG_EQ (spurious.at (0).m_packetNumber, SequenceNumber32 (1), "Wrong spurious loss");
+  NS_TEST_ASSERT_MSG_EQ (spurious.at (0).m_reordering, 4, "Wrong reordering of the spurious loss");
+
+  // the same ACK does not report the loss again
+  txBuf.OnAckUpdate (tcbd, 5, additionalAckBlocks, gaps);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.DetectSpuriousLosses ().size (), 0, "Spurious loss reported twice");
+}
+
 void
 QuicTxBufferTestCase::DoTeardown ()
 {